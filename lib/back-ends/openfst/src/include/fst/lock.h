@@ -20,6 +20,9 @@
 #ifndef FST_LIB_LOCK_H__
 #define FST_LIB_LOCK_H__
 
+#include <atomic>
+#include <mutex>
+
 #include <fst/compat.h>  // for DISALLOW_COPY_AND_ASSIGN
 
 namespace fst {
@@ -27,7 +30,7 @@ namespace fst {
 using namespace std;
 
 //
-// Single initialization  - single-thread implementation
+// Single initialization, safe to call from several threads
 //
 
 typedef int FstOnceType;
@@ -35,6 +38,8 @@ typedef int FstOnceType;
 static const int FST_ONCE_INIT = 1;
 
 inline int FstOnceInit(FstOnceType *once, void (*init)(void)) {
+  static std::mutex once_mutex;
+  std::lock_guard<std::mutex> l(once_mutex);
   if (*once)
     (*init)();
   *once = 0;
@@ -42,36 +47,48 @@ inline int FstOnceInit(FstOnceType *once, void (*init)(void)) {
 }
 
 //
-// Thread locking - single-thread (non-)implementation
+// Thread locking, so that transducers that share an implementation
+// or symbol table can be used from several threads
 //
 
 class Mutex {
  public:
   Mutex() {}
+  void Lock() { mutex_.lock(); }
+  void Unlock() { mutex_.unlock(); }
 
  private:
+  std::mutex mutex_;
+
   DISALLOW_COPY_AND_ASSIGN(Mutex);
 };
 
 class MutexLock {
  public:
-  MutexLock(Mutex *) {}
+  MutexLock(Mutex *m) : mutex_(m) { mutex_->Lock(); }
+  ~MutexLock() { mutex_->Unlock(); }
 
  private:
+  Mutex *mutex_;
+
   DISALLOW_COPY_AND_ASSIGN(MutexLock);
 };
 
-// Reference counting - single-thread implementation
+//
+// Reference counting, atomic so that copies of a transducer can be
+// made and destroyed in different threads
+//
+
 class RefCounter {
  public:
   RefCounter() : count_(1) {}
 
-  int count() const { return count_; }
+  int count() const { return count_.load(); }
   int Incr() const { return ++count_; }
   int Decr() const {  return --count_; }
 
  private:
-  mutable int count_;
+  mutable std::atomic<int> count_;
 
   DISALLOW_COPY_AND_ASSIGN(RefCounter);
 };
@@ -10,6 +10,7 @@
 #include "HarmonizeUnknownAndIdentitySymbols.h"
 #include "HfstTransducer.h"
 #include "implementations/HfstBasicTransducer.h"
+#include "implementations/HfstSymbolInterner.h"
 #include "HfstFlagDiacritics.h"
 #include "implementations/optimized-lookup/pmatch.h"
 
@@ -18,6 +19,9 @@
 namespace hfst
 {
 
+using implementations::HfstState;
+using implementations::HfstSymbolInterner;
+
 const char * HarmonizeUnknownAndIdentitySymbols::identity =
   "@_IDENTITY_SYMBOL_@"; // --- internal_identity.c_str();
 const char * HarmonizeUnknownAndIdentitySymbols::unknown =
@@ -72,23 +76,11 @@ HarmonizeUnknownAndIdentitySymbols::HarmonizeUnknownAndIdentitySymbols
       assert(is_subset(t2_symbols_in_transitions,t2_symbol_set));
     }
 
-  // --- typedef StringVector (not in HfstSymbolDefs.h, maybe it should be?)
-  std::vector<std::string> diff_vector
-    (max_(t1_symbol_set.size(),t2_symbol_set.size()),"");
-  
   if (debug_harmonize)
     { debug_harmonize_print("Computing t1 symbols - t2 symbols."); }
 
-  // --- documentation would be useful
-  std::vector<std::string>::iterator diff_end =
-    std::set_difference(t1_symbol_set.begin(),t1_symbol_set.end(),
-            t2_symbol_set.begin(),t2_symbol_set.end(),
-            diff_vector.begin());
-
-  StringSet t1_symbols_minus_t2_symbols(diff_vector.begin(),diff_end);
-
-  t1_symbols_minus_t2_symbols.erase(identity);
-  t1_symbols_minus_t2_symbols.erase(unknown);
+  SymbolNumbers t1_symbols_minus_t2_symbols =
+    symbols_missing_from(t1_symbol_set,t2_symbol_set);
 
   if (debug_harmonize)
     {
@@ -99,14 +91,8 @@ HarmonizeUnknownAndIdentitySymbols::HarmonizeUnknownAndIdentitySymbols
   if (debug_harmonize)
     { debug_harmonize_print("Computing t2 symbols - t1 symbols."); }
 
-  diff_end = std::set_difference(t2_symbol_set.begin(),t2_symbol_set.end(),
-                 t1_symbol_set.begin(),t1_symbol_set.end(),
-                 diff_vector.begin());
-
-  StringSet t2_symbols_minus_t1_symbols(diff_vector.begin(),diff_end);
-
-  t1_symbols_minus_t2_symbols.erase(unknown);
-  t1_symbols_minus_t2_symbols.erase(identity);
+  SymbolNumbers t2_symbols_minus_t1_symbols =
+    symbols_missing_from(t2_symbol_set,t1_symbol_set);
 
   if (debug_harmonize)
     {
@@ -185,113 +171,171 @@ void HarmonizeUnknownAndIdentitySymbols::add_symbols_to_alphabet
     }
 }
 
-// --- documentation would make this function easier to follow
+HarmonizeUnknownAndIdentitySymbols::SymbolNumbers
+HarmonizeUnknownAndIdentitySymbols::symbols_missing_from
+(const StringSet &symbols,const StringSet &other_symbols)
+{
+  HfstSymbolInterner &interner = HfstSymbolInterner::global();
+
+  // The numbers of the symbols in other_symbols as a bitset
+  std::vector<bool> in_other_symbols;
+  for (StringSet::const_iterator it = other_symbols.begin();
+       it != other_symbols.end(); ++it)
+    {
+      unsigned int number = interner.get_number(*it);
+      if (number >= in_other_symbols.size())
+        { in_other_symbols.resize(number + 1, false); }
+      in_other_symbols[number] = true;
+    }
+
+  const unsigned int identity_number = interner.get_number(identity);
+  const unsigned int unknown_number = interner.get_number(unknown);
+
+  SymbolNumbers missing_symbols;
+  for (StringSet::const_iterator it = symbols.begin();
+       it != symbols.end(); ++it)
+    {
+      unsigned int number = interner.get_number(*it);
+      if (number == identity_number || number == unknown_number)
+        { continue; }
+      if (number < in_other_symbols.size() && in_other_symbols[number])
+        { continue; }
+      missing_symbols.push_back(number);
+    }
+  return missing_symbols;
+}
+
 void HarmonizeUnknownAndIdentitySymbols::harmonize_identity_symbols
-(HfstBasicTransducer &t,const StringSet &missing_symbols)
+(HfstBasicTransducer &t,const SymbolNumbers &missing_symbols)
 {
   if (missing_symbols.empty())
     { return; }
 
+  const unsigned int identity_number =
+    HfstSymbolInterner::global().get_number(identity);
+
   for (HfstBasicTransducer::iterator it = t.begin(); it != t.end(); ++it)
     {
+      hfst::implementations::HfstBasicTransitions &transitions = *it;
+      const size_t original_size = transitions.size();
 
-      hfst::implementations::HfstBasicTransitions added_transitions;
+      size_t added_size = 0;
+      for (size_t i = 0; i < original_size; ++i)
+    {
+      if (transitions[i].get_input_number() == identity_number)
+        { added_size += missing_symbols.size(); }
+    }
+      if (added_size == 0)
+    { continue; }
+      transitions.reserve(original_size + added_size);
 
-      for (hfst::implementations::HfstBasicTransitions::const_iterator jt =
-         it->begin();
-       jt != it->end();
-       ++jt)
+      for (size_t i = 0; i < original_size; ++i)
     {
-      if (jt->get_input_symbol() == identity)
-        {
-          // --- an exception instead, this could also be checked
-          //     at an earlier stage
-          assert(jt->get_output_symbol() == identity);
-          for (StringSet::const_iterator kt = missing_symbols.begin();
+      if (transitions[i].get_input_number() != identity_number)
+        { continue; }
+      // --- an exception instead, this could also be checked
+      //     at an earlier stage
+      assert(transitions[i].get_output_number() == identity_number);
+
+      HfstState target = transitions[i].get_target_state();
+      float weight = transitions[i].get_weight();
+      for (SymbolNumbers::const_iterator kt = missing_symbols.begin();
            kt != missing_symbols.end();
            ++kt)
-        { added_transitions.push_back
-            (HfstBasicTransition(jt->get_target_state(),
-                     *kt,*kt,
-                     jt->get_weight())); }
-        }
+        { transitions.push_back
+            (HfstBasicTransition(target,*kt,*kt,weight,false)); }
     }
-      it->insert(it->end(),
-         added_transitions.begin(),added_transitions.end());
     }
 }
 
-// --- documentation would make this function easier to follow
 void HarmonizeUnknownAndIdentitySymbols::harmonize_unknown_symbols
-(HfstBasicTransducer &t,const StringSet &missing_symbols)
+(HfstBasicTransducer &t,const SymbolNumbers &missing_symbols)
 {
   if (missing_symbols.empty())
     { return; }
 
+  const unsigned int identity_number =
+    HfstSymbolInterner::global().get_number(identity);
+  const unsigned int unknown_number =
+    HfstSymbolInterner::global().get_number(unknown);
+  const size_t n = missing_symbols.size();
+
   for (HfstBasicTransducer::iterator it = t.begin(); it != t.end(); ++it)
     {
-      hfst::implementations::HfstBasicTransitions added_transitions;
+      hfst::implementations::HfstBasicTransitions &transitions = *it;
+      const size_t original_size = transitions.size();
 
-      for (hfst::implementations::HfstBasicTransitions::const_iterator jt =
-         it->begin();
-       jt != it->end();
-       ++jt)
+      size_t added_size = 0;
+      for (size_t i = 0; i < original_size; ++i)
+    {
+      bool input_unknown =
+        (transitions[i].get_input_number() == unknown_number);
+      bool output_unknown =
+        (transitions[i].get_output_number() == unknown_number);
+      if (input_unknown)
+        { added_size += n; }
+      if (output_unknown)
+        { added_size += n; }
+      if (input_unknown && output_unknown)
+        { added_size += n * (n - 1); }
+    }
+      if (added_size == 0)
+    { continue; }
+      transitions.reserve(original_size + added_size);
+
+      for (size_t i = 0; i < original_size; ++i)
     {
-      if (jt->get_input_symbol() == unknown)
+      unsigned int input = transitions[i].get_input_number();
+      unsigned int output = transitions[i].get_output_number();
+      if (input != unknown_number && output != unknown_number)
+        { continue; }
+
+      HfstState target = transitions[i].get_target_state();
+      float weight = transitions[i].get_weight();
+
+      if (input == unknown_number)
         {
           // --- an exception instead, this could also be checked
           //     at an earlier stage
-          assert(jt->get_output_symbol() != identity);
+          assert(output != identity_number);
         
-          for (StringSet::const_iterator kt = missing_symbols.begin();
+          for (SymbolNumbers::const_iterator kt = missing_symbols.begin();
            kt != missing_symbols.end();
            ++kt)
-        {
-          added_transitions.push_back
-            (HfstBasicTransition(jt->get_target_state(),
-                     *kt,jt->get_output_symbol(),
-                     jt->get_weight()));
+        { transitions.push_back
+            (HfstBasicTransition(target,*kt,output,weight,false)); }
         }
-        }
-      if (jt->get_output_symbol() == unknown)
+      if (output == unknown_number)
         {
           // --- an exception instead, this could also be checked
           //     at an earlier stage
-          assert(jt->get_input_symbol() != identity);
+          assert(input != identity_number);
 
-          for (StringSet::const_iterator kt = missing_symbols.begin();
+          for (SymbolNumbers::const_iterator kt = missing_symbols.begin();
            kt != missing_symbols.end();
            ++kt)
-        { added_transitions.push_back
-            (HfstBasicTransition(jt->get_target_state(),
-                     jt->get_input_symbol(),*kt,
-                     jt->get_weight())); }
-
+        { transitions.push_back
+            (HfstBasicTransition(target,input,*kt,weight,false)); }
         }
-      if (jt->get_input_symbol() == unknown &&
-          jt->get_output_symbol() == unknown)
+      if (input == unknown_number && output == unknown_number)
         {
-          for (StringSet::const_iterator kt = missing_symbols.begin();
+          for (SymbolNumbers::const_iterator kt = missing_symbols.begin();
            kt != missing_symbols.end();
            ++kt)
         {
-          for (StringSet::const_iterator lt = missing_symbols.begin();
+          for (SymbolNumbers::const_iterator lt = missing_symbols.begin();
                lt != missing_symbols.end();
                ++lt)
             {
               if (kt == lt)
             { continue; }
 
-              added_transitions.push_back
-            (HfstBasicTransition(jt->get_target_state(),
-                         *lt,*kt,
-                         jt->get_weight()));
+              transitions.push_back
+            (HfstBasicTransition(target,*lt,*kt,weight,false));
             }
         }
         }
     }
-      it->insert(it->end(),
-         added_transitions.begin(),added_transitions.end());
     }
 }
 
@@ -307,19 +351,184 @@ void debug_harmonize_print(const StringSet &s)
 void debug_harmonize_print(const std::string &s)
 { std::cerr << s << std::endl; }
 
+void debug_harmonize_print
+(const HarmonizeUnknownAndIdentitySymbols::SymbolNumbers &s)
+{
+  for (HarmonizeUnknownAndIdentitySymbols::SymbolNumbers::const_iterator it =
+         s.begin();
+       it != s.end();
+       ++it)
+    { std::cerr << HfstSymbolInterner::global().get_symbol(*it)
+                << std::endl; }
+}
+
 }
 
 
 #else // MAIN_TEST --- good
+#include <cassert>
+
 using hfst::HfstInputStream;
 using hfst::HfstTransducer;
 using hfst::HfstOutputStream;
 using hfst::HfstBasicTransducer;
 
+// Whether t has a transition with the identity or unknown symbol.
+static bool has_unknown_or_identity(const HfstBasicTransducer &t)
+{
+  for (HfstBasicTransducer::const_iterator it = t.begin();
+       it != t.end(); ++it)
+    {
+      for (hfst::implementations::HfstBasicTransitions::const_iterator tr_it
+             = it->begin(); tr_it != it->end(); ++tr_it)
+        {
+          const std::string &isymbol = tr_it->get_input_symbol();
+          const std::string &osymbol = tr_it->get_output_symbol();
+          if (isymbol == hfst::internal_identity ||
+              isymbol == hfst::internal_unknown ||
+              osymbol == hfst::internal_identity ||
+              osymbol == hfst::internal_unknown)
+            { return true; }
+        }
+    }
+  return false;
+}
+
+// Whether t has a transition with the symbol unknown on either side.
+static bool has_unknown(const HfstBasicTransducer &t)
+{
+  for (HfstBasicTransducer::const_iterator it = t.begin();
+       it != t.end(); ++it)
+    {
+      for (hfst::implementations::HfstBasicTransitions::const_iterator tr_it
+             = it->begin(); tr_it != it->end(); ++tr_it)
+        {
+          if (tr_it->get_input_symbol() == hfst::internal_unknown ||
+              tr_it->get_output_symbol() == hfst::internal_unknown)
+            { return true; }
+        }
+    }
+  return false;
+}
+
+// Whether state s of t has a transition input:output.
+static bool has_transition(const HfstBasicTransducer &t,
+                           hfst::implementations::HfstState s,
+                           const std::string &input,
+                           const std::string &output)
+{
+  const hfst::implementations::HfstBasicTransitions &transitions =
+    t.transitions(s);
+  for (hfst::implementations::HfstBasicTransitions::const_iterator it
+         = transitions.begin(); it != transitions.end(); ++it)
+    {
+      if (it->get_input_symbol() == input &&
+          it->get_output_symbol() == output)
+        { return true; }
+    }
+  return false;
+}
+
 int main(int argc, char * argv[])
 {
     std::cout << "Unit tests for " __FILE__ ":" << std::endl;
 
+  // t1 has only an identity transition and t2 has an unknown transition.
+  // The identity of t1 is expanded with b, the symbol it lacks, but not
+  // with the unknown symbol of t2. The unknown symbol is removed from the
+  // alphabet of t1, where HfstBasicTransducer puts it, so that it is one
+  // of the symbols t1 lacks.
+  {
+    HfstBasicTransducer t1;
+    t1.add_transition
+      (0, hfst::implementations::HfstBasicTransition
+       (1, hfst::internal_identity, hfst::internal_identity, 0));
+    t1.set_final_weight(1, 0);
+    t1.remove_symbol_from_alphabet(hfst::internal_unknown);
+
+    HfstBasicTransducer t2;
+    t2.add_transition
+      (0, hfst::implementations::HfstBasicTransition
+       (1, hfst::internal_unknown, "b", 0));
+    t2.set_final_weight(1, 0);
+
+    hfst::HarmonizeUnknownAndIdentitySymbols(t1, t2);
+
+    assert(! has_unknown(t1));
+    assert(has_transition(t1, 0, "b", "b"));
+    assert(t1.transitions(0).size() == 2);
+  }
+
+  // "?:?" and "a:?" in t1 are expanded with the symbols b and c of t2:
+  // "?:?" to b:?, c:?, ?:b, ?:c, b:c and c:b, but not to b:b or c:c,
+  // which the identity symbol stands for, and "a:?" to a:b and a:c.
+  {
+    HfstBasicTransducer t1;
+    t1.add_transition
+      (0, hfst::implementations::HfstBasicTransition
+       (1, hfst::internal_unknown, hfst::internal_unknown, 0));
+    t1.add_transition
+      (0, hfst::implementations::HfstBasicTransition
+       (1, "a", hfst::internal_unknown, 0));
+    t1.set_final_weight(1, 0);
+
+    HfstBasicTransducer t2;
+    t2.add_transition
+      (0, hfst::implementations::HfstBasicTransition(1, "b", "b", 0));
+    t2.add_transition
+      (0, hfst::implementations::HfstBasicTransition(1, "c", "c", 0));
+    t2.set_final_weight(1, 0);
+
+    hfst::HarmonizeUnknownAndIdentitySymbols(t1, t2);
+
+    const std::string &unknown = hfst::internal_unknown;
+    assert(has_transition(t1, 0, "b", unknown));
+    assert(has_transition(t1, 0, "c", unknown));
+    assert(has_transition(t1, 0, unknown, "b"));
+    assert(has_transition(t1, 0, unknown, "c"));
+    assert(has_transition(t1, 0, "b", "c"));
+    assert(has_transition(t1, 0, "c", "b"));
+    assert(! has_transition(t1, 0, "b", "b"));
+    assert(! has_transition(t1, 0, "c", "c"));
+    assert(has_transition(t1, 0, "a", "b"));
+    assert(has_transition(t1, 0, "a", "c"));
+    assert(t1.transitions(0).size() == 10);
+
+    // t1 has no symbols that t2 lacks other than a, which t2 has no
+    // identity or unknown transitions to expand with
+    assert(t2.transitions(0).size() == 2);
+  }
+
+  // Only t2 has identity and unknown symbols: they are expanded in t2 with
+  // the symbols of t1, but nothing is added to t1.
+  {
+    HfstBasicTransducer t1;
+    t1.add_transition
+      (0, hfst::implementations::HfstBasicTransition(1, "a", "a", 0));
+    t1.set_final_weight(1, 0);
+
+    HfstBasicTransducer t2;
+    t2.add_transition
+      (0, hfst::implementations::HfstBasicTransition
+       (1, hfst::internal_identity, hfst::internal_identity, 0));
+    t2.add_transition
+      (0, hfst::implementations::HfstBasicTransition
+       (1, hfst::internal_unknown, "b", 0));
+    t2.add_transition
+      (0, hfst::implementations::HfstBasicTransition(1, "c", "c", 0));
+    t2.set_final_weight(1, 0);
+
+    hfst::HarmonizeUnknownAndIdentitySymbols(t1, t2);
+
+    assert(! has_unknown_or_identity(t1));
+    assert(t1.transitions(0).size() == 1);
+    assert(t1.transitions(0)[0].get_input_symbol() == "a");
+    assert(t1.transitions(0)[0].get_output_symbol() == "a");
+
+    // identity, unknown:b, c:c, and the expansions a:a and a:b
+    assert(t2.transitions(0).size() == 5);
+  }
+
     // the following tests require stdio, not appropriate for unit testing..
     // TODO: implement whatever we want to do in functionality tests?
     /*
@@ -23,6 +23,7 @@
 #include <string>
 #include <iosfwd>
 #include <algorithm>
+#include <vector>
 
 #include "HfstDataTypes.h"
 #include "HfstSymbolDefs.h"
@@ -49,6 +50,10 @@ class HarmonizeUnknownAndIdentitySymbols
   // --- const std::string instead
   static const char * identity; // --- a short documentation
   static const char * unknown;  // --- "" ---
+
+  // Symbols as the numbers they are interned as, in the order of the
+  // symbol strings.
+  typedef std::vector<unsigned int> SymbolNumbers;
   
   // Constructor whose side effect it is to harmonize the identity and unknown
   // symbols of its arguments.
@@ -71,11 +76,16 @@ class HarmonizeUnknownAndIdentitySymbols
   // Add all symbols in the StringSet to the alphabet of the transducer.
   HFSTDLL void add_symbols_to_alphabet(HfstBasicTransducer &, const StringSet &);
 
+  // The symbols in the first set that are not in the second one, other
+  // than the identity and unknown symbols.
+  HFSTDLL static SymbolNumbers symbols_missing_from
+    (const StringSet &, const StringSet &);
+
   // For every x in the set, add x:x transitions for every identity:identity
   // transition in the argument transducer (the source and target states as
   // well as the weights are the same as in the original identity transition.
   HFSTDLL void harmonize_identity_symbols
-    (HfstBasicTransducer &,const StringSet &);
+    (HfstBasicTransducer &,const SymbolNumbers &);
 
   // For every x in the set
   // 1. add, x:c transitions for every unknown:c transition in the argument
@@ -88,12 +98,17 @@ class HarmonizeUnknownAndIdentitySymbols
   //
   // (the source and target states as well as the weights are the same as in
   // the original identity transition)
+  //
+  // The transitions are appended to each state at once, after reserving
+  // room for all of them.
   HFSTDLL void harmonize_unknown_symbols
-    (HfstBasicTransducer &,const StringSet &);
+    (HfstBasicTransducer &,const SymbolNumbers &);
 };
 
 HFSTDLL void debug_harmonize_print(const StringSet &);
 HFSTDLL void debug_harmonize_print(const std::string &);
+HFSTDLL void debug_harmonize_print
+  (const HarmonizeUnknownAndIdentitySymbols::SymbolNumbers &);
 // use name 'max_' to avoid collision with windows macro 'max'
 HFSTDLL size_t max_(size_t t1,size_t t2); // --- a short documentation
 
@@ -0,0 +1,370 @@
+// Copyright (c) 2016 University of Helsinki
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+// See the file COPYING included with this distribution for more
+// information.
+
+#include "HfstCompilationCache.h"
+#include "HfstTransducer.h"
+#include "HfstInputStream.h"
+#include "HfstOutputStream.h"
+#include "implementations/HfstBasicTransducer.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#ifdef _MSC_VER
+#include <direct.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifndef MAIN_TEST
+
+namespace hfst
+{
+  using hfst::implementations::HfstBasicTransducer;
+  using hfst::implementations::HfstBasicTransitions;
+  using hfst::implementations::HfstState;
+
+  /* Increase when the way keys are computed changes. */
+  static const long CACHE_FORMAT_VERSION = 1;
+
+  /* How deep \@re"FILE" and \@include"FILE" references are followed. */
+  static const unsigned int MAX_REFERENCE_DEPTH = 16;
+
+  HfstCompilationCache::Key::Key
+  (const std::string & kind, ImplementationType type):
+    first(14695981039346656037ULL), second(0x9e3779b97f4a7c15ULL)
+  {
+    add(CACHE_FORMAT_VERSION);
+#ifdef PACKAGE_VERSION
+    add(std::string("" PACKAGE_VERSION));
+#endif
+    add(kind);
+    add((long)type);
+    add((long)get_encode_weights());
+    add((long)get_minimization());
+    add((long)get_minimization_algorithm());
+    add((long)get_minimize_even_if_already_minimal());
+    add((long)get_xerox_composition());
+    add((long)get_flag_is_epsilon_in_composition());
+    add((long)get_lookahead_composition());
+    add((long)get_harmonize_smaller());
+    add((long)get_unknown_symbols_in_use());
+  }
+
+  void HfstCompilationCache::Key::add_bytes(const char * bytes, size_t length)
+  {
+    // FNV-1a and a multiplicative hash with a different constant
+    for (size_t i = 0; i < length; i++)
+      {
+        unsigned char c = (unsigned char)bytes[i];
+        first = (first ^ c) * 1099511628211ULL;
+        second = (second ^ c) * 0xff51afd7ed558ccdULL;
+        second ^= second >> 32;
+      }
+  }
+
+  HfstCompilationCache::Key &
+  HfstCompilationCache::Key::add(long number)
+  {
+    std::ostringstream oss;
+    oss << number;
+    return add(oss.str());
+  }
+
+  HfstCompilationCache::Key &
+  HfstCompilationCache::Key::add(const std::string & part)
+  {
+    std::ostringstream oss;
+    oss << part.size() << ":";
+    add_bytes(oss.str().c_str(), oss.str().size());
+    add_bytes(part.c_str(), part.size());
+    return *this;
+  }
+
+  bool HfstCompilationCache::Key::add_referenced_files
+  (const std::string & source, const std::string & directory)
+  {
+    return add_referenced_files(source, directory, 0);
+  }
+
+  bool HfstCompilationCache::Key::add_referenced_files
+  (const std::string & source, const std::string & directory,
+   unsigned int depth)
+  {
+    if (depth > MAX_REFERENCE_DEPTH)
+      {
+        return false;
+      }
+    for (size_t at = source.find('@'); at != std::string::npos;
+         at = source.find('@', at + 1))
+      {
+        size_t quote = at + 1;
+        while (quote < source.size() &&
+               source[quote] >= 'a' && source[quote] <= 'z')
+          {
+            ++quote;
+          }
+        if (quote >= source.size() || source[quote] != '"')
+          {
+            continue;
+          }
+        size_t end = source.find('"', quote + 1);
+        if (end == std::string::npos)
+          {
+            continue;
+          }
+        std::string command = source.substr(at, quote - at);
+        std::string name = source.substr(quote + 1, end - quote - 1);
+        if (name.find_first_of("%\\") != std::string::npos)
+          {
+            // The file name would have to be unescaped as the parsers do
+            return false;
+          }
+        std::string path = name;
+        if (directory.size() > 0 && path.size() > 0 && path[0] != '/')
+          {
+            path.insert(0, directory);
+          }
+        std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+        if (! file.good())
+          {
+            return false;
+          }
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        add(command).add(name).add(contents.str());
+        if ((command == "@re" || command == "@include") &&
+            ! add_referenced_files(contents.str(), directory, depth + 1))
+          {
+            return false;
+          }
+      }
+    return true;
+  }
+
+  /* Weights are written exactly, so that only equal weights hash alike. */
+  static std::string weight_to_string(float weight)
+  {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%a", (double)weight);
+    return std::string(buffer);
+  }
+
+  std::string HfstCompilationCache::Key::str() const
+  {
+    char buffer[33];
+    snprintf(buffer, sizeof(buffer), "%016llx%016llx", first, second);
+    return std::string(buffer);
+  }
+
+  HfstCompilationCache::HfstCompilationCache(const std::string & directory_):
+    directory(directory_)
+  {
+#ifdef _MSC_VER
+    _mkdir(directory.c_str());
+#else
+    mkdir(directory.c_str(), 0777);
+#endif
+  }
+
+  const std::string & HfstCompilationCache::get_directory() const
+  {
+    return directory;
+  }
+
+  std::string HfstCompilationCache::filename(const std::string & key) const
+  {
+    return directory + "/" + key + ".hfst";
+  }
+
+  HfstTransducer * HfstCompilationCache::get(const std::string & key) const
+  {
+    HfstTransducerVector transducers;
+    if (! get(key, transducers) || transducers.size() != 1)
+      {
+        return NULL;
+      }
+    return new HfstTransducer(transducers[0]);
+  }
+
+  bool HfstCompilationCache::get
+  (const std::string & key, HfstTransducerVector & transducers) const
+  {
+    std::string name = filename(key);
+    if (! std::ifstream(name.c_str()).good())
+      {
+        return false;
+      }
+    try
+      {
+        HfstInputStream in(name);
+        while (! in.is_eof())
+          {
+            transducers.push_back(HfstTransducer(in));
+          }
+        in.close();
+      }
+    catch (const HfstException &)
+      {
+        // A broken file is as good as none
+        transducers.clear();
+        return false;
+      }
+    return transducers.size() > 0;
+  }
+
+  void HfstCompilationCache::put
+  (const std::string & key, const HfstTransducer & transducer) const
+  {
+    put(key, HfstTransducerVector(1, transducer));
+  }
+
+  void HfstCompilationCache::put
+  (const std::string & key, const HfstTransducerVector & transducers) const
+  {
+    if (transducers.empty())
+      {
+        return;
+      }
+    // Written under a name of its own and renamed, so that a process
+    // reading the cache never sees a partial file
+    std::ostringstream temporary;
+#ifdef _MSC_VER
+    temporary << filename(key) << "." << _getpid() << ".tmp";
+#else
+    temporary << filename(key) << "." << getpid() << ".tmp";
+#endif
+    try
+      {
+        HfstOutputStream out(temporary.str(), transducers[0].get_type());
+        for (HfstTransducerVector::const_iterator it = transducers.begin();
+             it != transducers.end(); it++)
+          {
+            HfstTransducer copy(*it);
+            out << copy;
+          }
+        out.close();
+      }
+    catch (const HfstException &)
+      {
+        remove(temporary.str().c_str());
+        return;
+      }
+    if (rename(temporary.str().c_str(), filename(key).c_str()) != 0)
+      {
+        remove(temporary.str().c_str());
+      }
+  }
+
+  std::string HfstCompilationCache::hash(const HfstTransducer & transducer)
+  {
+    Key key("transducer", transducer.get_type());
+    HfstBasicTransducer basic(transducer);
+    const HfstBasicTransducer::HfstAlphabet & alphabet = basic.get_alphabet();
+    for (HfstBasicTransducer::HfstAlphabet::const_iterator it
+           = alphabet.begin(); it != alphabet.end(); it++)
+      {
+        key.add(*it);
+      }
+    HfstState state = 0;
+    for (HfstBasicTransducer::const_iterator it = basic.begin();
+         it != basic.end(); it++, state++)
+      {
+        key.add("state");
+        if (basic.is_final_state(state))
+          {
+            key.add(weight_to_string(basic.get_final_weight(state)));
+          }
+        for (HfstBasicTransitions::const_iterator tr_it = it->begin();
+             tr_it != it->end(); tr_it++)
+          {
+            key.add(tr_it->get_input_symbol())
+              .add(tr_it->get_output_symbol())
+              .add((long)tr_it->get_target_state())
+              .add(weight_to_string(tr_it->get_weight()));
+          }
+      }
+    return key.str();
+  }
+}
+
+#else // MAIN_TEST was defined
+
+#include <iostream>
+#include <cassert>
+
+using namespace hfst;
+
+int main(int argc, char * argv[])
+{
+    std::cout << "Unit tests for " __FILE__ ":" << std::endl;
+
+    if (! HfstTransducer::is_implementation_type_available
+        (TROPICAL_OPENFST_TYPE))
+      {
+        std::cout << "skipped" << std::endl;
+        return 77;
+      }
+
+    // Keys differ in each part and in how the parts are split
+    std::string ab_c = HfstCompilationCache::Key("xre", TROPICAL_OPENFST_TYPE)
+      .add("ab").add("c").str();
+    std::string a_bc = HfstCompilationCache::Key("xre", TROPICAL_OPENFST_TYPE)
+      .add("a").add("bc").str();
+    assert(ab_c.size() == 32);
+    assert(ab_c != a_bc);
+    assert(ab_c == HfstCompilationCache::Key("xre", TROPICAL_OPENFST_TYPE)
+           .add("ab").add("c").str());
+    assert(ab_c != HfstCompilationCache::Key("lexc", TROPICAL_OPENFST_TYPE)
+           .add("ab").add("c").str());
+    bool xerox = get_xerox_composition();
+    set_xerox_composition(! xerox);
+    assert(ab_c != HfstCompilationCache::Key("xre", TROPICAL_OPENFST_TYPE)
+           .add("ab").add("c").str());
+    set_xerox_composition(xerox);
+
+    // A file that cannot be read makes a source uncacheable
+    HfstCompilationCache::Key key("xre", TROPICAL_OPENFST_TYPE);
+    assert(key.add_referenced_files("a b c", ""));
+    assert(! key.add_referenced_files("@bin\"no/such/file.hfst\"", ""));
+
+    HfstTransducer cat("c", "d", TROPICAL_OPENFST_TYPE);
+    HfstTransducer dog("d", "g", TROPICAL_OPENFST_TYPE);
+    assert(HfstCompilationCache::hash(cat) != HfstCompilationCache::hash(dog));
+    assert(HfstCompilationCache::hash(cat)
+           == HfstCompilationCache::hash(HfstTransducer(cat)));
+
+    HfstCompilationCache cache("hfst-compilation-cache-test");
+    assert(cache.get(ab_c) == NULL);
+    cache.put(ab_c, cat);
+    HfstTransducer * cached = cache.get(ab_c);
+    assert(cached != NULL);
+    assert(cached->compare(cat));
+    delete cached;
+
+    HfstTransducerVector both;
+    both.push_back(cat);
+    both.push_back(dog);
+    cache.put(a_bc, both);
+    HfstTransducerVector stored;
+    assert(cache.get(a_bc, stored));
+    assert(stored.size() == 2);
+    assert(stored[1].compare(dog));
+    assert(cache.get(a_bc) == NULL); // not a single transducer
+
+    remove((cache.get_directory() + "/" + ab_c + ".hfst").c_str());
+    remove((cache.get_directory() + "/" + a_bc + ".hfst").c_str());
+    remove(cache.get_directory().c_str());
+
+    std::cout << "ok" << std::endl;
+    return 0;
+}
+#endif // MAIN_TEST
@@ -0,0 +1,112 @@
+// Copyright (c) 2016 University of Helsinki
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+// See the file COPYING included with this distribution for more
+// information.
+
+#ifndef _HFST_COMPILATION_CACHE_H_
+#define _HFST_COMPILATION_CACHE_H_
+
+#include "HfstDataTypes.h"
+#include <string>
+
+#include "hfstdll.h"
+
+/** @file HfstCompilationCache.h
+    \brief Declaration of class #hfst::HfstCompilationCache. */
+
+namespace hfst
+{
+  /** \brief An on-disk cache of transducers compiled from source text.
+
+      The compilers of regular expressions, xfst scripts, lexc and pmatch
+      can store what they compile in a directory and reuse it in later
+      runs, as long as nothing the result depends on has changed. The
+      results are stored in HFST binary format, one file per #Key.
+
+      The cache is only an optimization: if a file in the directory
+      cannot be read or written, the source is compiled as usual. Warnings
+      that the compiler would print are not printed when a result is
+      found in the cache.
+
+      @see hfst::xre::XreCompiler::set_cache */
+  class HfstCompilationCache
+  {
+  public:
+
+    /** \brief A hash of everything that the result of a compilation
+        depends on.
+
+        Each part is added with its length, so that e.g. "ab" "c" and
+        "a" "bc" give different keys. */
+    class Key
+    {
+    public:
+      /** \brief A key for compiling \a kind source (e.g. "xre" or "lexc")
+          into \a type transducers.
+
+          The version of the library and the global options of
+          HfstTransducer.h that change compilation results, such as
+          #set_encode_weights and #set_xerox_composition, are included. */
+      HFSTDLL Key(const std::string & kind, ImplementationType type);
+
+      HFSTDLL Key & add(const std::string & part);
+      HFSTDLL Key & add(long number);
+
+      /** \brief Add the contents of the files that \a source reads with
+          \@bin"FILE", \@txt"FILE", \@re"FILE" and the like.
+
+          Relative file names are taken relative to \a directory, or to the
+          working directory if \a directory is empty.
+          @return Whether all of the files could be read. */
+      HFSTDLL bool add_referenced_files(const std::string & source,
+                                        const std::string & directory);
+
+      /** \brief The key as 32 hexadecimal digits. */
+      HFSTDLL std::string str() const;
+
+    private:
+      unsigned long long first;
+      unsigned long long second;
+      void add_bytes(const char * bytes, size_t length);
+      bool add_referenced_files(const std::string & source,
+                                const std::string & directory,
+                                unsigned int depth);
+    };
+
+    /** \brief A cache in \a directory, which is created if needed. */
+    HFSTDLL HfstCompilationCache(const std::string & directory);
+
+    HFSTDLL const std::string & get_directory() const;
+
+    /** \brief The transducer stored for \a key, or NULL if there is none.
+        The caller takes ownership. */
+    HFSTDLL HfstTransducer * get(const std::string & key) const;
+
+    /** \brief Set \a transducers to the transducers stored for \a key.
+        @return Whether anything was stored. */
+    HFSTDLL bool get(const std::string & key,
+                     HfstTransducerVector & transducers) const;
+
+    /** \brief Store \a transducer for \a key. */
+    HFSTDLL void put(const std::string & key,
+                     const HfstTransducer & transducer) const;
+
+    /** \brief Store \a transducers for \a key. */
+    HFSTDLL void put(const std::string & key,
+                     const HfstTransducerVector & transducers) const;
+
+    /** \brief A hash of the states, transitions and alphabet of
+        \a transducer, for using a transducer as a part of a #Key. */
+    HFSTDLL static std::string hash(const HfstTransducer & transducer);
+
+  private:
+    std::string directory;
+    std::string filename(const std::string & key) const;
+  };
+}
+
+#endif
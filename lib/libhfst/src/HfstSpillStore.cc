@@ -0,0 +1,251 @@
+// Copyright (c) 2016 University of Helsinki
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+// See the file COPYING included with this distribution for more
+// information.
+
+#include "HfstSpillStore.h"
+#include "HfstTransducer.h"
+#include "HfstInputStream.h"
+#include "HfstOutputStream.h"
+#include "HfstExceptionDefs.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <sys/stat.h>
+#ifdef _MSC_VER
+#include <direct.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+
+#ifndef MAIN_TEST
+
+namespace hfst
+{
+  /* The directory gets a name no other process can guess beforehand,
+     so that nobody can create it first or link files into it. */
+  static std::string make_directory(const std::string & parent)
+  {
+    std::string prefix
+      = (parent.empty() ? std::string(".") : parent) + "/hfst-spill-";
+#ifdef _MSC_VER
+    // There is no mkdtemp, so try random names until one is free.
+    static unsigned int stores_created = 0;
+    for (unsigned int attempt = 0; attempt < 100; attempt++)
+      {
+        std::ostringstream name;
+        name << prefix << _getpid() << "-" << stores_created++
+             << "-" << rand();
+        if (_mkdir(name.str().c_str()) == 0)
+          { return name.str(); }
+        if (errno != EEXIST)
+          { break; }
+      }
+    HFST_THROW_MESSAGE(HfstException, "could not create a directory in "
+                       + prefix);
+#else
+    std::vector<char> name(prefix.begin(), prefix.end());
+    name.insert(name.end(), 6, 'X');
+    name.push_back('\0');
+    if (mkdtemp(&name[0]) == NULL)
+      {
+        HFST_THROW_MESSAGE(HfstException, "could not create directory "
+                           + std::string(&name[0]));
+      }
+    return std::string(&name[0]);
+#endif
+  }
+
+  HfstSpillStore::HfstSpillStore
+  (const std::string & directory_, unsigned int min_states_):
+    directory(make_directory(directory_)), min_states(min_states_),
+    next_id(0), total_size(0)
+  {}
+
+  HfstSpillStore::~HfstSpillStore()
+  {
+    for (std::map<Id, unsigned long long>::const_iterator it
+           = file_sizes.begin(); it != file_sizes.end(); it++)
+      {
+        ::remove(filename(it->first).c_str());
+      }
+#ifdef _MSC_VER
+    _rmdir(directory.c_str());
+#else
+    rmdir(directory.c_str());
+#endif
+  }
+
+  const std::string & HfstSpillStore::get_directory() const
+  {
+    return directory;
+  }
+
+  std::string HfstSpillStore::filename(Id id) const
+  {
+    std::ostringstream oss;
+    oss << directory << "/" << id << ".hfst";
+    return oss.str();
+  }
+
+  bool HfstSpillStore::is_worth_storing(const HfstTransducer & transducer) const
+  {
+    return transducer.number_of_states() >= min_states;
+  }
+
+  HfstSpillStore::Id HfstSpillStore::put(const HfstTransducer & transducer)
+  {
+    Id id = next_id++;
+    std::string name = filename(id);
+    try
+      {
+        HfstOutputStream out(name, transducer.get_type());
+        // Writing only reads the transducer
+        out << const_cast<HfstTransducer &>(transducer);
+        out.close();
+      }
+    catch (const HfstException &)
+      {
+        ::remove(name.c_str());
+        HFST_THROW_MESSAGE(HfstException, "could not write " + name);
+      }
+    struct stat st;
+    unsigned long long size =
+      (stat(name.c_str(), &st) == 0) ? (unsigned long long)st.st_size : 0;
+    file_sizes[id] = size;
+    total_size += size;
+    return id;
+  }
+
+  HfstTransducer * HfstSpillStore::get(Id id) const
+  {
+    HfstInputStream in(filename(id));
+    HfstTransducer * transducer = new HfstTransducer(in);
+    in.close();
+    return transducer;
+  }
+
+  void HfstSpillStore::remove(Id id)
+  {
+    std::map<Id, unsigned long long>::iterator it = file_sizes.find(id);
+    if (it == file_sizes.end())
+      {
+        return;
+      }
+    ::remove(filename(id).c_str());
+    total_size -= it->second;
+    file_sizes.erase(it);
+  }
+
+  size_t HfstSpillStore::size() const
+  {
+    return file_sizes.size();
+  }
+
+  unsigned long long HfstSpillStore::bytes() const
+  {
+    return total_size;
+  }
+
+  unsigned long long get_resident_memory()
+  {
+#if defined(__linux__)
+    // The second field is the resident set size in pages
+    std::ifstream statm("/proc/self/statm");
+    unsigned long long total = 0, resident = 0;
+    if (statm >> total >> resident)
+      {
+        return resident * (unsigned long long)sysconf(_SC_PAGESIZE);
+      }
+    return 0;
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                  (task_info_t)&info, &count) == KERN_SUCCESS)
+      {
+        return (unsigned long long)info.resident_size;
+      }
+    return 0;
+#else
+    return 0;
+#endif
+  }
+}
+
+#else // MAIN_TEST was defined
+
+#include <iostream>
+#include <cassert>
+
+using namespace hfst;
+
+int main(int argc, char * argv[])
+{
+    std::cout << "Unit tests for " __FILE__ ":" << std::endl;
+
+    if (! HfstTransducer::is_implementation_type_available
+        (TROPICAL_OPENFST_TYPE))
+      {
+        std::cout << "skipped" << std::endl;
+        return 77;
+      }
+
+    HfstTransducer cat("c", "d", TROPICAL_OPENFST_TYPE);
+    HfstTransducer dog("d", "g", TROPICAL_OPENFST_TYPE);
+    dog.set_name("dog");
+
+    std::string directory;
+    {
+      HfstSpillStore store(".", 2);
+      directory = store.get_directory();
+      assert(store.is_worth_storing(cat));
+      assert(! store.is_worth_storing(HfstTransducer(TROPICAL_OPENFST_TYPE)));
+
+      HfstSpillStore::Id cat_id = store.put(cat);
+      HfstSpillStore::Id dog_id = store.put(dog);
+      assert(cat_id != dog_id);
+      assert(store.size() == 2);
+      assert(store.bytes() > 0);
+
+      // A transducer can be read any number of times
+      for (int i = 0; i < 2; i++)
+        {
+          HfstTransducer * stored = store.get(dog_id);
+          assert(stored->compare(dog));
+          assert(stored->get_name() == "dog");
+          delete stored;
+        }
+
+      unsigned long long bytes = store.bytes();
+      store.remove(cat_id);
+      assert(store.size() == 1);
+      assert(store.bytes() < bytes);
+      store.remove(cat_id);
+      assert(store.size() == 1);
+
+      // Two stores do not share a directory
+      HfstSpillStore other(".");
+      assert(other.get_directory() != directory);
+    }
+    // The files and the directory are removed with the store
+    assert(! std::ifstream((directory + "/1.hfst").c_str()).good());
+    struct stat st;
+    assert(stat(directory.c_str(), &st) != 0);
+
+    std::cout << "ok" << std::endl;
+    return 0;
+}
+#endif // MAIN_TEST
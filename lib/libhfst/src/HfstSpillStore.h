@@ -0,0 +1,90 @@
+// Copyright (c) 2016 University of Helsinki
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+// See the file COPYING included with this distribution for more
+// information.
+
+#ifndef _HFST_SPILL_STORE_H_
+#define _HFST_SPILL_STORE_H_
+
+#include "HfstDataTypes.h"
+#include <string>
+#include <map>
+
+#include "hfstdll.h"
+
+/** @file HfstSpillStore.h
+    \brief Declaration of class #hfst::HfstSpillStore. */
+
+namespace hfst
+{
+  /** \brief A temporary directory where transducers that are not in use
+      are kept outside memory.
+
+      Each transducer is written in HFST binary format in a file of its
+      own and read back when it is needed again. The files and the
+      directory are removed when the store is destroyed.
+
+      The xfst compiler uses a store for the transducers on its stack
+      below the topmost one and for its definitions.
+
+      @see hfst::xfst::XfstCompiler::setSpillStore */
+  class HfstSpillStore
+  {
+  public:
+
+    /** \brief The number under which a transducer is stored. */
+    typedef unsigned int Id;
+
+    /** \brief A store in a new directory under \a directory. Transducers
+        with fewer than \a min_states states are not worth storing.
+        @throws HfstException if the directory cannot be created. */
+    HFSTDLL HfstSpillStore(const std::string & directory,
+                           unsigned int min_states=1000);
+    HFSTDLL ~HfstSpillStore();
+
+    /** \brief The directory where the transducers are stored. */
+    HFSTDLL const std::string & get_directory() const;
+
+    /** \brief Whether \a transducer is large enough to be stored. */
+    HFSTDLL bool is_worth_storing(const HfstTransducer & transducer) const;
+
+    /** \brief Store \a transducer.
+        @return The number under which it is stored.
+        @throws HfstException if the file cannot be written. */
+    HFSTDLL Id put(const HfstTransducer & transducer);
+
+    /** \brief A copy of the transducer stored as \a id. The caller takes
+        ownership. The transducer remains in the store. */
+    HFSTDLL HfstTransducer * get(Id id) const;
+
+    /** \brief Remove the transducer stored as \a id. */
+    HFSTDLL void remove(Id id);
+
+    /** \brief The number of transducers stored. */
+    HFSTDLL size_t size() const;
+
+    /** \brief The size of the stored transducers in bytes. */
+    HFSTDLL unsigned long long bytes() const;
+
+  private:
+    std::string directory;
+    unsigned int min_states;
+    Id next_id;
+    std::map<Id, unsigned long long> file_sizes;
+    unsigned long long total_size;
+    std::string filename(Id id) const;
+
+    HfstSpillStore(const HfstSpillStore &);
+    HfstSpillStore & operator=(const HfstSpillStore &);
+  };
+
+  /** \brief The resident memory of the running process in bytes, or 0 if
+      it is not known on this platform. */
+  HFSTDLL unsigned long long get_resident_memory();
+}
+
+#endif
@@ -85,6 +85,10 @@ namespace hfst
   /* By default, we do not minimize transducers that are already minimal.
      This variable is for debugging and profiling. */
   bool minimize_even_if_already_minimal=false;
+  /* By default, minimization runs on one thread. */
+  unsigned int minimization_jobs=1;
+  /* By default, compose_intersect runs on one thread. */
+  unsigned int compose_intersect_jobs=1;
   /* By default, weights are not encoded in minimization. */
   bool encode_weights=false;
   /* Allow minimization of intermediary results, used in some more complex functions.
@@ -99,6 +103,8 @@ namespace hfst
   bool xerox_composition=false;
   /* Xerox option where flag diacritic are treated as epsilons in composition. */
   bool flag_is_epsilon_in_composition=false;
+  /* Label-lookahead composition of tropical OpenFst transducers. */
+  bool lookahead_composition=false;
 
   void set_xerox_composition(bool value) {
     xerox_composition=value;
@@ -108,6 +114,14 @@ namespace hfst
     return xerox_composition;
   }
 
+  void set_lookahead_composition(bool value) {
+    lookahead_composition=value;
+  }
+
+  bool get_lookahead_composition() {
+    return lookahead_composition;
+  }
+
   void set_minimization(bool value) {
     can_minimize=value;
   }
@@ -195,6 +209,23 @@ void set_minimization_algorithm(MinimizationAlgorithm a) {
 MinimizationAlgorithm get_minimization_algorithm() {
     return minimization_algorithm; }
 
+void set_minimization_jobs(unsigned int jobs) {
+    minimization_jobs = (jobs == 0) ? 1 : jobs;
+#if HAVE_OPENFST
+    hfst::implementations::openfst_tropical_set_minimization_jobs
+      (minimization_jobs);
+#endif
+}
+
+unsigned int get_minimization_jobs() {
+    return minimization_jobs; }
+
+void set_compose_intersect_jobs(unsigned int jobs) {
+    compose_intersect_jobs = (jobs == 0) ? 1 : jobs; }
+
+unsigned int get_compose_intersect_jobs() {
+    return compose_intersect_jobs; }
+
 void set_unknown_symbols_in_use(bool value) {
     unknown_symbols_in_use=value; }
 
@@ -694,33 +725,110 @@ HfstOneLevelPaths * HfstTransducer::lookup(const HfstTokenizer& tok,
 }
 
 HfstOneLevelPaths * HfstTransducer::lookdown(const StringVector& s,
-                         ssize_t limit) const {
-    (void)s;
-    (void)limit;
-    HFST_THROW(FunctionNotImplementedException);
+                         ssize_t limit, double time_cutoff) const {
+    StringVector sv(s);
+    return lookdown_fd(sv, limit, time_cutoff);
 }
 
 HfstOneLevelPaths * HfstTransducer::lookdown_fd(StringVector& s,
-                        ssize_t limit) const {
-    (void)s;
-    (void)limit;
-    HFST_THROW(FunctionNotImplementedException);
+                        ssize_t limit, double time_cutoff) const {
+    switch(this->type) {
+
+    case (HFST_OL_TYPE):
+    case (HFST_OLW_TYPE):
+        return this->implementation.hfst_ol->lookdown_fd(s, limit, time_cutoff);
+
+    case (ERROR_TYPE):
+      HFST_THROW(TransducerHasWrongTypeException);
+    default:
+      HFST_THROW(FunctionNotImplementedException);
+    }
 }
 
   HfstOneLevelPaths * HfstTransducer::lookdown(const std::string& s,
-                         ssize_t limit) const {
-    (void)s;
-    (void)limit;
-    HFST_THROW(FunctionNotImplementedException);
+                         ssize_t limit, double time_cutoff) const {
+    return lookdown_fd(s, limit, time_cutoff);
 }
 
   HfstOneLevelPaths * HfstTransducer::lookdown_fd(const std::string& s,
-                        ssize_t limit) const {
-    (void)s;
-    (void)limit;
-    HFST_THROW(FunctionNotImplementedException);
+                        ssize_t limit, double time_cutoff) const {
+    switch(this->type) {
+
+    case (HFST_OL_TYPE):
+    case (HFST_OLW_TYPE):
+        return this->implementation.hfst_ol->lookdown_fd(s, limit, time_cutoff);
+
+    case (ERROR_TYPE):
+      HFST_THROW(TransducerHasWrongTypeException);
+    default:
+      HFST_THROW(FunctionNotImplementedException);
+    }
+}
+
+
+HfstOneLevelPaths * HfstTransducer::lookup_cascade
+(const std::vector<HfstTransducer> & cascade, const StringVector& s,
+ ssize_t limit, double time_cutoff) {
+    std::string input_str;
+    for (StringVector::const_iterator it = s.begin(); it != s.end(); ++it) {
+        input_str.append(*it);
+    }
+    return lookup_cascade(cascade, input_str, limit, time_cutoff);
+}
+
+HfstOneLevelPaths * HfstTransducer::lookup_cascade
+(const std::vector<HfstTransducer> & cascade, const std::string& s,
+ ssize_t limit, double time_cutoff) {
+    hfst_ol::TransducerCascade levels(cascade_levels(cascade));
+    return levels.lookup_fd(s, limit, time_cutoff);
 }
 
+hfst_ol::TransducerCascade * HfstTransducer::create_lookup_cascade
+(const std::vector<HfstTransducer> & cascade) {
+    return new hfst_ol::TransducerCascade(cascade_levels(cascade));
+}
+
+hfst_ol::Transducer * HfstTransducer::create_lookup_copy() const
+{
+    switch(this->type) {
+    case (HFST_OL_TYPE):
+    case (HFST_OLW_TYPE):
+        return this->implementation.hfst_ol->copy_for_lookup();
+    case (ERROR_TYPE):
+      HFST_THROW(TransducerHasWrongTypeException);
+    default:
+      HFST_THROW(FunctionNotImplementedException);
+    }
+}
+
+bool HfstTransducer::is_cascade_lookup_infinitely_ambiguous
+(const std::vector<HfstTransducer> & cascade, const StringVector& s) {
+    std::string input_str;
+    for (StringVector::const_iterator it = s.begin(); it != s.end(); ++it) {
+        input_str.append(*it);
+    }
+    hfst_ol::TransducerCascade levels(cascade_levels(cascade));
+    return levels.is_lookup_infinitely_ambiguous(input_str);
+}
+
+std::vector<hfst_ol::Transducer *> HfstTransducer::cascade_levels
+(const std::vector<HfstTransducer> & cascade) {
+    std::vector<hfst_ol::Transducer *> levels;
+    for (std::vector<HfstTransducer>::const_iterator it = cascade.begin();
+         it != cascade.end(); ++it) {
+        switch(it->type) {
+        case (HFST_OL_TYPE):
+        case (HFST_OLW_TYPE):
+            levels.push_back(it->implementation.hfst_ol);
+            break;
+        case (ERROR_TYPE):
+            HFST_THROW(TransducerHasWrongTypeException);
+        default:
+            HFST_THROW(FunctionNotImplementedException);
+        }
+    }
+    return levels;
+}
 
 bool HfstTransducer::is_lookup_infinitely_ambiguous(const StringVector& s)
     const {
@@ -753,7 +861,14 @@ bool HfstTransducer::is_lookup_infinitely_ambiguous(const std::string & s)
 bool HfstTransducer::is_lookdown_infinitely_ambiguous
 (const StringVector& s) const {
     (void)s;
+    switch(this->type) {
+    case (HFST_OL_TYPE):
+    case (HFST_OLW_TYPE):
+    return this->implementation.hfst_ol->
+        is_lookdown_infinitely_ambiguous();
+    default:
     HFST_THROW(FunctionNotImplementedException);
+    }
 }
 
 bool HfstTransducer::is_infinitely_ambiguous()
@@ -2527,6 +2642,15 @@ int HfstTransducer::longest_path_size(bool obey_flags) const
       HFST_THROW(TransducerIsCyclicException);
     }
 
+  if (! obey_flags && ConversionFunctions::has_csr_conversion(this->type))
+    {
+      hfst::implementations::CsrTransducer * csr =
+        ConversionFunctions::hfst_transducer_to_csr(*this);
+      int size = csr->longest_path_size();
+      delete csr;
+      return size;
+    }
+
   if (! obey_flags)
     {
       HfstBasicTransducer net(*this);
@@ -4026,7 +4150,8 @@ HfstTransducer &HfstTransducer::compose
     fst::StdVectorFst * tropical_ofst_temp =
             this->tropical_ofst_interface.compose
         (this->implementation.tropical_ofst,
-         another_copy->implementation.tropical_ofst);
+         another_copy->implementation.tropical_ofst,
+         lookahead_composition);
     tropical_ofst_interface.delete_transducer(implementation.tropical_ofst);
     implementation.tropical_ofst = tropical_ofst_temp;
     break;
@@ -4623,7 +4748,7 @@ HfstTransducer &HfstTransducer::compose_intersect
       implementations::ComposeIntersectLexicon lexicon(*harmonized_lexicon);
       
       hfst::implementations::HfstBasicTransducer res =
-        lexicon.compose_with_rules(&rule);
+        lexicon.compose_with_rules(&rule,compose_intersect_jobs);
       
       res.prune_alphabet();
       *this = HfstTransducer(res,type);
@@ -4687,7 +4812,7 @@ HfstTransducer &HfstTransducer::compose_intersect
         // Create a ComposeIntersectLexicon from *this.
         implementations::ComposeIntersectLexicon lexicon(*harmonized_lexicon);
         hfst::implementations::HfstBasicTransducer res =
-          lexicon.compose_with_rules(rules);
+          lexicon.compose_with_rules(rules,compose_intersect_jobs);
         
         res.prune_alphabet();
         *this = HfstTransducer(res,type);
@@ -5032,6 +5157,13 @@ HfstTransducer &HfstTransducer::convert(const HfstTransducer &t,
       throw ImplementationTypeNotAvailableException("HfstTransducer::convert", __FILE__, __LINE__, type);
     }
 
+    if (ConversionFunctions::has_direct_conversion(t.type, type))
+    {
+        HfstTransducer * retval = new HfstTransducer(t);
+        retval->convert(type);
+        return *retval;
+    }
+
     hfst::implementations::HfstBasicTransducer net(t);
 
     HfstTransducer * retval = new HfstTransducer(net, type);
@@ -5122,6 +5254,63 @@ HfstTransducer &HfstTransducer::convert(ImplementationType type,
       throw ImplementationTypeNotAvailableException("HfstTransducer::convert", __FILE__, __LINE__, type);
     }
 
+    /* Conversions between some formats go through a compact numeric
+       transducer, which is much cheaper than HfstBasicTransducer. */
+    if (ConversionFunctions::has_direct_conversion(this->type, type))
+      {
+        hfst::implementations::CsrTransducer * csr = NULL;
+        switch (this->type)
+          {
+#if HAVE_FOMA
+          case FOMA_TYPE:
+            csr = ConversionFunctions::foma_to_csr(implementation.foma);
+            foma_interface.delete_foma(implementation.foma);
+            break;
+#endif
+#if HAVE_OPENFST
+          case TROPICAL_OPENFST_TYPE:
+            csr = ConversionFunctions::tropical_ofst_to_csr
+              (implementation.tropical_ofst);
+            tropical_ofst_interface.delete_transducer
+              (implementation.tropical_ofst);
+            break;
+          case HFST_OL_TYPE:
+          case HFST_OLW_TYPE:
+            csr = ConversionFunctions::hfst_ol_to_csr(implementation.hfst_ol);
+            delete implementation.hfst_ol;
+            break;
+#endif
+          default:
+            HFST_THROW(TransducerHasWrongTypeException);
+          }
+        this->type = type;
+        switch (this->type)
+          {
+#if HAVE_FOMA
+          case FOMA_TYPE:
+            implementation.foma = ConversionFunctions::csr_to_foma(csr);
+            break;
+#endif
+#if HAVE_OPENFST
+          case TROPICAL_OPENFST_TYPE:
+            implementation.tropical_ofst =
+              ConversionFunctions::csr_to_tropical_ofst(csr);
+            break;
+          case HFST_OL_TYPE:
+          case HFST_OLW_TYPE:
+            implementation.hfst_ol =
+              ConversionFunctions::csr_to_hfst_ol
+              (csr, this->type==HFST_OLW_TYPE?true:false, options);
+            break;
+#endif
+          default:
+            delete csr;
+            HFST_THROW(TransducerHasWrongTypeException);
+          }
+        delete csr;
+        return *this;
+      }
+
     hfst::implementations::HfstBasicTransducer * internal=NULL;
     switch (this->type)
       {
@@ -5295,6 +5484,14 @@ void HfstTransducer::write_in_att_format
   if (this->type == XFSM_TYPE)
     HFST_THROW(FunctionNotImplementedException);
 #endif
+    if (ConversionFunctions::has_csr_conversion(this->type))
+      {
+        hfst::implementations::CsrTransducer * csr =
+          ConversionFunctions::hfst_transducer_to_csr(*this);
+        csr->write_in_att_format(ofile, print_weights);
+        delete csr;
+        return;
+      }
     // Implemented only for internal transducer format.
     hfst::implementations::HfstBasicTransducer net(*this);
     net.write_in_att_format(ofile, print_weights);
@@ -5792,13 +5989,21 @@ std::ostream & operator<<
   if (t.type == XFSM_TYPE)
     HFST_THROW(FunctionNotImplementedException);
 #endif
-    // Implemented only for internal transducer format.
-    hfst::implementations::HfstBasicTransducer net(t);
     bool write_weights;
     if (t.type == SFST_TYPE || t.type == FOMA_TYPE)
     write_weights=false;
     else
     write_weights=true;
+    if (ConversionFunctions::has_csr_conversion(t.type))
+      {
+        hfst::implementations::CsrTransducer * csr =
+          ConversionFunctions::hfst_transducer_to_csr(t);
+        csr->write_in_att_format(out, write_weights);
+        delete csr;
+        return out;
+      }
+    // Implemented only for internal transducer format.
+    hfst::implementations::HfstBasicTransducer net(t);
     net.write_in_att_format(out, write_weights);
     return out;
 }
@@ -47,6 +47,7 @@
 //#endif
 
 #include "implementations/HfstOlTransducer.h"
+#include "implementations/optimized-lookup/cascade.h"
 #include "HfstTokenizer.h"
 #include "implementations/ConvertTransducerFormat.h"
 #include "HfstExceptionDefs.h"
@@ -128,6 +129,19 @@ namespace hfst
   HFSTDLL void set_minimization_algorithm(MinimizationAlgorithm);
   HFSTDLL MinimizationAlgorithm get_minimization_algorithm();
 
+  /* How many threads determinization and minimization of tropical OpenFst
+     transducers use. With more than one, the result is the same for any
+     number of threads, but its states may be numbered differently than
+     with one. The other implementation types ignore this. Defaults to 1. */
+  HFSTDLL void set_minimization_jobs(unsigned int);
+  HFSTDLL unsigned int get_minimization_jobs();
+
+  /* How many threads compose_intersect uses to compute the states of the
+     result. The result is the same for any number of threads. Defaults
+     to 1. */
+  HFSTDLL void set_compose_intersect_jobs(unsigned int);
+  HFSTDLL unsigned int get_compose_intersect_jobs();
+
   /* Whether weights are encoded as part of transition in weighted minimization. Defaults to false. */
   HFSTDLL void set_encode_weights(bool);
   HFSTDLL bool get_encode_weights();
@@ -148,6 +162,15 @@ namespace hfst
   HFSTDLL void set_flag_is_epsilon_in_composition(bool);
   HFSTDLL bool get_flag_is_epsilon_in_composition();
 
+  /* Whether composition of tropical OpenFst transducers uses label-lookahead
+     matchers, so that states with no way forward are not built at all.
+     Saves memory when composing a big lexicon with rules. The result has
+     the same paths and weights as without lookahead, but the epsilons of a
+     path may be aligned differently. The other implementation types ignore
+     this. Defaults to false. */
+  HFSTDLL void set_lookahead_composition(bool);
+  HFSTDLL bool get_lookahead_composition();
+
   /* Whether in harmonization the smaller transducer is always harmonized
      according to the bigger transducer. Defaults to true. */
   HFSTDLL void set_harmonize_smaller(bool);
@@ -401,6 +424,12 @@ An example:
     static HfstTransducer &convert
       (const HfstTransducer &t, ImplementationType type);
 
+    /* For internal use: The optimized-lookup implementations of the
+       transducers in \a cascade, which must all be of type
+       #HFST_OL_TYPE or #HFST_OLW_TYPE. */
+    static std::vector<hfst_ol::Transducer *> cascade_levels
+      (const std::vector<HfstTransducer> &cascade);
+
     /* For internal use:
        Create an HfstBasicTransducer equivalent to \a t end delete
        the backend implementation of \a t. */
@@ -1160,39 +1189,48 @@ ccc : ddd
         const std::string &s, ssize_t limit = -1,
         double time_cutoff = 0.0) const;
 
-    //! @brief (Not implemented) Lookdown a single string \a s and return
+    //! @brief Lookdown a single string \a s and return
     //! a maximum of \a limit results.
     //!
     //! Traverse all paths on logical second level of the transducer to produce
     //! all possible inputs on the first.
     //! This is in effect a fast composition of single
-    //! path from left hand side.
+    //! path from right hand side, i.e. lookup in the inverted transducer.
+    //! Currently, this function calls lookdown_fd.
+    //!
+    //! @pre The transducer must be of type #HFST_OL_TYPE or #HFST_OLW_TYPE.
+    //!      This function is not implemented for other transducer types.
     //!
     //! @param s  string to look down
-    //! <!-- @param tok  tokenizer to split string in arcs? -->
     //! @param limit  number of strings to extract. -1 tries to extract all and
     //!             may get stuck if infinitely ambiguous
-    //! @return  output parameter to store unique results
-    //! @todo todo
+    //! @param time_cutoff Number of seconds that can pass before lookdown is stopped.
+    //! \return{A pointer to a HfstOneLevelPaths container allocated by callee}
+    //! @sa lookdown_fd
     HFSTDLL HfstOneLevelPaths * lookdown(const StringVector& s,
-                 ssize_t limit = -1) const;
+                 ssize_t limit = -1, double time_cutoff = 0.0) const;
 
     HFSTDLL HfstOneLevelPaths * lookdown(const std::string& s,
-                 ssize_t limit = -1) const;
+                 ssize_t limit = -1, double time_cutoff = 0.0) const;
 
-    //! @brief (Not implemented) Lookdown a single string minding
-    //! flag diacritics properly.
+    //! @brief Lookdown a single string minding flag diacritics properly.
     //!
     //! This is a version of lookdown that handles flag diacritics as epsilons
-    //! and validates the sequences prior to outputting.
+    //! and validates the sequences prior to outputting. The string is
+    //! tokenized using the output symbols of the transducer. The first call
+    //! indexes the transitions of the transducer by output symbol, so
+    //! generation doesn't need a separate inverted transducer.
+    //!
+    //! @pre The transducer must be of type #HFST_OL_TYPE or #HFST_OLW_TYPE.
+    //!      This function is not implemented for other transducer types.
     //!
     //! @sa lookdown
-    //! @todo todo
+    //! @sa lookup_fd
     HFSTDLL HfstOneLevelPaths * lookdown_fd(StringVector& s,
-                    ssize_t limit = -1) const;
+                    ssize_t limit = -1, double time_cutoff = 0.0) const;
 
     HFSTDLL HfstOneLevelPaths * lookdown_fd(const std::string& s,
-                    ssize_t limit = -1) const;
+                    ssize_t limit = -1, double time_cutoff = 0.0) const;
 
     //! @brief Whether lookup of path \a s will have infinite results.
     //!
@@ -1204,11 +1242,90 @@ ccc : ddd
     HFSTDLL bool is_lookup_infinitely_ambiguous(const StringVector & s) const;
     HFSTDLL bool is_lookup_infinitely_ambiguous(const std::string & s) const;
 
-    //! @brief (Not implemented) Whether lookdown of path \a s will have
-    //! infinite results.
-    //! @todo todo
+    //! @brief Whether lookdown of path \a s may have infinite results.
+    //!
+    //! This function returns whether the transducer has a cycle of
+    //! transitions with epsilon or flag diacritic outputs, i.e. the
+    //! argument \a s is ignored.
+    //!
+    //! @pre The transducer must be of type #HFST_OL_TYPE or #HFST_OLW_TYPE.
     HFSTDLL bool is_lookdown_infinitely_ambiguous(const StringVector& s) const;
 
+    //! @brief Lookup \a s through the composition of the transducers
+    //! in \a cascade and return a maximum of \a limit results.
+    //!
+    //! The composition is not built: the transducers are traversed in
+    //! step, each output symbol of one being matched against the input
+    //! of the next as it is produced, so a cascade stored as separate
+    //! transducers is looked up almost as fast as the composed transducer.
+    //! The results are the outputs of the last transducer, weighted by
+    //! the sum of the weights on all transducers. Each transducer handles
+    //! its own flag diacritics as in lookup_fd, and flag diacritics are
+    //! not passed on to the next transducer. The string is tokenized
+    //! using the input symbols of the first transducer.
+    //!
+    //! @pre The transducers must be of type #HFST_OL_TYPE or #HFST_OLW_TYPE.
+    //!      This function is not implemented for other transducer types.
+    //!
+    //! @param cascade  the transducers, first one applied first
+    //! @param s  string to look up
+    //! @param limit  number of strings to extract. -1 tries to extract all and
+    //!             may get stuck if infinitely ambiguous
+    //! @param time_cutoff Number of seconds that can pass before lookup is stopped.
+    //! \return{A pointer to a HfstOneLevelPaths container allocated by callee}
+    //!
+    //! The symbols matched between the transducers are cached in a
+    //! cascade object that only lives for this call. To look up many
+    //! strings, create the object once with create_lookup_cascade and
+    //! call its lookup_fd for each string.
+    //!
+    //! @sa lookup_fd, create_lookup_cascade
+    HFSTDLL static HfstOneLevelPaths * lookup_cascade
+      (const std::vector<HfstTransducer> &cascade, const StringVector& s,
+       ssize_t limit = -1, double time_cutoff = 0.0);
+
+    HFSTDLL static HfstOneLevelPaths * lookup_cascade
+      (const std::vector<HfstTransducer> &cascade, const std::string& s,
+       ssize_t limit = -1, double time_cutoff = 0.0);
+
+    //! @brief Create an object for looking up strings through the
+    //! composition of the transducers in \a cascade as in lookup_cascade.
+    //!
+    //! The object keeps the symbols matched between the transducers
+    //! from one lookup to the next, so it is faster than lookup_cascade
+    //! when many strings are looked up. The transducers in \a cascade
+    //! are used, not copied, and must not be changed or destroyed while
+    //! the object is in use. The object is allocated with new and must be
+    //! deleted by the caller.
+    //!
+    //! @pre The transducers must be of type #HFST_OL_TYPE or #HFST_OLW_TYPE.
+    //! @sa lookup_cascade
+    HFSTDLL static hfst_ol::TransducerCascade * create_lookup_cascade
+      (const std::vector<HfstTransducer> &cascade);
+
+    //! @brief Create an object for looking up strings in this transducer
+    //! in another thread.
+    //!
+    //! Lookup keeps its state in the transducer, so two threads cannot look
+    //! up strings in the same transducer at once. The object has a lookup
+    //! state of its own but shares the transition tables with this
+    //! transducer, which must not be changed or destroyed while the object
+    //! is in use. The object is allocated with new and must be deleted by
+    //! the caller.
+    //!
+    //! @pre The transducer must be of type #HFST_OL_TYPE or #HFST_OLW_TYPE.
+    HFSTDLL hfst_ol::Transducer * create_lookup_copy() const;
+
+    //! @brief Whether lookup_cascade of \a s may have infinite results.
+    //!
+    //! The first transducer is checked as in
+    //! is_lookup_infinitely_ambiguous and the others for any cycle of
+    //! transitions with epsilon or flag diacritic inputs.
+    //!
+    //! @pre The transducers must be of type #HFST_OL_TYPE or #HFST_OLW_TYPE.
+    HFSTDLL static bool is_cascade_lookup_infinitely_ambiguous
+      (const std::vector<HfstTransducer> &cascade, const StringVector& s);
+
     HFSTDLL bool is_infinitely_ambiguous() const ;
 
 
@@ -1325,7 +1442,10 @@ ccc : ddd
 	that flag diacritics are treated as ordinary symbols. */
     HFSTDLL HfstTransducer &negate();
     
-    /** \brief Compose this transducer with \a another. */
+    /** \brief Compose this transducer with \a another.
+
+        @see set_xerox_composition, set_flag_is_epsilon_in_composition,
+        set_lookahead_composition */
     HFSTDLL HfstTransducer &compose(const HfstTransducer &another,
                             bool harmonize=true);
 
@@ -333,6 +333,158 @@ namespace hfst { namespace implementations
     return net;
   }
 
+
+  /* ------------------------------------------------------------------------
+
+     Create a CsrTransducer equivalent to foma transducer \a t.
+
+     ------------------------------------------------------------------------ */
+
+  /* Get the number of the symbol with common number \a number in \a h,
+     adding the symbol to \a h if needed. \a foma_numbers caches the
+     numbers, -1 standing for not yet known. */
+  static int get_foma_number(struct fsm_construct_handle * h,
+                             std::vector<int> & foma_numbers,
+                             unsigned int number)
+  {
+    if (number >= foma_numbers.size())
+      foma_numbers.resize(number + 1, -1);
+    if (foma_numbers[number] == -1)
+      {
+        std::string symbol = ConversionFunctions::get_string(number);
+        char * s = const_cast<char*>(symbol.c_str());
+        int foma_number = fsm_construct_check_symbol(h, s);
+        if (foma_number == -1)
+          foma_number = fsm_construct_add_symbol(h, s);
+        foma_numbers[number] = foma_number;
+      }
+    return foma_numbers[number];
+  }
+
+  CsrTransducer * ConversionFunctions::foma_to_csr(fsm * t)
+  {
+    StringVector symbol_vector = FomaTransducer::get_symbol_vector(t);
+    NumberVector harmonization_vector = get_harmonization_vector(symbol_vector);
+
+    CsrTransducer * csr = new CsrTransducer();
+    csr->alphabet.push_back(get_number(internal_epsilon));
+    csr->alphabet.push_back(get_number(internal_unknown));
+    csr->alphabet.push_back(get_number(internal_identity));
+    for (struct sigma * p = t->sigma; p != NULL && p->symbol != NULL;
+         p = p->next)
+      csr->alphabet.push_back(get_number(std::string(p->symbol)));
+    csr->sort_alphabet();
+
+    // Find the number of states and the start state
+    struct fsm_state * fsm = t->states;
+    int start_state_id = -1;
+    bool start_state_found = false;
+    int max_state = 0;
+    size_t number_of_arcs = 0;
+    for (int i=0; (fsm+i)->state_no != -1; i++) {
+      if ((fsm+i)->start_state == 1) {
+        handle_start_state(fsm+i, start_state_id, start_state_found);
+      }
+      if ((fsm+i)->state_no > max_state)
+        max_state = (fsm+i)->state_no;
+      if ((fsm+i)->target != -1) {
+        number_of_arcs++;
+        if ((fsm+i)->target > max_state)
+          max_state = (fsm+i)->target;
+      }
+    }
+    csr->reset(max_state + 1);
+
+    /* If there was not an initial state, the transducer is empty and
+       the states are copied as they are, as in
+       foma_to_hfst_basic_transducer. Else the initial state and state
+       zero swap numbers. */
+    unsigned int start = start_state_found ? start_state_id : 0;
+
+    std::vector<CsrTransducer::Arc> arcs;
+    std::vector<unsigned int> sources;
+    arcs.reserve(number_of_arcs);
+    sources.reserve(number_of_arcs);
+    for (int i=0; (fsm+i)->state_no != -1; i++) {
+      unsigned int state = (fsm+i)->state_no;
+      if (state == start)
+        state = 0;
+      else if (state == 0)
+        state = start;
+
+      if ((fsm+i)->target != -1) {
+        unsigned int target = (fsm+i)->target;
+        if (target == start)
+          target = 0;
+        else if (target == 0)
+          target = start;
+
+        CsrTransducer::Arc arc;
+        arc.input = harmonization_vector.at((fsm+i)->in);
+        arc.output = harmonization_vector.at((fsm+i)->out);
+        arc.target = target;
+        arc.weight = 0;
+        arcs.push_back(arc);
+        sources.push_back(state);
+      }
+
+      if ((fsm+i)->final_state == 1) {
+        csr->final_states[state] = true;
+      }
+    }
+    csr->set_arcs(arcs, sources);
+
+    return csr;
+  }
+
+
+
+  /* ------------------------------------------------------------------------
+
+     Create a foma transducer equivalent to CsrTransducer \a csr.
+
+     ------------------------------------------------------------------------ */
+
+  fsm * ConversionFunctions::csr_to_foma(const CsrTransducer * csr)
+  {
+    const char * emptystr = "";
+    struct fsm_construct_handle * h
+      = fsm_construct_init(const_cast<char*>(emptystr));
+
+    /* The foma number of each common symbol number. Symbols are added
+       to h in the order hfst_basic_transducer_to_foma would add them,
+       so that both give the same numbering. */
+    std::vector<int> foma_numbers;
+
+    unsigned int number_of_states = csr->get_number_of_states();
+    for (unsigned int s = 0; s < number_of_states; s++)
+      {
+        for (unsigned int i = csr->first_arc[s]; i < csr->first_arc[s+1]; i++)
+          {
+            const CsrTransducer::Arc & arc = csr->arcs[i];
+            int in = get_foma_number(h, foma_numbers, arc.input);
+            int out = get_foma_number(h, foma_numbers, arc.output);
+            fsm_construct_add_arc_nums(h, (int)s, (int)arc.target, in, out);
+          }
+      }
+
+    for (unsigned int s = 0; s < number_of_states; s++)
+      {
+        if (csr->final_states[s])
+          fsm_construct_set_final(h, (int)s);
+      }
+
+    for (std::vector<unsigned int>::const_iterator it = csr->alphabet.begin();
+         it != csr->alphabet.end(); it++)
+      get_foma_number(h, foma_numbers, *it);
+
+    fsm_construct_set_initial(h, 0);
+    fsm * net = fsm_construct_done(h);
+    fsm_count(net);
+    net = fsm_topsort(net);
+    return net;
+  }
+
   }}
 #endif // HAVE_FOMA
 
@@ -12,10 +12,12 @@
 #endif
 
 #include <algorithm>
+#include <unordered_map>
 
 #include "ConvertTransducerFormat.h"
 #include "optimized-lookup/convert.h"
 #include "HfstBasicTransducer.h"
+#include "HfstSymbolInterner.h"
 //#include "HfstTransducer.h"
 
 #ifndef MAIN_TEST
@@ -138,16 +140,126 @@ unsigned int hfst_ol_to_hfst_basic_add_state
       
   }
 
-typedef std::set<std::string> StringSet;
+  /* Create a CsrTransducer equivalent to hfst_ol::Transducer \a t . The
+     states are numbered as in hfst_ol_to_hfst_basic_transducer. */
+  CsrTransducer * ConversionFunctions::
+  hfst_ol_to_csr(hfst_ol::Transducer * t)
+  {
+      CsrTransducer * csr = new CsrTransducer();
+      bool weighted = t->get_header().probe_flag(hfst_ol::Weighted);
+      const hfst_ol::SymbolTable& symbols
+        = t->get_alphabet().get_symbol_table();
+      NumberVector harmonization_vector = get_harmonization_vector(symbols);
+      csr->alphabet.push_back(get_number(internal_epsilon));
+      csr->alphabet.push_back(get_number(internal_unknown));
+      csr->alphabet.push_back(get_number(internal_identity));
+      csr->alphabet.insert(csr->alphabet.end(), harmonization_vector.begin(),
+                           harmonization_vector.end());
+      csr->sort_alphabet();
+
+      std::vector<CsrTransducer::Arc> arcs;
+      std::vector<unsigned int> sources;
+      std::vector<bool> final_states;
+      std::vector<float> final_weights;
+
+      std::vector<hfst_ol::TransitionTableIndex> agenda;
+      hfst_ol::HfstOlToBasicStateMap state_map;
+      unsigned int state_number=0;
+
+      state_map[0] = state_number;
+      agenda.push_back(0);
+      while(!agenda.empty())
+      {
+          hfst_ol::TransitionTableIndex current_index = agenda.back();
+          agenda.pop_back();
+
+          unsigned int current_state = state_map[current_index];
+          if (current_state >= final_states.size()) {
+              final_states.resize(current_state + 1, false);
+              final_weights.resize(current_state + 1, 0);
+          }
+          if (hfst_ol::indexes_transition_index_table(current_index)) {
+              const hfst_ol::TransitionIndex& transition_index
+                = t->get_index(current_index);
+              if (transition_index.final()) {
+                  final_states[current_state] = true;
+                  final_weights[current_state] = weighted ?
+                    hfst::double_to_float
+                    (dynamic_cast<const hfst_ol::TransitionWIndex&>
+                     (transition_index).final_weight()) : (float)0.0;
+              }
+          } else {
+              const hfst_ol::Transition& transition
+                = t->get_transition(current_index);
+              if (transition.final()) {
+                  final_states[current_state] = true;
+                  final_weights[current_state] = weighted ?
+                    hfst::double_to_float
+                    (dynamic_cast<const hfst_ol::TransitionW&>
+                     (transition).get_weight()) : (float)0.0;
+              }
+          }
+
+          hfst_ol::TransitionTableIndexSet transitions
+            = t->get_transitions_from_state(current_index);
+          for(hfst_ol::TransitionTableIndexSet::const_iterator it
+                =transitions.begin();it!=transitions.end();it++)
+          {
+              const hfst_ol::Transition& transition = t->get_transition(*it);
+
+              hfst_ol::HfstOlToBasicStateMap::const_iterator target
+                = state_map.find(transition.get_target());
+              if(target == state_map.end())
+              {
+                  state_number++;
+                  target = state_map.insert
+                    (std::make_pair(transition.get_target(),
+                                    state_number)).first;
+                  agenda.push_back(transition.get_target());
+              }
+              CsrTransducer::Arc arc;
+              arc.input
+                = harmonization_vector.at(transition.get_input_symbol());
+              arc.output
+                = harmonization_vector.at(transition.get_output_symbol());
+              arc.target = target->second;
+              arc.weight = weighted ? dynamic_cast<const hfst_ol::TransitionW&>
+                (transition).get_weight() : 0;
+              arcs.push_back(arc);
+              sources.push_back(current_state);
+          }
+      }
+
+      csr->reset(state_number + 1);
+      for (unsigned int s = 0; s < final_states.size(); s++) {
+          csr->final_states[s] = final_states[s];
+          csr->final_weights[s] = final_weights[s];
+      }
+      csr->set_arcs(arcs, sources);
+      return csr;
+  }
+
 using hfst_ol::SymbolNumber;
 using hfst_ol::NO_SYMBOL_NUMBER;
 
+/* Order common symbol numbers by their symbol strings. */
+struct CompareSymbols
+{
+    const HfstSymbolInterner & interner;
+    CompareSymbols(): interner(HfstSymbolInterner::global()) {}
+    bool operator()(unsigned int a, unsigned int b) const
+    {
+        return interner.get_symbol(a) < interner.get_symbol(b);
+    }
+};
+
 void get_states_and_symbols(
-    const HfstBasicTransducer * t,
+    const CsrTransducer * t,
     std::vector<hfst_ol::StatePlaceholder> & state_placeholders,
     hfst_ol::SymbolTable & symbol_table,
     SymbolNumber & seen_input_symbols,
     std::set<SymbolNumber> & flag_symbols,
+    std::vector<bool> & is_flag,
     hfst_ol::Transducer * harmonizer)
 {
     // Symbols must be in the following order in an optimized-lookup
@@ -163,104 +275,122 @@ void get_states_and_symbols(
     // appear at the end of the alphabet. This allows us to ignore
     // them for indexing purposes, which potentially makes the index
     // table smaller and faster to pack.
-    
-    // We also gather information about possible gaps in the state numbering,
-    // because we want it to be contiguous from now on.
-
-    // If we have been told to use a certain symbol table,
-    // there's no need to keep track of symbols here.
-    StringSet * input_symbols = new StringSet();
-    StringSet * flag_diacritics = new StringSet();
-    StringSet * other_symbols = new StringSet();
-    
+
+    // Symbols are handled by their common numbers, and each symbol string
+    // is looked at only once, however many arcs it occurs on.
+    HfstSymbolInterner & interner = HfstSymbolInterner::global();
+    std::vector<SymbolNumber> ol_numbers;
+    std::vector<char> symbol_kinds;
+    enum { UNSEEN = 0, INPUT, FLAG, OTHER };
+
     unsigned int first_transition = 0;
-    unsigned int state_number = 0;
-    for (HfstBasicTransducer::const_iterator it = t->begin();
-         it != t->end(); ++it) {
+    unsigned int number_of_states = t->get_number_of_states();
+    state_placeholders.reserve(number_of_states);
+    for (unsigned int state_number = 0; state_number < number_of_states;
+         ++state_number) {
         hfst_ol::Weight final_w = 0.0;
-        if (t->is_final_state(state_number)) {
-            final_w = t->get_final_weight(state_number);
+        if (t->final_states[state_number]) {
+            final_w = t->final_weights[state_number];
         }
         state_placeholders.push_back(hfst_ol::StatePlaceholder(
                                          state_number,
-                                         t->is_final_state(state_number),
+                                         t->final_states[state_number],
                                          first_transition,
                                          final_w));
         ++first_transition; // there's a padding entry between states
-        for (HfstBasicTransitions::const_iterator tr_it
-                 = it->begin();
-             tr_it != it->end(); ++tr_it) {
-            ++first_transition;
-            // If we don't already have a symbol table, collect symbols
-            if (harmonizer == NULL) {
-                if (FdOperation::is_diacritic(tr_it->get_input_symbol()) ||
-                    hfst_ol::PmatchAlphabet::is_insertion(
-                        tr_it->get_input_symbol())) {
-                    flag_diacritics->insert(tr_it->get_input_symbol());
-                } else {
-                    input_symbols->insert(tr_it->get_input_symbol());
-                }
-                other_symbols->insert(tr_it->get_output_symbol());
+        first_transition += t->first_arc[state_number + 1]
+            - t->first_arc[state_number];
+    }
+
+    // Collect symbols if we need to
+    if (harmonizer == NULL) {
+        size_t symbol_count = interner.size();
+        symbol_kinds.assign(symbol_count, UNSEEN);
+        for (std::vector<CsrTransducer::Arc>::const_iterator it
+                 = t->arcs.begin(); it != t->arcs.end(); ++it) {
+            if (symbol_kinds[it->input] != INPUT &&
+                symbol_kinds[it->input] != FLAG) {
+                const std::string & input = interner.get_symbol(it->input);
+                symbol_kinds[it->input] =
+                    (FdOperation::is_diacritic(input) ||
+                     hfst_ol::PmatchAlphabet::is_insertion(input)) ?
+                    FLAG : INPUT;
+            }
+        }
+        // Output symbols and symbols from the source alphabet that don't
+        // appear as inputs are "other symbols".
+        for (std::vector<CsrTransducer::Arc>::const_iterator it
+                 = t->arcs.begin(); it != t->arcs.end(); ++it) {
+            if (symbol_kinds[it->output] == UNSEEN) {
+                symbol_kinds[it->output] = OTHER;
+            }
+        }
+        for (std::vector<unsigned int>::const_iterator it
+                 = t->alphabet.begin(); it != t->alphabet.end(); ++it) {
+            if (symbol_kinds[*it] == UNSEEN) {
+                symbol_kinds[*it] = OTHER;
             }
         }
-        ++state_number;
-    }
 
-    // We finally add symbols from the source alphabet that don't appear in any
-    // transitions to "other symbols".
-    StringSet source_alphabet = t->get_alphabet();
-    for (StringSet::iterator it = source_alphabet.begin();
-         it != source_alphabet.end(); ++it) {
-        if (input_symbols->count(*it) == 0 && flag_diacritics->count(*it) == 0) {
-            other_symbols->insert(*it);
+        std::vector<unsigned int> input_symbols;
+        std::vector<unsigned int> flag_diacritics;
+        std::vector<unsigned int> other_symbols;
+        for (unsigned int i = 0; i < symbol_count; ++i) {
+            if (symbol_kinds[i] == UNSEEN ||
+                is_epsilon(interner.get_symbol(i))) {
+                continue;
+            }
+            if (symbol_kinds[i] == INPUT) {
+                input_symbols.push_back(i);
+            } else if (symbol_kinds[i] == FLAG) {
+                flag_diacritics.push_back(i);
+            } else {
+                other_symbols.push_back(i);
+            }
         }
-    }
+        std::sort(input_symbols.begin(), input_symbols.end(),
+                  CompareSymbols());
+        std::sort(flag_diacritics.begin(), flag_diacritics.end(),
+                  CompareSymbols());
+        std::sort(other_symbols.begin(), other_symbols.end(),
+                  CompareSymbols());
 
-    std::map<std::string, SymbolNumber> string_symbol_map;
+        ol_numbers.assign(symbol_count, 0);
 
-    // Collect symbols if we need to
-    if (harmonizer == NULL) {
-        
         // 1) epsilon
-        string_symbol_map[internal_epsilon] = hfst::size_t_to_ushort(symbol_table.size());
+        ol_numbers[0] = hfst::size_t_to_ushort(symbol_table.size());
         symbol_table.push_back(internal_epsilon);
-        
+
         // 2) input symbols
-        for (std::set<std::string>::iterator it = input_symbols->begin();
-             it != input_symbols->end(); ++it) {
-            if (!is_epsilon(*it)) {
-                string_symbol_map[*it] = hfst::size_t_to_ushort(symbol_table.size());
-                symbol_table.push_back(*it);
-                ++seen_input_symbols;
-            }
+        for (std::vector<unsigned int>::const_iterator it
+                 = input_symbols.begin(); it != input_symbols.end(); ++it) {
+            ol_numbers[*it] = hfst::size_t_to_ushort(symbol_table.size());
+            symbol_table.push_back(interner.get_symbol(*it));
+            ++seen_input_symbols;
         }
-        
+
         // 3) Flag diacritics
-        for (std::set<std::string>::iterator it = flag_diacritics->begin();
-             it != flag_diacritics->end(); ++it) {
-            if (!is_epsilon(*it)) {
-                string_symbol_map[*it] = hfst::size_t_to_ushort(symbol_table.size());
-                // TODO: cl.exe: conversion from 'size_t' to 'char16_t'
-                flag_symbols.insert((unsigned short)symbol_table.size());
-                symbol_table.push_back(*it);
-                // don't increment seen_input_symbols - we use it for
-                // indexing
-            }
+        for (std::vector<unsigned int>::const_iterator it
+                 = flag_diacritics.begin(); it != flag_diacritics.end(); ++it) {
+            ol_numbers[*it] = hfst::size_t_to_ushort(symbol_table.size());
+            // TODO: cl.exe: conversion from 'size_t' to 'char16_t'
+            flag_symbols.insert((unsigned short)symbol_table.size());
+            symbol_table.push_back(interner.get_symbol(*it));
+            // don't increment seen_input_symbols - we use it for
+            // indexing
         }
-        
+
         // 4) non-input symbols
-        for (std::set<std::string>::iterator it = other_symbols->begin();
-             it != other_symbols->end(); ++it) {
-            if (!is_epsilon(*it) && input_symbols->count(*it) == 0 &&
-              flag_diacritics->count(*it) == 0) {
-                string_symbol_map[*it] = hfst::size_t_to_ushort(symbol_table.size());
-                symbol_table.push_back(*it);
-            }
+        for (std::vector<unsigned int>::const_iterator it
+                 = other_symbols.begin(); it != other_symbols.end(); ++it) {
+            ol_numbers[*it] = hfst::size_t_to_ushort(symbol_table.size());
+            symbol_table.push_back(interner.get_symbol(*it));
         }
         
     } else {
         symbol_table = harmonizer->get_symbol_table();
-        string_symbol_map = harmonizer->get_alphabet().build_string_symbol_map();
+        std::map<std::string, SymbolNumber> string_symbol_map
+            = harmonizer->get_alphabet().build_string_symbol_map();
         seen_input_symbols = harmonizer->get_header().input_symbol_count();
         for (SymbolNumber i = 0; i < symbol_table.size(); ++i) {
             if (harmonizer->get_alphabet().is_flag_diacritic(i) ||
@@ -268,43 +398,81 @@ void get_states_and_symbols(
                 flag_symbols.insert(i);
             }
         }
+        // Symbols missing from the harmonizer become epsilons
+        ol_numbers.assign(interner.size(), 0);
+        for (std::map<std::string, SymbolNumber>::const_iterator it
+                 = string_symbol_map.begin();
+             it != string_symbol_map.end(); ++it) {
+            unsigned int number;
+            if (interner.find(it->first, number) &&
+                number < ol_numbers.size()) {
+                ol_numbers[number] = it->second;
+            }
+        }
     }
-    delete input_symbols;
-    delete flag_diacritics;
-    delete other_symbols;
 
     // Do a second pass over the transitions, figuring out everything
     // about the states except starting indices
 
-    state_number = 0;
-    for (HfstBasicTransducer::const_iterator it = t->begin();
-         it != t->end(); ++it) {
-        for (HfstBasicTransitions::const_iterator tr_it
-               = it->begin();
-             tr_it != it->end(); ++tr_it) {
-            // add input in case we're seeing it the first time
-            state_placeholders[state_number].add_input(
-                string_symbol_map[tr_it->get_input_symbol()],
-                flag_symbols);
-            unsigned int target = tr_it->get_target_state();
-            hfst_ol::TransitionPlaceholder trans(
-                target,
-                string_symbol_map[tr_it->get_input_symbol()],
-                string_symbol_map[tr_it->get_output_symbol()],
-                tr_it->get_weight());
-            //SymbolNumber input_sym = string_symbol_map[tr_it->get_input_symbol()];
-            state_placeholders[state_number].add_transition(trans);
+    is_flag.assign(symbol_table.size(), false);
+    for (std::set<SymbolNumber>::const_iterator it = flag_symbols.begin();
+         it != flag_symbols.end(); ++it) {
+        if (*it < is_flag.size()) {
+            is_flag[*it] = true;
+        }
+    }
+
+    std::vector<hfst_ol::TransitionPlaceholder> transitions;
+    for (unsigned int state_number = 0; state_number < number_of_states;
+         ++state_number) {
+        transitions.clear();
+        for (unsigned int i = t->first_arc[state_number];
+             i < t->first_arc[state_number + 1]; ++i) {
+            const CsrTransducer::Arc & arc = t->arcs[i];
+            transitions.push_back(hfst_ol::TransitionPlaceholder(
+                arc.target,
+                ol_numbers[arc.input],
+                ol_numbers[arc.output],
+                arc.weight));
         }
-        ++state_number;
+        state_placeholders[state_number].set_transitions(transitions, is_flag);
     }
 }
 
+/* Hash for the index offsets of a state. */
+struct HashIndexOffsets
+{
+    size_t operator()(std::vector<unsigned int> const & offsets) const
+    {
+        size_t h = offsets.size();
+        for (std::vector<unsigned int>::const_iterator it = offsets.begin();
+             it != offsets.end(); ++it) {
+            h = h * 1000003u ^ *it;
+        }
+        return h;
+    }
+};
+
   /* Create an hfst_ol::Transducer equivalent to HfstBasicTransducer \a t.
      \a weighted defined whether the created transducer is weighted. */
   hfst_ol::Transducer * ConversionFunctions::
   hfst_basic_transducer_to_hfst_ol
   (const HfstBasicTransducer * t, bool weighted, std::string options,
    HfstTransducer * harmonizer)
+  {
+      CsrTransducer * csr = hfst_basic_transducer_to_csr(t);
+      hfst_ol::Transducer * retval
+        = csr_to_hfst_ol(csr, weighted, options, harmonizer);
+      delete csr;
+      return retval;
+  }
+
+  /* Create an hfst_ol::Transducer equivalent to CsrTransducer \a t.
+     \a weighted defined whether the created transducer is weighted. */
+  hfst_ol::Transducer * ConversionFunctions::
+  csr_to_hfst_ol
+  (const CsrTransducer * t, bool weighted, std::string options,
+   HfstTransducer * harmonizer)
   {
 #if HAVE_OPENFST
       const float packing_aggression = (float)0.85; // double -> const float
@@ -326,11 +494,13 @@ void get_states_and_symbols(
       hfst_ol::SymbolTable symbol_table;
       SymbolNumber seen_input_symbols = 1; // We always have epsilon
       std::set<SymbolNumber> flag_symbols;
+      std::vector<bool> is_flag;
       get_states_and_symbols(t,
                              state_placeholders,
                              symbol_table,
                              seen_input_symbols,
                              flag_symbols,
+                             is_flag,
                              harmonizer_ol);
 
       // For determining the index table we first sort the states (excepting
@@ -345,14 +515,24 @@ void get_states_and_symbols(
 
     // Now we assign starting indices (or alternatively determine a state
     // doesn't need an entry in the TIA ("is simple"). The starting state has
-    // index 0. Used indices are stored in a map (at the beginning, every
-    // index below or equal to the alphabet size is available except index 0).
-    // For every state (in the TIA) thereafter, we check each available
-    // starting index to see if it fits.
+    // index 0. For every state (in the TIA) thereafter, we look for the
+    // first starting index from first_available_index on where it fits.
+    // The bitmap of used indices lets us test 64 starting indices at a
+    // time.
+
+    // States with the same index offsets (the same input symbols, flags
+    // counted as epsilon) are bucketed together: used indices never become
+    // free and first_available_index never decreases, so no index before
+    // the one where the previous state of the bucket went can fit.
 
     // The starting state is special because it will have a TIA entry even if
     // it's simple, so we deal with it every time.
 
+    typedef std::unordered_map<std::vector<unsigned int>, unsigned int,
+                               HashIndexOffsets> OffsetBuckets;
+    OffsetBuckets previous_fits;
+    std::vector<unsigned int> offsets;
+
     unsigned int first_available_index = 0;
     unsigned int previous_first_index = 0;
     unsigned int previous_successful_index = 0;
@@ -363,30 +543,39 @@ void get_states_and_symbols(
         if (it->is_simple()) {
             continue;
         }
+        it->get_index_offsets(offsets, is_flag);
         unsigned int i = first_available_index;
+        OffsetBuckets::iterator bucket = previous_fits.find(offsets);
+        if (bucket != previous_fits.end() && bucket->second >= i) {
+            i = bucket->second + 1;
+        }
 
-        // While this index is not suitable for a starting index, keep looking
-        while (!used_indices->fits(*it, flag_symbols, i)) {
-            ++i;
+        i = used_indices->find_fit(offsets, i);
+        if (bucket != previous_fits.end()) {
+            bucket->second = i;
+        } else {
+            previous_fits.insert(std::make_pair(offsets, i));
         }
         it->start_index = i;
         previous_successful_index = i;
         // Once we've found a starting index, insert a finality marker and
         // mark all the used indices
-        used_indices->assign(i, it->state_number, NO_SYMBOL_NUMBER);
+        used_indices->assign(i, it->state_number, NO_SYMBOL_NUMBER, 0);
+        unsigned int transition_offset = 0;
         for (std::vector<std::vector<hfst_ol::TransitionPlaceholder> >
                  ::const_iterator tr_it = it->transition_placeholders.begin();
              tr_it != it->transition_placeholders.end(); ++tr_it) {
-            SymbolNumber index_offset = tr_it->at(0).input;
-            if (flag_symbols.count(index_offset) != 0) {
-                index_offset = 0;
-            }
-            used_indices->assign(i + index_offset + 1, it->state_number, index_offset);
+            SymbolNumber index_offset = hfst_ol::StatePlaceholder::index_offset
+                (tr_it->at(0).input, is_flag);
+            // Epsilons and flags all point to the first transition
+            used_indices->assign(i + index_offset + 1, it->state_number,
+                                 index_offset,
+                                 index_offset == 0 ? 0 : transition_offset);
+            transition_offset += hfst::size_t_to_uint(tr_it->size());
         }
 
-        while (used_indices->unsuitable(first_available_index, seen_input_symbols, packing_aggression)) {
-            ++first_available_index;
-        }
+        first_available_index = used_indices->first_suitable
+            (first_available_index, seen_input_symbols, packing_aggression);
         if (first_available_index == previous_first_index) {
             if (floor_stuck_counter > floor_jump_threshold) {
                 first_available_index = previous_successful_index + 1;
@@ -413,32 +602,31 @@ void get_states_and_symbols(
     hfst_ol::TransducerTable<hfst_ol::TransitionWIndex> windex_table;
     
     unsigned int greatest_index = 0;
-    if (used_indices->indices.size() != 0) {
-        greatest_index = hfst::size_t_to_uint(used_indices->indices.size() - 1);
+    if (used_indices->entries.size() != 0) {
+        greatest_index = hfst::size_t_to_uint(used_indices->entries.size() - 1);
     }
 
     for(unsigned int i = 0; i <= greatest_index; ++i) {
         if (!used_indices->used(i)) { // blank entries
             windex_table.append(hfst_ol::TransitionWIndex());
-        } else if (used_indices->get_target(i).second ==
+        } else if (used_indices->get_target(i).symbol ==
                    NO_SYMBOL_NUMBER) { // finality markers
-            if (state_placeholders[used_indices->get_target(i).first].final) {
+            if (state_placeholders[used_indices->get_target(i).target].final) {
                 windex_table.append(
                     hfst_ol::TransitionWIndex::create_final(
                         state_placeholders[
-                            used_indices->get_target(i).first].final_weight));
+                            used_indices->get_target(i).target].final_weight));
             } else {
                 windex_table.append(hfst_ol::TransitionWIndex());
             }
         } else { // actual entries
-            unsigned int idx = used_indices->get_target(i).first;
-            SymbolNumber sym = used_indices->get_target(i).second;
+            const hfst_ol::IndexPlaceholder & entry
+                = used_indices->get_target(i);
             windex_table.append(
                 hfst_ol::TransitionWIndex(
-                    sym,
-                    state_placeholders[idx].first_transition +
-                    state_placeholders[idx].symbol_offset(
-                        sym, flag_symbols) + TA_OFFSET));
+                    entry.symbol,
+                    state_placeholders[entry.target].first_transition +
+                    entry.offset + TA_OFFSET));
         }
     }
 
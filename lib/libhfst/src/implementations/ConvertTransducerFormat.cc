@@ -14,39 +14,26 @@
 #include "ConvertTransducerFormat.h"
 #include "optimized-lookup/convert.h"
 #include "HfstBasicTransducer.h"
+#include "HfstSymbolInterner.h"
 #include "HfstTransducer.h"
 
+#include <algorithm>
+
 #ifndef MAIN_TEST
 namespace hfst { namespace implementations
 {
 
-  ConversionFunctions::String2NumberMap
-    ConversionFunctions::string_to_number_map;
-  StringVector ConversionFunctions::number_to_string_vector;
-
-  StringVectorInitializer
-  dummy3(ConversionFunctions::number_to_string_vector);
-  String2NumberMapInitializer
-  dummy4(ConversionFunctions::string_to_number_map);
-
   std::string ConversionFunctions::get_string(unsigned int number)
   {
-    if (number >= number_to_string_vector.size()) {
+    HfstSymbolInterner & interner = HfstSymbolInterner::global();
+    if (!interner.has_symbol(number)) {
       return std::string(""); } // number not found
-    return number_to_string_vector[number];
+    return interner.get_symbol(number);
   }
 
   unsigned int ConversionFunctions::get_number(const std::string &str)
   {
-    String2NumberMap::iterator it =
-      string_to_number_map.find(str);
-    if (it == string_to_number_map.end()) { // string not found
-      number_to_string_vector.push_back(str);
-      unsigned int new_index = hfst::size_t_to_uint(number_to_string_vector.size()-1);
-      string_to_number_map[str] = new_index;
-      return new_index;
-    }
-    return it->second;
+    return HfstSymbolInterner::global().get_number(str);
   }
 
   ConversionFunctions::NumberVector
@@ -128,6 +115,380 @@ namespace hfst { namespace implementations
   }
 
 
+  void CsrTransducer::reset(unsigned int number_of_states)
+  {
+    first_arc.assign(number_of_states + 1, 0);
+    arcs.clear();
+    final_states.assign(number_of_states, false);
+    final_weights.assign(number_of_states, 0);
+  }
+
+  void CsrTransducer::set_arcs(const std::vector<Arc> & arcs_,
+                               const std::vector<unsigned int> & sources)
+  {
+    // A counting sort by source state
+    unsigned int number_of_states = get_number_of_states();
+    first_arc.assign(number_of_states + 1, 0);
+    for (std::vector<unsigned int>::const_iterator it = sources.begin();
+         it != sources.end(); it++)
+      first_arc[*it + 1]++;
+    for (unsigned int s = 0; s < number_of_states; s++)
+      first_arc[s + 1] += first_arc[s];
+
+    std::vector<unsigned int> position(first_arc.begin(), first_arc.end() - 1);
+    arcs.resize(arcs_.size());
+    for (size_t i = 0; i < arcs_.size(); i++)
+      arcs[position[sources[i]]++] = arcs_[i];
+  }
+
+  namespace {
+    struct CompareSymbolStrings
+    {
+      const HfstSymbolInterner & interner;
+      CompareSymbolStrings(const HfstSymbolInterner & i): interner(i) {}
+      bool operator()(unsigned int a, unsigned int b) const
+      { return interner.get_symbol(a) < interner.get_symbol(b); }
+    };
+  }
+
+  void CsrTransducer::sort_alphabet()
+  {
+    std::sort(alphabet.begin(), alphabet.end());
+    alphabet.erase(std::unique(alphabet.begin(), alphabet.end()),
+                   alphabet.end());
+    std::sort(alphabet.begin(), alphabet.end(),
+              CompareSymbolStrings(HfstSymbolInterner::global()));
+  }
+
+  std::vector<std::set<unsigned int> >
+  CsrTransducer::topsort(SortDistance dist) const
+  {
+    std::vector<std::set<unsigned int> > result;
+    unsigned int number_of_states = get_number_of_states();
+    if (number_of_states == 0)
+      return result;
+
+    if (dist == MaximumDistance)
+      {
+        // The longest distances in topological order (Kahn's algorithm)
+        // over the states reachable from the initial state
+        std::vector<unsigned int> in_degree(number_of_states, 0);
+        std::vector<bool> reachable(number_of_states, false);
+        std::vector<unsigned int> agenda(1, 0);
+        reachable[0] = true;
+        while (!agenda.empty())
+          {
+            unsigned int s = agenda.back();
+            agenda.pop_back();
+            for (unsigned int i = first_arc[s]; i < first_arc[s+1]; i++)
+              {
+                unsigned int t = arcs[i].target;
+                in_degree[t]++;
+                if (!reachable[t])
+                  {
+                    reachable[t] = true;
+                    agenda.push_back(t);
+                  }
+              }
+          }
+
+        std::vector<unsigned int> distance(number_of_states, 0);
+        agenda.push_back(0);
+        while (!agenda.empty())
+          {
+            unsigned int s = agenda.back();
+            agenda.pop_back();
+            if (distance[s] >= result.size())
+              result.resize(distance[s] + 1);
+            result[distance[s]].insert(s);
+            for (unsigned int i = first_arc[s]; i < first_arc[s+1]; i++)
+              {
+                unsigned int t = arcs[i].target;
+                if (distance[s] + 1 > distance[t])
+                  distance[t] = distance[s] + 1;
+                if (--in_degree[t] == 0)
+                  agenda.push_back(t);
+              }
+          }
+        return result;
+      }
+
+    // Breadth-first, a state is listed at every distance it is reached at
+    std::vector<unsigned int> level(1, 0);
+    std::vector<unsigned int> next_level;
+    std::vector<unsigned int> seen_at(number_of_states, (unsigned int)-1);
+    for (unsigned int d = 0; !level.empty(); d++)
+      {
+        result.push_back(std::set<unsigned int>(level.begin(), level.end()));
+        next_level.clear();
+        for (unsigned int s: level)
+          {
+            for (unsigned int i = first_arc[s]; i < first_arc[s+1]; i++)
+              {
+                unsigned int t = arcs[i].target;
+                if (seen_at[t] != d)
+                  {
+                    seen_at[t] = d;
+                    next_level.push_back(t);
+                  }
+              }
+          }
+        level.swap(next_level);
+      }
+    return result;
+  }
+
+  int CsrTransducer::longest_path_size() const
+  {
+    std::vector<std::set<unsigned int> > states_sorted
+      = topsort(MaximumDistance);
+    for (int distance = (int)states_sorted.size() - 1; distance >= 0;
+         distance--)
+      {
+        for (unsigned int state: states_sorted[distance])
+          {
+            if (final_states[state])
+              return distance;
+          }
+      }
+    return -1;
+  }
+
+  std::vector<unsigned int> CsrTransducer::path_sizes() const
+  {
+    std::vector<unsigned int> result;
+    std::vector<std::set<unsigned int> > states_sorted
+      = topsort(MinimumDistance);
+    for (int distance = (int)states_sorted.size() - 1; distance >= 0;
+         distance--)
+      {
+        for (unsigned int state: states_sorted[distance])
+          {
+            if (final_states[state])
+              {
+                result.push_back((unsigned int)distance);
+                break;
+              }
+          }
+      }
+    return result;
+  }
+
+  std::vector<std::string> CsrTransducer::get_att_symbols() const
+  {
+    unsigned int max_number = 0;
+    for (const Arc & arc: arcs)
+      max_number = std::max(max_number, std::max(arc.input, arc.output));
+
+    // Each symbol is escaped once instead of once per arc
+    HfstSymbolInterner & interner = HfstSymbolInterner::global();
+    std::vector<std::string> symbols(max_number + 1);
+    std::vector<bool> done(max_number + 1, false);
+    for (const Arc & arc: arcs)
+      {
+        unsigned int numbers[2] = { arc.input, arc.output };
+        for (unsigned int number: numbers)
+          {
+            if (done[number])
+              continue;
+            std::string symbol = interner.get_symbol(number);
+            replace_all(symbol, " ", "@_SPACE_@");
+            replace_all(symbol, "@_EPSILON_SYMBOL_@", "@0@");
+            replace_all(symbol, "\t", "@_TAB_@");
+            symbols[number] = symbol;
+            done[number] = true;
+          }
+      }
+    return symbols;
+  }
+
+  void CsrTransducer::write_in_att_format(FILE * file,
+                                          bool write_weights) const
+  {
+    std::vector<std::string> symbols = get_att_symbols();
+    for (unsigned int s = 0; s < get_number_of_states(); s++)
+      {
+        for (unsigned int i = first_arc[s]; i < first_arc[s+1]; i++)
+          {
+            const Arc & arc = arcs[i];
+            fprintf(file, "%i\t%i\t%s\t%s", s, arc.target,
+                    symbols[arc.input].c_str(),
+                    symbols[arc.output].c_str());
+            if (write_weights)
+              fprintf(file, "\t%f", arc.weight);
+            fprintf(file, "\n");
+          }
+        if (final_states[s])
+          {
+            fprintf(file, "%i", s);
+            if (write_weights)
+              fprintf(file, "\t%f", final_weights[s]);
+            fprintf(file, "\n");
+          }
+      }
+  }
+
+  void CsrTransducer::write_in_att_format(std::ostream & os,
+                                          bool write_weights) const
+  {
+    std::vector<std::string> symbols = get_att_symbols();
+    for (unsigned int s = 0; s < get_number_of_states(); s++)
+      {
+        for (unsigned int i = first_arc[s]; i < first_arc[s+1]; i++)
+          {
+            const Arc & arc = arcs[i];
+            os << s << "\t" << arc.target << "\t"
+               << symbols[arc.input] << "\t" << symbols[arc.output];
+            if (write_weights)
+              os << "\t" << arc.weight;
+            os << "\n";
+          }
+        if (final_states[s])
+          {
+            os << s;
+            if (write_weights)
+              os << "\t" << final_weights[s];
+            os << "\n";
+          }
+      }
+  }
+
+  bool ConversionFunctions::has_csr_conversion(ImplementationType type)
+  {
+    switch (type)
+      {
+#if HAVE_OPENFST
+      case TROPICAL_OPENFST_TYPE:
+      case HFST_OL_TYPE:
+      case HFST_OLW_TYPE:
+#endif
+#if HAVE_FOMA
+      case FOMA_TYPE:
+#endif
+        return true;
+      default:
+        return false;
+      }
+  }
+
+  bool ConversionFunctions::has_direct_conversion
+  (ImplementationType from, ImplementationType to)
+  {
+    if (from == to)
+      return false;
+    if (!has_csr_conversion(from) || !has_csr_conversion(to))
+      return false;
+    // Optimized lookup transducers differ from each other only by
+    // their weights, which the generic conversion handles.
+    if ((from == HFST_OL_TYPE || from == HFST_OLW_TYPE) &&
+        (to == HFST_OL_TYPE || to == HFST_OLW_TYPE))
+      return false;
+    return true;
+  }
+
+  CsrTransducer * ConversionFunctions::hfst_basic_transducer_to_csr
+  (const HfstBasicTransducer * t)
+  {
+    CsrTransducer * csr = new CsrTransducer();
+    csr->reset(t->get_max_state() + 1);
+
+    size_t number_of_arcs = 0;
+    for (HfstBasicTransducer::const_iterator it = t->begin();
+         it != t->end(); it++)
+      number_of_arcs += it->size();
+    csr->arcs.reserve(number_of_arcs);
+
+    unsigned int state = 0;
+    for (HfstBasicTransducer::const_iterator it = t->begin();
+         it != t->end(); it++)
+      {
+        for (HfstBasicTransitions::const_iterator tr_it = it->begin();
+             tr_it != it->end(); tr_it++)
+          {
+            CsrTransducer::Arc arc;
+            arc.input = tr_it->get_input_number();
+            arc.output = tr_it->get_output_number();
+            arc.target = tr_it->get_target_state();
+            arc.weight = tr_it->get_weight();
+            csr->arcs.push_back(arc);
+          }
+        state++;
+        csr->first_arc[state] = (unsigned int)csr->arcs.size();
+      }
+
+    for (HfstBasicTransducer::FinalWeightMap::const_iterator it
+           = t->final_weight_map.begin();
+         it != t->final_weight_map.end(); it++)
+      {
+        csr->final_states[it->first] = true;
+        csr->final_weights[it->first] = it->second;
+      }
+
+    // The alphabet of t is already in the order of symbol strings
+    const HfstBasicTransducer::HfstAlphabet & alphabet = t->get_alphabet();
+    csr->alphabet.reserve(alphabet.size());
+    for (HfstBasicTransducer::HfstAlphabet::const_iterator it
+           = alphabet.begin(); it != alphabet.end(); it++)
+      csr->alphabet.push_back(get_number(*it));
+
+    return csr;
+  }
+
+  HfstBasicTransducer * ConversionFunctions::csr_to_hfst_basic_transducer
+  (const CsrTransducer * t)
+  {
+    HfstBasicTransducer * net = new HfstBasicTransducer();
+    unsigned int number_of_states = t->get_number_of_states();
+    if (number_of_states > 0)
+      net->add_state(number_of_states - 1);
+    for (unsigned int s = 0; s < number_of_states; s++)
+      {
+        HfstBasicTransitions & transitions = net->state_vector[s];
+        transitions.reserve(t->first_arc[s+1] - t->first_arc[s]);
+        for (unsigned int i = t->first_arc[s]; i < t->first_arc[s+1]; i++)
+          {
+            const CsrTransducer::Arc & arc = t->arcs[i];
+            transitions.push_back(HfstBasicTransition
+                                  (arc.target, arc.input, arc.output,
+                                   arc.weight, false));
+          }
+        if (t->final_states[s])
+          net->set_final_weight(s, t->final_weights[s]);
+      }
+
+    HfstBasicTransducer::HfstSymbolSet alphabet;
+    for (unsigned int number: t->alphabet)
+      alphabet.insert(get_string(number));
+    net->add_symbols_to_alphabet(alphabet);
+    return net;
+  }
+
+  CsrTransducer * ConversionFunctions::hfst_transducer_to_csr
+  (const hfst::HfstTransducer &t)
+  {
+    switch (t.type)
+      {
+#if HAVE_FOMA
+      case FOMA_TYPE:
+        return foma_to_csr(t.implementation.foma);
+#endif
+#if HAVE_OPENFST
+      case TROPICAL_OPENFST_TYPE:
+        return tropical_ofst_to_csr(t.implementation.tropical_ofst);
+      case HFST_OL_TYPE:
+      case HFST_OLW_TYPE:
+        return hfst_ol_to_csr(t.implementation.hfst_ol);
+#endif
+      default:
+        break;
+      }
+    HfstBasicTransducer * net = hfst_transducer_to_hfst_basic_transducer(t);
+    CsrTransducer * csr = hfst_basic_transducer_to_csr(net);
+    delete net;
+    return csr;
+  }
+
+
   /* Add here your conversion functions or write them to a separate file. */
   //#if HAVE_MY_TRANSDUCER_LIBRARY
   //
@@ -152,6 +513,7 @@ namespace hfst { namespace implementations
 #else // MAIN_TEST was defined
 #include <cstdlib>
 #include <cassert>
+#include <sstream>
 
 #include "../HfstTransducer.h"
 
@@ -180,6 +542,48 @@ int main(void)
 
             if (! fsm1.compare(fsm1_converted_twice))
               return 1;
+
+            // Direct conversions through CsrTransducer
+            for (unsigned int j=0; j < 3; j++)
+              {
+                if (! ConversionFunctions::has_direct_conversion
+                    (types[i], types[j]))
+                  continue;
+                HfstTransducer fsm1_direct(fsm1);
+                fsm1_direct.convert(types[j]).convert(types[i]);
+                if (types[i] != FOMA_TYPE && types[j] == FOMA_TYPE)
+                  fsm1_direct.set_final_weights(4);
+                if (! fsm1.compare(fsm1_direct))
+                  return 1;
+              }
+
+            // The frozen form agrees with HfstBasicTransducer
+            HfstTransducer fsm2("ca", "do", tok, types[i]);
+            fsm2.disjunct(fsm1).disjunct(HfstTransducer(internal_epsilon, types[i]));
+            HfstBasicTransducer net(fsm2);
+            CsrTransducer * csr =
+              ConversionFunctions::hfst_basic_transducer_to_csr(&net);
+            assert(csr->longest_path_size() == net.longest_path_size());
+            assert(csr->path_sizes() == net.path_sizes());
+            assert(csr->topsort(CsrTransducer::MaximumDistance) ==
+                   net.topsort(HfstBasicTransducer::MaximumDistance));
+            assert(csr->topsort(CsrTransducer::MinimumDistance) ==
+                   net.topsort(HfstBasicTransducer::MinimumDistance));
+            std::ostringstream net_att, csr_att;
+            net.write_in_att_format(net_att);
+            csr->write_in_att_format(csr_att);
+            assert(net_att.str() == csr_att.str());
+
+            HfstBasicTransducer * thawed =
+              ConversionFunctions::csr_to_hfst_basic_transducer(csr);
+            assert(HfstTransducer(*thawed, types[i]).compare(fsm2));
+            delete thawed;
+            delete csr;
+
+            csr = ConversionFunctions::hfst_transducer_to_csr(fsm2);
+            assert(csr->longest_path_size() == net.longest_path_size());
+            assert(csr->path_sizes() == net.path_sizes());
+            delete csr;
           }
       }
 
@@ -15,6 +15,9 @@
 #endif // HAVE_CONFIG_H
 
 #include <map>
+#include <set>
+#include <string>
+#include <cstdio>
 #include <iosfwd>
 #include <vector>
 
@@ -76,36 +79,132 @@ namespace implementations {
 #endif
 
 
+  /* A compact transducer that direct conversions between two backend
+     formats go through instead of HfstBasicTransducer. It is also a
+     frozen, read-only form of HfstBasicTransducer for algorithms that
+     only walk the graph.
+
+     The states are numbered from zero, zero being the initial state, and
+     the arcs of state s are arcs[first_arc[s]] .. arcs[first_arc[s+1]-1].
+     Symbols are numbers in the symbol numbering common to all transducers
+     (HfstSymbolInterner), so a backend transducer is converted with one
+     vector that maps its own symbol numbers to common ones and no symbol
+     string is handled per arc. Final weights are a dense array. */
+  struct CsrTransducer
+  {
+    struct Arc
+    {
+      unsigned int input;
+      unsigned int output;
+      unsigned int target;
+      float weight;
+    };
+
+    std::vector<unsigned int> first_arc;
+    std::vector<Arc> arcs;
+    std::vector<bool> final_states;
+    std::vector<float> final_weights;
+    /* Common numbers of the alphabet, ordered by symbol string. */
+    std::vector<unsigned int> alphabet;
+
+    unsigned int get_number_of_states() const
+    { return (unsigned int)final_states.size(); }
+
+    /* Give the transducer \a number_of_states states, none of them final,
+       and no arcs. */
+    void reset(unsigned int number_of_states);
+
+    /* Set \a arcs as the arcs of the transducer. The source state of
+       arcs[i] is \a sources[i]. The arcs of a state keep their order. */
+    void set_arcs(const std::vector<Arc> & arcs,
+                  const std::vector<unsigned int> & sources);
+
+    /* Remove duplicates from the alphabet and order it by symbol
+       string. */
+    void sort_alphabet();
+
+    enum SortDistance { MaximumDistance, MinimumDistance };
+
+    /* A topological sort of the states reachable from the initial state,
+       as in HfstBasicTransducer::topsort. With MaximumDistance, the set
+       at index d holds the states whose longest path from the initial
+       state has d arcs. With MinimumDistance, it holds every state that
+       some path of d arcs leads to.
+
+       @pre The transducer is acyclic. */
+    std::vector<std::set<unsigned int> > topsort(SortDistance dist) const;
+
+    /* The length of the longest string accepted, or -1 if no string is
+       accepted.
+
+       @pre The transducer is acyclic. */
+    int longest_path_size() const;
+
+    /* The lengths of the strings accepted, in descending order.
+
+       @pre The transducer is acyclic. */
+    std::vector<unsigned int> path_sizes() const;
+
+    /* Write the transducer in AT&T format to \a file, as
+       HfstBasicTransducer::write_in_att_format does. */
+    void write_in_att_format(FILE * file, bool write_weights=true) const;
+
+    /* Write the transducer in AT&T format to \a os, as
+       HfstBasicTransducer::write_in_att_format does. */
+    void write_in_att_format(std::ostream & os,
+                             bool write_weights=true) const;
+
+  protected:
+    /* The symbols of the arcs escaped for AT&T format, indexed by
+       symbol number. */
+    std::vector<std::string> get_att_symbols() const;
+  };
+
   class ConversionFunctions {
 
   public:
 
-    typedef std::map<std::string, unsigned int> String2NumberMap;
     typedef std::vector<unsigned int> NumberVector;
 
-    /* A number-to-string vector common to all transducers during a session. */
-    static StringVector number_to_string_vector;
-
-    /* A string-to-number map common to all transducers during a session. */
-    static String2NumberMap string_to_number_map;
-
-    /* Get the string that is represented by \a number in the number-to-string
-       vector. If \a number is not found, return the empty string. */
+    /* Get the string that is represented by \a number in the symbol
+       numbering common to all transducers during a session
+       (HfstSymbolInterner). If \a number is not found, return the empty
+       string. */
     static std::string get_string(unsigned int number);
 
-    /* Get the number that represents \a str in the string-to-number map.
-       If \a str is not found, add it to the next free index. */
+    /* Get the number that represents \a str in the common symbol
+       numbering. If \a str is not found, add it to the next free index. */
     static unsigned int get_number(const std::string &str);
 
     /* Get a vector that tells how a transducer that follows
        the number-to-symbol encoding of \a coding should be harmonized so that
-       it will follow the one of number_to_string_vector. */
+       it will follow the common symbol numbering. */
     static NumberVector get_harmonization_vector
       (const StringVector &coding_vector);
 
     static HfstBasicTransducer * hfst_transducer_to_hfst_basic_transducer
       (const hfst::HfstTransducer &t);
 
+    /* Whether a transducer of type \a from can be converted to type \a to
+       through a CsrTransducer, without HfstBasicTransducer. */
+    static bool has_direct_conversion
+      (ImplementationType from, ImplementationType to);
+
+    /* Whether a transducer of type \a type can be converted to and from
+       a CsrTransducer without HfstBasicTransducer. */
+    static bool has_csr_conversion(ImplementationType type);
+
+    static CsrTransducer * hfst_basic_transducer_to_csr
+      (const HfstBasicTransducer * t);
+
+    static HfstBasicTransducer * csr_to_hfst_basic_transducer
+      (const CsrTransducer * t);
+
+    /* A CsrTransducer equivalent to \a t. It is converted directly if
+       has_csr_conversion(t.get_type()), else through HfstBasicTransducer. */
+    static CsrTransducer * hfst_transducer_to_csr
+      (const hfst::HfstTransducer &t);
+
 #if HAVE_SFST || HAVE_LEAN_SFST
   static void sfst_to_hfst_basic_transducer
     ( SFST::Node *node,
@@ -124,6 +223,10 @@ namespace implementations {
 
   static fsm * hfst_basic_transducer_to_foma
     (const HfstBasicTransducer * t);
+
+  static CsrTransducer * foma_to_csr(fsm * t);
+
+  static fsm * csr_to_foma(const CsrTransducer * t);
 #endif // HAVE_FOMA
 
 #if HAVE_XFSM
@@ -142,6 +245,10 @@ namespace implementations {
   static fst::StdVectorFst * hfst_basic_transducer_to_tropical_ofst
     (const HfstBasicTransducer * t);
 
+  static CsrTransducer * tropical_ofst_to_csr(fst::StdVectorFst * t);
+
+  static fst::StdVectorFst * csr_to_tropical_ofst(const CsrTransducer * t);
+
 #if HAVE_OPENFST_LOG || HAVE_LEAN_OPENFST_LOG
   static HfstBasicTransducer * log_ofst_to_hfst_basic_transducer
     (fst::LogFst * t, bool had_hfst_header=true);
@@ -164,6 +271,12 @@ namespace implementations {
       (const HfstBasicTransducer * t, bool weighted,
        std::string options="", HfstTransducer * harmonizer = NULL);
 
+  static CsrTransducer * hfst_ol_to_csr(hfst_ol::Transducer * t);
+
+  static hfst_ol::Transducer * csr_to_hfst_ol
+      (const CsrTransducer * t, bool weighted,
+       std::string options="", HfstTransducer * harmonizer = NULL);
+
   // A way to smuggle a hfst_ol backend into a HfstTransducer wrapper
   static HfstTransducer * hfst_ol_to_hfst_transducer(hfst_ol::Transducer * t);
 
@@ -182,33 +295,8 @@ namespace implementations {
   //    (const HfstBasicTransducer * t);
   //#endif // HAVE_MY_TRANSDUCER_LIBRARY
 
-    friend class StringVectorInitializer;
-    friend class String2NumberMapInitializer;
-  
   };
 
-    // Initialization of static members in class
-    // ConvertTransducerFormat..
-    class StringVectorInitializer {
-    public:
-      StringVectorInitializer
-        (StringVector &vector) {
-        vector.push_back(std::string("@_EPSILON_SYMBOL_@"));
-    vector.push_back(std::string("@_UNKNOWN_SYMBOL_@"));
-        vector.push_back(std::string("@_IDENTITY_SYMBOL_@"));
-      }
-    };
-
-    class String2NumberMapInitializer {
-    public:
-      String2NumberMapInitializer
-        (ConversionFunctions::String2NumberMap &map) {
-        map["@_EPSILON_SYMBOL_@"] = 0;
-        map["@_UNKNOWN_SYMBOL_@"] = 1;
-        map["@_IDENTITY_SYMBOL_@"] = 2;
-      }
-    };
-
 } }
 #endif // _CONVERT_TRANSDUCER_H_
 
@@ -297,6 +297,150 @@ namespace hfst { namespace implementations
     return t;
   }
 
+  /* ---------------------------------------------------------------------------
+
+     Create a CsrTransducer equivalent to an OpenFst tropical weight
+     transducer \a t.
+
+     --------------------------------------------------------------------------- */
+
+  /* Copy the common numbers of the symbols in \a symbols to \a alphabet. */
+  static void copy_alphabet(const fst::SymbolTable * symbols,
+                            std::vector<unsigned int> & alphabet)
+  {
+    if (symbols == NULL)
+      return;
+    for (fst::SymbolTableIterator it = fst::SymbolTableIterator(*symbols);
+         ! it.Done(); it.Next())
+      {
+        assert(it.Symbol() != "");
+        if (it.Value() != 0) // epsilon is not inserted
+          alphabet.push_back(ConversionFunctions::get_number(it.Symbol()));
+      }
+  }
+
+  CsrTransducer * ConversionFunctions::
+  tropical_ofst_to_csr(fst::StdVectorFst * t)
+  {
+    if (t->InputSymbols() == NULL) {
+      HFST_THROW(MissingOpenFstInputSymbolTableException);
+    }
+
+    CsrTransducer * csr = new CsrTransducer();
+    csr->alphabet.push_back(get_number(internal_epsilon));
+    csr->alphabet.push_back(get_number(internal_unknown));
+    csr->alphabet.push_back(get_number(internal_identity));
+    copy_alphabet(t->InputSymbols(), csr->alphabet);
+    copy_alphabet(t->OutputSymbols(), csr->alphabet);
+    csr->sort_alphabet();
+
+    StateId initial_state = t->Start();
+    if (initial_state == (StateId)fst::kNoStateId)
+      {
+        csr->reset(1);
+        return csr;
+      }
+
+    StringVector symbol_vector = TropicalWeightTransducer::get_symbol_vector(t);
+    NumberVector harmonization_vector = get_harmonization_vector(symbol_vector);
+
+    /* The initial state and state zero swap numbers, as in
+       tropical_ofst_to_hfst_basic_transducer. */
+    unsigned int number_of_states = t->NumStates();
+    csr->reset(number_of_states);
+    size_t number_of_arcs = 0;
+    for (StateId s = 0; s < number_of_states; s++)
+      number_of_arcs += t->NumArcs(s);
+    csr->arcs.reserve(number_of_arcs);
+
+    for (StateId state = 0; state < number_of_states; state++)
+      {
+        StateId s = state;
+        if (s == 0)
+          s = initial_state;
+        else if (s == initial_state)
+          s = 0;
+
+        for (fst::ArcIterator<fst::StdVectorFst> aiter(*t,s);
+             !aiter.Done(); aiter.Next())
+          {
+            const fst::StdArc &arc = aiter.Value();
+            if ((size_t)arc.ilabel >= symbol_vector.size() ||
+                (size_t)arc.olabel >= symbol_vector.size())
+              {
+                std::ostringstream oss;
+                oss << "FATAL ERROR: arc label " << arc.ilabel << ":"
+                    << arc.olabel << " not in symbol_vector" << std::endl;
+                HFST_THROW_MESSAGE(HfstFatalException, oss.str());
+              }
+
+            StateId target = arc.nextstate;
+            if (target == initial_state)
+              target = 0;
+            else if (target == 0)
+              target = initial_state;
+
+            CsrTransducer::Arc csr_arc;
+            csr_arc.input = harmonization_vector[arc.ilabel];
+            csr_arc.output = harmonization_vector[arc.olabel];
+            csr_arc.target = target;
+            csr_arc.weight = arc.weight.Value();
+            csr->arcs.push_back(csr_arc);
+          }
+        csr->first_arc[state + 1] = (unsigned int)csr->arcs.size();
+
+        if (t->Final(s) != fst::TropicalWeight::Zero()) {
+          csr->final_states[state] = true;
+          csr->final_weights[state] = t->Final(s).Value();
+        }
+      }
+
+    return csr;
+  }
+
+
+  /* ---------------------------------------------------------------------------
+
+     Create an OpenFst transducer equivalent to CsrTransducer \a csr.
+
+     --------------------------------------------------------------------------- */
+
+  fst::StdVectorFst * ConversionFunctions::
+  csr_to_tropical_ofst(const CsrTransducer * csr)
+  {
+    fst::StdVectorFst * t = new fst::StdVectorFst();
+    unsigned int number_of_states = csr->get_number_of_states();
+    t->ReserveStates(number_of_states);
+    for (unsigned int s = 0; s < number_of_states; s++)
+      t->AddState();
+    t->SetStart(0);
+
+    fst::SymbolTable st("");
+    st.AddSymbol(internal_epsilon, 0);
+    st.AddSymbol(internal_unknown, 1);
+    st.AddSymbol(internal_identity, 2);
+    for (std::vector<unsigned int>::const_iterator it = csr->alphabet.begin();
+         it != csr->alphabet.end(); it++) {
+      st.AddSymbol(get_string(*it), *it);
+    }
+
+    for (unsigned int s = 0; s < number_of_states; s++)
+      {
+        t->ReserveArcs(s, csr->first_arc[s+1] - csr->first_arc[s]);
+        for (unsigned int i = csr->first_arc[s]; i < csr->first_arc[s+1]; i++)
+          {
+            const CsrTransducer::Arc & arc = csr->arcs[i];
+            t->AddArc(s, fst::StdArc(arc.input, arc.output,
+                                     arc.weight, arc.target));
+          }
+        if (csr->final_states[s])
+          t->SetFinal(s, csr->final_weights[s]);
+      }
+
+    t->SetInputSymbols(&st);
+    return t;
+  }
+
 #endif // HAVE_OPENFST
 
 
@@ -9,6 +9,7 @@
 // information.
 
 #include "HfstBasicTransducer.h"
+#include "HfstSymbolInterner.h"
 
 #ifndef MAIN_TEST
 
@@ -2892,20 +2893,22 @@
                             HfstState s)
          {
            HfstState current_state = s;
+           HfstSymbolInterner & interner = HfstSymbolInterner::global();
            // Path inserted, return the final state on this path
            while (it != spv.end()) {
-            HfstBasicTransitions tr = state_vector[current_state];
+            const HfstBasicTransitions & tr = state_vector[current_state];
             bool transition_found=false;
             /* The target state of the transition followed or added */
             HfstState next_state;
 
-            // Find the transition
-            // (Searching is slow?)
+            // Find the transition by symbol numbers. A linear search,
+            // HfstTrieBuilder keeps an index for building large tries.
+            unsigned int input = interner.get_number(it->first);
+            unsigned int output = interner.get_number(it->second);
             for (const auto & tr_it: tr)
               {
-                HfstTropicalTransducerTransitionData data = tr_it.get_transition_data();
-                if (data.get_input_symbol().compare(it->first) == 0 &&
-                    data.get_output_symbol().compare(it->second) == 0)
+                if (tr_it.get_input_number() == input &&
+                    tr_it.get_output_number() == output)
                   {
                     transition_found=true;
                     next_state = tr_it.get_target_state();
@@ -832,6 +832,8 @@
          lexicon.disjunct(TOK.tokenize("elephant"), 1.6);
          \endverbatim
          
+         Each call searches the transitions of every state on the path,
+         so for large lexicons HfstTrieBuilder is much faster.
      */
      HFSTDLL HfstBasicTransducer &disjunct
        (const StringPairVector &spv, HfstTropicalTransducerTransitionData::WeightType weight);
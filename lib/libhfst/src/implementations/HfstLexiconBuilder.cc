@@ -0,0 +1,345 @@
+// Copyright (c) 2016 University of Helsinki
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+// See the file COPYING included with this distribution for more
+// information.
+
+#include "HfstLexiconBuilder.h"
+
+#include <unordered_set>
+#include <functional>
+#include <algorithm>
+#include <numeric>
+
+#ifndef MAIN_TEST
+
+ namespace hfst {
+
+   namespace implementations {
+
+     namespace {
+
+       typedef unsigned int Label;
+       typedef unsigned int BuildStateId;
+
+       /* A state of the automaton under construction. Arcs are kept
+          sorted by label because paths are inserted in sorted order. */
+       struct BuildState
+       {
+         std::vector<std::pair<Label, BuildStateId> > arcs;
+         float weight;
+         bool final;
+         BuildState(void): weight(0), final(false) {}
+       };
+
+       typedef std::vector<BuildState> BuildStates;
+
+       /* Two registered states are equivalent if they agree on finality,
+          final weight and arcs. The targets of the arcs are themselves
+          registered, so comparing their numbers is enough. */
+       struct RegisterHash
+       {
+         const BuildStates * states;
+         RegisterHash(const BuildStates * s): states(s) {}
+         size_t operator()(BuildStateId id) const
+         {
+           const BuildState & s = (*states)[id];
+           size_t h = s.final ? std::hash<float>()(s.weight) + 1 : 0;
+           for (const auto & arc: s.arcs)
+             {
+               h = h * 1000003u ^ arc.first;
+               h = h * 1000003u ^ arc.second;
+             }
+           return h;
+         }
+       };
+
+       struct RegisterEqual
+       {
+         const BuildStates * states;
+         RegisterEqual(const BuildStates * s): states(s) {}
+         bool operator()(BuildStateId a, BuildStateId b) const
+         {
+           const BuildState & sa = (*states)[a];
+           const BuildState & sb = (*states)[b];
+           return sa.final == sb.final &&
+             (!sa.final || sa.weight == sb.weight) &&
+             sa.arcs == sb.arcs;
+         }
+       };
+
+       typedef std::unordered_set<BuildStateId, RegisterHash, RegisterEqual>
+         Register;
+
+       /* Minimize the states of \a path that lie deeper than \a keep,
+          deepest first: replace each with an equivalent registered state
+          if there is one, else register it. */
+       void replace_or_register(BuildStates & states, Register & reg,
+                                std::vector<BuildStateId> & free_states,
+                                std::vector<BuildStateId> & path,
+                                size_t keep)
+       {
+         while (path.size() > keep + 1)
+           {
+             BuildStateId child = path.back();
+             path.pop_back();
+             Register::const_iterator it = reg.find(child);
+             if (it != reg.end())
+               {
+                 states[path.back()].arcs.back().second = *it;
+                 states[child] = BuildState();
+                 free_states.push_back(child);
+               }
+             else
+               {
+                 reg.insert(child);
+               }
+           }
+       }
+
+       BuildStateId new_state(BuildStates & states,
+                              std::vector<BuildStateId> & free_states)
+       {
+         if (free_states.empty())
+           {
+             states.push_back(BuildState());
+             return (BuildStateId)(states.size() - 1);
+           }
+         BuildStateId id = free_states.back();
+         free_states.pop_back();
+         return id;
+       }
+
+     }
+
+     size_t HfstLexiconBuilder::StringPairHash::operator()
+       (const StringPair & sp) const
+     {
+       std::hash<std::string> h;
+       return h(sp.first) * 31 + h(sp.second);
+     }
+
+     HfstLexiconBuilder::HfstLexiconBuilder(void)
+     {
+       word_offsets.push_back(0);
+     }
+
+     HfstLexiconBuilder::Label HfstLexiconBuilder::intern(const StringPair & sp)
+     {
+       std::unordered_map<StringPair, Label, StringPairHash>::const_iterator
+         it = label_ids.find(sp);
+       if (it != label_ids.end())
+         return it->second;
+       Label label = (Label)labels.size();
+       labels.push_back(sp);
+       label_ids[sp] = label;
+       return label;
+     }
+
+     void HfstLexiconBuilder::add(const StringPairVector & spv, float weight)
+     {
+       for (const auto & sp: spv)
+         word_labels.push_back(intern(sp));
+       word_offsets.push_back(word_labels.size());
+       word_weights.push_back(weight);
+     }
+
+     size_t HfstLexiconBuilder::size(void) const
+     {
+       return word_weights.size();
+     }
+
+     void HfstLexiconBuilder::clear(void)
+     {
+       label_ids.clear();
+       labels.clear();
+       word_labels.clear();
+       word_offsets.assign(1, 0);
+       word_weights.clear();
+     }
+
+     HfstBasicTransducer HfstLexiconBuilder::get_transducer(void) const
+     {
+       // Sort path indices lexicographically by label sequence, so that
+       // paths sharing a prefix are adjacent.
+       std::vector<size_t> order(word_weights.size());
+       std::iota(order.begin(), order.end(), 0);
+       const Label * data = word_labels.data();
+       const std::vector<size_t> & offsets = word_offsets;
+       std::sort(order.begin(), order.end(),
+                 [data, &offsets](size_t a, size_t b)
+                 {
+                   return std::lexicographical_compare
+                     (data + offsets[a], data + offsets[a+1],
+                      data + offsets[b], data + offsets[b+1]);
+                 });
+
+       BuildStates states(1);
+       std::vector<BuildStateId> free_states;
+       Register reg(1024, RegisterHash(&states), RegisterEqual(&states));
+       std::vector<BuildStateId> path(1, 0);
+       const Label * previous = NULL;
+       size_t previous_length = 0;
+       bool has_previous = false;
+
+       for (size_t index: order)
+         {
+           const Label * word = data + offsets[index];
+           size_t length = offsets[index+1] - offsets[index];
+           float weight = word_weights[index];
+
+           size_t prefix = 0;
+           if (has_previous)
+             {
+               size_t max_prefix = std::min(length, previous_length);
+               while (prefix < max_prefix && word[prefix] == previous[prefix])
+                 ++prefix;
+               if (prefix == length && prefix == previous_length)
+                 {
+                   // The same path again, the smaller weight remains.
+                   BuildState & last = states[path.back()];
+                   if (weight < last.weight)
+                     last.weight = weight;
+                   continue;
+                 }
+             }
+
+           replace_or_register(states, reg, free_states, path, prefix);
+           for (size_t i = prefix; i < length; ++i)
+             {
+               BuildStateId target = new_state(states, free_states);
+               states[path.back()].arcs.push_back
+                 (std::pair<Label, BuildStateId>(word[i], target));
+               path.push_back(target);
+             }
+           states[path.back()].final = true;
+           states[path.back()].weight = weight;
+           previous = word;
+           previous_length = length;
+           has_previous = true;
+         }
+       replace_or_register(states, reg, free_states, path, 0);
+
+       // Number the reachable states depth-first, the root as zero.
+       const BuildStateId unnumbered = (BuildStateId)-1;
+       std::vector<HfstState> numbers(states.size(), unnumbered);
+       std::vector<BuildStateId> agenda(1, 0);
+       std::vector<BuildStateId> numbered;
+       numbers[0] = 0;
+       numbered.push_back(0);
+       while (!agenda.empty())
+         {
+           BuildStateId s = agenda.back();
+           agenda.pop_back();
+           for (const auto & arc: states[s].arcs)
+             {
+               if (numbers[arc.second] == unnumbered)
+                 {
+                   numbers[arc.second] = (HfstState)numbered.size();
+                   numbered.push_back(arc.second);
+                   agenda.push_back(arc.second);
+                 }
+             }
+         }
+
+       HfstBasicTransducer result;
+       result.add_state((HfstState)(numbered.size() - 1));
+       for (BuildStateId s: numbered)
+         {
+           const BuildState & state = states[s];
+           for (const auto & arc: state.arcs)
+             {
+               const StringPair & sp = labels[arc.first];
+               result.add_transition
+                 (numbers[s],
+                  HfstBasicTransition(numbers[arc.second],
+                                      sp.first, sp.second, 0),
+                  false);
+             }
+           if (state.final)
+             result.set_final_weight(numbers[s], state.weight);
+         }
+
+       HfstBasicTransducer::HfstSymbolSet alphabet;
+       for (const auto & sp: labels)
+         {
+           alphabet.insert(sp.first);
+           alphabet.insert(sp.second);
+         }
+       result.add_symbols_to_alphabet(alphabet);
+       return result;
+     }
+
+   }
+
+ }
+
+#else // MAIN_TEST was defined
+#include <iostream>
+#include <cassert>
+
+using namespace hfst::implementations;
+
+/* The final weight of the path \a word in \a t, or -1 if there is none. */
+static float lookup_weight(const HfstBasicTransducer & t, const char * word)
+{
+  HfstState s = 0;
+  for (const char * c = word; *c != '\0'; ++c)
+    {
+      bool found = false;
+      for (const auto & tr: t.transitions(s))
+        {
+          if (tr.get_input_symbol() == std::string(1, *c))
+            {
+              s = tr.get_target_state();
+              found = true;
+              break;
+            }
+        }
+      if (!found)
+        return -1;
+    }
+  return t.is_final_state(s) ? t.get_final_weight(s) : -1;
+}
+
+int main(int argc, char * argv[])
+{
+  std::cout << "Unit tests for " __FILE__ ":" << std::endl;
+
+  HfstLexiconBuilder builder;
+  const char * words[] = { "cats", "dog", "cat", "dogs", "cat", "" };
+  float weights[] = { 4, 2, 3, 4, 0.5, 5 };
+  for (unsigned int i = 0; i < 6; ++i)
+    {
+      hfst::StringPairVector spv;
+      for (const char * c = words[i]; *c != '\0'; ++c)
+        spv.push_back(hfst::StringPair(std::string(1, *c),
+                                       std::string(1, *c)));
+      builder.add(spv, weights[i]);
+    }
+  assert(builder.size() == 6);
+
+  // "cat" and "dog" have different weights, so only the final state
+  // of "cats" and "dogs" is shared: 1 + 4 + 3 states.
+  HfstBasicTransducer lexicon = builder.get_transducer();
+  assert(lexicon.get_max_state() == 7);
+  assert(lexicon.is_final_state(0));
+  assert(lexicon.get_final_weight(0) == 5);
+
+  assert(lookup_weight(lexicon, "cat") == 0.5);
+  assert(lookup_weight(lexicon, "cats") == 4);
+  assert(lookup_weight(lexicon, "dogs") == 4);
+  assert(lookup_weight(lexicon, "do") == -1);
+
+  builder.clear();
+  assert(builder.size() == 0);
+  assert(builder.get_transducer().get_max_state() == 0);
+
+  std::cout << "ok" << std::endl;
+  return EXIT_SUCCESS;
+}
+
+#endif // MAIN_TEST
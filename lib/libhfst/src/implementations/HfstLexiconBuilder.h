@@ -0,0 +1,97 @@
+// Copyright (c) 2016 University of Helsinki
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+// See the file COPYING included with this distribution for more
+// information.
+
+ #ifndef _HFST_LEXICON_BUILDER_H_
+ #define _HFST_LEXICON_BUILDER_H_
+
+ /** @file HfstLexiconBuilder.h
+     @brief Class HfstLexiconBuilder */
+
+ #include <string>
+ #include <vector>
+ #include <unordered_map>
+
+ #include "../HfstDataTypes.h"
+ #include "HfstBasicTransducer.h"
+
+ #include "../hfstdll.h"
+
+ namespace hfst {
+
+   namespace implementations {
+
+     /** @brief A builder for minimal acyclic transducers from large
+         word lists.
+
+         Paths are added with #add in any order. Each symbol pair is
+         interned to an integer label, so a path costs one hash lookup
+         per symbol pair and no graph is built until #get_transducer is
+         called. At that point the paths are sorted and the minimal
+         acyclic transducer is built in one pass with the incremental
+         algorithm for sorted input of Daciuk et al. (2000).
+
+         If the same path is added more than once, the smallest weight
+         wins, as in HfstBasicTransducer::disjunct. All weights are
+         placed in final states.
+
+ \verbatim
+   HfstLexiconBuilder builder;
+   HfstTokenizer TOK;
+   builder.add(TOK.tokenize("dog"), 0.3);
+   builder.add(TOK.tokenize("cat"), 0.5);
+   builder.add(TOK.tokenize("elephant"), 1.6);
+   HfstTransducer lexicon(builder.get_transducer(), TROPICAL_OPENFST_TYPE);
+ \endverbatim
+     */
+     class HfstLexiconBuilder
+     {
+     protected:
+       typedef unsigned int Label;
+
+       struct StringPairHash
+       {
+         size_t operator()(const StringPair & sp) const;
+       };
+
+       /* Interned symbol pairs; labels[i] is the pair of label i. */
+       std::unordered_map<StringPair, Label, StringPairHash> label_ids;
+       std::vector<StringPair> labels;
+
+       /* Path i is word_labels[word_offsets[i] .. word_offsets[i+1]). */
+       std::vector<Label> word_labels;
+       std::vector<size_t> word_offsets;
+       std::vector<float> word_weights;
+
+       Label intern(const StringPair & sp);
+
+     public:
+       HFSTDLL HfstLexiconBuilder(void);
+
+       /** @brief Add the path \a spv with final weight \a weight. */
+       HFSTDLL void add(const StringPairVector & spv, float weight=0);
+
+       /** @brief The number of paths added so far, duplicates
+           included. */
+       HFSTDLL size_t size(void) const;
+
+       /** @brief Remove all paths from the builder. */
+       HFSTDLL void clear(void);
+
+       /** @brief Build the minimal acyclic transducer that accepts
+           exactly the paths added so far.
+
+           The builder is left unchanged, so more paths can be added
+           and the transducer built again. */
+       HFSTDLL HfstBasicTransducer get_transducer(void) const;
+     };
+
+   }
+ }
+
+#endif // #ifndef _HFST_LEXICON_BUILDER_H_
@@ -0,0 +1,186 @@
+// Copyright (c) 2016 University of Helsinki
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+// See the file COPYING included with this distribution for more
+// information.
+
+#include "HfstSymbolInterner.h"
+
+#ifndef MAIN_TEST
+
+namespace hfst {
+
+  namespace implementations {
+
+    HfstSymbolInterner::HfstSymbolInterner(void):
+      symbol_count(0)
+    {
+      for (unsigned int i = 0; i < CHUNK_COUNT; i++)
+        chunks[i].store(NULL, std::memory_order_relaxed);
+      // The special symbols always have the same numbers
+      get_number("@_EPSILON_SYMBOL_@");
+      get_number("@_UNKNOWN_SYMBOL_@");
+      get_number("@_IDENTITY_SYMBOL_@");
+    }
+
+    HfstSymbolInterner::~HfstSymbolInterner(void)
+    {
+      for (unsigned int i = 0; i < CHUNK_COUNT; i++)
+        delete[] chunks[i].load(std::memory_order_relaxed);
+    }
+
+    HfstSymbolInterner & HfstSymbolInterner::global(void)
+    {
+      // Constructed on first use, so that transducers built during
+      // static initialization in other translation units can use it.
+      static HfstSymbolInterner interner;
+      return interner;
+    }
+
+    void HfstSymbolInterner::locate(unsigned int number,
+                                    unsigned int & chunk,
+                                    unsigned int & offset)
+    {
+      // Chunk k holds FIRST_CHUNK_SIZE << k numbers starting from
+      // FIRST_CHUNK_SIZE * (2^k - 1).
+      unsigned int scaled = number / FIRST_CHUNK_SIZE + 1;
+      chunk = 0;
+      while (scaled >>= 1)
+        chunk++;
+      offset = number - FIRST_CHUNK_SIZE * ((1u << chunk) - 1);
+    }
+
+    HfstSymbolInterner::Shard &
+    HfstSymbolInterner::shard_of(const std::string & symbol)
+    {
+      return shards[std::hash<std::string>()(symbol) % SHARD_COUNT];
+    }
+
+    unsigned int HfstSymbolInterner::append(const std::string & symbol)
+    {
+      std::lock_guard<std::mutex> lock(append_mutex);
+      unsigned int number = symbol_count.load(std::memory_order_relaxed);
+      unsigned int chunk, offset;
+      locate(number, chunk, offset);
+      std::string * symbols = chunks[chunk].load(std::memory_order_relaxed);
+      if (symbols == NULL)
+        {
+          symbols = new std::string[FIRST_CHUNK_SIZE << chunk];
+          chunks[chunk].store(symbols, std::memory_order_release);
+        }
+      symbols[offset] = symbol;
+      // Publish the number only after its string is in place
+      symbol_count.store(number + 1, std::memory_order_release);
+      return number;
+    }
+
+    unsigned int HfstSymbolInterner::get_number(const std::string & symbol)
+    {
+      Shard & shard = shard_of(symbol);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      std::unordered_map<std::string, unsigned int>::const_iterator it
+        = shard.numbers.find(symbol);
+      if (it != shard.numbers.end())
+        return it->second;
+      unsigned int number = append(symbol);
+      shard.numbers.insert(std::pair<std::string, unsigned int>
+                           (symbol, number));
+      return number;
+    }
+
+    bool HfstSymbolInterner::find(const std::string & symbol,
+                                  unsigned int & number)
+    {
+      Shard & shard = shard_of(symbol);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      std::unordered_map<std::string, unsigned int>::const_iterator it
+        = shard.numbers.find(symbol);
+      if (it == shard.numbers.end())
+        return false;
+      number = it->second;
+      return true;
+    }
+
+    bool HfstSymbolInterner::has_symbol(unsigned int number) const
+    {
+      return number < symbol_count.load(std::memory_order_acquire);
+    }
+
+    const std::string & HfstSymbolInterner::get_symbol
+      (unsigned int number) const
+    {
+      unsigned int chunk, offset;
+      locate(number, chunk, offset);
+      return chunks[chunk].load(std::memory_order_acquire)[offset];
+    }
+
+    unsigned int HfstSymbolInterner::size(void) const
+    {
+      return symbol_count.load(std::memory_order_acquire);
+    }
+
+  } // namespace implementations
+
+} // namespace hfst
+
+#else // MAIN_TEST was defined
+
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <cassert>
+#include <cstdlib>
+
+using hfst::implementations::HfstSymbolInterner;
+
+int main(int argc, char * argv[])
+{
+  std::cout << "Unit tests for " __FILE__ ":" << std::endl;
+
+  HfstSymbolInterner interner;
+  assert(interner.size() == 3);
+  assert(interner.get_number("@_EPSILON_SYMBOL_@") == 0);
+  assert(interner.get_number("@_IDENTITY_SYMBOL_@") == 2);
+
+  // Several threads interning overlapping symbols must agree on
+  // their numbers, and every number must map back to its symbol.
+  const unsigned int thread_count = 8;
+  const unsigned int symbol_count = 5000;
+  std::vector<std::vector<unsigned int> > numbers
+    (thread_count, std::vector<unsigned int>(symbol_count));
+  std::vector<std::thread> threads;
+  for (unsigned int t = 0; t < thread_count; t++)
+    {
+      threads.push_back(std::thread([&interner, &numbers, t]() {
+            for (unsigned int i = 0; i < symbol_count; i++)
+              {
+                std::ostringstream oss;
+                oss << "sym" << (i * 7 + t) % symbol_count;
+                numbers[t][i] = interner.get_number(oss.str());
+                assert(interner.get_symbol(numbers[t][i]) == oss.str());
+              }
+          }));
+    }
+  for (unsigned int t = 0; t < thread_count; t++)
+    threads[t].join();
+
+  assert(interner.size() == symbol_count + 3);
+  for (unsigned int i = 0; i < symbol_count; i++)
+    {
+      std::ostringstream oss;
+      oss << "sym" << i;
+      unsigned int number;
+      assert(interner.find(oss.str(), number));
+      assert(interner.has_symbol(number));
+      assert(interner.get_symbol(number) == oss.str());
+    }
+
+  std::cout << "ok" << std::endl;
+  return EXIT_SUCCESS;
+}
+
+#endif // MAIN_TEST
@@ -0,0 +1,96 @@
+// Copyright (c) 2016 University of Helsinki
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+// See the file COPYING included with this distribution for more
+// information.
+
+#ifndef _HFST_SYMBOL_INTERNER_H_
+#define _HFST_SYMBOL_INTERNER_H_
+
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+
+#include "../hfstdll.h"
+
+namespace hfst {
+
+  namespace implementations {
+
+    /** @brief A process-wide mapping between symbol strings and numbers
+        that can be used from several threads at once.
+
+        Numbers are given out consecutively starting from zero, and
+        epsilon, unknown and identity are always 0, 1 and 2. A symbol
+        keeps its number and its string keeps its address for the
+        lifetime of the interner.
+
+        \internal The string-to-number direction is a hash map split into
+        shards, each with its own lock, so that threads looking up
+        different symbols seldom contend. The number-to-string direction
+        is an append-only table of chunks that never move. Each chunk
+        is twice the size of the previous one. Readers only load the
+        published size and a chunk pointer and never lock. New symbols
+        are appended under a single lock. They are rare after a
+        grammar's alphabet has been seen once. */
+    class HfstSymbolInterner {
+    public:
+      HFSTDLL HfstSymbolInterner(void);
+      HFSTDLL ~HfstSymbolInterner(void);
+
+      /** @brief The interner shared by all of libhfst. */
+      HFSTDLL static HfstSymbolInterner & global(void);
+
+      /** @brief The number of \a symbol, interning it if needed. */
+      HFSTDLL unsigned int get_number(const std::string & symbol);
+
+      /** @brief Whether \a symbol has a number, stored in \a number. */
+      HFSTDLL bool find(const std::string & symbol,
+                        unsigned int & number);
+
+      /** @brief Whether \a number has been given to some symbol. */
+      HFSTDLL bool has_symbol(unsigned int number) const;
+
+      /** @brief The symbol of \a number.
+
+          @pre has_symbol(\a number) */
+      HFSTDLL const std::string & get_symbol(unsigned int number) const;
+
+      /** @brief The number of symbols interned so far. */
+      HFSTDLL unsigned int size(void) const;
+
+    protected:
+      static const unsigned int SHARD_COUNT = 64;
+      static const unsigned int FIRST_CHUNK_SIZE = 1024;
+      static const unsigned int CHUNK_COUNT = 23;
+
+      struct Shard
+      {
+        std::mutex mutex;
+        std::unordered_map<std::string, unsigned int> numbers;
+      };
+
+      Shard shards[SHARD_COUNT];
+      std::atomic<std::string*> chunks[CHUNK_COUNT];
+      std::atomic<unsigned int> symbol_count;
+      std::mutex append_mutex;
+
+      Shard & shard_of(const std::string & symbol);
+      unsigned int append(const std::string & symbol);
+      static void locate(unsigned int number, unsigned int & chunk,
+                         unsigned int & offset);
+
+    private:
+      HfstSymbolInterner(const HfstSymbolInterner &);
+      HfstSymbolInterner & operator=(const HfstSymbolInterner &);
+    };
+
+  } // namespace implementations
+
+} // namespace hfst
+
+#endif // #ifndef _HFST_SYMBOL_INTERNER_H_
@@ -0,0 +1,213 @@
+// Copyright (c) 2016 University of Helsinki
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+// See the file COPYING included with this distribution for more
+// information.
+
+#include "HfstTrieBuilder.h"
+#include "HfstSymbolInterner.h"
+
+#include <stdint.h>
+
+#ifndef MAIN_TEST
+
+ namespace hfst {
+
+   namespace implementations {
+
+     size_t HfstTrieBuilder::hash(const Arc & arc)
+     {
+       uint64_t h = arc.source;
+       h = h * 0x9e3779b97f4a7c15ULL ^ arc.input;
+       h = h * 0x9e3779b97f4a7c15ULL ^ arc.output;
+       h *= 0x9e3779b97f4a7c15ULL;
+       return (size_t)(h ^ (h >> 32));
+     }
+
+     void HfstTrieBuilder::grow(void)
+     {
+       std::vector<Slot> old_slots(slots.size() * 2);
+       old_slots.swap(slots);
+       size_t mask = slots.size() - 1;
+       for (const auto & slot: old_slots)
+         {
+           if (slot.child == 0)
+             continue;
+           size_t i = hash(slot.arc) & mask;
+           while (slots[i].child != 0)
+             i = (i + 1) & mask;
+           slots[i] = slot;
+         }
+     }
+
+     HfstTrieBuilder::HfstTrieBuilder(void)
+     {
+       clear();
+     }
+
+     unsigned int HfstTrieBuilder::intern(const std::string & symbol)
+     {
+       // The numbers are those of HfstBasicTransition, so that
+       // finalize can create transitions without looking them up again.
+       unsigned int number = HfstSymbolInterner::global().get_number(symbol);
+       if (number >= used_numbers.size())
+         used_numbers.resize(number + 1, false);
+       used_numbers[number] = true;
+       return number;
+     }
+
+     HfstState HfstTrieBuilder::add(const StringPairVector & spv, float weight)
+     {
+       HfstState state = 0;
+       for (const auto & sp: spv)
+         {
+           Arc arc;
+           arc.source = state;
+           arc.input = intern(sp.first);
+           arc.output = intern(sp.second);
+           size_t mask = slots.size() - 1;
+           size_t i = hash(arc) & mask;
+           while (slots[i].child != 0 &&
+                  !(slots[i].arc.source == arc.source &&
+                    slots[i].arc.input == arc.input &&
+                    slots[i].arc.output == arc.output))
+             i = (i + 1) & mask;
+           if (slots[i].child == 0)
+             {
+               slots[i].arc = arc;
+               slots[i].child = (HfstState)incoming.size();
+               incoming.push_back(arc);
+               final_states.push_back(false);
+               final_weights.push_back(0);
+             }
+           state = slots[i].child;
+           // Keep the table at most half full
+           if (incoming.size() * 2 > slots.size())
+             grow();
+         }
+
+       // The same path with smaller weight remains
+       if (!final_states[state] || weight <= final_weights[state])
+         {
+           final_states[state] = true;
+           final_weights[state] = weight;
+         }
+       return state;
+     }
+
+     size_t HfstTrieBuilder::get_state_count(void) const
+     {
+       return incoming.size();
+     }
+
+     void HfstTrieBuilder::clear(void)
+     {
+       incoming.assign(1, Arc());
+       final_states.assign(1, false);
+       final_weights.assign(1, 0);
+       slots.assign(1024, Slot());
+       used_numbers.clear();
+     }
+
+     HfstBasicTransducer HfstTrieBuilder::finalize(void)
+     {
+       HfstBasicTransducer result;
+       result.add_state((HfstState)(incoming.size() - 1));
+       // Targets are numbered in creation order, so visiting them in
+       // order lists the transitions of each state in insertion order.
+       for (HfstState s = 1; s < (HfstState)incoming.size(); ++s)
+         {
+           const Arc & arc = incoming[s];
+           result.add_transition
+             (arc.source,
+              HfstBasicTransition(s, arc.input, arc.output, 0, false),
+              false);
+         }
+       for (HfstState s = 0; s < (HfstState)final_states.size(); ++s)
+         {
+           if (final_states[s])
+             result.set_final_weight(s, final_weights[s]);
+         }
+
+       HfstSymbolInterner & interner = HfstSymbolInterner::global();
+       HfstBasicTransducer::HfstSymbolSet alphabet;
+       for (unsigned int n = 0; n < used_numbers.size(); ++n)
+         {
+           if (used_numbers[n])
+             alphabet.insert(interner.get_symbol(n));
+         }
+       result.add_symbols_to_alphabet(alphabet);
+
+       clear();
+       return result;
+     }
+
+   }
+
+ }
+
+#else // MAIN_TEST was defined
+#include <iostream>
+#include <cassert>
+
+using namespace hfst::implementations;
+
+static hfst::StringPairVector tokenize(const char * word)
+{
+  hfst::StringPairVector spv;
+  for (const char * c = word; *c != '\0'; ++c)
+    spv.push_back(hfst::StringPair(std::string(1, *c), std::string(1, *c)));
+  return spv;
+}
+
+int main(int argc, char * argv[])
+{
+  std::cout << "Unit tests for " __FILE__ ":" << std::endl;
+
+  const char * words[] = { "cats", "dog", "cat", "dogs", "cat", "" };
+  float weights[] = { 4, 2, 3, 4, 0.5, 5 };
+
+  HfstTrieBuilder builder;
+  HfstBasicTransducer expected;
+  for (unsigned int i = 0; i < 6; ++i)
+    {
+      builder.add(tokenize(words[i]), weights[i]);
+      expected.disjunct(tokenize(words[i]), weights[i]);
+    }
+  // 1 + "cats" 4 + "dogs" 4
+  assert(builder.get_state_count() == 9);
+
+  // The same graph as with HfstBasicTransducer::disjunct, state
+  // numbers and transition order included.
+  HfstBasicTransducer trie = builder.finalize();
+  assert(trie.get_max_state() == expected.get_max_state());
+  for (HfstState s = 0; s <= trie.get_max_state(); ++s)
+    {
+      const HfstBasicTransitions & a = trie.transitions(s);
+      const HfstBasicTransitions & b = expected.transitions(s);
+      assert(a.size() == b.size());
+      for (unsigned int i = 0; i < a.size(); ++i)
+        {
+          assert(a[i].get_target_state() == b[i].get_target_state());
+          assert(a[i].get_input_symbol() == b[i].get_input_symbol());
+          assert(a[i].get_output_symbol() == b[i].get_output_symbol());
+        }
+      assert(trie.is_final_state(s) == expected.is_final_state(s));
+      if (trie.is_final_state(s))
+        assert(trie.get_final_weight(s) == expected.get_final_weight(s));
+    }
+  assert(trie.get_final_weight(0) == 5);
+  assert(trie.get_alphabet().count("g") == 1);
+
+  // The builder is empty after finalize.
+  assert(builder.get_state_count() == 1);
+  assert(builder.finalize().get_max_state() == 0);
+
+  std::cout << "ok" << std::endl;
+  return EXIT_SUCCESS;
+}
+
+#endif // MAIN_TEST
@@ -0,0 +1,115 @@
+// Copyright (c) 2016 University of Helsinki
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+// See the file COPYING included with this distribution for more
+// information.
+
+ #ifndef _HFST_TRIE_BUILDER_H_
+ #define _HFST_TRIE_BUILDER_H_
+
+ /** @file HfstTrieBuilder.h
+     @brief Class HfstTrieBuilder */
+
+ #include <vector>
+
+ #include "../HfstDataTypes.h"
+ #include "HfstBasicTransducer.h"
+
+ #include "../hfstdll.h"
+
+ namespace hfst {
+
+   namespace implementations {
+
+     /** @brief A builder for trie-shaped transducers, the fast
+         equivalent of repeated calls to HfstBasicTransducer::disjunct.
+
+         Each path added with #add is followed from the initial state as
+         far as it is already in the trie and the rest is appended. The
+         children of every state are found with one hash lookup per
+         symbol pair, keyed by the state and the interned numbers of the
+         pair, and nothing is copied while a path is inserted.
+
+         #finalize hands back the trie as an HfstBasicTransducer and
+         empties the builder. States are numbered in the order they were
+         created and transitions are listed in the order they were
+         added, so the result is the same graph that
+         HfstBasicTransducer::disjunct would have built from the same
+         paths. If the same path is added more than once, the smallest
+         weight wins. All weights are placed in final states.
+
+ \verbatim
+   HfstTrieBuilder trie;
+   HfstTokenizer TOK;
+   trie.add(TOK.tokenize("dog"), 0.3);
+   trie.add(TOK.tokenize("cat"), 0.5);
+   trie.add(TOK.tokenize("elephant"), 1.6);
+   HfstTransducer lexicon(trie.finalize(), TROPICAL_OPENFST_TYPE);
+ \endverbatim
+
+         Unlike HfstLexiconBuilder, the trie is built as paths are added
+         and is not minimized. */
+     class HfstTrieBuilder
+     {
+     protected:
+       /* The arc leading to a state from its parent. Every state except
+          the initial one has exactly one. */
+       struct Arc
+       {
+         HfstState source;
+         unsigned int input;
+         unsigned int output;
+       };
+
+       /* A slot of the child index; child is zero if the slot is
+          empty, as the initial state is nobody's child. */
+       struct Slot
+       {
+         Arc arc;
+         HfstState child;
+       };
+
+       /* incoming[s] is the arc leading to state s, incoming[0] is
+          unused. */
+       std::vector<Arc> incoming;
+       std::vector<bool> final_states;
+       std::vector<float> final_weights;
+
+       /* The child of a state along an arc, an open-addressing hash
+          table with linear probing whose size is a power of two. */
+       std::vector<Slot> slots;
+
+       /* used_numbers[n] tells whether symbol number n is in the trie. */
+       std::vector<bool> used_numbers;
+
+       unsigned int intern(const std::string & symbol);
+       static size_t hash(const Arc & arc);
+       void grow(void);
+
+     public:
+       HFSTDLL HfstTrieBuilder(void);
+
+       /** @brief Add the path \a spv with final weight \a weight.
+
+           @return The final state of the path. */
+       HFSTDLL HfstState add(const StringPairVector & spv, float weight=0);
+
+       /** @brief The number of states in the trie. */
+       HFSTDLL size_t get_state_count(void) const;
+
+       /** @brief Remove all paths from the builder. */
+       HFSTDLL void clear(void);
+
+       /** @brief Hand back the trie as an HfstBasicTransducer.
+
+           The builder is left empty. */
+       HFSTDLL HfstBasicTransducer finalize(void);
+     };
+
+   }
+ }
+
+#endif // #ifndef _HFST_TRIE_BUILDER_H_
@@ -8,6 +8,7 @@
 // information.
 
 #include "HfstTropicalTransducerTransitionData.h"
+#include "HfstSymbolInterner.h"
 #include <string>
 #include <map>
 #include <set>
@@ -38,18 +39,8 @@ namespace hfst {
         return SymbolType("@_IDENTITY_SYMBOL_@");
       }
 
-    HfstTropicalTransducerTransitionData::Number2SymbolVector
-    HfstTropicalTransducerTransitionData::number2symbol_map;
-    Number2SymbolVectorInitializer
-    dummy1(HfstTropicalTransducerTransitionData::number2symbol_map);
-    HfstTropicalTransducerTransitionData::Symbol2NumberMap
-    HfstTropicalTransducerTransitionData::symbol2number_map;
-    Symbol2NumberMapInitializer
-    dummy2(HfstTropicalTransducerTransitionData::symbol2number_map);
-    unsigned int HfstTropicalTransducerTransitionData::max_number=2;
-
     unsigned int HfstTropicalTransducerTransitionData::get_max_number() {
-      return max_number;
+      return HfstSymbolInterner::global().size() - 1;
     }
 
     std::vector<unsigned int> HfstTropicalTransducerTransitionData::get_harmonization_vector
@@ -70,6 +61,7 @@ namespace hfst {
         (const std::map<HfstTropicalTransducerTransitionData::SymbolType, unsigned int> &symbols)
       {
         std::vector<unsigned int> harmv;
+        unsigned int max_number = get_max_number();
         harmv.reserve(max_number+1);
         harmv.resize(max_number+1, 0);
         for (unsigned int i=0; i<harmv.size(); i++)
@@ -84,7 +76,8 @@ namespace hfst {
 
       const std::string & HfstTropicalTransducerTransitionData::get_symbol(unsigned int number)
       {
-        if (number >= number2symbol_map.size()) {
+        HfstSymbolInterner & interner = HfstSymbolInterner::global();
+        if (!interner.has_symbol(number)) {
           std::string message("HfstTropicalTransducerTransitionData: "
                               "number ");
           std::ostringstream oss;
@@ -94,33 +87,24 @@ namespace hfst {
           HFST_THROW_MESSAGE
             (HfstFatalException, message);
         }
-        return number2symbol_map[number];
+        return interner.get_symbol(number);
       }
 
       unsigned int HfstTropicalTransducerTransitionData::get_number(const std::string &symbol)
       {
         if(symbol.empty()) { // FAIL
-          Symbol2NumberMap::iterator it = symbol2number_map.find(symbol);
-          if (it == symbol2number_map.end()) {
+          unsigned int number;
+          if (!HfstSymbolInterner::global().find(symbol, number)) {
             std::cerr << "ERROR: No number for the empty symbol\n"
                       << std::endl;
           }
           else {
             std::cerr << "ERROR: The empty symbol corresdponds to number "
-                      << it->second << std::endl;
+                      << number << std::endl;
           }
           assert(false);
         }
-
-        Symbol2NumberMap::iterator it = symbol2number_map.find(symbol);
-        if (it == symbol2number_map.end())
-          {
-            max_number++;
-            symbol2number_map[symbol] = max_number;
-            number2symbol_map.push_back(symbol);
-            return max_number;
-          }
-        return it->second;
+        return HfstSymbolInterner::global().get_number(symbol);
       }
 
 
@@ -249,20 +233,6 @@ namespace hfst {
       weight = another.weight;
     }
 
-    Number2SymbolVectorInitializer::Number2SymbolVectorInitializer
-    (HfstTropicalTransducerTransitionData::Number2SymbolVector &vect) {
-      vect.push_back(std::string("@_EPSILON_SYMBOL_@"));
-      vect.push_back(std::string("@_UNKNOWN_SYMBOL_@"));
-      vect.push_back(std::string("@_IDENTITY_SYMBOL_@"));
-    }
-
-    Symbol2NumberMapInitializer::Symbol2NumberMapInitializer
-    (HfstTropicalTransducerTransitionData::Symbol2NumberMap &map) {
-      map["@_EPSILON_SYMBOL_@"] = 0;
-      map["@_UNKNOWN_SYMBOL_@"] = 1;
-      map["@_IDENTITY_SYMBOL_@"] = 2;
-    }
-
   } // namespace implementations
 
 } // namespace hfst
@@ -27,12 +27,6 @@ namespace hfst {
 
   namespace implementations {
 
-    struct string_comparison {
-      bool operator() (const std::string &str1, const std::string &str2) const {
-        return (str1.compare(str2) < 0);
-      }
-    };
-    
     /** @brief One implementation of template class C in
         HfstTransition.
         
@@ -43,8 +37,9 @@ namespace hfst {
         \internal Actually a HfstTropicalTransducerTransitionData has an
         input and an output number of type unsigned int, but this
         implementation is hidden from the user.
-        The class has two static maps and functions that take care of conversion
-        between strings and internal numbers.
+        The numbers are shared by all transitions in the process through
+        HfstSymbolInterner, so that transitions can be created on several
+        threads at once.
         
         @see HfstTransition HfstBasicTransition */
     class HfstTropicalTransducerTransitionData {
@@ -55,24 +50,12 @@ namespace hfst {
       typedef float WeightType;
       /** @brief A set of symbols. */
       typedef std::set<SymbolType> SymbolTypeSet;
-      
-      typedef std::vector<SymbolType>
-        Number2SymbolVector;
-      typedef std::map<SymbolType, unsigned int, string_comparison>
-        Symbol2NumberMap;
 
       HFSTDLL static SymbolType get_epsilon();
       HFSTDLL static SymbolType get_unknown();
       HFSTDLL static SymbolType get_identity();
       
-    public: /* FIXME: Should be private. */
-      /* Maps that contain information of the mappings between strings
-         and numbers */
-      HFSTDLL static Number2SymbolVector number2symbol_map;
-      HFSTDLL static Symbol2NumberMap symbol2number_map;
-      /* The biggest number in use. */
-      HFSTDLL static unsigned int max_number;
-
+    public:
       /* Get the biggest number used to represent a symbol. */
       HFSTDLL static unsigned int get_max_number();
 
@@ -178,9 +161,6 @@ namespace hfst {
       HFSTDLL bool less_than_ignore_weight(const HfstTropicalTransducerTransitionData &another) const;
       HFSTDLL void operator=(const HfstTropicalTransducerTransitionData &another);
       
-      friend class Number2SymbolVectorInitializer;
-      friend class Symbol2NumberMapInitializer;
-
       friend class ComposeIntersectFst;
       friend class ComposeIntersectLexicon;
       friend class ComposeIntersectRule;
@@ -189,20 +169,6 @@ namespace hfst {
 
     };
 
-    // Initialization of static members in class
-    // HfstTropicalTransducerTransitionData..
-    class Number2SymbolVectorInitializer {
-    public:
-      HFSTDLL Number2SymbolVectorInitializer
-        (HfstTropicalTransducerTransitionData::Number2SymbolVector &vect);
-    };
-
-    class Symbol2NumberMapInitializer {
-    public:
-      HFSTDLL Symbol2NumberMapInitializer
-        (HfstTropicalTransducerTransitionData::Symbol2NumberMap &map);
-    };
-
   } // namespace implementations
 
 } // namespace hfst
@@ -185,6 +185,11 @@ namespace hfst {
       return false;
     }
 
+  unsigned int openfst_tropical_minimization_jobs=1;
+  void openfst_tropical_set_minimization_jobs(unsigned int jobs) {
+    openfst_tropical_minimization_jobs = (jobs == 0) ? 1 : jobs;
+  }
+
     // This function can be moved to its own file if TropicalWeightTransducer.o
     // yields a 'File too big' error.
     StdVectorFst * TropicalWeightTransducer::minimize(StdVectorFst * t)
@@ -221,10 +226,19 @@ namespace hfst {
       EncodeMapper<StdArc> encode_mapper
         (hfst::get_encode_weights() ? (kEncodeLabels|kEncodeWeights) : (kEncodeLabels), ENCODE);
       Encode(t, &encode_mapper);
-      StdVectorFst * det = new StdVectorFst();
+      StdVectorFst * det = NULL;
 
-      Determinize<StdArc>(*t, det);
-      Minimize<StdArc>(det);
+      if (openfst_tropical_minimization_jobs > 1)
+        {
+          det = determinize_in_parallel(*t, openfst_tropical_minimization_jobs);
+          minimize_in_parallel(det, openfst_tropical_minimization_jobs);
+        }
+      else
+        {
+          det = new StdVectorFst();
+          Determinize<StdArc>(*t, det);
+          Minimize<StdArc>(det);
+        }
       Decode(det, encode_mapper);
 
       if (w < 0)
@@ -1775,8 +1789,16 @@ namespace hfst {
     EncodeMapper<StdArc> encode_mapper
       (hfst::get_encode_weights() ? (kEncodeLabels|kEncodeWeights) : (kEncodeLabels), ENCODE);
     Encode(t, &encode_mapper);
-    StdVectorFst * det = new StdVectorFst();
-    Determinize<StdArc>(*t, det);
+    StdVectorFst * det = NULL;
+    if (openfst_tropical_minimization_jobs > 1)
+      {
+        det = determinize_in_parallel(*t, openfst_tropical_minimization_jobs);
+      }
+    else
+      {
+        det = new StdVectorFst();
+        Determinize<StdArc>(*t, det);
+      }
     Decode(det, encode_mapper);
 
     if (w < 0)
@@ -2383,25 +2405,54 @@ namespace hfst {
     return t;
   }
 
-  StdVectorFst * TropicalWeightTransducer::compose(StdVectorFst * t1,
-                         StdVectorFst * t2)
+  /* Whether \a t has a cycle whose arcs all have an epsilon output.
+     OpenFst cannot build a label-lookahead matcher for such a transducer. */
+  static bool has_output_epsilon_cycles(const StdVectorFst * t)
   {
-    StringSet foo;
-    // a copy of t2 is created so that its symbol table check sum
-    // is the same as t1's
-    // (else OpenFst complains about non-matching check sums... )
-    StdVectorFst * t2_ = expand_arcs(t2, foo, false);
-    t1->SetOutputSymbols(t1->InputSymbols());
-    t2_->SetInputSymbols(t1->OutputSymbols());
-
-    ArcSort(t1, StdOLabelCompare());
-    ArcSort(t2_, StdILabelCompare());
+    std::vector<StdArc::StateId> order;
+    bool acyclic = true;
+    TopOrderVisitor<StdArc> visitor(&order, &acyclic);
+    DfsVisit(*t, &visitor, OutputEpsilonArcFilter<StdArc>());
+    return !acyclic;
+  }
 
+  StdVectorFst * TropicalWeightTransducer::compose(StdVectorFst * t1,
+                         StdVectorFst * t2,
+                         bool lookahead)
+  {
     StdVectorFst *result = new StdVectorFst();
-    Compose(*t1, *t2_, result);
-    delete t2_;
 
-    t1->SetOutputSymbols(NULL);
+    if (lookahead && !has_output_epsilon_cycles(t1))
+      {
+        // The output labels of t1 are renumbered so that the labels
+        // reachable from each state form intervals, and the input labels
+        // of a copy of t2 accordingly. The renumbering drops the symbol
+        // tables on both sides, so they need no aligning.
+        StdOLabelLookAheadFst la_t1(*t1);
+        StdVectorFst t2_(*t2);
+        LabelLookAheadRelabeler<StdArc>::Relabel(&t2_, la_t1, true);
+
+        // Output lookahead needs the filter that takes the epsilons of
+        // t2 first, so epsilon:x and x:epsilon arcs can come in the
+        // other order than in eager composition.
+        typedef LookAheadMatcher<StdFst> M;
+        typedef LookAheadComposeFilter<AltSequenceComposeFilter<M>, M> F;
+        ComposeFstOptions<StdArc, M, F> opts;
+        // Only the last state is cached, as in eager composition
+        opts.gc_limit = 0;
+        *result = ComposeFst<StdArc>(la_t1, t2_, opts);
+        Connect(result);
+      }
+    else
+      {
+        // The symbol tables must have the same check sum, else OpenFst
+        // complains. The numbers already agree, so t1 simply borrows the
+        // table of t2 instead of t2 being copied.
+        t1->SetOutputSymbols(t2->InputSymbols());
+        ArcSort(t1, StdOLabelCompare());
+        Compose(*t1, *t2, result);
+        t1->SetOutputSymbols(NULL);
+      }
 
     result->SetInputSymbols(t1->InputSymbols());
     return result;
@@ -78,6 +78,8 @@ namespace implementations
   using std::stringstream;
 
   void openfst_tropical_set_hopcroft(bool value);
+  /* Determinize and minimize on \a jobs threads (1 by default). */
+  void openfst_tropical_set_minimization_jobs(unsigned int jobs);
 
   class TropicalWeightInputStream
   {
@@ -179,8 +181,13 @@ namespace implementations
       static void extract_random_paths_fd
         (StdVectorFst *t, HfstTwoLevelPaths &results, int max_num, bool filter_fd);
 
+      /* If \a lookahead is true, \a t1 is wrapped in a label-lookahead
+         matcher so that states of the composition that cannot be
+         continued are not built. Eager composition is used instead if
+         \a t1 has a cycle of arcs with an epsilon output. */
       static StdVectorFst * compose(StdVectorFst * t1,
-                                   StdVectorFst * t2);
+                                   StdVectorFst * t2,
+                                   bool lookahead=false);
       static StdVectorFst * concatenate(StdVectorFst * t1,
                                         StdVectorFst * t2);
       static StdVectorFst * disjunct(StdVectorFst * t1,
@@ -304,6 +311,14 @@ namespace implementations
       static std::ostream * get_warning_stream();
 
     private:
+      /* Defined in TropicalWeightTransducerParallel.cc. They give the same
+         result for any number of threads. It is equivalent to the result
+         of Determinize and Minimize, but not identical: its states may be
+         numbered differently. */
+      static StdVectorFst * determinize_in_parallel
+        (const StdVectorFst & t, unsigned int jobs);
+      static void minimize_in_parallel(StdVectorFst * t, unsigned int jobs);
+
       static fst::SymbolTable create_symbol_table(std::string name);
       static void initialize_symbol_tables(StdVectorFst *t);
       static void remove_symbol_table(StdVectorFst *t);
@@ -0,0 +1,645 @@
+// Copyright (c) 2016 University of Helsinki
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+// See the file COPYING included with this distribution for more
+// information.
+
+/* Multithreaded determinization and minimization of the encoded
+   acceptors that TropicalWeightTransducer::determinize and
+   TropicalWeightTransducer::minimize work on. Both give the same
+   transducer whatever the number of threads: the states are numbered
+   in breadth-first order from the initial state, following arcs in
+   label order. */
+
+#include "TropicalWeightTransducer.h"
+
+#ifdef _MSC_VER
+#include "back-ends/openfstwin/src/include/fst/fstlib.h"
+#else
+#if HAVE_OPENFST_UPSTREAM
+#include <fst/fstlib.h>
+#else
+#include "back-ends/openfst/src/include/fst/fstlib.h"
+#endif
+#endif // _MSC_VER
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#ifndef MAIN_TEST
+
+namespace hfst {
+  namespace implementations {
+
+  namespace {
+
+  typedef StdArc::StateId ArcStateId;
+  typedef StdArc::Label Label;
+
+  /* The number of independently locked parts of the hash tables. */
+  const size_t SHARD_COUNT = 256;
+
+  /* The number of Moore refinement rounds after which a cyclic
+     acceptor is handed over to OpenFst's Hopcroft minimization. Each
+     round costs as much as the whole acceptor, and a cycle can need as
+     many rounds as it has states. */
+  const unsigned int MAX_REFINEMENT_ROUNDS = 256;
+
+  /* Run fun(first, last) on \a jobs threads over [0, size). */
+  template <class F>
+  void for_each_range(unsigned int jobs, size_t size, const F & fun)
+  {
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> errors(jobs);
+    for (unsigned int i = 0; i < jobs; ++i)
+      {
+        size_t first = size * i / jobs;
+        size_t last = size * (i + 1) / jobs;
+        threads.push_back(std::thread([&, i, first, last]()
+          {
+            try
+              { fun(first, last); }
+            catch (...)
+              { errors[i] = std::current_exception(); }
+          }));
+      }
+    for (size_t i = 0; i < threads.size(); ++i)
+      { threads[i].join(); }
+    for (size_t i = 0; i < errors.size(); ++i)
+      {
+        if (errors[i])
+          { std::rethrow_exception(errors[i]); }
+      }
+  }
+
+  /* A hash table from keys to state numbers that several threads can
+     add to at the same time. Numbers are given in the order the keys
+     are first added, which depends on the scheduling of the threads. */
+  template <class K, class H>
+  class ConcurrentStateTable
+  {
+  protected:
+    struct Shard
+    {
+      std::mutex mutex;
+      std::unordered_map<K, ArcStateId, H> states;
+    };
+    std::unique_ptr<Shard[]> shards;
+    std::atomic<ArcStateId> state_count;
+    H hasher;
+
+  public:
+    ConcurrentStateTable():
+      shards(new Shard[SHARD_COUNT]), state_count(0) {}
+
+    /* The number of \a key, which is added if it is new. \a added is
+       set to a pointer to the stored copy of a new key and to NULL
+       otherwise. */
+    ArcStateId find(const K & key, const K ** added)
+    {
+      Shard & shard = shards[hasher(key) % SHARD_COUNT];
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      typename std::unordered_map<K, ArcStateId, H>::iterator it =
+        shard.states.find(key);
+      if (it != shard.states.end())
+        {
+          *added = NULL;
+          return it->second;
+        }
+      ArcStateId s = state_count++;
+      it = shard.states.insert(std::make_pair(key, s)).first;
+      *added = &(it->first);
+      return s;
+    }
+
+    ArcStateId size() const
+    { return state_count; }
+  };
+
+  /* Numbers the states reachable from \a start breadth-first, taking
+     the targets of each state in the order next_states lists them.
+     Returns the states in their new order and sets new_numbers. */
+  template <class N>
+  std::vector<ArcStateId> breadth_first_order
+  (ArcStateId start, ArcStateId state_count, const N & next_states,
+   std::vector<ArcStateId> & new_numbers)
+  {
+    std::vector<ArcStateId> order;
+    new_numbers.assign(state_count, kNoStateId);
+    new_numbers[start] = 0;
+    order.push_back(start);
+    for (size_t i = 0; i < order.size(); ++i)
+      {
+        next_states(order[i], [&](ArcStateId next)
+          {
+            if (new_numbers[next] == kNoStateId)
+              {
+                new_numbers[next] = order.size();
+                order.push_back(next);
+              }
+          });
+      }
+    return order;
+  }
+
+  //
+  // Determinization
+  //
+
+  struct SubsetElement
+  {
+    ArcStateId state;
+    TropicalWeight weight;
+    bool operator==(const SubsetElement & another) const
+    { return state == another.state && weight == another.weight; }
+  };
+
+  /* A determinized state. The elements are ordered by state and carry
+     the residual weights, quantized as OpenFst's Determinize does. */
+  typedef std::vector<SubsetElement> Subset;
+
+  struct SubsetHash
+  {
+    size_t operator()(const Subset & subset) const
+    {
+      size_t h = subset.size();
+      for (Subset::const_iterator it = subset.begin();
+           it != subset.end(); ++it)
+        {
+          h = h * 7853 + it->state;
+          h = h * 7867 + std::hash<float>()(it->weight.Value());
+        }
+      return h;
+    }
+  };
+
+  struct DeterminizedState
+  {
+    ArcStateId state;
+    TropicalWeight final_weight;
+    std::vector<StdArc> arcs;
+  };
+
+  /* Tasks shared between workers. Each worker has a double-ended
+     queue; it takes its newest task from the back and, when it has
+     none, steals the oldest one from the front of another queue. */
+  class WorkStealingFrontier
+  {
+  public:
+    struct Task
+    {
+      ArcStateId state;
+      const Subset * subset;
+    };
+
+  protected:
+    struct Queue
+    {
+      std::mutex mutex;
+      std::deque<Task> tasks;
+    };
+    std::unique_ptr<Queue[]> queues;
+    unsigned int queue_count;
+    // Tasks added and not yet finished
+    std::atomic<size_t> pending;
+
+  public:
+    WorkStealingFrontier(unsigned int workers):
+      queues(new Queue[workers]), queue_count(workers), pending(0) {}
+
+    void push(unsigned int worker, const Task & task)
+    {
+      ++pending;
+      std::lock_guard<std::mutex> lock(queues[worker].mutex);
+      queues[worker].tasks.push_back(task);
+    }
+
+    bool pop(unsigned int worker, Task & task)
+    {
+      {
+        std::lock_guard<std::mutex> lock(queues[worker].mutex);
+        if (! queues[worker].tasks.empty())
+          {
+            task = queues[worker].tasks.back();
+            queues[worker].tasks.pop_back();
+            return true;
+          }
+      }
+      for (unsigned int i = 1; i < queue_count; ++i)
+        {
+          Queue & victim = queues[(worker + i) % queue_count];
+          std::lock_guard<std::mutex> lock(victim.mutex);
+          if (! victim.tasks.empty())
+            {
+              task = victim.tasks.front();
+              victim.tasks.pop_front();
+              return true;
+            }
+        }
+      return false;
+    }
+
+    /* A task that was popped has been handled, including pushing the
+       tasks it gave rise to. */
+    void finish(void)
+    { --pending; }
+
+    bool is_finished(void) const
+    { return pending == 0; }
+  };
+
+  /* A destination element before the elements of the same state are
+     merged. */
+  struct LabelledElement
+  {
+    Label label;
+    ArcStateId state;
+    TropicalWeight weight;
+    bool operator<(const LabelledElement & another) const
+    {
+      if (label != another.label)
+        { return label < another.label; }
+      return state < another.state;
+    }
+  };
+
+  class ParallelDeterminizer
+  {
+  protected:
+    const StdVectorFst & fst;
+    ConcurrentStateTable<Subset, SubsetHash> subsets;
+    WorkStealingFrontier frontier;
+    std::vector<std::vector<DeterminizedState> > expanded;
+    std::atomic<bool> failed;
+
+    /* The arcs and the final weight of a subset, computed the way
+       OpenFst's DeterminizeFsa does so that the weights come out the
+       same. */
+    void expand(unsigned int worker, const WorkStealingFrontier::Task & task,
+                std::vector<LabelledElement> & destinations)
+    {
+      DeterminizedState state;
+      state.state = task.state;
+      state.final_weight = TropicalWeight::Zero();
+      destinations.clear();
+      for (Subset::const_iterator it = task.subset->begin();
+           it != task.subset->end(); ++it)
+        {
+          state.final_weight = Plus(state.final_weight,
+                                    Times(it->weight, fst.Final(it->state)));
+          for (ArcIterator<StdVectorFst> aiter(fst, it->state);
+               !aiter.Done(); aiter.Next())
+            {
+              const StdArc & arc = aiter.Value();
+              LabelledElement destination;
+              destination.label = arc.ilabel;
+              destination.state = arc.nextstate;
+              destination.weight = Times(it->weight, arc.weight);
+              destinations.push_back(destination);
+            }
+        }
+      std::sort(destinations.begin(), destinations.end());
+
+      Subset subset;
+      for (size_t first = 0; first < destinations.size(); )
+        {
+          size_t last = first;
+          TropicalWeight arc_weight = TropicalWeight::Zero();
+          subset.clear();
+          for (; last < destinations.size() &&
+                 destinations[last].label == destinations[first].label;
+               ++last)
+            {
+              const LabelledElement & destination = destinations[last];
+              arc_weight = Plus(arc_weight, destination.weight);
+              if (! subset.empty() &&
+                  subset.back().state == destination.state)
+                {
+                  subset.back().weight = Plus(subset.back().weight,
+                                              destination.weight);
+                }
+              else
+                {
+                  SubsetElement element;
+                  element.state = destination.state;
+                  element.weight = destination.weight;
+                  subset.push_back(element);
+                }
+            }
+          for (Subset::iterator it = subset.begin(); it != subset.end(); ++it)
+            {
+              it->weight = Divide(it->weight, arc_weight, DIVIDE_LEFT)
+                .Quantize(kDelta);
+            }
+
+          const Subset * added = NULL;
+          ArcStateId target = subsets.find(subset, &added);
+          if (added != NULL)
+            {
+              WorkStealingFrontier::Task next = { target, added };
+              frontier.push(worker, next);
+            }
+          state.arcs.push_back(StdArc(destinations[first].label,
+                                      destinations[first].label,
+                                      arc_weight, target));
+          first = last;
+        }
+      expanded[worker].push_back(state);
+    }
+
+    void work(unsigned int worker)
+    {
+      std::vector<LabelledElement> destinations;
+      WorkStealingFrontier::Task task;
+      while (! failed)
+        {
+          if (frontier.pop(worker, task))
+            {
+              expand(worker, task, destinations);
+              frontier.finish();
+            }
+          else if (frontier.is_finished())
+            { break; }
+          else
+            { std::this_thread::yield(); }
+        }
+    }
+
+  public:
+    ParallelDeterminizer(const StdVectorFst & t, unsigned int jobs):
+      fst(t), frontier(jobs), expanded(jobs), failed(false) {}
+
+    StdVectorFst * determinize(void)
+    {
+      StdVectorFst * result = new StdVectorFst();
+      result->SetInputSymbols(fst.InputSymbols());
+      result->SetOutputSymbols(fst.OutputSymbols());
+      if (fst.Start() == kNoStateId)
+        { return result; }
+
+      Subset start;
+      SubsetElement element = { fst.Start(), TropicalWeight::One() };
+      start.push_back(element);
+      const Subset * added = NULL;
+      ArcStateId start_state = subsets.find(start, &added);
+      WorkStealingFrontier::Task task = { start_state, added };
+      frontier.push(0, task);
+
+      unsigned int jobs = expanded.size();
+      std::vector<std::exception_ptr> errors(jobs);
+      std::vector<std::thread> threads;
+      for (unsigned int i = 0; i < jobs; ++i)
+        {
+          threads.push_back(std::thread([&, i]()
+            {
+              try
+                { work(i); }
+              catch (...)
+                {
+                  errors[i] = std::current_exception();
+                  failed = true;
+                }
+            }));
+        }
+      for (size_t i = 0; i < threads.size(); ++i)
+        { threads[i].join(); }
+      for (size_t i = 0; i < errors.size(); ++i)
+        {
+          if (errors[i])
+            {
+              delete result;
+              std::rethrow_exception(errors[i]);
+            }
+        }
+
+      std::vector<const DeterminizedState *> states(subsets.size());
+      for (size_t i = 0; i < expanded.size(); ++i)
+        {
+          for (size_t j = 0; j < expanded[i].size(); ++j)
+            { states[expanded[i][j].state] = &expanded[i][j]; }
+        }
+
+      std::vector<ArcStateId> new_numbers;
+      std::vector<ArcStateId> order = breadth_first_order
+        (start_state, states.size(),
+         [&](ArcStateId s, const std::function<void(ArcStateId)> & visit)
+         {
+           const std::vector<StdArc> & arcs = states[s]->arcs;
+           for (size_t i = 0; i < arcs.size(); ++i)
+             { visit(arcs[i].nextstate); }
+         },
+         new_numbers);
+
+      result->ReserveStates(order.size());
+      for (size_t i = 0; i < order.size(); ++i)
+        { result->AddState(); }
+      result->SetStart(0);
+      for (size_t i = 0; i < order.size(); ++i)
+        {
+          const DeterminizedState & state = *states[order[i]];
+          result->SetFinal(i, state.final_weight);
+          result->ReserveArcs(i, state.arcs.size());
+          for (size_t j = 0; j < state.arcs.size(); ++j)
+            {
+              StdArc arc = state.arcs[j];
+              arc.nextstate = new_numbers[arc.nextstate];
+              result->AddArc(i, arc);
+            }
+        }
+      return result;
+    }
+  };
+
+  //
+  // Minimization
+  //
+
+  /* The class of a state followed by the labels and target classes of
+     its arcs. */
+  typedef std::vector<ArcStateId> Signature;
+
+  struct SignatureHash
+  {
+    size_t operator()(const Signature & signature) const
+    {
+      size_t h = signature.size();
+      for (Signature::const_iterator it = signature.begin();
+           it != signature.end(); ++it)
+        { h = h * 7853 + *it; }
+      return h;
+    }
+  };
+
+  /* Moore's partition refinement of the unweighted deterministic
+     acceptor \a fst, whose arcs are sorted by label. Every round splits
+     the classes of the previous one by the classes the arcs lead to,
+     the states being divided between the threads. Returns false if the
+     partition was not stable after MAX_REFINEMENT_ROUNDS. */
+  bool refine_partition(const StdVectorFst & fst, unsigned int jobs,
+                        std::vector<ArcStateId> & classes)
+  {
+    ArcStateId state_count = fst.NumStates();
+    classes.assign(state_count, 0);
+    bool has_final = false;
+    bool has_nonfinal = false;
+    for (ArcStateId s = 0; s < state_count; ++s)
+      {
+        if (fst.Final(s) != TropicalWeight::Zero())
+          {
+            classes[s] = 1;
+            has_final = true;
+          }
+        else
+          { has_nonfinal = true; }
+      }
+    if (! has_final || ! has_nonfinal)
+      {
+        // Only one class; renumber it as 0
+        classes.assign(state_count, 0);
+      }
+    ArcStateId class_count = (has_final && has_nonfinal) ? 2 : 1;
+
+    std::vector<ArcStateId> new_classes(state_count);
+    for (unsigned int round = 0; round < MAX_REFINEMENT_ROUNDS; ++round)
+      {
+        ConcurrentStateTable<Signature, SignatureHash> signatures;
+        for_each_range(jobs, state_count, [&](size_t first, size_t last)
+          {
+            Signature signature;
+            for (size_t s = first; s < last; ++s)
+              {
+                signature.clear();
+                signature.push_back(classes[s]);
+                for (ArcIterator<StdVectorFst> aiter(fst, s);
+                     !aiter.Done(); aiter.Next())
+                  {
+                    signature.push_back(aiter.Value().ilabel);
+                    signature.push_back(classes[aiter.Value().nextstate]);
+                  }
+                const Signature * added = NULL;
+                new_classes[s] = signatures.find(signature, &added);
+              }
+          });
+        classes.swap(new_classes);
+        if (signatures.size() == class_count)
+          { return true; }
+        class_count = signatures.size();
+      }
+    return false;
+  }
+
+  /* Minimize the unweighted deterministic acceptor \a t. */
+  void minimize_acceptor(StdVectorFst * t, unsigned int jobs)
+  {
+    Connect(t);
+    if (t->NumStates() == 0)
+      { return; }
+    ArcSort(t, StdILabelCompare());
+
+    std::vector<ArcStateId> classes;
+    if (! refine_partition(*t, jobs, classes))
+      {
+        AcceptorMinimize(t);
+        return;
+      }
+
+    // Any state of a class will do, they all have the same arcs
+    ArcStateId class_count =
+      *std::max_element(classes.begin(), classes.end()) + 1;
+    std::vector<ArcStateId> representatives(class_count, kNoStateId);
+    for (ArcStateId s = 0; s < t->NumStates(); ++s)
+      {
+        if (representatives[classes[s]] == kNoStateId)
+          { representatives[classes[s]] = s; }
+      }
+
+    std::vector<ArcStateId> new_numbers;
+    std::vector<ArcStateId> order = breadth_first_order
+      (classes[t->Start()], class_count,
+       [&](ArcStateId c, const std::function<void(ArcStateId)> & visit)
+       {
+         for (ArcIterator<StdVectorFst> aiter(*t, representatives[c]);
+              !aiter.Done(); aiter.Next())
+           { visit(classes[aiter.Value().nextstate]); }
+       },
+       new_numbers);
+
+    StdVectorFst result;
+    result.SetInputSymbols(t->InputSymbols());
+    result.SetOutputSymbols(t->OutputSymbols());
+    result.ReserveStates(order.size());
+    for (size_t i = 0; i < order.size(); ++i)
+      { result.AddState(); }
+    result.SetStart(0);
+    for (size_t i = 0; i < order.size(); ++i)
+      {
+        ArcStateId s = representatives[order[i]];
+        result.SetFinal(i, t->Final(s));
+        result.ReserveArcs(i, t->NumArcs(s));
+        for (ArcIterator<StdVectorFst> aiter(*t, s);
+             !aiter.Done(); aiter.Next())
+          {
+            StdArc arc = aiter.Value();
+            arc.nextstate = new_numbers[classes[arc.nextstate]];
+            result.AddArc(i, arc);
+          }
+      }
+    *t = result;
+  }
+
+  }
+
+  StdVectorFst * TropicalWeightTransducer::determinize_in_parallel
+  (const StdVectorFst & t, unsigned int jobs)
+  {
+    if (t.Properties(kAcceptor | kNoEpsilons, true) !=
+        (kAcceptor | kNoEpsilons))
+      {
+        StdVectorFst * det = new StdVectorFst();
+        Determinize<StdArc>(t, det);
+        return det;
+      }
+    ParallelDeterminizer determinizer(t, jobs);
+    return determinizer.determinize();
+  }
+
+  void TropicalWeightTransducer::minimize_in_parallel
+  (StdVectorFst * t, unsigned int jobs)
+  {
+    uint64 props = t->Properties(kAcceptor | kIDeterministic |
+                                 kWeighted | kUnweighted, true);
+    if (! (props & kAcceptor) || ! (props & kIDeterministic))
+      {
+        Minimize<StdArc>(t);
+      }
+    else if (props & kWeighted)
+      {
+        // As in Minimize, the weights are pushed and encoded in the
+        // labels first
+        Push(t, REWEIGHT_TO_INITIAL, kDelta);
+        ArcMap(t, QuantizeMapper<StdArc>(kDelta));
+        EncodeMapper<StdArc> encoder(kEncodeLabels | kEncodeWeights, ENCODE);
+        Encode(t, &encoder);
+        minimize_acceptor(t, jobs);
+        Decode(t, encoder);
+      }
+    else
+      {
+        minimize_acceptor(t, jobs);
+      }
+  }
+
+  }
+}
+
+#endif // MAIN_TEST
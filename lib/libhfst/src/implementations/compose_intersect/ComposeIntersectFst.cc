@@ -154,6 +154,14 @@ namespace hfst
     {
       if (s >= transition_map_vector.size())
     { HFST_THROW(StateNotDefined); }
+      {
+        std::shared_lock<std::shared_timed_mutex> lock(transition_mutex);
+        SymbolTransitionMap::const_iterator it =
+          transition_map_vector[s].find(symbol);
+        if (it != transition_map_vector[s].end())
+          { return it->second; }
+      }
+      std::unique_lock<std::shared_timed_mutex> lock(transition_mutex);
       if (transition_map_vector.at(s).find(symbol) ==
       transition_map_vector.at(s).end())
     {
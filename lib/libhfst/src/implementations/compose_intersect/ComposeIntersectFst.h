@@ -10,6 +10,8 @@
 
 #include <set>
 #include <map>
+#include <mutex>
+#include <shared_mutex>
 
 #include "ComposeIntersectUtilities.h"
 #include "../../HfstExceptionDefs.h"
@@ -49,6 +51,8 @@ namespace hfst
       ComposeIntersectFst(const HfstBasicTransducer &, bool input_keys);
       ComposeIntersectFst(void);
       virtual ~ComposeIntersectFst(void);
+      // Transitions are computed on first use and cached. Several threads
+      // may call this at once; the returned set stays valid and unchanged.
       virtual const TransitionSet &
     get_transitions(HfstState,size_t);
       virtual float get_final_weight(HfstState) const;
@@ -70,6 +74,8 @@ namespace hfst
       TransitionMapVector transition_map_vector;
       FloatVector finality_vector;
       TransitionVector identity_transition_vector;
+      // Guards the transitions that get_transitions adds to the cache.
+      mutable std::shared_timed_mutex transition_mutex;
     };
   }
 }
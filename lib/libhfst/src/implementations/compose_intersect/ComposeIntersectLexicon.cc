@@ -8,12 +8,32 @@
 // information.
 #include "ComposeIntersectLexicon.h"
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+
 #ifndef MAIN_TEST
 
 namespace hfst
 {
   namespace implementations
   {
+    /* The fewest result states in one breadth-first level that are worth
+       starting a thread for. */
+    static const size_t MIN_STATES_PER_JOB = 128;
+
+    /* Threads take the states of a level in chunks of this size. */
+    static const size_t STATE_CHUNK_SIZE = 32;
+
+    ComposeIntersectLexicon::PendingTransition::PendingTransition
+    (size_t input,size_t output,float weight,const StatePair &target):
+      input(input),
+      output(output),
+      weight(weight),
+      target(target)
+    {}
+
     ComposeIntersectLexicon::ComposeIntersectLexicon
     (const HfstBasicTransducer &t):
       ComposeIntersectFst(t,false)
@@ -29,69 +49,56 @@ namespace hfst
 
     void ComposeIntersectLexicon::clear_all_info(void)
     {
-      state_pair_map.clear();
-      pair_vector.clear();
-
-      while (! agenda.empty())
-    { agenda.pop(); }
-
+      state_pairs.clear();
+      lexicon_non_epsilon_states.clear();
       result = HfstBasicTransducer();
     }
 
-    HfstState ComposeIntersectLexicon::map_state_and_add_to_agenda
-    (const StatePair &p, bool allow_lexicon_epsilons)
-    {
-      HfstState s;
-
-      if (p.first == START && p.second == ComposeIntersectRule::START)
-    { s = 0; }
-      else
-    { s = result.add_state(); }
-
-      // Sanity check...
-      assert(s == state_pair_map.size());
-
-      state_pair_map[p] = s;
-      pair_vector.push_back(p);
-      agenda.push(s);
-      lexicon_non_epsilon_states.insert(s);
-
-      return s;
-    }
-
     bool ComposeIntersectLexicon::can_have_lexicon_epsilons(HfstState s)
-    { return lexicon_non_epsilon_states.count(s) > 0; }
+    { return lexicon_non_epsilon_states.at(s); }
 
     HfstBasicTransducer ComposeIntersectLexicon::compose_with_rules
-    (ComposeIntersectRule * rules)
+    (ComposeIntersectRule * rules, unsigned int jobs)
     {
       clear_all_info();
       StatePair start_pair = StatePair(START,ComposeIntersectRule::START);
 
       // This will return 0.
-      (void)map_state_and_add_to_agenda(start_pair, true);
+      (void)get_state(start_pair, true);
 
-      return compute_composition_result(rules);
+      return compute_composition_result(rules, jobs == 0 ? 1 : jobs);
     }
 
     HfstState ComposeIntersectLexicon::get_state(const StatePair &p,
                                                  bool allow_lexicon_epsilons)
     {
-      if (state_pair_map.find(p) == state_pair_map.end())
+      (void)allow_lexicon_epsilons;
+      bool added = false;
+      HfstState s = state_pairs.insert(p,added);
+      if (added)
     {
-      return map_state_and_add_to_agenda(p, allow_lexicon_epsilons);
+      // A new pair is a new result state, which is now on the agenda.
+      // The start pair is numbered first and is the existing state 0.
+      if (s != 0)
+        {
+          HfstState new_state = result.add_state();
+          // Sanity check...
+          assert(new_state == s);
+          (void)new_state;
+        }
+      lexicon_non_epsilon_states.push_back(true);
     }
-
-      return state_pair_map[p];
+      return s;
     }
 
     void ComposeIntersectLexicon::set_final_state_weights
     (ComposeIntersectRule * rules)
     {
-      for (size_t s = 0; s < pair_vector.size(); ++s)
+      for (size_t s = 0; s < state_pairs.size(); ++s)
     {
-      float lexicon_weight = get_final_weight(pair_vector[s].first);
-      float rules_weight = rules->get_final_weight(pair_vector[s].second);
+      const StatePair &p = state_pairs.get_pair(hfst::size_t_to_uint(s));
+      float lexicon_weight = get_final_weight(p.first);
+      float rules_weight = rules->get_final_weight(p.second);
       if (lexicon_weight != std::numeric_limits<float>::infinity() &&
           rules_weight != std::numeric_limits<float>::infinity())
         { result.set_final_weight(hfst::size_t_to_uint(s),lexicon_weight+rules_weight); }
@@ -99,33 +106,108 @@ namespace hfst
     }
 
     HfstBasicTransducer &ComposeIntersectLexicon::compute_composition_result
-    (ComposeIntersectRule * rules)
+    (ComposeIntersectRule * rules, unsigned int jobs)
     {
-      while (! agenda.empty())
+      // The states are computed one breadth-first level at a time. The
+      // states of a level are numbered before any of them is computed,
+      // and the targets they reach form the next level.
+      HfstState first = 0;
+      while (first < state_pairs.size())
         {
-          HfstState s = agenda.front();
-          agenda.pop();
-          
-          compute_state(s, rules, can_have_lexicon_epsilons(s));
+          HfstState last = hfst::size_t_to_uint(state_pairs.size());
+          if (jobs > 1 && last - first >= 2 * MIN_STATES_PER_JOB)
+            { compute_states_in_parallel(first, last, rules, jobs); }
+          else
+            {
+              PendingTransitionVector transitions;
+              for (HfstState s = first; s < last; ++s)
+                {
+                  transitions.clear();
+                  compute_state(s, rules, can_have_lexicon_epsilons(s),
+                                transitions);
+                  add_transitions(s, transitions);
+                }
+            }
+          first = last;
         }
       
       set_final_state_weights(rules);
       return result;
     }
 
+    void ComposeIntersectLexicon::compute_states_in_parallel
+    (HfstState first, HfstState last, ComposeIntersectRule * rules,
+     unsigned int jobs)
+    {
+      // The threads only find the transitions of each state. Their targets
+      // are numbered afterwards in state order, so that the result is the
+      // same as when the states are computed one by one.
+      size_t size = last - first;
+      std::vector<PendingTransitionVector> transitions(size);
+      std::vector<bool> allow_lexicon_epsilons(size);
+      for (size_t i = 0; i < size; ++i)
+        { allow_lexicon_epsilons[i] =
+            can_have_lexicon_epsilons(hfst::size_t_to_uint(first + i)); }
+
+      size_t thread_count = std::min<size_t>(jobs, size / MIN_STATES_PER_JOB);
+      std::atomic<size_t> next_chunk(0);
+      std::vector<std::exception_ptr> errors(thread_count);
+      std::vector<std::thread> threads;
+      for (size_t t = 0; t < thread_count; ++t)
+        {
+          threads.push_back(std::thread([&, t]()
+            {
+              try
+                {
+                  for (size_t chunk = next_chunk++;
+                       chunk * STATE_CHUNK_SIZE < size;
+                       chunk = next_chunk++)
+                    {
+                      size_t end = std::min
+                        (size, (chunk + 1) * STATE_CHUNK_SIZE);
+                      for (size_t i = chunk * STATE_CHUNK_SIZE; i < end; ++i)
+                        { compute_state
+                            (hfst::size_t_to_uint(first + i), rules,
+                             allow_lexicon_epsilons[i], transitions[i]); }
+                    }
+                }
+              catch (...)
+                { errors[t] = std::current_exception(); }
+            }));
+        }
+      for (size_t t = 0; t < threads.size(); ++t)
+        { threads[t].join(); }
+      for (size_t t = 0; t < errors.size(); ++t)
+        {
+          if (errors[t])
+            { std::rethrow_exception(errors[t]); }
+        }
+
+      for (size_t i = 0; i < size; ++i)
+        {
+          add_transitions(hfst::size_t_to_uint(first + i), transitions[i]);
+          PendingTransitionVector().swap(transitions[i]);
+        }
+    }
+
     ComposeIntersectLexicon::StatePair ComposeIntersectLexicon::get_pair
     (HfstState s)
     {
-      if (s >= pair_vector.size())
+      if (s >= state_pairs.size())
     { HFST_THROW(StateNotDefined); }
 
-      return pair_vector[s];
+      return state_pairs.get_pair(s);
     }
 
+    // Only reads the lexicon and the result states numbered so far, so
+    // that several threads can compute different states at once.
     void ComposeIntersectLexicon::compute_state
-    (HfstState state,ComposeIntersectRule * rules, bool allow_lexicon_epsilons)
+    (HfstState state,ComposeIntersectRule * rules, bool allow_lexicon_epsilons,
+     PendingTransitionVector &transitions)
     {
-      StatePair p = get_pair(state);
+      StatePair p = state_pairs.get_pair(state);
+      const size_t epsilon = HfstTropicalTransducerTransitionData::get_number
+        ("@_EPSILON_SYMBOL_@");
 
       //bool lexicon_eps_transition_found = false;
       
@@ -134,68 +216,105 @@ namespace hfst
        it != transition_map_vector[p.first].end();
        ++it)
     {
-      if (it->first == HfstTropicalTransducerTransitionData::get_number
-          ("@_EPSILON_SYMBOL_@"))
+      if (it->first == epsilon)
         {
           if (allow_lexicon_epsilons)
             {
-              lexicon_skip_symbol_compose(it->second,p.second,state);
+              lexicon_skip_symbol_compose(it->second,p.second,transitions);
               //lexicon_eps_transition_found = true;
             }
         }
       else if (is_flag_diacritic(it->first) &&
            (! rules->known_symbol(it->first)))
         {
-          lexicon_skip_symbol_compose(it->second,p.second,state);
+          lexicon_skip_symbol_compose(it->second,p.second,transitions);
           //lexicon_eps_transition_found = true;
         }
       else
         {
           compose(it->second,rules->get_transitions
-                  (p.second,it->first),state);
+                  (p.second,it->first),transitions);
         }
     }
       
       rule_skip_symbol_compose
-        (rules->get_transitions
-         (p.second,HfstTropicalTransducerTransitionData::get_number
-          ("@_EPSILON_SYMBOL_@")),p.first,state);
+        (rules->get_transitions(p.second,epsilon),p.first,transitions);
+      order_tied_transitions(rules,transitions);
+    }
+
+    // Transitions that differ only in the rule state of their target are
+    // in the order of the numbers of those states. For a rule pair, the
+    // numbers depend on the order in which threads reached the states,
+    // so such transitions are sorted by the states of the single rules.
+    void ComposeIntersectLexicon::order_tied_transitions
+    (ComposeIntersectRule * rules,PendingTransitionVector &transitions)
+    {
+      size_t begin = 0;
+      while (begin < transitions.size())
+        {
+          const PendingTransition &first = transitions[begin];
+          size_t end = begin + 1;
+          while (end < transitions.size() &&
+                 transitions[end].input == first.input &&
+                 transitions[end].output == first.output &&
+                 transitions[end].weight == first.weight &&
+                 transitions[end].target.first == first.target.first)
+            { ++end; }
+          if (end - begin > 1)
+            {
+              std::vector<std::pair<std::vector<HfstState>,size_t> >
+                keys(end - begin);
+              for (size_t i = begin; i < end; ++i)
+                {
+                  rules->get_rule_states(transitions[i].target.second,
+                                         keys[i - begin].first);
+                  keys[i - begin].second = i;
+                }
+              std::sort(keys.begin(),keys.end());
+              PendingTransitionVector ordered;
+              for (size_t i = 0; i < keys.size(); ++i)
+                { ordered.push_back(transitions[keys[i].second]); }
+              std::copy(ordered.begin(),ordered.end(),
+                        transitions.begin() + begin);
+            }
+          begin = end;
+        }
     }
 
 
     void ComposeIntersectLexicon::lexicon_skip_symbol_compose
-    (const TransitionSet &transitions,HfstState rule_state,HfstState origin)
+    (const TransitionSet &transitions,HfstState rule_state,
+     PendingTransitionVector &pending)
     {
       for (TransitionSet::const_iterator it = transitions.begin();
            it != transitions.end();
            ++it)
         {
-          add_transition
-            (origin,it->ilabel,it->olabel,it->weight,
-             get_state(StatePair(it->target,rule_state)));
+          pending.push_back
+            (PendingTransition(it->ilabel,it->olabel,it->weight,
+                               StatePair(it->target,rule_state)));
         }
     }
 
     void ComposeIntersectLexicon::rule_skip_symbol_compose
-    (const TransitionSet &transitions,HfstState lex_state,HfstState origin)
+    (const TransitionSet &transitions,HfstState lex_state,
+     PendingTransitionVector &pending)
     {
       for (TransitionSet::const_iterator it = transitions.begin();
        it != transitions.end();
        ++it)
     {
-      add_transition
-        (origin,it->ilabel,it->olabel,it->weight,
-         get_state(StatePair(lex_state,it->target), false));
+      pending.push_back
+        (PendingTransition(it->ilabel,it->olabel,it->weight,
+                           StatePair(lex_state,it->target)));
     }
 
     }
 
     void ComposeIntersectLexicon::compose
     (const TransitionSet &lex_transitions,
-     const TransitionSet &rule_transitions,HfstState origin)
+     const TransitionSet &rule_transitions,PendingTransitionVector &pending)
     {
-      StatePair p = get_pair(origin);
-      (void)p;
       for (TransitionSet::const_iterator it = lex_transitions.begin();
        it != lex_transitions.end();
        ++it)
@@ -203,12 +322,24 @@ namespace hfst
       for (TransitionSet::const_iterator jt = rule_transitions.begin();
            jt != rule_transitions.end();
            ++jt)
-        { add_transition
-        (origin,it->ilabel,jt->olabel,it->weight + jt->weight,
-         get_state(StatePair(it->target,jt->target))); }
+        { pending.push_back
+        (PendingTransition(it->ilabel,jt->olabel,it->weight + jt->weight,
+                           StatePair(it->target,jt->target))); }
     }
     }
 
+    void ComposeIntersectLexicon::add_transitions
+    (HfstState origin,const PendingTransitionVector &transitions)
+    {
+      for (PendingTransitionVector::const_iterator it = transitions.begin();
+           it != transitions.end();
+           ++it)
+        {
+          add_transition(origin,it->input,it->output,it->weight,
+                         get_state(it->target));
+        }
+    }
+
     void ComposeIntersectLexicon::add_transition
     (HfstState origin, size_t input,size_t output,
      float weight,HfstState target)
@@ -231,6 +362,7 @@ namespace hfst
 using namespace hfst;
 using namespace implementations;
 #include <cassert>
+#include <sstream>
 int main(int argc, char * argv[])
 {
     std::cout << "Unit tests for " __FILE__ ":" << std::endl;
@@ -308,6 +440,85 @@ int main(int argc, char * argv[])
   lex_fst.minimize();
   std::cerr << lex_fst << std::endl;
 
+  // A trie of all strings of a and b of length 10, whose deepest levels
+  // are large enough to be computed in parallel.
+  HfstBasicTransducer trie;
+  std::vector<HfstState> level(1, 0);
+  for (int depth = 0; depth < 10; ++depth)
+    {
+      std::vector<HfstState> next_level;
+      for (size_t i = 0; i < level.size(); ++i)
+        {
+          HfstState a = trie.add_state();
+          HfstState b = trie.add_state();
+          trie.add_transition(level[i], HfstBasicTransition(a, "a", "a", 0));
+          trie.add_transition(level[i], HfstBasicTransition(b, "b", "b", 0));
+          next_level.push_back(a);
+          next_level.push_back(b);
+        }
+      level.swap(next_level);
+    }
+  for (size_t i = 0; i < level.size(); ++i)
+    { trie.set_final_weight(level[i], 0); }
+
+  // Rules that count the a's modulo 2, 3 and 4 and the symbols read, so
+  // that the deepest levels reach new states of the rule pairs. Each a
+  // goes to two states with alike transitions but different final
+  // weights, and the transitions to them tie in their order.
+  std::vector<HfstBasicTransducer> ambiguous_rules;
+  for (HfstState modulus = 2; modulus <= 4; ++modulus)
+    {
+      HfstBasicTransducer rule;
+      for (HfstState depth = 0; depth <= 10; ++depth)
+        {
+          for (HfstState count = 0; count < modulus; ++count)
+            {
+              for (HfstState copy = 0; copy < 2; ++copy)
+                {
+                  HfstState s = (depth * modulus + count) * 2 + copy;
+                  rule.add_state(s);
+                  rule.set_final_weight(s, static_cast<float>(copy));
+                  if (depth == 10)
+                    { continue; }
+                  HfstState next = (depth + 1) * modulus;
+                  HfstState next_count = (count + 1) % modulus;
+                  rule.add_transition
+                    (s, HfstBasicTransition
+                     ((next + next_count) * 2, "a", "a", 0));
+                  rule.add_transition
+                    (s, HfstBasicTransition
+                     ((next + next_count) * 2 + 1, "a", "a", 0));
+                  rule.add_transition
+                    (s, HfstBasicTransition
+                     ((next + count) * 2 + 1, "b", "b", 0));
+                }
+            }
+        }
+      ambiguous_rules.push_back(rule);
+    }
+
+  // The result is the same, states numbered alike, for any number of jobs.
+  std::string serial_result;
+  for (unsigned int jobs = 1; jobs <= 4; jobs += 3)
+    {
+      for (int round = 0; round < (jobs == 1 ? 1 : 10); ++round)
+        {
+          ComposeIntersectRulePair rule_pairs
+            (new ComposeIntersectRule(ambiguous_rules[0]),
+             new ComposeIntersectRulePair
+             (new ComposeIntersectRule(ambiguous_rules[1]),
+              new ComposeIntersectRule(ambiguous_rules[2])));
+          ComposeIntersectLexicon trie_lexicon(trie);
+          std::ostringstream result;
+          trie_lexicon.compose_with_rules(&rule_pairs, jobs).write_in_att_format
+            (result);
+          if (jobs == 1)
+            { serial_result = result.str(); }
+          else
+            { assert(result.str() == serial_result); }
+        }
+    }
+
   std::cout << "ok" << std::endl;
   return 0;
 }
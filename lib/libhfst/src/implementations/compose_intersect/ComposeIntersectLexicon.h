@@ -9,8 +9,7 @@
 #ifndef COMPOSE_INTERSECT_LEXICON_H
 #define COMPOSE_INTERSECT_LEXICON_H
 
-#include <queue>
-#include <set>
+#include <vector>
 
 #ifdef HAVE_CONFIG_H
 #  include "config.h"
@@ -29,38 +28,54 @@ namespace hfst
       typedef ComposeIntersectFst::SymbolTransitionMap SymbolTransitionMap;
       ComposeIntersectLexicon(const HfstBasicTransducer &);
       ComposeIntersectLexicon(void);
-      HfstBasicTransducer compose_with_rules(ComposeIntersectRule *);
+      // The result is the same, states numbered alike, for any number of
+      // jobs.
+      HfstBasicTransducer compose_with_rules(ComposeIntersectRule *,
+                                             unsigned int jobs=1);
     protected:
-      typedef std::pair<HfstState,HfstState> StatePair;
-      typedef std::map<StatePair,HfstState> StatePairMap;
-      typedef std::set<HfstState> StateSet;
+      typedef compose_intersect_utilities::StatePairTable StatePairTable;
+      typedef StatePairTable::StatePair StatePair;
 
-      typedef std::vector<StatePair> PairVector;
-      typedef std::queue<HfstState> StateQueue;
+      // A transition of a result state whose target is not numbered yet.
+      struct PendingTransition
+      {
+        size_t input;
+        size_t output;
+        float weight;
+        StatePair target;
+        PendingTransition(size_t,size_t,float,const StatePair &);
+      };
+      typedef std::vector<PendingTransition> PendingTransitionVector;
 
-
-      StatePairMap state_pair_map;
-      PairVector   pair_vector;
-      StateQueue   agenda;
+      // Pairs of a lexicon state and a rule state, numbered in the order
+      // in which they are reached. This is also the breadth-first agenda:
+      // the states that are numbered but not yet computed are waiting.
+      StatePairTable state_pairs;
       HfstBasicTransducer result;
-      StateSet lexicon_non_epsilon_states;
+      std::vector<bool> lexicon_non_epsilon_states;
 
       bool is_flag_diacritic(size_t);
       HfstState get_state(const StatePair &, bool allow_lexicon_epsilons=true);
       StatePair get_pair(HfstState);
       void clear_all_info(void);
-      HfstState map_state_and_add_to_agenda(const StatePair &,
-                                            bool allow_lexicon_epsilons);
       HfstBasicTransducer &compute_composition_result
-    (ComposeIntersectRule *);
+    (ComposeIntersectRule *,unsigned int jobs);
+      void compute_states_in_parallel
+    (HfstState first,HfstState last,ComposeIntersectRule *,unsigned int jobs);
       void compute_state(HfstState state,ComposeIntersectRule *,
-                         bool allow_lexicon_epsilons);
+                         bool allow_lexicon_epsilons,
+                         PendingTransitionVector &);
+      void order_tied_transitions(ComposeIntersectRule *,
+                                  PendingTransitionVector &);
+      void add_transitions(HfstState,const PendingTransitionVector &);
       bool can_have_lexicon_epsilons(HfstState s);
       void set_final_state_weights(ComposeIntersectRule *);
       void lexicon_skip_symbol_compose
-    (const TransitionSet &,HfstState,HfstState);
-      void rule_skip_symbol_compose(const TransitionSet &,HfstState,HfstState);
-      void compose(const TransitionSet &,const TransitionSet &,HfstState);
+    (const TransitionSet &,HfstState,PendingTransitionVector &);
+      void rule_skip_symbol_compose
+    (const TransitionSet &,HfstState,PendingTransitionVector &);
+      void compose(const TransitionSet &,const TransitionSet &,
+                   PendingTransitionVector &);
       void add_transition
     (HfstState, size_t,size_t,float,HfstState);
       void identity_compose
@@ -24,6 +24,9 @@ namespace hfst
     { return
         symbols.count(HfstTropicalTransducerTransitionData::get_symbol(hfst::size_t_to_uint(symbol)))
     > 0; }
+    void ComposeIntersectRule::get_rule_states
+    (HfstState s,std::vector<HfstState> &states)
+    { states.push_back(s); }
   }
 }
 
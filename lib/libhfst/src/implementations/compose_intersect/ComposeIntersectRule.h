@@ -10,6 +10,8 @@
 #ifndef COMPOSE_INTERSECT_RULE_H
 #define COMPOSE_INTERSECT_RULE_H
 
+#include <vector>
+
 #include "ComposeIntersectFst.h"
 
 namespace hfst
@@ -22,6 +24,11 @@ namespace hfst
       ComposeIntersectRule(const HfstBasicTransducer &);
       ComposeIntersectRule(void);
       bool known_symbol(size_t symbol);
+      // Appends the states of the rules that s is made of. Unlike the
+      // numbers of the states of a rule pair, these do not depend on the
+      // order in which threads reach the states.
+      virtual void get_rule_states(HfstState s,
+                                   std::vector<HfstState> &states);
     protected:
       StringSet symbols;
     };
@@ -23,13 +23,9 @@ namespace hfst
     {
       ComposeIntersectRule::symbol_set = fst1->get_symbols();
 
-      pair_state_map[StatePair(ComposeIntersectRule::START,
-                   ComposeIntersectRule::START)] = START;
-
-      state_pair_vector.push_back(StatePair(ComposeIntersectRule::START,
-                        ComposeIntersectRule::START));
-
-      state_transition_vector.push_back(SymbolTransitionMap());
+      // This will return START.
+      (void)get_state(StatePair(ComposeIntersectRule::START,
+                                ComposeIntersectRule::START));
     }
 
     ComposeIntersectRulePair::~ComposeIntersectRulePair(void)
@@ -42,35 +38,33 @@ namespace hfst
     ComposeIntersectRulePair::get_transitions
     (HfstState s,size_t symbol)
     {
-      if (! has_state(s))
-    { HFST_THROW(StateNotDefined); }
-      if (! transitions_computed(s,symbol))
-    { compute_transition_set(s,symbol); }
-      return state_transition_vector[s][symbol];
+      {
+        std::shared_lock<std::shared_timed_mutex> lock(transition_mutex);
+        if (! has_state(s))
+      { HFST_THROW(StateNotDefined); }
+        SymbolTransitionMap::const_iterator it =
+          state_transition_vector[s].find(symbol);
+        if (it != state_transition_vector[s].end())
+          { return it->second; }
+      }
+      std::unique_lock<std::shared_timed_mutex> lock(transition_mutex);
+      SymbolTransitionMap::const_iterator it =
+        state_transition_vector[s].find(symbol);
+      if (it != state_transition_vector[s].end())
+        { return it->second; }
+      return compute_transition_set(s,symbol);
     }
     
     bool ComposeIntersectRulePair::has_state(HfstState s) const
-    { return s < state_pair_vector.size(); }
-    
-    bool ComposeIntersectRulePair::has_pair
-    (const ComposeIntersectRulePair::StatePair &p) const
-    { return pair_state_map.find(p) != pair_state_map.end(); }
-    
-    bool ComposeIntersectRulePair::transitions_computed
-    (HfstState state,size_t symbol)
-    { return state_transition_vector.at(state).find(symbol)
-    != state_transition_vector.at(state).end(); }
+    { return s < state_pairs.size(); }
     
     HfstState ComposeIntersectRulePair::get_state(const StatePair &p)
     {
-      if (! has_pair(p))
-    {
-      pair_state_map[p] = hfst::size_t_to_uint(state_pair_vector.size());
-      state_pair_vector.push_back(p);
-      state_transition_vector.push_back(SymbolTransitionMap());
-      return hfst::size_t_to_uint(state_pair_vector.size() - 1);
-    }
-      return pair_state_map[p];
+      bool added = false;
+      HfstState s = state_pairs.insert(p,added);
+      if (added)
+        { state_transition_vector.push_back(SymbolTransitionMap()); }
+      return s;
     }
 
     void ComposeIntersectRulePair::add_transition
@@ -83,17 +77,37 @@ namespace hfst
 
     float ComposeIntersectRulePair::get_final_weight(HfstState s) const
     {
-      if (! has_state(s))
-    { HFST_THROW(StateNotDefined); }
-      const StatePair &state_pair = state_pair_vector[s];
+      StatePair state_pair;
+      {
+        std::shared_lock<std::shared_timed_mutex> lock(transition_mutex);
+        if (! has_state(s))
+      { HFST_THROW(StateNotDefined); }
+        state_pair = state_pairs.get_pair(s);
+      }
       return fst1->get_final_weight(state_pair.first) +
     fst2->get_final_weight(state_pair.second);
     }
 
-    void ComposeIntersectRulePair::compute_transition_set
+    void ComposeIntersectRulePair::get_rule_states
+    (HfstState s,std::vector<HfstState> &states)
+    {
+      StatePair state_pair;
+      {
+        std::shared_lock<std::shared_timed_mutex> lock(transition_mutex);
+        if (! has_state(s))
+      { HFST_THROW(StateNotDefined); }
+        state_pair = state_pairs.get_pair(s);
+      }
+      fst1->get_rule_states(state_pair.first,states);
+      fst2->get_rule_states(state_pair.second,states);
+    }
+
+    // Called with transition_mutex locked for writing.
+    const ComposeIntersectRulePair::TransitionSet &
+    ComposeIntersectRulePair::compute_transition_set
     (HfstState state, size_t symbol)
     {
-      StatePair state_pair = state_pair_vector[state];
+      StatePair state_pair = state_pairs.get_pair(state);
       const ComposeIntersectRule::TransitionSet &fst1_transitions =
     fst1->get_transitions(state_pair.first,symbol);
       ComposeIntersectRule::TransitionSet::const_iterator it =
@@ -103,24 +117,36 @@ namespace hfst
       ComposeIntersectRule::TransitionSet::const_iterator jt =
     fst2_transitions.begin();
  
-      (void)state_transition_vector[state][symbol];
       TransitionSet transitions;
       while (it != fst1_transitions.end() && jt != fst2_transitions.end())
     {
       if (it->olabel == jt->olabel)
         {
+          // Pair every transition with this output symbol in fst1 with
+          // every one in fst2. Pairing them in their order in the sets
+          // would depend on how the states of a rule pair are numbered.
           size_t output = it->olabel;
-          HfstState target = get_state(StatePair(it->target,jt->target));
-          float weight = it->weight + jt->weight;
-          add_transition(transitions,target,symbol,output,weight);
-          ++it; ++jt;
+          ComposeIntersectRule::TransitionSet::const_iterator kt = jt;
+          for ( ; it != fst1_transitions.end() && it->olabel == output; ++it)
+            {
+              for (kt = jt;
+                   kt != fst2_transitions.end() && kt->olabel == output;
+                   ++kt)
+                {
+                  HfstState target =
+                    get_state(StatePair(it->target,kt->target));
+                  float weight = it->weight + kt->weight;
+                  add_transition(transitions,target,symbol,output,weight);
+                }
+            }
+          jt = kt;
         }
       else if (it->olabel < jt->olabel)
         { ++it; }
       else
         { ++jt; }
     }
-      state_transition_vector[state][symbol] = transitions;
+      return state_transition_vector[state][symbol] = transitions;
     }
   }
 }
@@ -9,10 +9,10 @@
 #ifndef COMPOSE_INTERSECT_RULE_PAIR_H
 #define COMPOSE_INTERSECT_RULE_PAIR_H
 
-#include <map>
+#include <deque>
 #include <string>
+#include <unordered_map>
 #include <vector>
-#include <string>
 
 #include "ComposeIntersectRule.h"
 
@@ -36,19 +36,23 @@ namespace hfst
 
       float get_final_weight(HfstState) const;
 
+      virtual void get_rule_states(HfstState,std::vector<HfstState> &);
+
 #ifdef MAIN_TEST
       std::ostream &print(std::ostream &);
 #endif
       
     protected:
-      typedef std::pair<HfstState,HfstState> StatePair;
-      typedef std::vector<StatePair> StatePairVector;
-      typedef std::map<StatePair,HfstState> PairStateMap;
-      typedef std::map<size_t,TransitionSet> SymbolTransitionMap;
-      typedef std::vector<SymbolTransitionMap> StateTransitionVector;
+      typedef compose_intersect_utilities::StatePairTable StatePairTable;
+      typedef StatePairTable::StatePair StatePair;
+      typedef std::unordered_map<size_t,TransitionSet> SymbolTransitionMap;
+      // A deque, so that adding states does not move the transition sets
+      // that get_transitions has returned.
+      typedef std::deque<SymbolTransitionMap> StateTransitionVector;
 
-      StatePairVector state_pair_vector;
-      PairStateMap pair_state_map;
+      // The pairs of states of fst1 and fst2 that have been reached so
+      // far. Only those are states of the intersection.
+      StatePairTable state_pairs;
       
       StateTransitionVector state_transition_vector;
 
@@ -56,9 +60,7 @@ namespace hfst
       ComposeIntersectRule * fst2;
 
       bool has_state(HfstState s) const;
-      bool has_pair(const StatePair&) const;
-      bool transitions_computed(HfstState,size_t);
-      void compute_transition_set(HfstState,size_t);
+      const TransitionSet &compute_transition_set(HfstState,size_t);
       HfstState get_state(const StatePair &);
       void add_transition
     (TransitionSet &,HfstState target,size_t,size_t,float);
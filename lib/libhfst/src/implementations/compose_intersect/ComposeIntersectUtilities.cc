@@ -101,6 +101,23 @@ int main(int argc, char * argv[])
   sset.insert(2);
   assert(! sset.has_element(1));
 
+  using hfst::implementations::compose_intersect_utilities::StatePairTable;
+  typedef StatePairTable::StatePair StatePair;
+  StatePairTable table;
+  bool added = false;
+  assert(table.insert(StatePair(0,0),added) == 0 && added);
+  assert(table.insert(StatePair(1,0),added) == 1 && added);
+  assert(table.insert(StatePair(0,1),added) == 2 && added);
+  assert(table.insert(StatePair(1,0),added) == 1 && ! added);
+  assert(table.insert(StatePair(4000000000u,7),added) == 3 && added);
+  assert(table.insert(StatePair(7,4000000000u),added) == 4 && added);
+  assert(table.size() == 5);
+  assert(table.get_pair(2) == StatePair(0,1));
+  assert(table.get_pair(3) == StatePair(4000000000u,7));
+  table.clear();
+  assert(table.size() == 0);
+  assert(table.insert(StatePair(1,0),added) == 0 && added);
+
   std::cout << "ok" << std::endl;
   return 0;
 }
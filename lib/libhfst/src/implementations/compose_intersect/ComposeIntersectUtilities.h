@@ -17,6 +17,7 @@
 #include <vector>
 #include <algorithm>
 #include <utility>
+#include <unordered_map>
 
 namespace hfst
 {
@@ -118,6 +119,49 @@ namespace hfst
       { container_.insert(least_upper_bound,x); }
       };
 
+      /* Numbers pairs of states consecutively from zero in the order in
+         which they are first seen. A pair is found by hashing both state
+         numbers packed into one 64-bit key. */
+      class StatePairTable
+      {
+      public:
+        typedef std::pair<unsigned int,unsigned int> StatePair;
+
+        /* The number of \a p, giving it the next free number if it has
+           none. \a added tells whether it was given one. */
+        unsigned int insert(const StatePair &p,bool &added)
+        {
+          std::pair<NumberMap::iterator,bool> result =
+            numbers.insert
+            (NumberMap::value_type(key(p),(unsigned int)pairs.size()));
+          added = result.second;
+          if (added)
+            { pairs.push_back(p); }
+          return result.first->second;
+        }
+
+        const StatePair &get_pair(unsigned int number) const
+        { return pairs[number]; }
+
+        size_t size(void) const
+        { return pairs.size(); }
+
+        void clear(void)
+        {
+          numbers.clear();
+          pairs.clear();
+        }
+
+      protected:
+        typedef std::unordered_map<unsigned long long,unsigned int> NumberMap;
+
+        NumberMap numbers;
+        std::vector<StatePair> pairs;
+
+        static unsigned long long key(const StatePair &p)
+        { return ((unsigned long long)p.first << 32) | p.second; }
+      };
+
     }
   }
 }
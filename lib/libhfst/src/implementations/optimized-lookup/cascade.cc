@@ -0,0 +1,363 @@
+// Copyright (c) 2016 University of Helsinki
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+// See the file COPYING included with this distribution for more
+// information.
+
+#include "./cascade.h"
+
+namespace hfst_ol {
+
+TransducerCascade::TransducerCascade(
+    const std::vector<Transducer *> & transducers):
+    levels(transducers),
+    translations(transducers.empty() ? 0 : transducers.size() - 1),
+    current_weight(0.0), results(NULL), previous_start(0),
+    max_lookups(-1), recursion_depth_left(MAX_RECURSION_DEPTH),
+    max_time(0.0), start_clock(0)
+{}
+
+HfstOneLevelPaths * TransducerCascade::lookup_fd(const StringVector & s,
+                                                 ssize_t limit,
+                                                 double time_cutoff)
+{
+    std::string input_str;
+    for (StringVector::const_iterator it = s.begin(); it != s.end(); ++it) {
+        input_str.append(*it);
+    }
+    return lookup_fd(input_str, limit, time_cutoff);
+}
+
+HfstOneLevelPaths * TransducerCascade::lookup_fd(const std::string & s,
+                                                 ssize_t limit,
+                                                 double time_cutoff)
+{
+    return lookup_fd(s.c_str(), limit, time_cutoff);
+}
+
+HfstOneLevelPaths * TransducerCascade::lookup_fd(const char * s,
+                                                 ssize_t limit,
+                                                 double time_cutoff)
+{
+    max_lookups = limit;
+    max_time = 0.0;
+    if (time_cutoff > 0.0) {
+        max_time = time_cutoff;
+        start_clock = clock();
+    }
+    HfstOneLevelPaths * paths = new HfstOneLevelPaths;
+    // The input is tokenized by the first level alone
+    if (levels.empty() || !levels[0]->initialize_input(s)) {
+        return paths;
+    }
+    results = paths;
+    states.assign(levels.size(), 0);
+    output.clear();
+    current_weight = 0.0;
+    configurations.clear();
+    previous_start = 0;
+    get_analyses(0);
+    results = NULL;
+    return paths;
+}
+
+bool TransducerCascade::is_lookup_infinitely_ambiguous(const std::string & s)
+{
+    if (levels.empty()) {
+        return false;
+    }
+    if (levels[0]->is_lookup_infinitely_ambiguous(s)) {
+        return true;
+    }
+    // The input of the other levels can be anything the level above
+    // outputs, so any reachable epsilon loop counts
+    for (size_t k = 1; k < levels.size(); ++k) {
+        if (levels[k]->input_epsilon_cycles == NULL) {
+            levels[k]->input_epsilon_cycles =
+                new InputEpsilonCycles(*levels[k]);
+        }
+        if (levels[k]->input_epsilon_cycles->reaches_cycle(0)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TransducerCascade::get_analyses(unsigned int input_pos)
+{
+    if (recursion_depth_left == 0) {
+        return;
+    }
+    if (max_lookups >= 0 && (ssize_t)results->size() >= max_lookups) {
+        // Back out because we have enough results already
+        return;
+    }
+    if (max_time > 0.0) {
+        // quit if we've overspent our time
+        if ((((double) clock() - start_clock) / CLOCKS_PER_SEC) > max_time) {
+            return;
+        }
+    }
+    --recursion_depth_left;
+
+    SymbolNumber input = levels[0]->input_tape[input_pos];
+    if (input == NO_SYMBOL_NUMBER) {
+        // The composed state is final if every level is
+        Weight final_weight = 0.0;
+        bool final = true;
+        for (size_t k = 0; k < levels.size() && final; ++k) {
+            TransducerTablesInterface * tables = levels[k]->tables;
+            TransitionTableIndex i = states[k];
+            if (indexes_transition_table(i)) {
+                i -= TRANSITION_TARGET_TABLE_START;
+                final = tables->get_transition_finality(i);
+                final_weight += final ? tables->get_weight(i) : 0.0f;
+            } else {
+                final = tables->get_index_finality(i);
+                final_weight += final ? tables->get_final_weight(i) : 0.0f;
+            }
+        }
+        if (final) {
+            note_analysis(final_weight);
+        }
+    }
+
+    // A move starts on some level with an arc that consumes nothing, or
+    // on the first level with one that consumes the next input symbol
+    for (unsigned int level = 0; level < levels.size(); ++level) {
+        try_epsilon_moves(level, input_pos);
+    }
+    if (input != NO_SYMBOL_NUMBER) {
+        find_moves(0, 0, input, input_pos + 1, true);
+    }
+    ++recursion_depth_left;
+}
+
+void TransducerCascade::try_epsilon_moves(unsigned int level,
+                                          unsigned int input_pos)
+{
+    TransitionTableIndex i = first_transition(level, 0);
+    if (i == NO_TABLE_INDEX) {
+        return;
+    }
+    TransducerTablesInterface * tables = levels[level]->tables;
+    TransducerAlphabet * alphabet = levels[level]->alphabet;
+    hfst::FdState<SymbolNumber> & flag_state = levels[level]->flag_state;
+    while (true)
+    {
+        SymbolNumber input = tables->get_transition_input(i);
+        if (input == 0) // epsilon
+        {
+            take_transition(level, level, i, 0, input_pos, false);
+        } else if (alphabet->is_flag_diacritic(input)) {
+            FlagDiacriticState flags = flag_state.get_values();
+            if (flag_state.apply_operation(
+                    *(alphabet->get_operation(input)))) {
+                // flag diacritic allowed
+                take_transition(level, level, i, 0, input_pos, false);
+            }
+            flag_state.assign_values(flags);
+        } else { // it's not epsilon and it's not a flag, so nothing to do
+            return;
+        }
+        ++i;
+    }
+}
+
+void TransducerCascade::find_moves(unsigned int level, unsigned int start,
+                                   SymbolNumber input,
+                                   unsigned int input_pos, bool progressed)
+{
+    TransducerAlphabet * alphabet = levels[level]->alphabet;
+    bool found = false;
+    if (input < alphabet->get_orig_symbol_count()) {
+        found = find_transitions(level, start, input, input,
+                                 input_pos, progressed);
+    } else {
+        // Symbols this level has not seen, as in lookup
+        if (alphabet->get_identity_symbol() != NO_SYMBOL_NUMBER) {
+            found = find_transitions(level, start,
+                                     alphabet->get_identity_symbol(), input,
+                                     input_pos, progressed);
+        }
+        if (alphabet->get_unknown_symbol() != NO_SYMBOL_NUMBER) {
+            found = find_transitions(level, start,
+                                     alphabet->get_unknown_symbol(), input,
+                                     input_pos, progressed) || found;
+        }
+    }
+    if (alphabet->get_default_symbol() != NO_SYMBOL_NUMBER && !found) {
+        find_transitions(level, start, alphabet->get_default_symbol(), input,
+                         input_pos, progressed);
+    }
+}
+
+bool TransducerCascade::find_transitions(unsigned int level,
+                                         unsigned int start,
+                                         SymbolNumber arc_input,
+                                         SymbolNumber input,
+                                         unsigned int input_pos,
+                                         bool progressed)
+{
+    TransitionTableIndex i = first_transition(level, arc_input);
+    if (i == NO_TABLE_INDEX) {
+        return false;
+    }
+    TransducerTablesInterface * tables = levels[level]->tables;
+    bool found = false;
+    while (tables->get_transition_input(i) == arc_input) {
+        take_transition(level, start, i, input, input_pos, progressed);
+        found = true;
+        ++i;
+    }
+    return found;
+}
+
+void TransducerCascade::take_transition(unsigned int level,
+                                        unsigned int start,
+                                        TransitionTableIndex i,
+                                        SymbolNumber input,
+                                        unsigned int input_pos,
+                                        bool progressed)
+{
+    TransducerTablesInterface * tables = levels[level]->tables;
+    TransducerAlphabet * alphabet = levels[level]->alphabet;
+    SymbolNumber output_symbol = tables->get_transition_output(i);
+    if (alphabet->is_meta_arc(output_symbol)) {
+        // we got here via default, identity or unknown, so write the
+        // symbol that was matched
+        output_symbol = input;
+    }
+    TransitionTableIndex old_state = states[level];
+    Weight old_weight = current_weight;
+    states[level] = tables->get_transition_target(i);
+    current_weight += tables->get_weight(i);
+
+    bool is_flag = alphabet->is_flag_diacritic(output_symbol);
+    if (level + 1 == levels.size()) {
+        if (output_symbol == 0) {
+            end_move(level, start, input_pos, progressed);
+        } else {
+            // Flag diacritics are written like in lookup, but going
+            // around a loop of them gets nowhere
+            output.push_back(output_symbol);
+            end_move(level, start, input_pos, progressed || !is_flag);
+            output.pop_back();
+        }
+    } else if (output_symbol == 0 || is_flag) {
+        end_move(level, start, input_pos, progressed);
+    } else {
+        find_moves(level + 1, start, translate(level, output_symbol),
+                   input_pos, progressed);
+    }
+
+    states[level] = old_state;
+    current_weight = old_weight;
+}
+
+void TransducerCascade::end_move(unsigned int level, unsigned int start,
+                                 unsigned int input_pos, bool progressed)
+{
+    // Moves on levels that don't overlap can be taken in either order,
+    // so only the one starting on the lower level is taken first
+    if (level < previous_start) {
+        return;
+    }
+    unsigned int old_start = previous_start;
+    previous_start = start;
+    if (progressed) {
+        // Loops start anew, but the configurations that led here are
+        // still needed when we come back
+        std::set<Configuration> epsilon_path;
+        epsilon_path.swap(configurations);
+        get_analyses(input_pos);
+        configurations.swap(epsilon_path);
+    } else {
+        Configuration configuration = get_configuration();
+        if (configurations.count(configuration) == 0) {
+            configurations.insert(configuration);
+            get_analyses(input_pos);
+            configurations.erase(configuration);
+        }
+    }
+    previous_start = old_start;
+}
+
+TransitionTableIndex TransducerCascade::first_transition(
+    unsigned int level, SymbolNumber input) const
+{
+    TransducerTablesInterface * tables = levels[level]->tables;
+    TransitionTableIndex i = states[level];
+    if (indexes_transition_table(i)) {
+        // The caller checks the transitions themselves
+        return i - TRANSITION_TARGET_TABLE_START + 1;
+    }
+    // Symbols that are only on the output side have no index entries
+    i += 1 + input;
+    if (i >= levels[level]->header->index_table_size() ||
+        tables->get_index_input(i) != input) {
+        return NO_TABLE_INDEX;
+    }
+    return tables->get_index_target(i) - TRANSITION_TARGET_TABLE_START;
+}
+
+SymbolNumber TransducerCascade::translate(unsigned int level,
+                                          SymbolNumber symbol)
+{
+    SymbolNumberVector & translation = translations[level];
+    if (symbol >= translation.size()) {
+        translation.resize(levels[level]->alphabet->get_symbol_table().size(),
+                           NO_SYMBOL_NUMBER);
+    }
+    if (translation[symbol] != NO_SYMBOL_NUMBER) {
+        return translation[symbol];
+    }
+    Transducer * next = levels[level + 1];
+    std::string symbol_string =
+        levels[level]->alphabet->string_from_symbol(symbol);
+    char * p = const_cast<char *>(symbol_string.c_str());
+    SymbolNumber key = next->encoder->find_key(&p);
+    if (key == NO_SYMBOL_NUMBER || *p != '\0') {
+        // Not an input symbol of the next level, but it may still be in
+        // its alphabet, in which case no identity arc matches it
+        key = next->alphabet->symbol_from_string(symbol_string);
+        if (key == NO_SYMBOL_NUMBER) {
+            next->include_symbol_in_alphabet(symbol_string);
+            key = hfst::size_t_to_uint(
+                next->alphabet->get_symbol_table().size() - 1);
+        }
+    }
+    translation[symbol] = key;
+    return key;
+}
+
+TransducerCascade::Configuration
+TransducerCascade::get_configuration(void) const
+{
+    Configuration configuration;
+    configuration.first = states;
+    for (size_t k = 0; k < levels.size(); ++k) {
+        configuration.second.push_back(levels[k]->flag_state.get_values());
+    }
+    return configuration;
+}
+
+void TransducerCascade::note_analysis(Weight final_weight)
+{
+    if (max_lookups >= 0 && (ssize_t)results->size() >= max_lookups) {
+        return;
+    }
+    HfstOneLevelPath result;
+    const TransducerAlphabet * alphabet = levels.back()->alphabet;
+    for (SymbolNumberVector::const_iterator it = output.begin();
+         it != output.end(); ++it) {
+        result.second.push_back(alphabet->string_from_symbol(*it));
+    }
+    result.first = current_weight + final_weight;
+    results->insert(result);
+}
+
+}
@@ -0,0 +1,99 @@
+// Copyright (c) 2016 University of Helsinki
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+// See the file COPYING included with this distribution for more
+// information.
+#ifndef _HFST_OL_TRANSDUCER_CASCADE_H_
+#define _HFST_OL_TRANSDUCER_CASCADE_H_
+
+#include "./transducer.h"
+
+namespace hfst_ol {
+
+/** \brief Lookup through the composition of a chain of transducers
+    without building the composed transducer.
+
+    The levels are traversed in step: an arc taken on one level whose
+    output is not an epsilon or a flag diacritic is matched against the
+    input side of the next level, and only the output of the last level
+    is collected. Each level checks its own flag diacritics as lookup on
+    it alone would, and flag diacritics are not passed on to the next
+    level. Symbols are matched between levels by their strings, symbols
+    unknown to a level going to its identity and unknown arcs.
+
+    The transducers are used, not owned, and they must not be used for
+    anything else during a lookup.
+*/
+class TransducerCascade
+{
+protected:
+    typedef std::pair<std::vector<TransitionTableIndex>,
+                      std::vector<FlagDiacriticState> > Configuration;
+
+    std::vector<Transducer *> levels;
+    // translations[k] takes the output symbols of level k to the input
+    // symbols of level k + 1, filled in when first needed
+    std::vector<SymbolNumberVector> translations;
+
+    // for lookup
+    std::vector<TransitionTableIndex> states;
+    SymbolNumberVector output;
+    Weight current_weight;
+    HfstOneLevelPaths * results;
+    // The configurations passed through since input or output last
+    // advanced, to keep out of epsilon loops
+    std::set<Configuration> configurations;
+    // The level the previous move started on
+    unsigned int previous_start;
+
+    ssize_t max_lookups;
+    unsigned int recursion_depth_left;
+    double max_time;
+    clock_t start_clock;
+
+    void get_analyses(unsigned int input_pos);
+    void try_epsilon_moves(unsigned int level, unsigned int input_pos);
+    void find_moves(unsigned int level, unsigned int start,
+                    SymbolNumber input, unsigned int input_pos,
+                    bool progressed);
+    bool find_transitions(unsigned int level, unsigned int start,
+                          SymbolNumber arc_input, SymbolNumber input,
+                          unsigned int input_pos, bool progressed);
+    void take_transition(unsigned int level, unsigned int start,
+                         TransitionTableIndex i, SymbolNumber input,
+                         unsigned int input_pos, bool progressed);
+    void end_move(unsigned int level, unsigned int start,
+                  unsigned int input_pos, bool progressed);
+    TransitionTableIndex first_transition(unsigned int level,
+                                          SymbolNumber input) const;
+    SymbolNumber translate(unsigned int level, SymbolNumber symbol);
+    Configuration get_configuration(void) const;
+    void note_analysis(Weight final_weight);
+
+public:
+    TransducerCascade(const std::vector<Transducer *> & transducers);
+
+    HfstOneLevelPaths * lookup_fd(const StringVector & s, ssize_t limit = -1,
+                                  double time_cutoff = 0.0);
+    /** \brief Look up \a s through the composition of the levels. The
+        return value, a pointer to HfstOneLevelPaths allocated with new,
+        holds the outputs of the last level and the sums of the weights
+        of all levels. At most \a limit results are found if it is not
+        negative.
+    */
+    HfstOneLevelPaths * lookup_fd(const std::string & s, ssize_t limit = -1,
+                                  double time_cutoff = 0.0);
+    HfstOneLevelPaths * lookup_fd(const char * s, ssize_t limit = -1,
+                                  double time_cutoff = 0.0);
+
+    /** \brief Whether lookup of \a s may have infinitely many results,
+        checked on each level separately. */
+    bool is_lookup_infinitely_ambiguous(const std::string & s);
+};
+
+}
+
+#endif // _HFST_OL_TRANSDUCER_CASCADE_H_
@@ -9,6 +9,11 @@
 
 #include "convert.h"
 
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 #ifdef _MSC_VER
 #include "back-ends/openfstwin/src/include/fst/fstlib.h"
 #else
@@ -50,41 +55,18 @@ void write_transitions_from_state_placeholders(
                     it->final, it->final_weight));
         }
         
-        // Then we iterate through the symbols each state has.
-    // First we do a pass for epsilon and flags (they have to come
-    // first), then everything else.
-        if (it->input_present(0)) {
-            add_transitions_with(0, it->get_transition_placeholders(0),
-                                 transition_table,
-                                 state_placeholders,
-                                 flag_symbols);
-    }
-    for (std::set<hfst_ol::SymbolNumber>::iterator flag_it =
-         flag_symbols.begin(); flag_it != flag_symbols.end();
-         ++flag_it) {
-        if (it->input_present(*flag_it)) {
-            hfst_ol::add_transitions_with(
-                *flag_it,
-                it->get_transition_placeholders(*flag_it),
-                transition_table,
-                state_placeholders,
-                flag_symbols);
-            
+        // The transitions are already grouped in the order they
+        // are written in: epsilon, flags and everything else.
+        for (std::vector<std::vector<TransitionPlaceholder> >::iterator
+                 group_it = it->transition_placeholders.begin();
+             group_it != it->transition_placeholders.end(); ++group_it) {
+            hfst_ol::add_transitions_with(group_it->at(0).input,
+                                          *group_it,
+                                          transition_table,
+                                          state_placeholders,
+                                          flag_symbols);
         }
     }
-    for (unsigned int i = 1; i < it->symbol_to_transition_placeholder_v.size();
-         ++i) {
-        if (!it->input_present(i) ||
-            flag_symbols.count(i) != 0) {
-        continue;
-        }
-        hfst_ol::add_transitions_with(i,
-                                      it->get_transition_placeholders(i),
-                                      transition_table,
-                                      state_placeholders,
-                                      flag_symbols);
-    }
-    }
 
         
     // one final padding transition
@@ -119,6 +101,168 @@ void add_transitions_with(SymbolNumber symbol,
     }
 }
 
+namespace {
+    // Order in which symbols are written: epsilon, flags, others
+    struct CompareTransitionInputs
+    {
+        std::vector<bool> const & is_flag;
+        CompareTransitionInputs(std::vector<bool> const & f): is_flag(f) {}
+        int rank(SymbolNumber input) const
+        {
+            if (input == 0) {
+                return 0;
+            }
+            return (input < is_flag.size() && is_flag[input]) ? 1 : 2;
+        }
+        bool operator()(TransitionPlaceholder const & lhs,
+                        TransitionPlaceholder const & rhs) const
+        {
+            int lhs_rank = rank(lhs.input);
+            int rhs_rank = rank(rhs.input);
+            if (lhs_rank != rhs_rank) {
+                return lhs_rank < rhs_rank;
+            }
+            return lhs.input < rhs.input;
+        }
+    };
+
+    unsigned int count_trailing_zeros(uint64_t word)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, word);
+        return index;
+#else
+        return __builtin_ctzll(word);
+#endif
+    }
+
+    unsigned int count_ones(uint64_t word)
+    {
+#ifdef _MSC_VER
+        return (unsigned int)__popcnt64(word);
+#else
+        return __builtin_popcountll(word);
+#endif
+    }
+}
+
+void StatePlaceholder::set_transitions(
+    std::vector<TransitionPlaceholder> & transitions,
+    std::vector<bool> const & is_flag)
+{
+    CompareTransitionInputs compare(is_flag);
+    std::stable_sort(transitions.begin(), transitions.end(), compare);
+    transition_placeholders.clear();
+    unsigned int zero_indexed = 0;
+    unsigned int nonzero_indexed = 0;
+    for (std::vector<TransitionPlaceholder>::const_iterator it
+             = transitions.begin(); it != transitions.end(); ++it) {
+        if (transition_placeholders.empty() ||
+            transition_placeholders.back()[0].input != it->input) {
+            transition_placeholders.push_back(
+                std::vector<TransitionPlaceholder>());
+            if (compare.rank(it->input) == 2) {
+                ++nonzero_indexed;
+            } else {
+                ++zero_indexed;
+            }
+        }
+        transition_placeholders.back().push_back(*it);
+    }
+    inputs = hfst::size_t_to_ushort(transition_placeholders.size());
+
+    // Epsilons and flags both index to 0. If we have only one input symbol,
+    // we're simple.
+    if (type != nonsimple) {
+        if (inputs == 0) {
+            type = empty;
+        } else if (nonzero_indexed == 0) {
+            type = simple_zero_index;
+        } else if (nonzero_indexed == 1 && zero_indexed == 0) {
+            type = simple_nonzero_index;
+        } else {
+            type = nonsimple;
+        }
+    }
+}
+
+void StatePlaceholder::get_index_offsets(
+    std::vector<unsigned int> & offsets,
+    std::vector<bool> const & is_flag) const
+{
+    offsets.clear();
+    offsets.push_back(0);
+    for (std::vector<std::vector<TransitionPlaceholder> >::const_iterator it
+             = transition_placeholders.begin();
+         it != transition_placeholders.end(); ++it) {
+        unsigned int offset = index_offset(it->at(0).input, is_flag) + 1;
+        if (offset != offsets.back()) { // zero-indexed groups repeat 1
+            offsets.push_back(offset);
+        }
+    }
+}
+
+uint64_t IndexPlaceholders::used_from(unsigned int const position) const
+{
+    size_t word = position >> 6;
+    unsigned int shift = position & 63;
+    uint64_t bits = 0;
+    if (word < bitmap.size()) {
+        bits = bitmap[word] >> shift;
+    }
+    if (shift != 0 && word + 1 < bitmap.size()) {
+        bits |= bitmap[word + 1] << (64 - shift);
+    }
+    return bits;
+}
+
+unsigned int IndexPlaceholders::count(unsigned int begin,
+                                      unsigned int end) const
+{
+    unsigned int filled = 0;
+    for (; begin + 64 <= end; begin += 64) {
+        filled += count_ones(used_from(begin));
+    }
+    if (begin < end) {
+        filled += count_ones(used_from(begin) &
+                             (((uint64_t)1 << (end - begin)) - 1));
+    }
+    return filled;
+}
+
+unsigned int IndexPlaceholders::find_fit(
+    std::vector<unsigned int> const & offsets, unsigned int from) const
+{
+    // Bit i of candidates tells whether from + i may still be a fit
+    for (;; from += 64) {
+        uint64_t candidates = ~(uint64_t)0;
+        for (std::vector<unsigned int>::const_iterator it = offsets.begin();
+             it != offsets.end() && candidates != 0; ++it) {
+            candidates &= ~used_from(from + *it);
+        }
+        if (candidates != 0) {
+            return from + count_trailing_zeros(candidates);
+        }
+    }
+}
+
+unsigned int IndexPlaceholders::first_suitable(
+    unsigned int index,
+    SymbolNumber const symbols,
+    float const packing_aggression) const
+{
+    // The number of used indices among the symbols following index,
+    // maintained as a sliding window
+    unsigned int filled = count(index + 1, index + symbols + 1);
+    while (used(index) || filled >= (packing_aggression*symbols)) {
+        filled -= used(index + 1);
+        filled += used(index + symbols + 1);
+        ++index;
+    }
+    return index;
+}
+
 bool compare_states_by_input_size(
     const StatePlaceholder & lhs, const StatePlaceholder & rhs)
 {
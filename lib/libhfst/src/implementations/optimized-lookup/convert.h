@@ -13,6 +13,8 @@
 #include "transducer.h"
 #include "pmatch.h"
 
+#include <stdint.h>
+
 #ifdef HAVE_OPENFST_UPSTREAM
   #include <fst/fst-decl.h>
   namespace fst { template <class F> class ArcIterator; }
@@ -47,7 +49,9 @@ struct StatePlaceholder {
     unsigned int state_number;
     unsigned int start_index;
     unsigned int first_transition;
-    std::vector<unsigned int> symbol_to_transition_placeholder_v;
+    // Transitions grouped by input symbol, in the order they are written
+    // to the transition table: epsilon, flag diacritics and then the other
+    // symbols, each in ascending order
     std::vector<std::vector<TransitionPlaceholder> > transition_placeholders;
     indexing_type type;
     SymbolNumber inputs;
@@ -88,108 +92,26 @@ struct StatePlaceholder {
         return count;
     }
 
-    bool input_present(SymbolNumber input) const {
-        return input < symbol_to_transition_placeholder_v.size() &&
-                       symbol_to_transition_placeholder_v[input] != UINT_MAX;
-    }
+    // Set the transitions of the state. is_flag[s] tells whether symbol s
+    // is a flag diacritic (or otherwise indexed like epsilon).
+    void set_transitions(std::vector<TransitionPlaceholder> & transitions,
+                         std::vector<bool> const & is_flag);
 
-    void add_input(SymbolNumber input, std::set<SymbolNumber> const & flag_symbols)
+    // Epsilons and flags are indexed at offset 0, other symbols at their
+    // own number.
+    static SymbolNumber index_offset(SymbolNumber input,
+                                     std::vector<bool> const & is_flag)
         {
-            if (input_present(input)) {
-                return;
-            }
-            while (symbol_to_transition_placeholder_v.size() <= input) {
-                symbol_to_transition_placeholder_v.push_back(UINT_MAX);
+            if (input < is_flag.size() && is_flag[input]) {
+                return 0;
             }
-            symbol_to_transition_placeholder_v[input] = hfst::size_t_to_uint(transition_placeholders.size());
-            transition_placeholders.push_back(std::vector<TransitionPlaceholder>());
-            ++inputs;
-            if (type != nonsimple) {
-                // Depending on what type of inputs we now have, adjust the index type.
-                // Epsilons and flags both index to 0. If we have only one input symbol,
-                // we're simple.
-                if (type == empty) {
-                    if (input == 0 || flag_symbols.count(input) == 1) {
-                        type = simple_zero_index;
-                    } else {
-                        type = simple_nonzero_index;
-                    }
-                } else if (type == simple_zero_index) {
-                    if (input != 0 && flag_symbols.count(input) == 0) {
-                        type = nonsimple;
-                    }
-                } else { // simple_nonzero_index
-                    if (inputs > 1 || input == 0 || flag_symbols.count(input) == 1) {
-                        type = nonsimple;
-                    }
-                }
-            }
-        }
-
-    SymbolNumber get_largest_index(void)
-        {
-            return transition_placeholders[symbol_to_transition_placeholder_v.back()][0].input;
-        }
-
-    void add_transition(TransitionPlaceholder & trans)
-        {
-            transition_placeholders[symbol_to_transition_placeholder_v[trans.input]].push_back(trans);
+            return input;
         }
 
-    std::vector<TransitionPlaceholder> & get_transition_placeholders(SymbolNumber input)
-        {
-            return transition_placeholders[symbol_to_transition_placeholder_v[input]];
-        }
-    
-    unsigned int symbol_offset(
-        SymbolNumber const symbol,
-        std::set<SymbolNumber> const & flag_symbols) {
-        if (symbol == 0) {
-            return 0;
-        }
-        unsigned int offset = 0;
-        // if (flag_symbols.size() == 0) {
-        //     for(int i = 0; i < symbol_to_transition_placeholder_v.size(); ++i) {
-        //         if (symbol_to_transition_placeholder_v[i] != UINT_MAX) {
-        //             if (symbol == i) {
-        //                 return offset;
-        //             }
-        //             offset += get_transition_placeholders(i).size();
-        //         }
-        //     }
-        // } else {
-        if (input_present(0)) { // if there are epsilons
-            offset = hfst::size_t_to_uint(get_transition_placeholders(0).size());
-        }
-        for(std::set<SymbolNumber>::const_iterator flag_it = flag_symbols.begin();
-            flag_it != flag_symbols.end(); ++flag_it) {
-            if (input_present(*flag_it)) {
-                if (symbol == *flag_it) {
-                    // Flags go to 0 (even if there's no epsilon)
-                    return 0;
-                }
-                offset += hfst::size_t_to_uint(get_transition_placeholders(*flag_it).size());
-            }
-        }
-        for(unsigned int i = 1; i < symbol_to_transition_placeholder_v.size(); ++i) {
-            if (input_present(i)) {
-                if (flag_symbols.count(i) != 0) {
-                    // already counted
-                    continue;
-                }
-                if (symbol == i) {
-                    return offset;
-                }
-                offset += hfst::size_t_to_uint(get_transition_placeholders(i).size());
-            }
-        }
-        std::string message("error in conversion between optimized lookup "
-                            "format and HfstTransducer;\ntried to calculate "
-                            "symbol_offset for symbol not present in state");
-        HFST_THROW_MESSAGE
-            (HfstFatalException,
-             message);
-    }
+    // Offsets from start_index of the index table entries of the state,
+    // sorted and without duplicates. The finality marker is at offset 0.
+    void get_index_offsets(std::vector<unsigned int> & offsets,
+                           std::vector<bool> const & is_flag) const;
 };
 
 bool compare_states_by_input_size(
@@ -197,79 +119,61 @@ bool compare_states_by_input_size(
 bool compare_states_by_state_number(
     const StatePlaceholder & lhs, const StatePlaceholder & rhs);
 
+struct IndexPlaceholder
+{
+    unsigned int target;
+    SymbolNumber symbol;
+    // Position of the first transition with symbol from the first
+    // transition of the target state
+    unsigned int offset;
+    IndexPlaceholder(unsigned int t, SymbolNumber s, unsigned int o):
+        target(t), symbol(s), offset(o) {}
+};
+
+// The index table under construction. Which entries are used is kept
+// in a bitmap, so that 64 candidate start indices of a state can be
+// tested with one word operation per index entry of the state.
 struct IndexPlaceholders
 {
-    std::vector<unsigned int> indices;
-    std::vector<std::pair<unsigned int, SymbolNumber> > targets;
+    std::vector<uint64_t> bitmap;
+    std::vector<IndexPlaceholder> entries;
 
     bool used(unsigned int const position) const
         {
-            return position < indices.size() && indices[position] != NO_TABLE_INDEX;
+            return (position >> 6) < bitmap.size() &&
+                ((bitmap[position >> 6] >> (position & 63)) & 1) != 0;
         }
-
-    void assign(unsigned int const position, unsigned int target, SymbolNumber sym)
+    void assign(unsigned int const position, unsigned int target,
+                SymbolNumber sym, unsigned int offset)
         {
-            while (position >= indices.size()) {
-                indices.push_back(NO_TABLE_INDEX);
+            if (position >= entries.size()) {
+                entries.resize(position + 1,
+                               IndexPlaceholder(UINT_MAX, NO_SYMBOL_NUMBER, 0));
+                bitmap.resize((position >> 6) + 1, 0);
             }
-            indices[position] = hfst::size_t_to_uint(targets.size());
-            targets.push_back(std::pair<unsigned int, SymbolNumber>(target, sym));
+            entries[position] = IndexPlaceholder(target, sym, offset);
+            bitmap[position >> 6] |= (uint64_t)1 << (position & 63);
         }
-
-    std::pair<unsigned int, SymbolNumber> get_target(unsigned int index)
+    IndexPlaceholder const & get_target(unsigned int index) const
         {
-            return targets[indices[index]];
-        }
-    
-    bool fits(StatePlaceholder const & state,
-              std::set<SymbolNumber> const & flag_symbols,
-              unsigned int const position) const
-        {
-            if (used(position)) {
-                return false;
-            }
-            for (std::vector<std::vector<TransitionPlaceholder> >::const_iterator it = state.transition_placeholders.begin();
-                 it != state.transition_placeholders.end(); ++it) {
-                SymbolNumber index_offset = it->at(0).input;
-                if (flag_symbols.count(index_offset) != 0) {
-                    index_offset = 0;
-                }
-                if (used(index_offset + position + 1)) {
-                    return false;
-                }
-            }
-            return true;
-        }
-
-    bool unsuitable(unsigned int const index,
-                    SymbolNumber const symbols,
-                    float const packing_aggression) const
-    {
-    if (used(index)) {
-        return true;
-    }
-    
-    // "Perfect packing" (under this strategy)
-/*              for (unsigned int i = 0; i < symbols; ++i) {
-        
-        if (count(index + i) == 0) {
-        return true;
-        }
-        return false;
-        }*/
-
-    unsigned int filled = 0;
-    for (unsigned int i = 0; i < symbols; ++i) {
-        filled += used(index + i + 1);
-        if (filled >= (packing_aggression*symbols)) {
-            return true; // too full
+            return entries[index];
         }
-    }
-    return false;
-    }
+    // Bit i of the result tells whether index position + i is used
+    uint64_t used_from(unsigned int const position) const;
+    // The number of used indices in [begin, end)
+    unsigned int count(unsigned int begin, unsigned int end) const;
+    // The first start index from `from' on where a state with index
+    // entries at `offsets' fits
+    unsigned int find_fit(std::vector<unsigned int> const & offsets,
+                          unsigned int from) const;
+    // The first index from `index' on that is not used and after which
+    // less than packing_aggression * symbols of the next `symbols'
+    // indices are used
+    unsigned int first_suitable(unsigned int index,
+                                SymbolNumber const symbols,
+                                float const packing_aggression) const;
 };
 
-
 void write_transitions_from_state_placeholders(
     TransducerTable<TransitionW> & transition_table,
     std::vector<hfst_ol::StatePlaceholder>
@@ -9,6 +9,8 @@
 
 #include "./transducer.h"
 
+#include <algorithm>
+
 namespace hfst_ol {
 
 // Define an operation for checking state equivalence for the
@@ -45,6 +47,152 @@ bool TraversalState::operator<(const TraversalState & rhs) const
     return false;
 }
 
+InputEpsilonCycles::InputEpsilonCycles(const Transducer & t):
+    index_states(t.get_header().index_table_size(), false),
+    transition_states(t.get_header().target_table_size(), false)
+{
+    const TransducerAlphabet & alphabet = t.get_alphabet();
+    std::unordered_map<TransitionTableIndex, unsigned int> state_numbers;
+    std::vector<TransitionTableIndex> states;
+    // The arcs of state number n are in [starts[n], starts[n+1])
+    std::vector<unsigned int> starts;
+    std::vector<unsigned int> targets;
+    std::vector<bool> epsilon_arcs;
+    std::vector<TransitionTableIndex> state_transitions;
+
+    // Number the states in breadth-first order from the start state
+    states.push_back(0);
+    state_numbers[0] = 0;
+    for (size_t n = 0; n < states.size(); ++n) {
+        starts.push_back(hfst::size_t_to_uint(targets.size()));
+        state_transitions.clear();
+        t.get_state_transitions(states[n], state_transitions);
+        for (size_t i = 0; i < state_transitions.size(); ++i) {
+            const Transition & transition =
+                t.get_transition(state_transitions[i]);
+            TransitionTableIndex target = transition.get_target();
+            if (state_numbers.count(target) == 0) {
+                state_numbers[target] = hfst::size_t_to_uint(states.size());
+                states.push_back(target);
+            }
+            targets.push_back(state_numbers[target]);
+            SymbolNumber input = transition.get_input_symbol();
+            epsilon_arcs.push_back(input == 0 ||
+                                   alphabet.is_flag_diacritic(input));
+        }
+    }
+    unsigned int state_count = hfst::size_t_to_uint(states.size());
+    starts.push_back(hfst::size_t_to_uint(targets.size()));
+
+    // Tarjan's algorithm over the epsilon arcs. The states of a strongly
+    // connected component with more than one state are on a cycle.
+    const unsigned int unvisited = UINT_MAX;
+    std::vector<unsigned int> order(state_count, unvisited);
+    std::vector<unsigned int> low(state_count);
+    std::vector<bool> on_stack(state_count, false);
+    std::vector<bool> on_cycle(state_count, false);
+    std::vector<unsigned int> component;
+    std::vector<std::pair<unsigned int, unsigned int> > calls;
+    unsigned int counter = 0;
+
+    for (unsigned int root = 0; root < state_count; ++root) {
+        if (order[root] != unvisited) {
+            continue;
+        }
+        order[root] = low[root] = counter++;
+        component.push_back(root);
+        on_stack[root] = true;
+        calls.push_back(std::make_pair(root, starts[root]));
+        while (!calls.empty()) {
+            unsigned int n = calls.back().first;
+            unsigned int position = calls.back().second;
+            if (position < starts[n + 1]) {
+                ++calls.back().second;
+                if (!epsilon_arcs[position]) {
+                    continue;
+                }
+                unsigned int m = targets[position];
+                if (m == n) {
+                    on_cycle[n] = true;
+                } else if (order[m] == unvisited) {
+                    order[m] = low[m] = counter++;
+                    component.push_back(m);
+                    on_stack[m] = true;
+                    calls.push_back(std::make_pair(m, starts[m]));
+                } else if (on_stack[m]) {
+                    low[n] = std::min(low[n], order[m]);
+                }
+                continue;
+            }
+            calls.pop_back();
+            if (!calls.empty()) {
+                unsigned int parent = calls.back().first;
+                low[parent] = std::min(low[parent], low[n]);
+            }
+            if (low[n] == order[n]) {
+                bool cycle = (component.back() != n);
+                unsigned int m;
+                do {
+                    m = component.back();
+                    component.pop_back();
+                    on_stack[m] = false;
+                    if (cycle) {
+                        on_cycle[m] = true;
+                    }
+                } while (m != n);
+            }
+        }
+    }
+
+    // Everything from which a cycle can be reached, following the arcs
+    // backwards
+    std::vector<unsigned int> reverse_starts(state_count + 1, 0);
+    for (size_t position = 0; position < targets.size(); ++position) {
+        ++reverse_starts[targets[position] + 1];
+    }
+    for (unsigned int n = 0; n < state_count; ++n) {
+        reverse_starts[n + 1] += reverse_starts[n];
+    }
+    std::vector<unsigned int> sources(targets.size());
+    std::vector<unsigned int> fill(reverse_starts.begin(),
+                                   reverse_starts.end() - 1);
+    for (unsigned int n = 0; n < state_count; ++n) {
+        for (unsigned int position = starts[n]; position < starts[n + 1];
+             ++position) {
+            sources[fill[targets[position]]++] = n;
+        }
+    }
+    std::vector<unsigned int> queue;
+    for (unsigned int n = 0; n < state_count; ++n) {
+        if (on_cycle[n]) {
+            queue.push_back(n);
+        }
+    }
+    std::vector<bool> & reaches = on_cycle;
+    for (size_t q = 0; q < queue.size(); ++q) {
+        unsigned int n = queue[q];
+        for (unsigned int position = reverse_starts[n];
+             position < reverse_starts[n + 1]; ++position) {
+            if (!reaches[sources[position]]) {
+                reaches[sources[position]] = true;
+                queue.push_back(sources[position]);
+            }
+        }
+    }
+
+    for (unsigned int n = 0; n < state_count; ++n) {
+        if (!reaches[n]) {
+            continue;
+        }
+        if (indexes_transition_table(states[n])) {
+            transition_states[states[n] - TRANSITION_TARGET_TABLE_START] =
+                true;
+        } else {
+            index_states[states[n]] = true;
+        }
+    }
+}
+
 void Transducer::find_loop_epsilon_transitions(
     unsigned int input_pos,
     TransitionTableIndex i)
@@ -108,9 +256,12 @@ void Transducer::find_loop_transitions(SymbolNumber input,
 
     while (tables->get_transition_input(i) != NO_SYMBOL_NUMBER) {
         if (tables->get_transition_input(i) == input) {
-            // We're not going to find an epsilon / flag loop
-            traversal_states.clear();
+            // Loops start anew after the input symbol, but the epsilon
+            // path that led here is still needed when we come back
+            TraversalStates epsilon_path;
+            epsilon_path.swap(traversal_states);
             find_loop(input_pos, tables->get_transition_target(i));
+            traversal_states.swap(epsilon_path);
             found_transition = true;
         } else {
             return;
@@ -123,6 +274,10 @@ void Transducer::find_loop_index(SymbolNumber input,
                                       unsigned int input_pos,
                                       TransitionTableIndex i)
 {
+    // Symbols that are only on the output side have no index entries
+    if (i+input >= header->index_table_size()) {
+        return;
+    }
     if (tables->get_index_input(i+input) == input)
     {
         find_loop_transitions(input,
@@ -139,6 +294,10 @@ void Transducer::find_loop_index(SymbolNumber input,
 void Transducer::find_loop(unsigned int input_pos,
                            TransitionTableIndex i)
 {
+    // There are no loops ahead
+    if (!input_epsilon_cycles->reaches_cycle(i)) {
+        return;
+    }
     found_transition = false;
     
     if (indexes_transition_table(i))
@@ -155,7 +314,19 @@ void Transducer::find_loop(unsigned int input_pos,
         SymbolNumber input = input_tape[input_pos];
         ++input_pos;
 
-        find_loop_transitions(input, input_pos, i+1);
+        if (input < alphabet->get_orig_symbol_count()) {
+            find_loop_transitions(input, input_pos, i+1);
+        } else {
+            // Symbols added to the alphabet at tokenization, as in lookup
+            if (alphabet->get_identity_symbol() != NO_SYMBOL_NUMBER) {
+                find_loop_transitions(alphabet->get_identity_symbol(),
+                                      input_pos, i+1);
+            }
+            if (alphabet->get_unknown_symbol() != NO_SYMBOL_NUMBER) {
+                find_loop_transitions(alphabet->get_unknown_symbol(),
+                                      input_pos, i+1);
+            }
+        }
         if (alphabet->get_default_symbol() != NO_SYMBOL_NUMBER &&
             !found_transition) {
             find_loop_transitions(alphabet->get_default_symbol(),
@@ -174,7 +345,18 @@ void Transducer::find_loop(unsigned int input_pos,
         SymbolNumber input = input_tape[input_pos];
         ++input_pos;
 
-        find_loop_index(input, input_pos, i+1);
+        if (input < alphabet->get_orig_symbol_count()) {
+            find_loop_index(input, input_pos, i+1);
+        } else {
+            if (alphabet->get_identity_symbol() != NO_SYMBOL_NUMBER) {
+                find_loop_index(alphabet->get_identity_symbol(),
+                                input_pos, i+1);
+            }
+            if (alphabet->get_unknown_symbol() != NO_SYMBOL_NUMBER) {
+                find_loop_index(alphabet->get_unknown_symbol(),
+                                input_pos, i+1);
+            }
+        }
         // If we have a default symbol defined and we didn't find an index,
         // check for that
         if (alphabet->get_default_symbol() != NO_SYMBOL_NUMBER && !found_transition) {
@@ -9,6 +9,7 @@
 
 #include "pmatch.h"
 #include "hfst.h"
+#include <iomanip>
 
 using hfst::HfstTransducer;
 
@@ -469,7 +470,8 @@ PmatchAlphabet::count(SymbolNumber sym)
 }
 
 PmatchContainer::PmatchContainer(std::istream &inputstream)
-    : entry_stack(), verbose(false), locate_mode(false), line_number(0),
+    : input_offset(0), input_cursor(NULL), input_exhausted(true),
+      entry_stack(), verbose(false), locate_mode(false), line_number(0),
       profile_mode(false), single_codepoint_tokenization(false),
       running_weight(0.0)
 {
@@ -581,7 +583,8 @@ PmatchContainer::PmatchContainer(std::istream &inputstream)
 }
 
 PmatchContainer::PmatchContainer(Transducer *t)
-    : entry_stack(), verbose(false), locate_mode(false), profile_mode(false),
+    : input_offset(0), input_cursor(NULL), input_exhausted(true),
+      entry_stack(), verbose(false), locate_mode(false), profile_mode(false),
       single_codepoint_tokenization(false), running_weight(0.0)
 {
     set_properties();
@@ -603,7 +606,8 @@ PmatchContainer::PmatchContainer(Transducer *t)
 // so there's no advantage to passing it transducers in optimized-lookup
 // format.
 PmatchContainer::PmatchContainer(std::vector<HfstTransducer> transducers)
-    : entry_stack(), verbose(false), locate_mode(false), line_number(0),
+    : input_offset(0), input_cursor(NULL), input_exhausted(true),
+      entry_stack(), verbose(false), locate_mode(false), line_number(0),
       profile_mode(false), single_codepoint_tokenization(false),
       running_weight(0.0)
 {
@@ -800,6 +804,7 @@ PmatchContainer::add_rtn(Transducer *rtn, const std::string &name)
 }
 
 PmatchContainer::PmatchContainer(void)
+    : input_offset(0), input_cursor(NULL), input_exhausted(true)
 {
     // Not used, but apparently needed by swig to construct these
 }
@@ -1176,27 +1181,45 @@ PmatchContainer::process(const std::string &input_str)
     best_captures.clear();
     captures.clear();
     reset_recursion();
+    if (profile_mode)
+    {
+        profile_start();
+    }
     DoubleTape nonmatching_locations;
     while (has_queued_input(input_pos))
     {
+        discard_input_before(input_pos);
         best_result.clear();
-        SymbolNumber current_input = input[input_pos];
+        SymbolNumber current_input = input_symbol(input_pos);
         if (not_possible_first_symbol(current_input))
         {
-            copy_to_result(current_input, current_input);
-            ++input_pos;
-            if (locate_mode && alphabet.is_printable(current_input))
+            // Nothing can start here, so skip over the whole stretch of
+            // input that can't start a match and copy it in one go
+            unsigned int skip_end = next_possible_first_position(input_pos + 1);
+            copy_input_to_result(input_pos, skip_end);
+            if (locate_mode)
             {
-                ++printable_input_pos;
-                nonmatching_locations.push_back(
-                    SymbolPair(current_input, current_input));
+                for (; input_pos < skip_end; ++input_pos)
+                {
+                    SymbolNumber sym = input_symbol(input_pos);
+                    if (alphabet.is_printable(sym))
+                    {
+                        ++printable_input_pos;
+                        nonmatching_locations.push_back(SymbolPair(sym, sym));
+                    }
+                }
             }
+            input_pos = skip_end;
             continue;
         }
         tape.clear();
         tape_locations.clear();
         unsigned int tape_pos = 0;
         unsigned int old_input_pos = input_pos;
+        if (profile_mode)
+        {
+            ++toplevel->profile.calls;
+        }
         toplevel->match(input_pos, tape_pos);
         if (candidate_found())
         {
@@ -1281,6 +1304,10 @@ PmatchContainer::process(const std::string &input_str)
         ls.push_back(nonmatching);
         locations.push_back(ls);
     }
+    if (profile_mode)
+    {
+        profile_charge();
+    }
 }
 
 std::string
@@ -1330,6 +1357,13 @@ counter_comp(std::pair<std::string, unsigned long> l,
     return l.second > r.second;
 }
 
+// Likewise for sorting transducers by the time spent in them
+static bool
+profile_time_comp(PmatchTransducer *l, PmatchTransducer *r)
+{
+    return l->get_profile().seconds > r->get_profile().seconds;
+}
+
 std::string
 PmatchContainer::get_profiling_info(void)
 {
@@ -1367,9 +1401,314 @@ PmatchContainer::get_profiling_info(void)
         }
         retval << it->second << "\n";
     }
+    std::vector<PmatchTransducer *> transducers = get_profiled_transducers();
+    std::sort(transducers.begin(), transducers.end(), profile_time_comp);
+    max_name_len = strlen("Transducer");
+    for (std::vector<PmatchTransducer *>::const_iterator it
+         = transducers.begin();
+         it != transducers.end(); ++it)
+    {
+        max_name_len = std::max(max_name_len, (*it)->get_name().size());
+    }
+    retval << "  Transducers by time spent in them:\n";
+    retval << "    " << std::left << std::setw(max_name_len + 2)
+           << "Transducer" << std::right << std::setw(12) << "calls"
+           << std::setw(14) << "seconds" << std::setw(10) << "depth"
+           << std::setw(16) << "states visited" << std::setw(14)
+           << "time cutoffs"
+           << "\n";
+    for (std::vector<PmatchTransducer *>::const_iterator it
+         = transducers.begin();
+         it != transducers.end(); ++it)
+    {
+        RtnProfile const &profile = (*it)->get_profile();
+        retval << "    " << std::left << std::setw(max_name_len + 2)
+               << (*it)->get_name() << std::right << std::setw(12)
+               << profile.calls << std::setw(14) << std::fixed
+               << std::setprecision(6) << profile.seconds << std::setw(10)
+               << profile.max_depth << std::setw(16) << profile.states_visited
+               << std::setw(14) << profile.time_cutoffs << "\n";
+    }
+    retval << "  Most visited states:\n";
+    for (std::vector<PmatchTransducer *>::const_iterator it
+         = transducers.begin();
+         it != transducers.end(); ++it)
+    {
+        std::vector<std::pair<TransitionTableIndex, unsigned long> > hottest
+            = (*it)->get_hottest_states(5);
+        if (hottest.size() == 0)
+        {
+            continue;
+        }
+        retval << "    " << (*it)->get_name() << ":";
+        for (size_t i = 0; i < hottest.size(); ++i)
+        {
+            retval << " " << hottest[i].first << " (" << hottest[i].second
+                   << ")";
+        }
+        retval << "\n";
+    }
     return retval.str();
 }
 
+std::string
+PmatchContainer::get_profiling_info(ProfileFormat format)
+{
+    switch (format)
+    {
+    case profile_json:
+        return get_profiling_json();
+    case profile_collapsed:
+        return get_profiling_collapsed_stacks();
+    default:
+        return get_profiling_info();
+    }
+}
+
+bool
+PmatchContainer::parse_profile_format(const std::string &name,
+                                      ProfileFormat &format)
+{
+    if (name == "text")
+    {
+        format = profile_text;
+    }
+    else if (name == "json")
+    {
+        format = profile_json;
+    }
+    else if (name == "collapsed")
+    {
+        format = profile_collapsed;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+static std::string
+json_escape(const std::string &str)
+{
+    std::string retval;
+    for (std::string::const_iterator it = str.begin(); it != str.end(); ++it)
+    {
+        switch (*it)
+        {
+        case '"':
+            retval.append("\\\"");
+            break;
+        case '\\':
+            retval.append("\\\\");
+            break;
+        case '\n':
+            retval.append("\\n");
+            break;
+        case '\t':
+            retval.append("\\t");
+            break;
+        default:
+            if ((unsigned char)*it < 0x20)
+            {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char)*it);
+                retval.append(buf);
+            }
+            else
+            {
+                retval.push_back(*it);
+            }
+        }
+    }
+    return retval;
+}
+
+std::string
+PmatchContainer::get_profiling_json(void)
+{
+    std::stringstream retval;
+    retval << std::setprecision(9);
+    retval << "{\"counters\": [";
+    bool first = true;
+    for (SymbolNumber i = 0; i < alphabet.counters.size(); ++i)
+    {
+        if (alphabet.counters[i] != NO_COUNTER)
+        {
+            retval << (first ? "" : ", ") << "{\"name\": \""
+                   << json_escape(alphabet.get_counter_name(i))
+                   << "\", \"count\": " << alphabet.counters[i] << "}";
+            first = false;
+        }
+    }
+    retval << "], \"transducers\": [";
+    std::vector<PmatchTransducer *> transducers = get_profiled_transducers();
+    std::sort(transducers.begin(), transducers.end(), profile_time_comp);
+    for (std::vector<PmatchTransducer *>::const_iterator it
+         = transducers.begin();
+         it != transducers.end(); ++it)
+    {
+        RtnProfile const &profile = (*it)->get_profile();
+        retval << (it == transducers.begin() ? "" : ", ") << "{\"name\": \""
+               << json_escape((*it)->get_name()) << "\", \"calls\": "
+               << profile.calls << ", \"seconds\": " << profile.seconds
+               << ", \"max_depth\": " << profile.max_depth
+               << ", \"states_visited\": " << profile.states_visited
+               << ", \"time_cutoffs\": " << profile.time_cutoffs
+               << ", \"hottest_states\": [";
+        std::vector<std::pair<TransitionTableIndex, unsigned long> > hottest
+            = (*it)->get_hottest_states(10);
+        for (size_t i = 0; i < hottest.size(); ++i)
+        {
+            retval << (i == 0 ? "" : ", ") << "{\"state\": "
+                   << hottest[i].first << ", \"visits\": "
+                   << hottest[i].second << "}";
+        }
+        retval << "]}";
+    }
+    retval << "]}\n";
+    return retval.str();
+}
+
+std::string
+PmatchContainer::get_profiling_collapsed_stacks(void)
+{
+    // One line per call path, in the format flamegraph.pl and friends read:
+    // names separated by semicolons, then the time in microseconds
+    std::stringstream retval;
+    for (size_t i = 0; i < profile_stack_nodes.size(); ++i)
+    {
+        unsigned long micros = (unsigned long)(
+            profile_stack_nodes[i].seconds * 1000000.0 + 0.5);
+        if (micros == 0)
+        {
+            continue;
+        }
+        std::vector<std::string> path;
+        size_t node = i;
+        while (true)
+        {
+            std::string name = profile_stack_nodes[node].rtn->get_name();
+            std::replace(name.begin(), name.end(), ';', '_');
+            std::replace(name.begin(), name.end(), ' ', '_');
+            path.push_back(name);
+            if (node == 0)
+            {
+                break;
+            }
+            node = profile_stack_nodes[node].parent;
+        }
+        for (std::vector<std::string>::reverse_iterator it = path.rbegin();
+             it != path.rend(); ++it)
+        {
+            retval << (it == path.rbegin() ? "" : ";") << *it;
+        }
+        retval << " " << micros << "\n";
+    }
+    return retval.str();
+}
+
+std::vector<PmatchTransducer *>
+PmatchContainer::get_profiled_transducers(void)
+{
+    std::vector<PmatchTransducer *> retval;
+    retval.push_back(toplevel);
+    for (RtnVector::const_iterator it = alphabet.rtns.begin();
+         it != alphabet.rtns.end(); ++it)
+    {
+        if (*it != NULL && *it != toplevel)
+        {
+            retval.push_back(*it);
+        }
+    }
+    return retval;
+}
+
+void
+PmatchContainer::reset_profile(void)
+{
+    profile_stack_nodes.clear();
+    profile_current_node = 0;
+    std::vector<PmatchTransducer *> transducers = get_profiled_transducers();
+    for (std::vector<PmatchTransducer *>::iterator it = transducers.begin();
+         it != transducers.end(); ++it)
+    {
+        (*it)->reset_profile();
+    }
+    for (SymbolNumber i = 0; i < alphabet.counters.size(); ++i)
+    {
+        if (alphabet.counters[i] != NO_COUNTER)
+        {
+            alphabet.counters[i] = 0;
+        }
+    }
+}
+
+void
+PmatchContainer::profile_start(void)
+{
+    if (profile_stack_nodes.size() == 0)
+    {
+        ProfileStackNode root;
+        root.rtn = toplevel;
+        root.parent = 0;
+        root.seconds = 0.0;
+        profile_stack_nodes.push_back(root);
+    }
+    profile_current_node = 0;
+    profile_last_event = std::chrono::steady_clock::now();
+}
+
+void
+PmatchContainer::profile_charge(void)
+{
+    // Charge the time since the last event to whatever is running now
+    std::chrono::steady_clock::time_point now
+        = std::chrono::steady_clock::now();
+    double elapsed
+        = std::chrono::duration<double>(now - profile_last_event).count();
+    profile_stack_nodes[profile_current_node].seconds += elapsed;
+    profile_stack_nodes[profile_current_node].rtn->profile.seconds += elapsed;
+    profile_last_event = now;
+}
+
+void
+PmatchContainer::profile_enter(PmatchTransducer *rtn)
+{
+    profile_charge();
+    std::map<PmatchTransducer *, size_t>::const_iterator child
+        = profile_stack_nodes[profile_current_node].children.find(rtn);
+    if (child != profile_stack_nodes[profile_current_node].children.end())
+    {
+        profile_current_node = child->second;
+        return;
+    }
+    ProfileStackNode node;
+    node.rtn = rtn;
+    node.parent = profile_current_node;
+    node.seconds = 0.0;
+    size_t node_index = profile_stack_nodes.size();
+    profile_stack_nodes.push_back(node);
+    profile_stack_nodes[profile_current_node].children[rtn] = node_index;
+    profile_current_node = node_index;
+}
+
+size_t
+PmatchContainer::profile_leave(void)
+{
+    profile_charge();
+    size_t left = profile_current_node;
+    profile_current_node = profile_stack_nodes[left].parent;
+    return left;
+}
+
+void
+PmatchContainer::profile_resume(size_t node)
+{
+    profile_charge();
+    profile_current_node = node;
+}
+
 std::string
 PmatchContainer::get_pattern_count_info(void)
 {
@@ -1412,6 +1751,45 @@ PmatchContainer::copy_to_result(SymbolNumber input_sym,
     result.push_back(SymbolPair(input_sym, output_sym));
 }
 
+void
+PmatchContainer::copy_input_to_result(unsigned int begin, unsigned int end)
+{
+    result.reserve(result.size() + (end - begin));
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        SymbolNumber sym = input_symbol(i);
+        result.push_back(SymbolPair(sym, sym));
+    }
+}
+
+unsigned int
+PmatchContainer::next_possible_first_position(unsigned int input_pos)
+{
+    // Tight scan over the encoded input; this is where tokenizers with
+    // a small set of initial symbols spend most of their time
+    if (possible_first_symbols.size() == 0)
+    {
+        return input_pos;
+    }
+    const char *first_symbols = possible_first_symbols.data();
+    const size_t first_symbols_size = possible_first_symbols.size();
+    while (has_queued_input(input_pos))
+    {
+        // Scan whatever has been encoded so far before encoding more
+        const unsigned int window_end
+            = input_offset + hfst::size_t_to_uint(input.size());
+        for (; input_pos < window_end; ++input_pos)
+        {
+            SymbolNumber sym = input[input_pos - input_offset];
+            if (sym < first_symbols_size && first_symbols[sym] != 0)
+            {
+                return input_pos;
+            }
+        }
+    }
+    return input_pos;
+}
+
 std::string
 PmatchAlphabet::stringify(const DoubleTape &str)
 {
@@ -1563,22 +1941,33 @@ PmatchContainer::get_unsatisfied_rtn_name(void) const
 bool
 PmatchContainer::has_queued_input(unsigned int input_pos)
 {
-    // we catch underflow due to left context checking here
-    return input_pos < input.size() && (input_pos + 1 != 0);
+    // we catch underflow due to left context checking here, and treat
+    // anything that has dropped out of the look-behind window the same way
+    if (input_pos + 1 == 0 || input_pos < input_offset)
+    {
+        return false;
+    }
+    while (input_pos - input_offset >= input.size())
+    {
+        if (!encode_next_symbol())
+        {
+            return false;
+        }
+    }
+    return true;
 }
 
 bool
-PmatchContainer::input_matches_at(unsigned int pos,
-                                  SymbolNumberVector::iterator begin,
-                                  SymbolNumberVector::iterator end)
+PmatchContainer::input_matches_at(unsigned int pos, unsigned int begin,
+                                  unsigned int end)
 {
-    if (pos + (end - begin) >= input.size())
+    if (!has_queued_input(pos + (end - begin)))
     {
         return false;
     }
-    for (size_t i = 0; begin + i != end; ++i)
+    for (unsigned int i = 0; begin + i != end; ++i)
     {
-        if (input[pos + i] != *(begin + i))
+        if (input_symbol(pos + i) != input_symbol(begin + i))
         {
             return false;
         }
@@ -1790,9 +2179,9 @@ PmatchContainer::collect_first_symbols(const std::string &symbols_list)
     {
         while (*it >= possible_first_symbols.size())
         {
-            possible_first_symbols.push_back(false);
+            possible_first_symbols.push_back(0);
         }
-        possible_first_symbols[*it] = true;
+        possible_first_symbols[*it] = 1;
     }
 }
 
@@ -1800,6 +2189,9 @@ SymbolNumberVector
 PmatchContainer::symbol_vector_from_symbols(const std::string &symbols)
 {
     initialize_input(symbols.c_str());
+    while (encode_next_symbol())
+    {
+    }
     if (alphabet.get_special(boundary) != NO_SYMBOL_NUMBER)
     {
         return SymbolNumberVector(input.begin() + 1, input.end() - 1);
@@ -1811,67 +2203,118 @@ void
 PmatchContainer::initialize_input(const char *input_s)
 {
     input.clear();
-    char *input_str = const_cast<char *>(input_s);
-    char **input_str_ptr = &input_str;
-    SymbolNumber k = NO_SYMBOL_NUMBER;
+    input_offset = 0;
+    input_cursor = input_s;
+    input_exhausted = false;
     SymbolNumber boundary_sym = alphabet.get_special(boundary);
-    char *single_codepoint_scratch;
-    char single_codepoint_scratch_orig[5] = {};
     if (boundary_sym != NO_SYMBOL_NUMBER)
     {
         input.push_back(boundary_sym);
     }
-    while (**input_str_ptr != 0)
+}
+
+bool
+PmatchContainer::encode_next_symbol(void)
+{
+    if (input_exhausted)
     {
-        char *original_input_loc = *input_str_ptr;
-        if (single_codepoint_tokenization)
+        return false;
+    }
+    if (*input_cursor == 0)
+    {
+        input_exhausted = true;
+        SymbolNumber boundary_sym = alphabet.get_special(boundary);
+        if (boundary_sym != NO_SYMBOL_NUMBER)
         {
-            int bytes_to_tokenize = nByte_utf8(**input_str_ptr);
-            if (bytes_to_tokenize > 0)
+            input.push_back(boundary_sym);
+            return true;
+        }
+        return false;
+    }
+    char *input_str = const_cast<char *>(input_cursor);
+    char **input_str_ptr = &input_str;
+    SymbolNumber k = NO_SYMBOL_NUMBER;
+    char *single_codepoint_scratch;
+    char single_codepoint_scratch_orig[5] = {};
+    char *original_input_loc = *input_str_ptr;
+    if (single_codepoint_tokenization)
+    {
+        int bytes_to_tokenize = nByte_utf8(**input_str_ptr);
+        if (bytes_to_tokenize > 0)
+        {
+            single_codepoint_scratch = single_codepoint_scratch_orig;
+            memcpy(single_codepoint_scratch, *input_str_ptr,
+                   bytes_to_tokenize);
+            single_codepoint_scratch[bytes_to_tokenize] = '\0';
+            k = encoder->find_key(&single_codepoint_scratch);
+            if (k != NO_SYMBOL_NUMBER)
             {
-                single_codepoint_scratch = single_codepoint_scratch_orig;
-                memcpy(single_codepoint_scratch, *input_str_ptr,
-                       bytes_to_tokenize);
-                single_codepoint_scratch[bytes_to_tokenize] = '\0';
-                k = encoder->find_key(&single_codepoint_scratch);
-                if (k != NO_SYMBOL_NUMBER)
-                {
-                    (*input_str_ptr) += bytes_to_tokenize;
-                }
+                (*input_str_ptr) += bytes_to_tokenize;
             }
         }
-        else
+    }
+    else
+    {
+        k = encoder->find_key(input_str_ptr);
+    }
+    if (k == NO_SYMBOL_NUMBER)
+    {
+        // Regular tokenization failed
+        // the encoder moves as far as it can during tokenization,
+        // we want to go back to be in position to add one utf-8 char
+        *input_str_ptr = original_input_loc;
+        int bytes_to_tokenize = nByte_utf8(**input_str_ptr);
+        if (bytes_to_tokenize == 0)
         {
-            k = encoder->find_key(input_str_ptr);
+            // if utf-8 tokenization fails too, just grab a byte
+            bytes_to_tokenize = 1;
         }
-        if (k == NO_SYMBOL_NUMBER)
+        char new_symbol[5];
+        memcpy(new_symbol, *input_str_ptr, bytes_to_tokenize);
+        new_symbol[bytes_to_tokenize] = '\0';
+        (*input_str_ptr) += bytes_to_tokenize;
+        alphabet.add_symbol(new_symbol);
+        encoder->read_input_symbol(new_symbol, symbol_count);
+        k = symbol_count;
+        ++symbol_count;
+    }
+    input_cursor = input_str;
+    input.push_back(k);
+    return true;
+}
+
+void
+PmatchContainer::discard_input_before(unsigned int input_pos)
+{
+    // Keep max_context_length symbols of look-behind for left contexts,
+    // and anything a capture may still be compared against
+    if (input_pos < input_offset + max_context_length)
+    {
+        return;
+    }
+    unsigned int keep_from
+        = input_pos - hfst::size_t_to_uint(max_context_length);
+    // Only compact when that gets rid of a good chunk of the window, so
+    // the cost is amortized over the symbols discarded
+    if (keep_from - input_offset < 4096
+        || keep_from - input_offset < input.size() / 2)
+    {
+        return;
+    }
+    for (std::vector<Capture>::const_iterator it = old_captures.begin();
+         it != old_captures.end(); ++it)
+    {
+        if (it->begin < keep_from)
         {
-            // Regular tokenization failed
-            // the encoder moves as far as it can during tokenization,
-            // we want to go back to be in position to add one utf-8 char
-            *input_str_ptr = original_input_loc;
-            int bytes_to_tokenize = nByte_utf8(**input_str_ptr);
-            if (bytes_to_tokenize == 0)
-            {
-                // if utf-8 tokenization fails too, just grab a byte
-                bytes_to_tokenize = 1;
-            }
-            char new_symbol[5];
-            memcpy(new_symbol, *input_str_ptr, bytes_to_tokenize);
-            new_symbol[bytes_to_tokenize] = '\0';
-            (*input_str_ptr) += bytes_to_tokenize;
-            alphabet.add_symbol(new_symbol);
-            encoder->read_input_symbol(new_symbol, symbol_count);
-            k = symbol_count;
-            ++symbol_count;
+            keep_from = it->begin;
         }
-        input.push_back(k);
     }
-    if (boundary_sym != NO_SYMBOL_NUMBER)
+    if (keep_from <= input_offset)
     {
-        input.push_back(boundary_sym);
+        return;
     }
-    return;
+    input.erase(input.begin(), input.begin() + (keep_from - input_offset));
+    input_offset = keep_from;
 }
 
 void
@@ -1891,6 +2334,13 @@ PmatchTransducer::rtn_call(unsigned int input_tape_pos, unsigned int tape_pos,
 {
     container->push_rtn_call(caller_index, caller);
     container->increase_stack_depth();
+    if (container->profile_mode)
+    {
+        ++profile.calls;
+        profile.max_depth
+            = std::max(profile.max_depth, container->get_stack_depth());
+        container->profile_enter(this);
+    }
     LocalVariables new_top(local_stack.top());
     new_top.flag_state = alphabet.get_fd_table();
     new_top.tape_step = 1;
@@ -1900,6 +2350,10 @@ PmatchTransducer::rtn_call(unsigned int input_tape_pos, unsigned int tape_pos,
     local_stack.push(new_top);
     get_analyses(input_tape_pos, tape_pos, 0);
     local_stack.pop();
+    if (container->profile_mode)
+    {
+        container->profile_leave();
+    }
     container->decrease_stack_depth();
     container->rtn_stack_pop();
 }
@@ -1913,11 +2367,22 @@ PmatchTransducer::rtn_call_in_context(unsigned int input_tape_pos,
 {
     container->push_rtn_call(caller_index, caller);
     container->increase_stack_depth();
+    if (container->profile_mode)
+    {
+        ++profile.calls;
+        profile.max_depth
+            = std::max(profile.max_depth, container->get_stack_depth());
+        container->profile_enter(this);
+    }
     LocalVariables new_top(locals);
     new_top.flag_state = alphabet.get_fd_table();
     local_stack.push(new_top);
     get_analyses(input_tape_pos, tape_pos, 0);
     local_stack.pop();
+    if (container->profile_mode)
+    {
+        container->profile_leave();
+    }
     container->decrease_stack_depth();
     container->rtn_stack_pop();
 }
@@ -1928,7 +2393,17 @@ PmatchTransducer::rtn_return(unsigned int input_tape_pos,
 {
     container->decrease_stack_depth();
     TransitionTableIndex entry_index = container->rtn_stack_top().caller_index;
+    // While we're back in the caller, time is charged to it
+    size_t profile_node = 0;
+    if (container->profile_mode)
+    {
+        profile_node = container->profile_leave();
+    }
     get_analyses(input_tape_pos, tape_pos, entry_index);
+    if (container->profile_mode)
+    {
+        container->profile_resume(profile_node);
+    }
     container->increase_stack_depth();
 }
 
@@ -2004,24 +2479,24 @@ std::pair<SymbolNumberVector::iterator, SymbolNumberVector::iterator>
 PmatchContainer::get_longest_matching_capture(SymbolNumber key,
                                               unsigned int input_pos)
 {
-    std::pair<SymbolNumberVector::iterator, SymbolNumberVector::iterator>
-        longest_so_far(input.begin(), input.begin());
+    // Matching may encode more input and so move the window around, so we
+    // keep track of positions and only make iterators at the end
+    unsigned int longest_begin = input_offset;
+    unsigned int longest_end = input_offset;
     for (std::vector<Capture>::iterator it = captures.begin();
          it != captures.end(); ++it)
     {
         if (key == it->name
-            && input_matches_at(input_pos, input.begin() + it->begin,
-                                input.begin() + it->end))
+            && input_matches_at(input_pos, it->begin, it->end))
         {
-            if ((it->end - it->begin)
-                <= longest_so_far.second - longest_so_far.first)
+            if ((it->end - it->begin) <= longest_end - longest_begin)
             {
                 continue;
             }
             else
             {
-                longest_so_far.first = input.begin() + it->begin;
-                longest_so_far.second = input.begin() + it->end;
+                longest_begin = it->begin;
+                longest_end = it->end;
             }
         }
     }
@@ -2029,22 +2504,23 @@ PmatchContainer::get_longest_matching_capture(SymbolNumber key,
          it != old_captures.end(); ++it)
     {
         if (key == it->name
-            && input_matches_at(input_pos, input.begin() + it->begin,
-                                input.begin() + it->end))
+            && input_matches_at(input_pos, it->begin, it->end))
         {
-            if ((it->end - it->begin)
-                <= longest_so_far.second - longest_so_far.first)
+            if ((it->end - it->begin) <= longest_end - longest_begin)
             {
                 continue;
             }
             else
             {
-                longest_so_far.first = input.begin() + it->begin;
-                longest_so_far.second = input.begin() + it->end;
+                longest_begin = it->begin;
+                longest_end = it->end;
             }
         }
     }
-    return longest_so_far;
+    return std::pair<SymbolNumberVector::iterator,
+                     SymbolNumberVector::iterator>(
+        input.begin() + (longest_begin - input_offset),
+        input.begin() + (longest_end - input_offset));
 }
 
 void
@@ -2277,8 +2753,8 @@ PmatchTransducer::take_transitions(SymbolNumber input, unsigned int input_pos,
                 {
                     // we got here via a meta-arc, so look back in the
                     // input tape to find the symbol we want to write
-                    this_output = container->input[input_pos];
-                    this_input = container->input[input_pos];
+                    this_output = container->input_symbol(input_pos);
+                    this_input = container->input_symbol(input_pos);
                 }
                 if (this_input == alphabet.get_special(Pmatch_passthrough))
                 {
@@ -2328,6 +2804,10 @@ PmatchTransducer::get_analyses(unsigned int input_pos, unsigned int tape_pos,
     {
         return;
     }
+    if (container->profile_mode)
+    {
+        note_state_visit(i);
+    }
     if (container->max_time > 0.0)
     {
         ++container->call_counter;
@@ -2340,6 +2820,10 @@ PmatchTransducer::get_analyses(unsigned int input_pos, unsigned int tape_pos,
                      / CLOCKS_PER_SEC)
                         > container->max_time)))
         {
+            if (container->profile_mode && !container->limit_reached)
+            {
+                ++profile.time_cutoffs;
+            }
             container->limit_reached = true;
             return;
         }
@@ -2378,18 +2862,19 @@ PmatchTransducer::get_analyses(unsigned int input_pos, unsigned int tape_pos,
     }
     else
     {
-        input = container->input[input_pos];
+        input = container->input_symbol(input_pos);
     }
 
     if (alphabet.symbol2lists[input] != NO_SYMBOL_NUMBER)
     {
-        // At least one symbol list could allow this symbol
-        for (SymbolNumberVector::const_iterator it
-             = alphabet.symbol_lists[alphabet.symbol2lists[input]].begin();
-             it != alphabet.symbol_lists[alphabet.symbol2lists[input]].end();
-             ++it)
+        // At least one symbol list could allow this symbol. Encoding more
+        // input further down may add symbols (and lists) to the alphabet,
+        // so we index rather than hold on to iterators.
+        SymbolNumber list = alphabet.symbol2lists[input];
+        for (size_t j = 0; j < alphabet.symbol_lists[list].size(); ++j)
         {
-            take_transitions(*it, input_pos, tape_pos, i + 1);
+            take_transitions(alphabet.symbol_lists[list][j], input_pos,
+                             tape_pos, i + 1);
         }
     }
     if (alphabet.get_special(UnicodeAlpha) != NO_SYMBOL_NUMBER)
@@ -2452,6 +2937,81 @@ PmatchTransducer::get_analyses(unsigned int input_pos, unsigned int tape_pos,
     container->unrecurse();
 }
 
+void
+PmatchTransducer::note_state_visit(TransitionTableIndex i)
+{
+    ++profile.states_visited;
+    if (indexes_transition_table(i))
+    {
+        if (transition_visits.size() == 0)
+        {
+            transition_visits.resize(transition_table.size(), 0);
+        }
+        TransitionTableIndex t = i - TRANSITION_TARGET_TABLE_START;
+        if (t < transition_visits.size())
+        {
+            ++transition_visits[t];
+        }
+    }
+    else
+    {
+        if (index_visits.size() == 0)
+        {
+            index_visits.resize(index_table.size(), 0);
+        }
+        if (i < index_visits.size())
+        {
+            ++index_visits[i];
+        }
+    }
+}
+
+static bool
+state_visit_comp(std::pair<TransitionTableIndex, unsigned long> l,
+                 std::pair<TransitionTableIndex, unsigned long> r)
+{
+    // Descending order
+    return l.second > r.second;
+}
+
+std::vector<std::pair<TransitionTableIndex, unsigned long> >
+PmatchTransducer::get_hottest_states(size_t n) const
+{
+    // States are reported by the index they have in the tables, with
+    // transition table states offset by TRANSITION_TARGET_TABLE_START
+    std::vector<std::pair<TransitionTableIndex, unsigned long> > retval;
+    for (size_t i = 0; i < index_visits.size(); ++i)
+    {
+        if (index_visits[i] != 0)
+        {
+            retval.push_back(std::pair<TransitionTableIndex, unsigned long>(
+                hfst::size_t_to_uint(i), index_visits[i]));
+        }
+    }
+    for (size_t i = 0; i < transition_visits.size(); ++i)
+    {
+        if (transition_visits[i] != 0)
+        {
+            retval.push_back(std::pair<TransitionTableIndex, unsigned long>(
+                hfst::size_t_to_uint(i) + TRANSITION_TARGET_TABLE_START,
+                transition_visits[i]));
+        }
+    }
+    n = std::min(n, retval.size());
+    std::partial_sort(retval.begin(), retval.begin() + n, retval.end(),
+                      state_visit_comp);
+    retval.resize(n);
+    return retval;
+}
+
+void
+PmatchTransducer::reset_profile(void)
+{
+    profile = RtnProfile();
+    index_visits.clear();
+    transition_visits.clear();
+}
+
 bool
 PmatchTransducer::checking_context(void) const
 {
@@ -14,6 +14,7 @@
 #include <sstream>
 #include <algorithm>
 #include <ctime>
+#include <chrono>
 #include "HfstTransducer.h"
 #include "HfstExceptionDefs.h"
 #include "transducer.h"
@@ -146,6 +147,32 @@ namespace hfst_ol {
         SymbolNumber name;
     };
 
+    // Profiling data gathered per transducer (TOP or an RTN) when
+    // profile_mode is on
+    struct RtnProfile
+    {
+        unsigned long calls;
+        // Time spent in this transducer itself, not in the ones it calls
+        double seconds;
+        unsigned int max_depth;
+        unsigned long states_visited;
+        unsigned long time_cutoffs;
+    RtnProfile(void): calls(0), seconds(0.0), max_depth(0),
+            states_visited(0), time_cutoffs(0) {}
+    };
+
+    // A node in the tree of RTN call paths seen while profiling, for
+    // collapsed-stack (flamegraph) output
+    struct ProfileStackNode
+    {
+        PmatchTransducer * rtn;
+        size_t parent;
+        std::map<PmatchTransducer *, size_t> children;
+        double seconds;
+    };
+
+    enum ProfileFormat{profile_text, profile_json, profile_collapsed};
+
     class PmatchContainer
     {
     protected:
@@ -154,7 +181,17 @@ namespace hfst_ol {
         SymbolNumber orig_symbol_count;
         SymbolNumber symbol_count;
         PmatchTransducer * toplevel;
+        // The input is encoded lazily as matching moves forward. input holds
+        // a window of encoded symbols starting at absolute position
+        // input_offset; input_cursor points at the first byte of the input
+        // string that hasn't been encoded yet. Only the encoded symbols are
+        // bounded (by max_context_length plus whatever captures still need):
+        // the caller's input string, result and locations all still grow
+        // with the input, so memory use is linear in the size of the input.
         SymbolNumberVector input;
+        unsigned int input_offset;
+        const char * input_cursor;
+        bool input_exhausted;
         // This tracks the ENTRY and EXIT tags
         std::vector<unsigned int> entry_stack;
         RtnCallStacks rtn_stacks;
@@ -168,7 +205,9 @@ namespace hfst_ol {
         std::vector<Capture> captures;
         std::vector<Capture> best_captures;
         std::vector<Capture> old_captures;
-        std::vector<bool> possible_first_symbols;
+        // Dense lookup table over symbol numbers, nonzero for symbols that
+        // may begin a match. Empty means "anything may begin a match".
+        std::vector<char> possible_first_symbols;
         // The flag state for global flags
         hfst::FdState<SymbolNumber> global_flag_state;
         bool verbose;
@@ -187,6 +226,10 @@ namespace hfst_ol {
         unsigned long line_number;
         std::map<std::string, size_t> pattern_counts;
         bool profile_mode;
+        // Call path tree for profiling, node 0 being TOP
+        std::vector<ProfileStackNode> profile_stack_nodes;
+        size_t profile_current_node;
+        std::chrono::steady_clock::time_point profile_last_event;
         bool single_codepoint_tokenization;
         unsigned int recursion_depth_left;
         // An optional time limit for operations
@@ -223,9 +266,18 @@ namespace hfst_ol {
         void collect_first_symbols(const std::string & symbol_list);
         SymbolNumberVector symbol_vector_from_symbols(const std::string & symbols);
         void initialize_input(const char * input);
+        bool encode_next_symbol(void);
+        void discard_input_before(unsigned int input_pos);
+        SymbolNumber input_symbol(unsigned int input_pos) const
+        {
+            return input[input_pos - input_offset];
+        }
         bool has_unsatisfied_rtns(void) const;
         std::string get_unsatisfied_rtn_name(void) const;
         void add_rtn(Transducer * rtn, const std::string & name);
+        // Match the whole of input, leaving the output in result (or
+        // locations in locate mode). The input and the output are held in
+        // memory in full; see input above.
         void process(const std::string & input);
         std::string match(const std::string & input,
                           double time_cutoff = 0.0,
@@ -239,21 +291,35 @@ namespace hfst_ol {
                   SymbolNumberVector::iterator>
         get_longest_matching_capture(SymbolNumber key, unsigned int input_pos);
         std::string get_profiling_info(void);
+        std::string get_profiling_info(ProfileFormat format);
+        std::string get_profiling_json(void);
+        std::string get_profiling_collapsed_stacks(void);
+        void reset_profile(void);
+        static bool parse_profile_format(const std::string & name,
+                                         ProfileFormat & format);
+        void profile_start(void);
+        void profile_charge(void);
+        void profile_enter(PmatchTransducer * rtn);
+        size_t profile_leave(void);
+        void profile_resume(size_t node);
+        std::vector<PmatchTransducer *> get_profiled_transducers(void);
         std::string get_pattern_count_info(void);
         bool has_queued_input(unsigned int input_pos);
         bool input_matches_at(unsigned int pos,
-                              SymbolNumberVector::iterator begin,
-                              SymbolNumberVector::iterator end);
+                              unsigned int begin,
+                              unsigned int end);
         bool not_possible_first_symbol(SymbolNumber sym)
         {
             if (possible_first_symbols.size() == 0) {
                 return false;
             }
             return sym >= possible_first_symbols.size() ||
-                possible_first_symbols[sym] == false;
+                possible_first_symbols[sym] == 0;
         }
+        unsigned int next_possible_first_position(unsigned int input_pos);
         void copy_to_result(const DoubleTape & best_result);
         void copy_to_result(SymbolNumber input, SymbolNumber output);
+        void copy_input_to_result(unsigned int begin, unsigned int end);
         static std::map<std::string, std::string> parse_hfst3_header(std::istream & f);
         void set_verbose(bool b) { verbose = b; }
         void set_locate_mode(bool b) { locate_mode = b; }
@@ -368,6 +434,12 @@ namespace hfst_ol {
         std::vector<TransitionW> transition_table;
         std::vector<TransitionWIndex> index_table;
 
+        // Profiling counters, only touched in profile_mode
+        RtnProfile profile;
+        std::vector<unsigned long> index_visits;
+        std::vector<unsigned long> transition_visits;
+        void note_state_visit(TransitionTableIndex i);
+
         PmatchAlphabet & alphabet;
         SymbolNumber orig_symbol_count;
         PmatchContainer * container;
@@ -469,6 +541,11 @@ namespace hfst_ol {
                                  LocalVariables locals);
         void rtn_return(unsigned int input_pos, unsigned int tape_pos);
         void handle_final_state(unsigned int input_pos, unsigned int tape_pos);
+        std::string const & get_name(void) const { return name; }
+        RtnProfile const & get_profile(void) const { return profile; }
+        std::vector<std::pair<TransitionTableIndex, unsigned long> >
+        get_hottest_states(size_t n) const;
+        void reset_profile(void);
 
         friend class PmatchContainer;
     };
@@ -9,6 +9,7 @@
 
 #include "./transducer.h"
 
+#include <algorithm>
 #include <cstdio> // testing
 
 #ifndef MAIN_TEST
@@ -311,6 +312,19 @@ SymbolNumber Encoder::find_key(char ** p)
 }
 
 bool Transducer::initialize_input(const char * input)
+{
+    return tokenize(input, encoder);
+}
+
+bool Transducer::initialize_output(const char * output)
+{
+    if (output_encoder == NULL) {
+        build_output_index();
+    }
+    return tokenize(output, output_encoder);
+}
+
+bool Transducer::tokenize(const char * input, Encoder * tokenizer)
 {
     char * input_str = const_cast<char *>(input);
     char ** input_str_ptr = &input_str;
@@ -318,7 +332,7 @@ bool Transducer::initialize_input(const char * input)
     SymbolNumber k = NO_SYMBOL_NUMBER;
     while(**input_str_ptr != 0) {
         char * original_input_loc = *input_str_ptr;
-        k = encoder->find_key(input_str_ptr);
+        k = tokenizer->find_key(input_str_ptr);
         if (k == NO_SYMBOL_NUMBER) {
             // Add what we assume to be an unknown utf-8 symbol to the alphabet
             *input_str_ptr = original_input_loc;
@@ -333,6 +347,9 @@ bool Transducer::initialize_input(const char * input)
             alphabet->add_symbol(new_symbol);
             k = hfst::size_t_to_uint(alphabet->get_symbol_table().size() - 1);
             encoder->read_input_symbol(new_symbol, k);
+            if (output_encoder != NULL) {
+                output_encoder->read_input_symbol(new_symbol, k);
+            }
             delete [] new_symbol;
         }
         input_tape.write(i, k);
@@ -354,6 +371,9 @@ void Transducer::include_symbol_in_alphabet(const std::string & sym)
     //std::strcpy(cstr_for_encoder, sym.c_str());
     strcpy(cstr_for_encoder, sym.c_str());
     encoder->read_input_symbol(cstr_for_encoder, key);
+    if (output_encoder != NULL) {
+        output_encoder->read_input_symbol(cstr_for_encoder, key);
+    }
     delete[] cstr_for_encoder;
 }
 
@@ -381,6 +401,13 @@ HfstTwoLevelPaths * Transducer::lookup_fd_pairs(const std::string & s, ssize_t l
 
 bool Transducer::is_lookup_infinitely_ambiguous(const std::string & s)
 {
+    if (input_epsilon_cycles == NULL) {
+        input_epsilon_cycles = new InputEpsilonCycles(*this);
+    }
+    // No input can lead to a loop
+    if (!input_epsilon_cycles->reaches_cycle(0)) {
+        return false;
+    }
     if (!initialize_input(s.c_str())) {
         return false;
     }
@@ -461,6 +488,71 @@ HfstTwoLevelPaths * Transducer::lookup_fd_pairs(const char * s, ssize_t limit,
     return results;
 }
 
+HfstOneLevelPaths * Transducer::lookdown_fd(const StringVector & s,
+                                            ssize_t limit, double time_cutoff)
+{
+    std::string output_str;
+    for (StringVector::const_iterator it = s.begin(); it != s.end(); ++it) {
+        output_str.append(*it);
+    }
+    return lookdown_fd(output_str, limit, time_cutoff);
+}
+
+HfstOneLevelPaths * Transducer::lookdown_fd(const std::string & s,
+                                            ssize_t limit, double time_cutoff)
+{
+    return lookdown_fd(s.c_str(), limit, time_cutoff);
+}
+
+HfstOneLevelPaths * Transducer::lookdown_fd(const char * s, ssize_t limit,
+                                            double time_cutoff)
+{
+    max_lookups = limit;
+    max_time = 0.0;
+    if (time_cutoff > 0.0) {
+        max_time = time_cutoff;
+        start_clock = clock();
+    }
+    HfstOneLevelPaths * results = new HfstOneLevelPaths;
+    if (!initialize_output(s)) {
+        return results;
+    }
+    lookup_paths = new HfstTwoLevelPaths;
+    traversal_states.clear();
+    get_generations(0, 0, 0);
+    for (HfstTwoLevelPaths::iterator it = lookup_paths->begin();
+         it != lookup_paths->end(); ++it) {
+        HfstOneLevelPath input_path;
+        input_path.first = it->first;
+        for (StringPairVector::const_iterator v_it = (it->second).begin();
+             v_it != (it->second).end(); ++v_it) {
+            input_path.second.push_back(v_it->first);
+        }
+        results->insert(input_path);
+    }
+    delete lookup_paths;
+    lookup_paths = NULL;
+    return results;
+}
+
+bool Transducer::is_lookdown_infinitely_ambiguous(void)
+{
+    if (output_index == NULL) {
+        build_output_index();
+    }
+    return output_index->has_epsilon_cycles();
+}
+
+void Transducer::build_output_index(void)
+{
+    delete output_index;
+    delete output_encoder;
+    output_index = new OutputSymbolIndex(*this);
+    output_encoder = new Encoder(
+        alphabet->get_symbol_table(),
+        hfst::size_t_to_uint(alphabet->get_symbol_table().size()));
+}
+
 void Transducer::try_epsilon_transitions(unsigned int input_pos,
                                          unsigned int output_pos,
                                          TransitionTableIndex i)
@@ -701,6 +793,134 @@ void Transducer::get_analyses(unsigned int input_pos,
     ++recursion_depth_left;
 }
 
+void Transducer::try_output_epsilons(unsigned int input_pos,
+                                     unsigned int output_pos,
+                                     TransitionTableIndex i)
+{
+    OutputSymbolIndex::Range range = output_index->find_epsilons(i);
+    for (unsigned int p = range.first; p < range.second; ++p)
+    {
+        TransitionTableIndex t = output_index->get_transition(p);
+        SymbolNumber input = tables->get_transition_input(t);
+        SymbolNumber output = tables->get_transition_output(t);
+        TransitionTableIndex target = tables->get_transition_target(t);
+        Weight old_weight = current_weight;
+        if (output == 0) // epsilon
+        {
+            output_tape.write(output_pos, input, output);
+            current_weight += tables->get_weight(t);
+            get_generations(input_pos, output_pos + 1, target);
+            current_weight = old_weight;
+        } else { // flag diacritic, as in try_epsilon_transitions
+            FlagDiacriticState flags = flag_state.get_values();
+            if (flag_state.apply_operation(
+                    *(alphabet->get_operation(output)))) {
+                TraversalState flag_reachable(target, flags);
+                if (traversal_states.count(flag_reachable) == 0) {
+                    traversal_states.insert(flag_reachable);
+                    output_tape.write(output_pos, input, output);
+                    current_weight += tables->get_weight(t);
+                    get_generations(input_pos, output_pos + 1, target);
+                    current_weight = old_weight;
+                    traversal_states.erase(flag_reachable);
+                }
+            }
+            flag_state.assign_values(flags);
+        }
+    }
+}
+
+bool Transducer::find_output_transitions(SymbolNumber output,
+                                         unsigned int input_pos,
+                                         unsigned int output_pos,
+                                         TransitionTableIndex i)
+{
+    OutputSymbolIndex::Range range = output_index->find(i, output);
+    for (unsigned int p = range.first; p < range.second; ++p)
+    {
+        TransitionTableIndex t = output_index->get_transition(p);
+        Weight old_weight = current_weight;
+        // We're not going to find an epsilon / flag loop
+        traversal_states.clear();
+        SymbolNumber input = tables->get_transition_input(t);
+        if (alphabet->is_meta_arc(input)) {
+            // we got here via default, identity or unknown, so write
+            // the symbol we are looking down
+            input = input_tape[input_pos - 1];
+        }
+        output_tape.write(output_pos, input, input_tape[input_pos - 1]);
+        current_weight += tables->get_weight(t);
+        get_generations(input_pos, output_pos + 1,
+                        tables->get_transition_target(t));
+        current_weight = old_weight;
+    }
+    return range.first != range.second;
+}
+
+// This is get_analyses with the sides of the transducer swapped: the input
+// tape is matched against output symbols and the input symbols are
+// collected.
+void Transducer::get_generations(unsigned int input_pos,
+                                 unsigned int output_pos,
+                                 TransitionTableIndex i)
+{
+    if (recursion_depth_left == 0) {
+        return;
+    }
+    if (max_lookups >= 0 && (ssize_t)lookup_paths->size() >= max_lookups) {
+        return;
+    }
+    if (max_time > 0.0) {
+        if ((((double) clock() - start_clock) / CLOCKS_PER_SEC) > max_time) {
+            return;
+        }
+    }
+    --recursion_depth_left;
+
+    if (input_tape[input_pos] == NO_SYMBOL_NUMBER) {
+        output_tape.write(output_pos, NO_SYMBOL_NUMBER, NO_SYMBOL_NUMBER);
+        bool final = indexes_transition_table(i) ?
+            tables->get_transition_finality(i - TRANSITION_TARGET_TABLE_START) :
+            tables->get_index_finality(i);
+        if (final) {
+            Weight old_weight = current_weight;
+            current_weight += indexes_transition_table(i) ?
+                tables->get_weight(i - TRANSITION_TARGET_TABLE_START) :
+                tables->get_final_weight(i);
+            note_analysis();
+            current_weight = old_weight;
+        }
+    }
+
+    try_output_epsilons(input_pos, output_pos, i);
+
+    if (input_tape[input_pos] != NO_SYMBOL_NUMBER) {
+        SymbolNumber output = input_tape[input_pos];
+        bool found = false;
+        if (output < alphabet->get_orig_symbol_count()) {
+            found = find_output_transitions(output, input_pos + 1,
+                                            output_pos, i);
+        } else {
+            if (alphabet->get_identity_symbol() != NO_SYMBOL_NUMBER) {
+                found = find_output_transitions(
+                    alphabet->get_identity_symbol(),
+                    input_pos + 1, output_pos, i) || found;
+            }
+            if (alphabet->get_unknown_symbol() != NO_SYMBOL_NUMBER) {
+                found = find_output_transitions(
+                    alphabet->get_unknown_symbol(),
+                    input_pos + 1, output_pos, i) || found;
+            }
+        }
+        if (alphabet->get_default_symbol() != NO_SYMBOL_NUMBER && !found) {
+            find_output_transitions(alphabet->get_default_symbol(),
+                                    input_pos + 1, output_pos, i);
+        }
+    }
+    output_tape.write(output_pos, NO_SYMBOL_NUMBER, NO_SYMBOL_NUMBER);
+    ++recursion_depth_left;
+}
+
 void Transducer::note_analysis(void)
 {
     HfstTwoLevelPath result;
@@ -714,8 +934,9 @@ void Transducer::note_analysis(void)
 }
 
 Transducer::Transducer():
-    header(NULL), alphabet(NULL), tables(NULL),
+    header(NULL), alphabet(NULL), tables(NULL), tables_shared(false),
     current_weight(0.0), lookup_paths(NULL), encoder(NULL),
+    output_index(NULL), output_encoder(NULL), input_epsilon_cycles(NULL),
     input_tape(), output_tape(),
     flag_state(), found_transition(false), max_lookups(-1),
     recursion_depth_left(MAX_RECURSION_DEPTH){}
@@ -723,9 +944,11 @@ Transducer::Transducer():
 Transducer::Transducer(std::istream& is):
     header(new TransducerHeader(is)),
     alphabet(new TransducerAlphabet(is, header->symbol_count())),
-    tables(NULL), current_weight(0.0), lookup_paths(NULL),
+    tables(NULL), tables_shared(false), current_weight(0.0),
+    lookup_paths(NULL),
     encoder(new Encoder(alphabet->get_symbol_table(),
                         header->input_symbol_count())),
+    output_index(NULL), output_encoder(NULL), input_epsilon_cycles(NULL),
     input_tape(), output_tape(),
     flag_state(alphabet->get_fd_table()), found_transition(false), max_lookups(-1),
     recursion_depth_left(MAX_RECURSION_DEPTH)
@@ -737,10 +960,12 @@ Transducer::Transducer(std::istream& is):
 Transducer::Transducer(bool weighted):
     header(new TransducerHeader(weighted)),
     alphabet(new TransducerAlphabet()),
+    tables_shared(false),
     current_weight(0.0),
     lookup_paths(NULL),
     encoder(new Encoder(alphabet->get_symbol_table(),
                         header->input_symbol_count())),
+    output_index(NULL), output_encoder(NULL), input_epsilon_cycles(NULL),
     input_tape(), output_tape(),
     flag_state(alphabet->get_fd_table()), found_transition(false),
     max_lookups(-1), recursion_depth_left(MAX_RECURSION_DEPTH)
@@ -759,10 +984,12 @@ Transducer::Transducer(const TransducerHeader& header,
     alphabet(new TransducerAlphabet(alphabet)),
     tables(new TransducerTables<TransitionIndex,Transition>(
                index_table, transition_table)),
+    tables_shared(false),
     current_weight(0.0),
     lookup_paths(NULL),
     encoder(new Encoder(alphabet.get_symbol_table(),
                         header.input_symbol_count())),
+    output_index(NULL), output_encoder(NULL), input_epsilon_cycles(NULL),
     input_tape(), output_tape(),
     flag_state(alphabet.get_fd_table()), found_transition(false), max_lookups(-1),
     recursion_depth_left(MAX_RECURSION_DEPTH)
@@ -776,10 +1003,12 @@ Transducer::Transducer(const TransducerHeader& header,
     alphabet(new TransducerAlphabet(alphabet)),
     tables(new TransducerTables<TransitionWIndex,TransitionW>(
                index_table, transition_table)),
+    tables_shared(false),
     current_weight(0.0),
     lookup_paths(NULL),
     encoder(new Encoder(alphabet.get_symbol_table(),
                         header.input_symbol_count())),
+    output_index(NULL), output_encoder(NULL), input_epsilon_cycles(NULL),
     input_tape(), output_tape(),
     flag_state(alphabet.get_fd_table()), found_transition(false), max_lookups(-1),
     recursion_depth_left(MAX_RECURSION_DEPTH)
@@ -789,8 +1018,13 @@ Transducer::~Transducer()
 {
     delete header;
     delete alphabet;
-    delete tables;
+    if (!tables_shared) {
+        delete tables;
+    }
     delete encoder;
+    delete output_index;
+    delete output_encoder;
+    delete input_epsilon_cycles;
 }
 
 TransducerTable<TransitionWIndex> Transducer::copy_windex_table()
@@ -881,6 +1115,25 @@ Transducer * Transducer::copy(Transducer * t, bool weighted)
     return another;
 }
 
+Transducer * Transducer::copy_for_lookup(void) const
+{
+    Transducer * another = new Transducer();
+    another->header = new TransducerHeader(*header);
+    another->alphabet = new TransducerAlphabet(*alphabet);
+    another->tables = tables;
+    another->tables_shared = true;
+    another->encoder = new Encoder(another->alphabet->get_symbol_table(),
+                                   header->input_symbol_count());
+    // Symbols that lookup has added to the alphabet
+    const SymbolTable & symbols = another->alphabet->get_symbol_table();
+    for (size_t i = alphabet->get_orig_symbol_count(); i < symbols.size(); ++i) {
+        another->encoder->read_input_symbol(
+            symbols[i].c_str(), hfst::size_t_to_uint(i));
+    }
+    another->flag_state = another->alphabet->get_fd_table();
+    return another;
+}
+
 void Transducer::display() const
 {
     std::cout << "-----Displaying optimized-lookup transducer------"
@@ -963,6 +1216,44 @@ TransitionTableIndexSet Transducer::get_transitions_from_state(
     return transitions;
 }
 
+void Transducer::get_state_transitions(
+    TransitionTableIndex state,
+    std::vector<TransitionTableIndex> & transitions) const
+{
+    if (indexes_transition_table(state)) {
+        for (TransitionTableIndex i = state - TRANSITION_TARGET_TABLE_START + 1;
+             i < header->target_table_size() &&
+                 get_transition(i).get_input_symbol() != NO_SYMBOL_NUMBER;
+             ++i) {
+            transitions.push_back(i);
+        }
+        return;
+    }
+
+    // Epsilons and flags are found at index 0, as in lookup
+    for (SymbolNumber symbol = 0; symbol < header->input_symbol_count();
+         ++symbol) {
+        if (symbol != 0 && alphabet->is_flag_diacritic(symbol)) {
+            continue;
+        }
+        if (state + 1 + symbol >= header->index_table_size() ||
+            get_index(state + 1 + symbol).get_input_symbol() != symbol) {
+            continue;
+        }
+        for (TransitionTableIndex i =
+                 get_index(state + 1 + symbol).get_target() -
+                 TRANSITION_TARGET_TABLE_START;
+             i < header->target_table_size(); ++i) {
+            SymbolNumber input = get_transition(i).get_input_symbol();
+            if (input != symbol &&
+                !(symbol == 0 && alphabet->is_flag_diacritic(input))) {
+                break;
+            }
+            transitions.push_back(i);
+        }
+    }
+}
+
 TransitionTableIndex Transducer::next(const TransitionTableIndex i,
                                       const SymbolNumber symbol) const
 {
@@ -1036,6 +1327,132 @@ Weight Transducer::final_weight(const TransitionTableIndex i) const
     }
 }
 
+static bool output_less(const std::pair<SymbolNumber, TransitionTableIndex> & a,
+                        const std::pair<SymbolNumber, TransitionTableIndex> & b)
+{
+    return a.first < b.first;
+}
+
+OutputSymbolIndex::OutputSymbolIndex(const Transducer & t):
+    epsilon_cycles(false)
+{
+    const TransducerAlphabet & alphabet = t.get_alphabet();
+    std::vector<TransitionTableIndex> state_transitions;
+    std::vector<TransitionTableIndex> states;
+    states.push_back(0);
+    state_numbers[0] = 0;
+    starts.push_back(0);
+
+    // States are numbered in breadth-first order from the start state
+    for (size_t n = 0; n < states.size(); ++n) {
+        state_transitions.clear();
+        t.get_state_transitions(states[n], state_transitions);
+
+        // Epsilon and flag outputs first, the rest sorted by output
+        std::vector<std::pair<SymbolNumber, TransitionTableIndex> >
+            epsilons, others;
+        for (size_t i = 0; i < state_transitions.size(); ++i) {
+            SymbolNumber output =
+                t.get_transition(state_transitions[i]).get_output_symbol();
+            if (output == 0 || alphabet.is_flag_diacritic(output)) {
+                epsilons.push_back(
+                    std::make_pair(output, state_transitions[i]));
+            } else {
+                others.push_back(std::make_pair(output, state_transitions[i]));
+            }
+        }
+        std::stable_sort(others.begin(), others.end(), output_less);
+
+        for (size_t i = 0; i < epsilons.size(); ++i) {
+            outputs.push_back(epsilons[i].first);
+            transitions.push_back(epsilons[i].second);
+        }
+        epsilon_ends.push_back(hfst::size_t_to_uint(transitions.size()));
+        for (size_t i = 0; i < others.size(); ++i) {
+            outputs.push_back(others[i].first);
+            transitions.push_back(others[i].second);
+        }
+        starts.push_back(hfst::size_t_to_uint(transitions.size()));
+
+        for (size_t i = 0; i < state_transitions.size(); ++i) {
+            TransitionTableIndex target =
+                t.get_transition(state_transitions[i]).get_target();
+            if (state_numbers.count(target) == 0) {
+                state_numbers[target] = hfst::size_t_to_uint(states.size());
+                states.push_back(target);
+            }
+        }
+    }
+    find_epsilon_cycles(t);
+}
+
+void OutputSymbolIndex::find_epsilon_cycles(const Transducer & t)
+{
+    // Depth-first search over transitions with epsilon or flag outputs
+    enum { unvisited, on_stack, done };
+    std::vector<char> colors(epsilon_ends.size(), unvisited);
+    std::vector<std::pair<unsigned int, unsigned int> > stack;
+
+    for (unsigned int root = 0; root < epsilon_ends.size(); ++root) {
+        if (colors[root] != unvisited) {
+            continue;
+        }
+        colors[root] = on_stack;
+        stack.push_back(std::make_pair(root, starts[root]));
+        while (!stack.empty()) {
+            unsigned int state = stack.back().first;
+            unsigned int & position = stack.back().second;
+            if (position == epsilon_ends[state]) {
+                colors[state] = done;
+                stack.pop_back();
+                continue;
+            }
+            // transition targets are always numbered states
+            unsigned int target = state_numbers.find(
+                t.get_transition(transitions[position]).get_target())->second;
+            ++position;
+            if (colors[target] == on_stack) {
+                epsilon_cycles = true;
+                return;
+            }
+            if (colors[target] == unvisited) {
+                colors[target] = on_stack;
+                stack.push_back(std::make_pair(target, starts[target]));
+            }
+        }
+    }
+}
+
+OutputSymbolIndex::Range OutputSymbolIndex::find(TransitionTableIndex state,
+                                                 SymbolNumber output) const
+{
+    std::unordered_map<TransitionTableIndex, unsigned int>::const_iterator it =
+        state_numbers.find(state);
+    if (it == state_numbers.end()) {
+        return Range(0, 0);
+    }
+    SymbolNumberVector::const_iterator begin =
+        outputs.begin() + epsilon_ends[it->second];
+    SymbolNumberVector::const_iterator end =
+        outputs.begin() + starts[it->second + 1];
+    std::pair<SymbolNumberVector::const_iterator,
+              SymbolNumberVector::const_iterator> found =
+        std::equal_range(begin, end, output);
+    return Range(hfst::size_t_to_uint(found.first - outputs.begin()),
+                 hfst::size_t_to_uint(found.second - outputs.begin()));
+}
+
+OutputSymbolIndex::Range OutputSymbolIndex::find_epsilons(
+    TransitionTableIndex state) const
+{
+    std::unordered_map<TransitionTableIndex, unsigned int>::const_iterator it =
+        state_numbers.find(state);
+    if (it == state_numbers.end()) {
+        return Range(0, 0);
+    }
+    return Range(starts[it->second], epsilon_ends[it->second]);
+}
+
 
 }
 
@@ -28,6 +28,7 @@
 #include <utility>
 #include <deque>
 #include <queue>
+#include <unordered_map>
 #include <stdexcept>
 #include <time.h>
 
@@ -909,6 +910,77 @@ public:
         }
 };
 
+class Transducer;
+
+/** \brief The transitions of a transducer sorted by output symbol, for
+    applying the transducer from the output side (lookdown).
+
+    States are numbered as in lookup: indices to the transition index table
+    and indices to the transition table plus TRANSITION_TARGET_TABLE_START.
+    In each state, the transitions whose output is an epsilon or a flag
+    diacritic come first and the rest are sorted by output symbol.
+    Transitions are referred to by their indices in the transition table.
+*/
+class OutputSymbolIndex
+{
+protected:
+    std::unordered_map<TransitionTableIndex, unsigned int> state_numbers;
+    // The transitions of state number n are in [starts[n], starts[n+1]),
+    // the ones with epsilon or flag outputs in [starts[n], epsilon_ends[n])
+    std::vector<unsigned int> starts;
+    std::vector<unsigned int> epsilon_ends;
+    SymbolNumberVector outputs;
+    std::vector<TransitionTableIndex> transitions;
+    bool epsilon_cycles;
+
+    void find_epsilon_cycles(const Transducer & t);
+
+public:
+    OutputSymbolIndex(const Transducer & t);
+
+    typedef std::pair<unsigned int, unsigned int> Range;
+
+    // The positions of the transitions of state with the given output
+    Range find(TransitionTableIndex state, SymbolNumber output) const;
+    // The positions of the transitions of state with epsilon or flag outputs
+    Range find_epsilons(TransitionTableIndex state) const;
+
+    TransitionTableIndex get_transition(unsigned int position) const
+        { return transitions[position]; }
+    // Whether some state can be reached from itself by transitions with
+    // epsilon or flag outputs, ignoring what the flags do
+    bool has_epsilon_cycles(void) const
+        { return epsilon_cycles; }
+};
+
+/** \brief The states of a transducer from which a cycle of transitions
+    with epsilon or flag diacritic inputs can be reached.
+
+    Lookup can only have infinitely many results if it passes through such
+    a state, so the search for epsilon loops need not go anywhere else.
+    States are numbered as in lookup.
+*/
+class InputEpsilonCycles
+{
+protected:
+    // Indexed by transition index table and transition table position
+    std::vector<bool> index_states;
+    std::vector<bool> transition_states;
+
+public:
+    InputEpsilonCycles(const Transducer & t);
+
+    bool reaches_cycle(TransitionTableIndex state) const
+        {
+            if (indexes_transition_table(state)) {
+                state -= TRANSITION_TARGET_TABLE_START;
+                return state < transition_states.size() &&
+                    transition_states[state];
+            }
+            return state < index_states.size() && index_states[state];
+        }
+};
+
 /** \brief A compiled transducer format, suitable for fast lookup operations.
  */
 class Transducer
@@ -917,12 +989,20 @@ protected:
     TransducerHeader* header;
     TransducerAlphabet* alphabet;
     TransducerTablesInterface* tables;
+    // Whether tables belong to the transducer this one was copied from
+    // with copy_for_lookup
+    bool tables_shared;
     void load_tables(std::istream& is);
 
     // for lookup
     Weight current_weight;
     HfstTwoLevelPaths * lookup_paths;
     Encoder * encoder;
+    // for lookdown, built when first needed
+    OutputSymbolIndex * output_index;
+    Encoder * output_encoder;
+    // for is_lookup_infinitely_ambiguous, built when first needed
+    InputEpsilonCycles * input_epsilon_cycles;
     Tape input_tape;
     DoubleTape output_tape;
     hfst::FdState<SymbolNumber> flag_state;
@@ -959,6 +1039,22 @@ protected:
                       unsigned int output_tape_pos,
                       TransitionTableIndex i);
     
+    void try_output_epsilons(unsigned int input_pos,
+                             unsigned int output_pos,
+                             TransitionTableIndex i);
+
+    bool find_output_transitions(SymbolNumber output,
+                                 unsigned int input_pos,
+                                 unsigned int output_pos,
+                                 TransitionTableIndex i);
+
+    void get_generations(unsigned int input_pos,
+                         unsigned int output_pos,
+                         TransitionTableIndex i);
+
+    bool tokenize(const char * str, Encoder * tokenizer);
+    void build_output_index(void);
+
     void find_loop_epsilon_transitions(unsigned int input_pos,
                                        TransitionTableIndex i);
     void find_loop_epsilon_indices(unsigned int input_pos,
@@ -990,6 +1086,11 @@ public:
 
     void write(std::ostream& os) const;
     Transducer * copy(Transducer * t, bool weighted = false);
+    /* A copy with a lookup state of its own that shares the transition
+       tables with this transducer, so that another thread can look up
+       strings with it. This transducer must not be changed or destroyed
+       while the copy is in use. */
+    Transducer * copy_for_lookup(void) const;
     void display() const;
 
     const TransducerHeader& get_header() const
@@ -1037,9 +1138,17 @@ public:
     // i.e. the arcs from the given state
     TransitionTableIndexSet get_transitions_from_state(
         TransitionTableIndex state_index) const;
+    // Append to transitions the indices to the transition table of the arcs
+    // from state, numbered as above, in the order lookup tries them
+    void get_state_transitions(
+        TransitionTableIndex state,
+        std::vector<TransitionTableIndex> & transitions) const;
 
 
     bool initialize_input(const char * input_str);
+    /* Tokenize \a output_str into the input tape using the output symbols
+       of the transducer, for lookdown. */
+    bool initialize_output(const char * output_str);
     void include_symbol_in_alphabet(const std::string & sym);
     HfstOneLevelPaths * lookup_fd(const StringVector & s, ssize_t limit = -1,
         double time_cutoff = 0.0);
@@ -1055,6 +1164,18 @@ public:
                                         double time_cutoff = 0.0);
     HfstTwoLevelPaths * lookup_fd_pairs(const char * s, ssize_t limit = -1,
                                         double time_cutoff = 0.0);
+    /* Tokenize and look down, accounting for flag diacritics, the string
+       \a s of output symbols, i.e. return the input side strings that
+       the transducer maps to \a s. The transitions are indexed by output
+       symbol on the first call.
+    */
+    HfstOneLevelPaths * lookdown_fd(const StringVector & s, ssize_t limit = -1,
+                                    double time_cutoff = 0.0);
+    HfstOneLevelPaths * lookdown_fd(const std::string & s, ssize_t limit = -1,
+                                    double time_cutoff = 0.0);
+    HfstOneLevelPaths * lookdown_fd(const char * s, ssize_t limit = -1,
+                                    double time_cutoff = 0.0);
+    bool is_lookdown_infinitely_ambiguous(void);
     void note_analysis(void);
 
     // Methods for supporting ospell
@@ -1080,6 +1201,7 @@ public:
 
     
     friend class ConvertTransducer;
+    friend class TransducerCascade;
 };
 
 class STransition{
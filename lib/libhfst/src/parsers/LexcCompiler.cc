@@ -31,6 +31,7 @@ using std::set_difference;
 
 #include "LexcCompiler.h"
 #include "HfstTransducer.h"
+#include "HfstCompilationCache.h"
 #include "XreCompiler.h"
 #include "lexc-utils.h"
 #ifdef YACC_USE_PARSER_H_EXTENSION
@@ -40,6 +41,7 @@ using std::set_difference;
 #endif
 #include "xre_utils.h"
 #include "HfstSymbolDefs.h"
+#include "implementations/HfstTrieBuilder.h"
 
 #ifdef WINDOWS
 #include "hfst-string-conversions.h"
@@ -49,6 +51,7 @@ using hfst::hfst_fprintf_console;
 using hfst::HfstTransducer;
 using hfst::implementations::HfstTransitionGraph;
 using hfst::implementations::HfstBasicTransducer;
+using hfst::implementations::HfstTrieBuilder;
 using hfst::implementations::HfstState;
 using hfst::implementations::HfstBasicTransition;
 using hfst::ImplementationType;
@@ -93,7 +96,9 @@ LexcCompiler::LexcCompiler() :
     winoss_(std::ostringstream()),
     redirected_stream_(NULL),
 #endif
-    parseErrors_(false)
+    parseErrors_(false),
+    cache_(NULL),
+    cacheable_(true)
 {
     xre_.set_expand_definitions(true);
     xre_.set_error_stream(this->error_);
@@ -120,7 +125,9 @@ LexcCompiler::LexcCompiler(ImplementationType impl) :
     winoss_(std::ostringstream()),
     redirected_stream_(NULL),
 #endif
-    parseErrors_(false)
+    parseErrors_(false),
+    cache_(NULL),
+    cacheable_(true)
 {
     tokenizer_.add_multichar_symbol("@_EPSILON_SYMBOL_@");
     tokenizer_.add_multichar_symbol("@0@");
@@ -154,7 +161,9 @@ LexcCompiler::LexcCompiler(ImplementationType impl, bool withFlags, bool alignSt
     winoss_(std::ostringstream()),
     redirected_stream_(NULL),
 #endif
-    parseErrors_(false)
+    parseErrors_(false),
+    cache_(NULL),
+    cacheable_(true)
 {
     tokenizer_.add_multichar_symbol("@_EPSILON_SYMBOL_@");
     tokenizer_.add_multichar_symbol("@0@");
@@ -194,12 +203,15 @@ LexcCompiler::~LexcCompiler()
       currentLexiconName_ = ""; // ?
       string hash("#");
       lexiconNames_.insert(hash);
-      stringsTrie_ =hfst::implementations::HfstBasicTransducer(); // ?
+      stringsBuilder_.clear();
       for(const auto &it: regexps_)
       {
         delete it.second;
       }
       regexps_.clear();
+      cacheable_ = true;
+      pendingFiles_.clear();
+      pendingSources_.clear();
     }
 
 
@@ -253,6 +265,9 @@ LexcCompiler::~LexcCompiler()
 
 LexcCompiler& LexcCompiler::parse(FILE* infile)
 {
+    // What is read from a stream cannot be a part of a cache key
+    parsePendingFiles();
+    cacheable_ = false;
     lexc_ = this;
     if (infile == stdin)
       {
@@ -274,6 +289,42 @@ LexcCompiler& LexcCompiler::parse(FILE* infile)
 }
 
 LexcCompiler& LexcCompiler::parse(const char* filename)
+{
+    if (cache_ == NULL || !cacheable_)
+      {
+        return parseFile(filename);
+      }
+    FILE * infile = hfst::hfst_fopen(filename, "r");
+    if (infile == NULL)
+      {
+        return parseFile(filename); // reports the error
+      }
+    string source;
+    char buffer[4096];
+    size_t length = 0;
+    while ((length = fread(buffer, 1, sizeof(buffer), infile)) > 0)
+      {
+        source.append(buffer, length);
+      }
+    fclose(infile);
+    pendingFiles_.push_back(filename);
+    pendingSources_.push_back(source);
+    return *this;
+}
+
+void LexcCompiler::parsePendingFiles()
+{
+    vector<string> files;
+    files.swap(pendingFiles_);
+    pendingSources_.clear();
+    for (vector<string>::const_iterator it = files.begin();
+         it != files.end(); it++)
+      {
+        parseFile(it->c_str());
+      }
+}
+
+LexcCompiler& LexcCompiler::parseFile(const char* filename)
 {
     lexc_ = this;
     hlexclex_destroy();
@@ -393,6 +444,14 @@ LexcCompiler::setRenameFlags(bool value)
     return *this;
 }
 
+LexcCompiler&
+LexcCompiler::setCache(hfst::HfstCompilationCache * cache)
+{
+    cache_ = cache;
+    xre_.set_cache(cache);
+    return *this;
+}
+
 
 LexcCompiler&
 LexcCompiler::addNoFlag(const string& lexname)
@@ -486,7 +545,7 @@ LexcCompiler::addStringEntry(const string& data,
 	    it->second.replace(start_pos, zero.length(), "0");
 	  }
       }
-    stringsTrie_.disjunct(newVector, hfst::double_to_float(weight));
+    stringsBuilder_.add(newVector, hfst::double_to_float(weight));
 
     return *this;
 }
@@ -694,7 +753,7 @@ LexcCompiler::addStringPairEntry(const string& upper, const string& lower,
 	  }
       }
 
-    stringsTrie_.disjunct(newVector, hfst::double_to_float(weight));
+    stringsBuilder_.add(newVector, hfst::double_to_float(weight));
 
     return *this;
 }
@@ -785,7 +844,7 @@ LexcCompiler::addXreEntry(const string& regexp, const string& continuation,
       }
       tokenizer_.add_multichar_symbol(joinerEnc);
       StringPairVector newVector(tokenizer_.tokenize(joinerEnc + regex_key + encodedCont));
-      stringsTrie_.disjunct(newVector, hfst::double_to_float(weight));
+      stringsBuilder_.add(newVector, hfst::double_to_float(weight));
 
 
 
@@ -874,8 +933,67 @@ LexcCompiler::setInitialLexiconName(const string& lexiconName)
     return *this;
 }
 
+string
+LexcCompiler::cacheKey()
+{
+    hfst::HfstCompilationCache::Key key("lexc", format_);
+    key.add((long)align_strings_)
+      .add((long)with_flags_)
+      .add((long)minimize_flags_)
+      .add((long)rename_flags_)
+      .add((long)treat_warnings_as_errors_)
+      .add((long)allow_multiple_sublexicon_definitions_)
+      .add(initialLexiconName_)
+      .add((long)noFlags_.size());
+    for (set<string>::const_iterator it = noFlags_.begin();
+         it != noFlags_.end(); it++)
+      {
+        key.add(*it);
+      }
+    // The file names do not change the result, only the order of the files
+    key.add((long)pendingSources_.size());
+    for (vector<string>::const_iterator it = pendingSources_.begin();
+         it != pendingSources_.end(); it++)
+      {
+        key.add(*it);
+        if (!key.add_referenced_files(*it, ""))
+          {
+            return string();
+          }
+      }
+    return key.str();
+}
+
 HfstTransducer*
 LexcCompiler::compileLexical()
+{
+    string key;
+    if (cache_ != NULL && cacheable_ && !pendingSources_.empty() &&
+        totalEntries_ == 0)
+      {
+        key = cacheKey();
+      }
+    if (!key.empty())
+      {
+        HfstTransducer * cached = cache_->get(key);
+        if (cached != NULL)
+          {
+            pendingFiles_.clear();
+            pendingSources_.clear();
+            return cached;
+          }
+      }
+    parsePendingFiles();
+    HfstTransducer * result = compileParsed();
+    if (result != NULL && !key.empty())
+      {
+        cache_->put(key, *result);
+      }
+    return result;
+}
+
+HfstTransducer*
+LexcCompiler::compileParsed()
   {
 
     if (parseErrors_)
@@ -894,7 +1012,7 @@ LexcCompiler::compileLexical()
         return 0;
       }
 
-    HfstTransducer lexicons(stringsTrie_, format_);
+    HfstTransducer lexicons(stringsBuilder_.get_transducer(), format_);
 
 
     lexicons.optimize();
@@ -910,7 +1028,7 @@ LexcCompiler::compileLexical()
     lexicons.substitute(smallSubstitutions);
     lexicons.prune_alphabet();
 
-    HfstBasicTransducer joinersTrie_;
+    HfstTrieBuilder joinersTrie_;
 
     HfstSymbolSubstitutions allJoinersToEpsilon;
 
@@ -939,7 +1057,7 @@ LexcCompiler::compileLexical()
 
             // joiners trie version (later compose)
             StringPairVector newVector(tokenizer_.tokenize(joinerEnc + joinerEnc));
-            joinersTrie_.disjunct(newVector, 0);
+            joinersTrie_.add(newVector, 0);
 
             allJoinersToEpsilon.insert(StringPair(joinerEnc, "@_EPSILON_SYMBOL_@"));
          }
@@ -995,7 +1113,7 @@ LexcCompiler::compileLexical()
 
             // joiners trie version (later compose)
             StringPairVector newVector(tokenizer_.tokenize(flagPstring + flagRstring));
-            joinersTrie_.disjunct(newVector, 0);
+            joinersTrie_.add(newVector, 0);
         }
     }
 
@@ -1036,10 +1154,10 @@ LexcCompiler::compileLexical()
             String alph = *it;
             tokenizer_.add_multichar_symbol(alph);
             StringPairVector newVector(tokenizer_.tokenize(alph));
-            joinersTrie_.disjunct(newVector, 0);
+            joinersTrie_.add(newVector, 0);
         }
 
-        HfstTransducer joinersAll(joinersTrie_, format_);
+        HfstTransducer joinersAll(joinersTrie_.finalize(), format_);
 
 
 
@@ -29,10 +29,11 @@
 #include <cstdio>
 
 //#include "HfstTransducer.h"
-namespace hfst { class HfstTransducer; }
+namespace hfst { class HfstTransducer; class HfstCompilationCache; }
 #include "XreCompiler.h"
 #include "../HfstTokenizer.h"
 #include "../implementations/HfstBasicTransducer.h"
+#include "../implementations/HfstLexiconBuilder.h"
 
 namespace hfst {
 //! @brief Namespace for Xerox LexC related specific functions and classes.
@@ -101,6 +102,12 @@ class LexcCompiler
 
   LexcCompiler& setRenameFlags(bool value);
 
+  //! @brief reuse the lexicon compiled in an earlier run from @a cache and
+  //! store a new one there. Only lexicons read with parse(const char*) are
+  //! looked up: their parsing is put off until compileLexical, where it is
+  //! skipped if the result is found. The cache is not owned.
+  LexcCompiler& setCache(hfst::HfstCompilationCache * cache);
+
   //! @brief add @a alphabet to multicharacter symbol set.
   //! These symbolse may be used for regular expression ? for backends that do
   //! not support open alphabets.
@@ -154,6 +161,11 @@ class LexcCompiler
   const LexcCompiler& printConnectedness(bool & warnings_printed);
 
   private:
+  LexcCompiler& parseFile(const char* filename);
+  void parsePendingFiles();
+  std::string cacheKey();
+  hfst::HfstTransducer* compileParsed();
+
   bool quiet_;
   bool verbose_;
   bool align_strings_;
@@ -173,7 +185,7 @@ class LexcCompiler
   hfst::HfstTokenizer tokenizer_;
   hfst::xre::XreCompiler xre_;
   std::string initialLexiconName_;
-  HfstBasicTransducer stringsTrie_;
+  hfst::implementations::HfstLexiconBuilder stringsBuilder_;
 
 
 
@@ -185,6 +197,11 @@ class LexcCompiler
   size_t totalEntries_;
   size_t currentEntries_;
   bool parseErrors_;
+  hfst::HfstCompilationCache * cache_;
+  // whether everything that was added came from pendingSources_
+  bool cacheable_;
+  std::vector<std::string> pendingFiles_;
+  std::vector<std::string> pendingSources_;
 }
 ;
 
@@ -14,6 +14,7 @@
 #include "PmatchCompiler.h"
 #include "pmatch_utils.h"
 #include "HfstTransducer.h"
+#include "HfstCompilationCache.h"
 
 #ifndef UNIT_TEST
 
@@ -21,6 +22,8 @@ namespace hfst { namespace pmatch {
 PmatchCompiler::PmatchCompiler() :
     flatten(false),
     verbose(false),
+    include_cosine_distances(false),
+    cache(NULL),
     definitions_(),
     format_(hfst::TROPICAL_OPENFST_TYPE)
 {}
@@ -28,6 +31,8 @@ PmatchCompiler::PmatchCompiler() :
 PmatchCompiler::PmatchCompiler(hfst::ImplementationType impl) :
     flatten(false),
     verbose(false),
+    include_cosine_distances(false),
+    cache(NULL),
     definitions_(),
     format_(impl)
 {}
@@ -35,18 +40,65 @@ PmatchCompiler::PmatchCompiler(hfst::ImplementationType impl) :
 void
 PmatchCompiler::define(const std::string& name, const std::string& pmatch)
 {
-  compile(pmatch);
+  // Not looked up in the cache, as the definitions that compiling leaves
+  // behind are needed
+  hfst::pmatch::compile(pmatch, definitions_, format_,
+                        verbose, flatten, include_cosine_distances,
+                        includedir);
   if (definitions.count(name) != 0) {
       definitions_[name] = definitions[name]->evaluate();
   }
 }
 
+std::string
+PmatchCompiler::cache_key(const std::string& pmatch)
+{
+    // Pmatch has no comments or whitespace that could safely be
+    // normalized away, so the source is used as it is. The include
+    // directory is left out, as the files read from it are added.
+    hfst::HfstCompilationCache::Key key("pmatch", format_);
+    key.add(pmatch)
+        .add((long)flatten)
+        .add((long)include_cosine_distances);
+    for (std::map<std::string, HfstTransducer*>::const_iterator it
+             = definitions_.begin(); it != definitions_.end(); ++it) {
+        key.add(it->first)
+            .add(hfst::HfstCompilationCache::hash(*(it->second)));
+    }
+    if (!key.add_referenced_files(pmatch, includedir)) {
+        return std::string();
+    }
+    return key.str();
+}
+
 std::map<std::string, HfstTransducer*>
 PmatchCompiler::compile(const std::string& pmatch)
 {
-    return hfst::pmatch::compile(pmatch, definitions_, format_,
-                                 verbose, flatten, include_cosine_distances,
-                                 includedir);
+    std::string key = (cache != NULL) ? cache_key(pmatch) : std::string();
+    HfstTransducerVector cached;
+    if (!key.empty() && cache->get(key, cached)) {
+        std::map<std::string, HfstTransducer*> retval;
+        for (HfstTransducerVector::const_iterator it = cached.begin();
+             it != cached.end(); ++it) {
+            retval[it->get_name()] = new HfstTransducer(*it);
+        }
+        return retval;
+    }
+    std::map<std::string, HfstTransducer*> retval =
+        hfst::pmatch::compile(pmatch, definitions_, format_,
+                              verbose, flatten, include_cosine_distances,
+                              includedir);
+    if (!key.empty() && !retval.empty()) {
+        // The names of the transducers are kept in the transducers
+        HfstTransducerVector compiled;
+        for (std::map<std::string, HfstTransducer*>::const_iterator it
+                 = retval.begin(); it != retval.end(); ++it) {
+            compiled.push_back(*(it->second));
+            compiled.back().set_name(it->first);
+        }
+        cache->put(key, compiled);
+    }
+    return retval;
 }
 
 void PmatchCompiler::set_include_path(std::string path)
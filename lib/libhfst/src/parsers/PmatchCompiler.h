@@ -31,6 +31,7 @@
 #include "../HfstDataTypes.h"
 
 namespace hfst {
+class HfstCompilationCache;
 //! @brief hfst::pmatch namespace is used for all functions related to Xerox
 //! Regular Expresisions (PMATCH) parsing.
 namespace pmatch {
@@ -42,6 +43,7 @@ private:
     bool verbose;
     bool include_cosine_distances;
     std::string includedir;
+    hfst::HfstCompilationCache * cache;
   public:
   //! @brief Construct compiler for unknown format transducers.
   PmatchCompiler();
@@ -52,6 +54,9 @@ private:
   void set_verbose(bool val) { verbose = val; }
   void set_include_cosine_distances(bool val)
         { include_cosine_distances = val; }
+  //! @brief Look up compiled sources in @a cache before compiling them
+  //!        and store the results there. The cache is not owned.
+  void set_cache(hfst::HfstCompilationCache * val) { cache = val; }
 
   //! @brief Add a definition macro.
   //!        Compilers will replace arcs labeled @a name, with the transducer
@@ -68,6 +73,8 @@ private:
   std::map<std::string,hfst::HfstTransducer*> definitions_;
   hfst::ImplementationType format_;
 
+  std::string cache_key(const std::string& pmatch);
+
 }
 ;
 }}
@@ -33,6 +33,7 @@
 #include "HfstInputStream.h"
 #include "HfstOutputStream.h"
 #include "implementations/HfstBasicTransducer.h"
+#include "implementations/HfstTrieBuilder.h"
 
 using hfst::implementations::HfstTransitionGraph;
 using hfst::implementations::HfstBasicTransducer;
@@ -655,7 +656,7 @@ namespace hfst
     free( filename );
 
     HfstTransducer * retval_hfst = NULL;
-    hfst::implementations::HfstBasicTransducer retval_fsm;
+    hfst::implementations::HfstTrieBuilder retval_fsm;
 
     if (type != FOMA_TYPE &&
     type != TROPICAL_OPENFST_TYPE &&
@@ -696,7 +697,7 @@ namespace hfst
       type != LOG_OPENFST_TYPE)
     retval_hfst->disjunct(spv);
       else
-    retval_fsm.disjunct(spv,0);
+    retval_fsm.add(spv,0);
 
     }
     if (Verbose && n >= 10000)
@@ -711,7 +712,7 @@ namespace hfst
     type != LOG_OPENFST_TYPE)
       return retval_hfst;
     else {
-      return new HfstTransducer(retval_fsm, type);
+      return new HfstTransducer(retval_fsm.finalize(), type);
     }
   }
 
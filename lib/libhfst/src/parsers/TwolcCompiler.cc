@@ -57,7 +57,8 @@ namespace hfst {
     int TwolcCompiler::compile
     (const std::string & inputfile, const std::string & outputfile,
      bool silent, bool verbose, bool resolve_left_conflicts,
-     bool resolve_right_conflicts, hfst::ImplementationType type)
+     bool resolve_right_conflicts, hfst::ImplementationType type,
+     unsigned int jobs)
     {
       // Reset previous values
       hfst::twolcpre1::reset_lexer();
@@ -127,6 +128,7 @@ namespace hfst {
 				     verbose,
 				     resolve_left_conflicts,
 				     resolve_right_conflicts);
+	  twolc_grammar.set_jobs(jobs);
 	  hfst::twolcpre3::set_grammar(&twolc_grammar);
 	  int exit_code = hfst::twolcpre3::parse();
 	  if (exit_code != 0)
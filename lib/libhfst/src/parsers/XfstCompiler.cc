@@ -44,6 +44,7 @@ using std::stack;
 #include "hfst-string-conversions.h"
 
 #include "XfstCompiler.h"
+#include "HfstSpillStore.h"
 #include "xfst-utils.h"
 
 #ifdef YACC_USE_PARSER_H_EXTENSION
@@ -144,12 +145,91 @@ namespace xfst {
   //FILE * warnstream_ = stderr;
   //FILE * errorstream_ = stderr;
 
+  HfstTransducer* &
+  TransducerStack::top()
+  {
+    reload(size() - 1);
+    return c.back();
+  }
+
+  void
+  TransducerStack::pop()
+  {
+    // A spilled transducer is popped without being read back
+    std::map<size_t, unsigned int>::iterator it = spilled_.find(size() - 1);
+    if (it != spilled_.end())
+      {
+        store_->remove(it->second);
+        spilled_.erase(it);
+      }
+    c.pop_back();
+  }
+
+  void
+  TransducerStack::spill(HfstSpillStore & store)
+  {
+    if (store_ != NULL && store_ != &store)
+      {
+        reload();
+      }
+    store_ = &store;
+    for (size_t position = 0; position + 1 < size(); position++)
+      {
+        HfstTransducer * & transducer = c[position];
+        if (transducer == NULL || ! store.is_worth_storing(*transducer))
+          {
+            continue;
+          }
+        spilled_[position] = store.put(*transducer);
+        delete transducer;
+        transducer = NULL;
+      }
+  }
+
+  void
+  TransducerStack::reload()
+  {
+    while (! spilled_.empty())
+      {
+        reload(spilled_.begin()->first);
+      }
+  }
+
+  void
+  TransducerStack::reload(size_t position)
+  {
+    std::map<size_t, unsigned int>::iterator it = spilled_.find(position);
+    if (it == spilled_.end())
+      {
+        return;
+      }
+    // The transducer may be changed once it is read back, so it is not
+    // kept in the store
+    c[position] = store_->get(it->second);
+    store_->remove(it->second);
+    spilled_.erase(it);
+  }
+
+  void
+  TransducerStack::forget_spilled()
+  {
+    spilled_.clear();
+  }
+
+  size_t
+  TransducerStack::spilled() const
+  {
+    return spilled_.size();
+  }
+
     XfstCompiler::XfstCompiler() :
         use_readline_(false),
         read_interactive_text_from_stdin_(false),
         output_to_console_(false),
         xre_(hfst::TROPICAL_OPENFST_TYPE),
         lexc_(hfst::TROPICAL_OPENFST_TYPE),
+        spill_store_(NULL),
+        report_memory_(false),
         format_(hfst::TROPICAL_OPENFST_TYPE),
         verbose_(false),
         verbose_prompt_(false),
@@ -217,6 +297,8 @@ namespace xfst {
         output_to_console_(false),
         xre_(impl),
         lexc_(impl),
+        spill_store_(NULL),
+        report_memory_(false),
         format_(impl),
         verbose_(false),
         verbose_prompt_(false),
@@ -280,6 +362,8 @@ namespace xfst {
 
   XfstCompiler::~XfstCompiler()
   {
+    // The spill store may already be gone
+    stack_.forget_spilled();
     while(!stack_.empty())
       {
         delete(stack_.top());
@@ -754,6 +838,31 @@ namespace xfst {
         return *this;
       }
 
+    XfstCompiler&
+    XfstCompiler::lookdown(char* line, const HfstTransducer * t, size_t cutoff)
+      {
+        char* token = strstrip(line);
+        HfstOneLevelPaths * paths = NULL;
+
+        if (variables_["obey-flags"] == "ON") {
+          paths = t->lookdown_fd(std::string(token), cutoff);
+        }
+        else {
+          paths = t->lookdown(std::string(token), cutoff);
+        }
+        free(token);
+
+        bool printed = this->print_paths(*paths);
+        if (!printed)
+          {
+            output() << "???" << std::endl;
+            flush(&output());
+          }
+
+        delete paths;
+        return *this;
+      }
+
   XfstCompiler&
   XfstCompiler::lookup_optimize()
   {
@@ -897,8 +1006,27 @@ namespace xfst {
     XfstCompiler&
     XfstCompiler::apply_up_line(char* line) // apply_down_line -> apply_up_line
       {
-        GET_TOP(t);
-        // lookdown not yet implemented in HFST
+        if (stack_.size() < 1)
+          {
+            EMPTY_STACK;
+            xfst_lesser_fail();
+            prompt();
+            return *this;
+          }
+        HfstTransducer * t = stack_.top();
+        if (t->get_type() == hfst::HFST_OL_TYPE || t->get_type() == hfst::HFST_OLW_TYPE)
+          {
+            size_t ol_cutoff = string_to_size_t(variables_["lookup-cycle-cutoff"]);
+            StringVector foo; // this gets ignored by ol transducer's is_lookdown_infinitely_ambiguous
+            if (verbose_ && t->is_lookdown_infinitely_ambiguous(foo))
+              {
+                error() << "warning: transducer is infinitely ambiguous, limiting number of cycles to " << ol_cutoff << std::endl;
+                flush(&error());
+              }
+            return this->lookdown(line, t, ol_cutoff);
+          }
+
+        // lookdown is only implemented for optimized lookup format
         if (verbose_)
           {
             error() << "warning: apply up not implemented, inverting transducer and performing apply down" << std::endl
@@ -1017,19 +1145,14 @@ namespace xfst {
                                // because it doesn't support is_lookup_infinitely_ambiguous(const string &)
 
         HfstBasicTransducer * fsm = NULL;
+        bool is_ol = (t->get_type() == hfst::HFST_OL_TYPE ||
+                      t->get_type() == hfst::HFST_OLW_TYPE);
+        // apply up is done with lookdown in optimized lookup format
+        bool inverted = (direction == APPLY_UP_DIRECTION && !is_ol);
 
-        if (direction == APPLY_UP_DIRECTION)
+        if (inverted)
           {
-            if (t->get_type() == hfst::HFST_OL_TYPE ||
-                t->get_type() == hfst::HFST_OLW_TYPE)
-              {
-                error() << "Operation not supported for optimized lookup format. Consider 'remove-optimization' to convert into ordinary format." << std::endl;
-                flush(&error());
-                prompt();
-                return *this;
-              }
-
-            // lookdown not yet implemented in HFST
+            // lookdown is only implemented for optimized lookup format
             if (verbose_)
               {
                 error() << "warning: apply up not implemented, inverting transducer and performing apply down" << std::endl
@@ -1040,14 +1163,16 @@ namespace xfst {
             t->invert().minimize(); // the user has been warned for possible slow performance
           }
 
-        if (t->get_type() != hfst::HFST_OL_TYPE && t->get_type() != hfst::HFST_OLW_TYPE)
+        if (!is_ol)
           {
             fsm = new HfstBasicTransducer(*t);
           }
         else
           {
             StringVector foo; // this gets ignored by ol transducer's is_lookup_infinitely_ambiguous
-            if (t->is_lookup_infinitely_ambiguous(foo))
+            if (direction == APPLY_UP_DIRECTION ?
+                t->is_lookdown_infinitely_ambiguous(foo) :
+                t->is_lookup_infinitely_ambiguous(foo))
               {
                 ol_cutoff = string_to_size_t(variables_["lookup-cycle-cutoff"]);
                 if (verbose_)
@@ -1088,6 +1213,8 @@ namespace xfst {
             // perform lookup/lookdown
             if (fsm != NULL)
               lookup(line, fsm);
+            else if (direction == APPLY_UP_DIRECTION)
+              lookdown(line, t, ol_cutoff);
             else
               lookup(line, t, ol_cutoff);
             free(line);
@@ -1096,7 +1223,7 @@ namespace xfst {
         // ignore all readline history given to the apply command
         ignore_history_after_index(ind);
 
-        if (direction == APPLY_UP_DIRECTION)
+        if (inverted)
           delete t;
         if (fsm != NULL)
           delete fsm;
@@ -1203,6 +1330,7 @@ namespace xfst {
     XfstCompiler&
     XfstCompiler::define_list(const char* name, const char* values)
       {
+        reload_definition(name);
         if (definitions_.find(name) != definitions_.end())
           {
             error() << "Error: '" << std::string(name) << "' has already been defined as a transducer variable." << std::endl
@@ -1237,12 +1365,7 @@ namespace xfst {
     if (variables_["name-nets"] == "ON") {
       transducer->set_name(name);
     }
-    auto const it = definitions_.find(name);
-    if (it != definitions_.end())
-    {
-      delete it->second;
-      definitions_.erase(it);
-    }
+    remove_definition(name);
     definitions_[name] = transducer;
 
     if (verbose_)
@@ -1256,6 +1379,67 @@ namespace xfst {
       }
   }
 
+  void
+  XfstCompiler::reload_definition(const std::string & name)
+  {
+    auto const it = spilled_definitions_.find(name);
+    if (it != spilled_definitions_.end() &&
+        definitions_.find(name) == definitions_.end())
+    {
+      definitions_[name] = spill_store_->get(it->second);
+    }
+  }
+
+  void
+  XfstCompiler::reload_definitions()
+  {
+    for (const auto & spilled : spilled_definitions_)
+    {
+      reload_definition(spilled.first);
+    }
+  }
+
+  bool
+  XfstCompiler::remove_definition(const std::string & name)
+  {
+    bool was_defined = false;
+    auto const it = definitions_.find(name);
+    if (it != definitions_.end())
+    {
+      delete it->second;
+      definitions_.erase(it);
+      was_defined = true;
+    }
+    auto const spilled = spilled_definitions_.find(name);
+    if (spilled != spilled_definitions_.end())
+    {
+      spill_store_->remove(spilled->second);
+      spilled_definitions_.erase(spilled);
+      was_defined = true;
+    }
+    return was_defined;
+  }
+
+  void
+  XfstCompiler::spill_definitions()
+  {
+    for (auto it = definitions_.begin(); it != definitions_.end(); )
+    {
+      // Definitions are not changed, so each is written only once
+      if (spilled_definitions_.find(it->first) == spilled_definitions_.end())
+      {
+        if (! spill_store_->is_worth_storing(*(it->second)))
+        {
+          it++;
+          continue;
+        }
+        spilled_definitions_[it->first] = spill_store_->put(*(it->second));
+      }
+      delete it->second;
+      it = definitions_.erase(it);
+    }
+  }
+
   XfstCompiler&
   XfstCompiler::define(const char * name)
   {
@@ -1514,11 +1698,8 @@ namespace xfst {
       char* name = strtok(s, " ");
       while (name != NULL)
         {
-          auto const it = definitions_.find(name);
-          if (it != definitions_.end())
+          if (remove_definition(name))
             {
-              delete it->second;
-              definitions_.erase(it);
               xre_.undefine(name);  // XRE
             }
           name = strtok(NULL, " ");
@@ -1539,7 +1720,7 @@ namespace xfst {
   /*XfstCompiler&
   XfstCompiler::name(const char* name)
     {
-      names_[name] = stack_.top();
+      names_.insert(name);
       PROMPT_AND_RETURN_THIS;
       }*/
 
@@ -1675,6 +1856,7 @@ namespace xfst {
   XfstCompiler&
   XfstCompiler::push(const char* name)
     {
+      reload_definition(name);
       if (definitions_.find(name) == definitions_.end())
         {
           output() << "no such defined network: '" << std::string(name) << "'" << std::endl;
@@ -1689,6 +1871,7 @@ namespace xfst {
   XfstCompiler&
   XfstCompiler::push()
     {
+      reload_definitions();
       for (const auto & def : definitions_)
         {
           stack_.push(new HfstTransducer(*(def.second)));
@@ -1721,7 +1904,7 @@ namespace xfst {
           PROMPT_AND_RETURN_THIS;
         }
 
-      stack<HfstTransducer*> tmp;
+      TransducerStack tmp;
       while (!stack_.empty())
         {
           tmp.push(stack_.top());
@@ -1752,13 +1935,10 @@ namespace xfst {
         flush(&error());
         return *this;
       }
-    auto it = definitions_.find(def_name);
-    if (it != definitions_.end())
+    if (remove_definition(def_name))
       {
         error() << "warning: a definition named '" << def_name << "' already exists, overwriting it" << std::endl;
         flush(&error());
-        delete it->second;
-        definitions_.erase(def_name);
       }
     definitions_[def_name] = t;
     return *this;
@@ -2303,6 +2483,7 @@ namespace xfst {
         xfst_lesser_fail();
         PROMPT_AND_RETURN_THIS;
       }
+      stack_.reload();
       std::stack<HfstTransducer*> copied_stack(stack_);
 
       HfstTransducer topmost_transducer(*(copied_stack.top()));
@@ -2440,6 +2621,7 @@ namespace xfst {
     {
       GET_TOP(top);
 
+      reload_definition(variable);
       auto it = definitions_.find(variable);
       if (it == definitions_.end())
         {
@@ -2717,6 +2899,7 @@ namespace xfst {
   XfstCompiler::print_labels(const char* name, std::ostream * oss_)
     {
       std::ostream * oss = get_stream(oss_);
+      reload_definition(name);
       auto it = definitions_.find(name);
       if (it == definitions_.end())
         {
@@ -3034,6 +3217,7 @@ namespace xfst {
         }
       else
         {
+          reload_definition(name);
           auto it = definitions_.find(name);
           if (it == definitions_.end())
             {
@@ -3076,6 +3260,7 @@ namespace xfst {
         }
       else
         {
+          reload_definition(name);
           auto it = definitions_.find(name);
           if (it == definitions_.end())
             {
@@ -3119,6 +3304,7 @@ namespace xfst {
         }
       else
         {
+          reload_definition(name);
           auto it = definitions_.find(name);
           if (it == definitions_.end())
             {
@@ -3189,6 +3375,7 @@ namespace xfst {
         }
       else
         {
+          reload_definition(name);
           auto it = definitions_.find(name);
           if (it == definitions_.end())
             {
@@ -3251,14 +3438,11 @@ namespace xfst {
       std::ostream * oss = get_stream(oss_);
       GET_TOP(tmp);
 
-      for (const auto & it : names_)
+      if (names_.find(tmp->get_name()) != names_.end())
         {
-          if (tmp == it.second)
-            {
-              *oss << "Name " << it.first << std::endl;
-              flush(oss);
-              PROMPT_AND_RETURN_THIS;
-            }
+          *oss << "Name " << tmp->get_name() << std::endl;
+          flush(oss);
+          PROMPT_AND_RETURN_THIS;
         }
 
       *oss << "No name." << std::endl;
@@ -3328,6 +3512,7 @@ namespace xfst {
   XfstCompiler&
   XfstCompiler::print_net(const char* name, std::ostream * oss_)
     {
+      reload_definition(name);
       auto it = definitions_.find(name);
       if (it == definitions_.end())
         {
@@ -3624,6 +3809,7 @@ namespace xfst {
   XfstCompiler&
   XfstCompiler::write_definition(const char* name, const char* outfile)
     {
+      reload_definition(name);
       if (definitions_.find(name) == definitions_.end())
         {
           error() << "no such defined network: '" << name << "'" << std::endl;
@@ -3644,6 +3830,7 @@ namespace xfst {
   XfstCompiler&
   XfstCompiler::write_definitions(const char* outfile)
     {
+      reload_definitions();
       if (definitions_.empty())
         {
           error() << "no defined networks" << std::endl;
@@ -4246,7 +4433,7 @@ namespace xfst {
         }
       HfstTransducer* t = stack_.top();
       t->set_name(s);
-      names_[s] = t;
+      names_.insert(s);
       PRINT_INFO_PROMPT_AND_RETURN_THIS;
     }
   XfstCompiler&
@@ -5083,8 +5270,9 @@ namespace xfst {
       PROMPT_AND_RETURN_THIS;
     }
   const std::stack<HfstTransducer*>&
-  XfstCompiler::get_stack() const
+  XfstCompiler::get_stack()
     {
+      stack_.reload();
       return stack_;
     }
   int
@@ -5202,6 +5390,81 @@ namespace xfst {
       lexc_.setVerbosity(this->verbose_ ? 2 : 0);
       return *this;
     }
+  XfstCompiler&
+  XfstCompiler::setCache(hfst::HfstCompilationCache * cache)
+    {
+      xre_.set_cache(cache);
+      lexc_.setCache(cache);
+      return *this;
+    }
+  XfstCompiler&
+  XfstCompiler::setSpillStore(hfst::HfstSpillStore * store)
+    {
+      stack_.reload();
+      reload_definitions();
+      for (const auto & spilled : spilled_definitions_)
+        {
+          spill_store_->remove(spilled.second);
+        }
+      spilled_definitions_.clear();
+      spill_store_ = store;
+      xre_.set_spill_store(store);
+      return *this;
+    }
+
+  static std::string to_megabytes(unsigned long long bytes)
+  {
+    std::ostringstream oss;
+    oss.setf(std::ios::fixed);
+    oss.precision(1);
+    oss << (double)bytes / (1024 * 1024) << " MB";
+    return oss.str();
+  }
+
+  XfstCompiler&
+  XfstCompiler::end_command()
+    {
+      if (spill_store_ != NULL)
+        {
+          try
+            {
+              stack_.spill(*spill_store_);
+              spill_definitions();
+              xre_.spill_definitions();
+            }
+          catch (const HfstException & e)
+            {
+              // What could not be spilled is kept in memory
+              error() << "warning: could not spill networks: "
+                      << e.what() << std::endl;
+              flush(&error());
+            }
+        }
+      if (report_memory_)
+        {
+          unsigned long long resident = hfst::get_resident_memory();
+          error() << "memory: "
+                  << ((resident > 0) ? to_megabytes(resident) : std::string("?"))
+                  << " resident";
+          if (spill_store_ != NULL)
+            {
+              error() << ", " << spill_store_->size() << " networks ("
+                      << to_megabytes(spill_store_->bytes()) << ") in "
+                      << spill_store_->get_directory();
+            }
+          error() << std::endl;
+          flush(&error());
+        }
+      return *this;
+    }
+
+  XfstCompiler&
+  XfstCompiler::setMemoryReport(bool report)
+  {
+    report_memory_ = report;
+    return *this;
+  }
+
   XfstCompiler&
   XfstCompiler::setPromptVerbosity(bool verbosity)
   {
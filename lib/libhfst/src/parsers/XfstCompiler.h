@@ -27,6 +27,7 @@
 
 #include <string>
 #include <map>
+#include <set>
 #include <stack>
 
 #include "HfstTransducer.h"
@@ -34,6 +35,7 @@
 #include "LexcCompiler.h"
 
 namespace hfst {
+class HfstSpillStore;
 //! @brief hfst::xfst namespace contains all functions needed to parse XFST scritpts
 namespace xfst {
 
@@ -58,6 +60,35 @@ namespace xfst {
 
   typedef std::map<std::string,std::string> StringMap;
 
+//! @brief The stack of an xfst compiler. The transducers below the topmost
+//! one can be moved to a spill store while they are not in use. They are
+//! read back when they are on the top again.
+class TransducerStack : public std::stack<hfst::HfstTransducer*>
+{
+  public:
+  //! @brief The topmost transducer, read back if it was spilled.
+  hfst::HfstTransducer* & top();
+  //! @brief Remove the topmost transducer.
+  void pop();
+  //! @brief Move the transducers below the topmost one that are large
+  //!        enough to @a store. The transducers are deleted.
+  void spill(hfst::HfstSpillStore & store);
+  //! @brief Read back all transducers that have been spilled.
+  void reload();
+  //! @brief Leave out the spilled transducers without reading them back.
+  //!        They are NULL on the stack.
+  void forget_spilled();
+  //! @brief The number of transducers that have been spilled.
+  size_t spilled() const;
+
+  private:
+  // positions of the spilled transducers counted from the bottom, the
+  // transducers are stored in store_ under the ids
+  std::map<size_t, unsigned int> spilled_;
+  hfst::HfstSpillStore * store_ = NULL;
+  void reload(size_t position);
+};
+
 //! @brief Xfst compiler contains all the methods and variables a session of
 //! XFST script parser needs.
 class XfstCompiler
@@ -78,10 +109,10 @@ class XfstCompiler
   XfstCompiler& add_props(const char* indata);
 
   //! @brief Perform lookdowns on top of the stack, one per line
-  //! @todo lookdown is missing from HFST
+  //! @todo lookdown is only implemented for optimized lookup format
   XfstCompiler& apply_up(FILE* infile);
   //! @brief Perform lookdowns on top of the stack, one per line
-  //! @todo lookdown is missing from HFST
+  //! @todo lookdown is only implemented for optimized lookup format
   XfstCompiler& apply_up(const char* indata);
   //! @brief Perform lookups on top of the stack, one per line
   //! @todo lookup is missing from HFST
@@ -476,8 +507,8 @@ class XfstCompiler
 
   //! @brief Sekrit HFST raw command mode!
   XfstCompiler& hfst(const char * data);
-  //! @brief Get current stack of compiler
-  const std::stack<HfstTransducer*>& get_stack() const;
+  //! @brief Get current stack of compiler. Spilled transducers are read back.
+  const std::stack<HfstTransducer*>& get_stack();
   //! @brief Parse input from @a infile
   int parse(FILE * infile);
   //! @brief Parse file @a filename
@@ -502,6 +533,20 @@ class XfstCompiler
   XfstCompiler& setVerbosity(bool verbosity);
   //! @brief Define wheter prompts are printed.
   XfstCompiler& setPromptVerbosity(bool verbosity);
+  //! @brief Reuse regexes and lexicons compiled in earlier runs from
+  //!        @a cache and store new ones there. The cache is not owned.
+  XfstCompiler& setCache(hfst::HfstCompilationCache * cache);
+  //! @brief Keep the transducers below the top of the stack and the
+  //!        definitions in @a store while they are not in use, and read
+  //!        them back when they are. The store is not owned.
+  XfstCompiler& setSpillStore(hfst::HfstSpillStore * store);
+  //! @brief Report the resident memory of the process and the size of
+  //!        the spill store after each command.
+  XfstCompiler& setMemoryReport(bool report);
+  //! @brief Called by the parser after each command. Spills the transducers
+  //!        that are not in use, if there is a spill store, and reports
+  //!        memory usage if it was requested with setMemoryReport.
+  XfstCompiler& end_command();
   //! @brief Explicitly print the prompt to stdout.
   const XfstCompiler& prompt();
   //! @brief Get the prompt string.
@@ -695,6 +740,7 @@ class XfstCompiler
 
   XfstCompiler& lookup(char* line, const HfstTransducer * t, size_t cutoff);
   XfstCompiler& lookup(char* line, HfstBasicTransducer * t);
+  XfstCompiler& lookdown(char* line, const HfstTransducer * t, size_t cutoff);
 
   XfstCompiler& apply_up_line(char* line);
   XfstCompiler& apply_down_line(char* line);
@@ -702,6 +748,16 @@ class XfstCompiler
 
   XfstCompiler& print_bool(bool value);
 
+  /* Read back the definition of @a name, if it has been spilled. */
+  void reload_definition(const std::string & name);
+  /* Read back all definitions that have been spilled. */
+  void reload_definitions();
+  /* Remove the definition of @a name from memory and from the spill store.
+     @return Whether there was one. */
+  bool remove_definition(const std::string & name);
+  /* Move the definitions that are large enough to the spill store. */
+  void spill_definitions();
+
   /* A wrapper around stream objects, see flush(std::ostream *) for more information. */
   std::ostream * get_stream(std::ostream * oss);
 
@@ -724,8 +780,17 @@ class XfstCompiler
   std::map<std::string,std::string> original_function_definitions_;
   std::map<std::string,std::string> function_definitions_;
   std::map<std::string,unsigned int> function_arguments_;
-  std::stack<hfst::HfstTransducer*> stack_;
-  std::map<std::string,hfst::HfstTransducer*> names_;
+  TransducerStack stack_;
+  /* Where transducers that are not in use are kept, or NULL. */
+  hfst::HfstSpillStore * spill_store_;
+  /* Where definitions are stored in spill_store_. The definitions that are
+     not in definitions_ are only there. */
+  std::map<std::string,unsigned int> spilled_definitions_;
+  /* Whether end_command reports memory usage. */
+  bool report_memory_;
+  /* The names given with 'name net'. A network has a name if its own
+     name is one of them, which survives spilling, unlike its address. */
+  std::set<std::string> names_;
   std::map<std::string,std::string> aliases_;
   std::map<std::string,std::string> variables_;
   std::map<std::string,std::string> properties_;
@@ -14,6 +14,8 @@
 #include "XreCompiler.h"
 #include "xre_utils.h"
 #include "HfstTransducer.h"
+#include "HfstCompilationCache.h"
+#include "HfstSpillStore.h"
 
 #ifdef WINDOWS
 #include "hfst-string-conversions.h"
@@ -42,7 +44,9 @@ XreCompiler::XreCompiler() :
     function_arguments_(),
     list_definitions_(),
     format_(hfst::TROPICAL_OPENFST_TYPE),
-    verbose_(false)
+    verbose_(false),
+    cache_(NULL),
+    spill_store_(NULL)
 #ifdef WINDOWS
     , output_to_console_(false)
 #endif
@@ -54,7 +58,9 @@ XreCompiler::XreCompiler(hfst::ImplementationType impl) :
     function_arguments_(),
     list_definitions_(),
     format_(impl),
-    verbose_(false)
+    verbose_(false),
+    cache_(NULL),
+    spill_store_(NULL)
 #ifdef WINDOWS
     , output_to_console_(false)
 #endif
@@ -66,7 +72,9 @@ XreCompiler::XreCompiler(hfst::ImplementationType impl) :
     function_arguments_(args.function_arguments),
     list_definitions_(args.list_definitions),
     format_(args.format),
-    verbose_(false)
+    verbose_(false),
+    cache_(NULL),
+    spill_store_(NULL)
 #ifdef WINDOWS
     , output_to_console_(false)
 #endif
@@ -92,6 +100,25 @@ XreCompiler::XreCompiler(hfst::ImplementationType impl) :
       return this->verbose_;
     }
 
+    void XreCompiler::set_cache(hfst::HfstCompilationCache * cache)
+    {
+      this->cache_ = cache;
+    }
+
+    void XreCompiler::set_spill_store(hfst::HfstSpillStore * store)
+    {
+      for (std::map<std::string, unsigned int>::const_iterator it
+             = spilled_definitions_.begin();
+           it != spilled_definitions_.end(); it++)
+        {
+          if (definitions_.find(it->first) == definitions_.end())
+            definitions_[it->first] = spill_store_->get(it->second);
+          spill_store_->remove(it->second);
+        }
+      spilled_definitions_.clear();
+      this->spill_store_ = store;
+    }
+
     // TODO: get rid of global variables
     void XreCompiler::set_error_stream(std::ostream * os)
     {
@@ -159,6 +186,10 @@ XreCompiler::XreCompiler(hfst::ImplementationType impl) :
 bool
 XreCompiler::define(const std::string& name, const std::string& xre)
 {
+  reload_definitions(xre);
+  // The key is computed before the old definition of name is removed,
+  // as xre may refer to it
+  std::string key = (cache_ != NULL) ? cache_key(xre) : std::string();
   HfstTransducer* compiled = compile(xre);
   if (compiled == NULL)
     {
@@ -175,6 +206,8 @@ XreCompiler::define(const std::string& name, const std::string& xre)
     }
   this->undefine(name);
   definitions_[name] = compiled;
+  if (! key.empty())
+    definition_keys_[name] = key;
   return true;
 }
 
@@ -207,6 +240,8 @@ XreCompiler::is_definition(const std::string & name)
 {
   if (definitions_.find(name) != definitions_.end())
     return true;
+  if (spilled_definitions_.find(name) != spilled_definitions_.end())
+    return true;
   return false;
 }
 
@@ -227,6 +262,35 @@ XreCompiler::undefine(const std::string& name)
     delete it->second;
     definitions_.erase(it);
   }
+  definition_keys_.erase(name);
+  auto const spilled = spilled_definitions_.find(name);
+  if (spilled != spilled_definitions_.end())
+  {
+    spill_store_->remove(spilled->second);
+    spilled_definitions_.erase(spilled);
+  }
+}
+
+void
+XreCompiler::spill_definitions()
+{
+  if (spill_store_ == NULL)
+    return;
+  for (auto it = definitions_.begin(); it != definitions_.end(); )
+    {
+      // A definition is never changed, so it is written only once
+      if (spilled_definitions_.find(it->first) == spilled_definitions_.end())
+        {
+          if (! spill_store_->is_worth_storing(*(it->second)))
+            {
+              it++;
+              continue;
+            }
+          spilled_definitions_[it->first] = spill_store_->put(*(it->second));
+        }
+      delete it->second;
+      it = definitions_.erase(it);
+    }
 }
 
 void
@@ -276,9 +340,240 @@ XreCompiler::contained_only_comments()
   return contains_only_comments;
 }
 
+static bool is_whitespace(char c)
+{
+  return (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+}
+
+// The number of bytes in the UTF-8 character starting with byte @a c.
+static size_t utf8_length(unsigned char c)
+{
+  if (c < 0xc0)
+    return 1;
+  if (c < 0xe0)
+    return 2;
+  if (c < 0xf0)
+    return 3;
+  return 4;
+}
+
+// Normalize @a xre for a cache key: a run of whitespace is replaced with
+// a newline or a space, depending on whether it contains a newline, and
+// '!' comments are left out. Escaped characters, quoted strings and
+// braced strings are kept as they are. As '#' can start both a comment
+// and a symbol, the text after it is kept as it is. @a extent is set to
+// the length of the first regex, i.e. the position after the first ';'
+// that ends an expression, or to npos if it is not known.
+static std::string normalize(const std::string& xre, size_t & extent)
+{
+  std::string result;
+  extent = std::string::npos;
+  size_t i = 0;
+  while (i < xre.size())
+    {
+      char c = xre[i];
+      if (is_whitespace(c))
+        {
+          bool newline = false;
+          for ( ; i < xre.size() && is_whitespace(xre[i]); i++)
+            newline = newline || (xre[i] == '\n');
+          result.push_back(newline ? '\n' : ' ');
+          continue;
+        }
+      size_t end = i + 1;
+      if (c == '%' && i + 1 < xre.size())
+        end = i + 1 + utf8_length(xre[i + 1]);
+      else if (c == '"' || c == '{')
+        {
+          end = xre.find((c == '"') ? '"' : '}', i + 1);
+          end = (end == std::string::npos) ? xre.size() : end + 1;
+        }
+      else if (c == '!')
+        {
+          i = xre.find('\n', i);
+          if (i == std::string::npos)
+            i = xre.size();
+          continue;
+        }
+      else if (c == '#')
+        end = xre.size();
+      else if (c == ';' && extent == std::string::npos)
+        extent = i + 1;
+      end = std::min(end, xre.size());
+      result.append(xre, i, end - i);
+      i = end;
+    }
+  return result;
+}
+
+// Whether @a name occurs in one of @a texts.
+static bool occurs_in(const std::string& name,
+                      const std::vector<std::string> & texts)
+{
+  for (std::vector<std::string>::const_iterator it = texts.begin();
+       it != texts.end(); it++)
+    {
+      if (it->find(name) != std::string::npos)
+        return true;
+    }
+  return false;
+}
+
+// Whether one of @a texts, as they are written, reads a regex with
+// @re"FILE". The names it refers to are not in @a texts.
+static bool reads_regex_files(const std::vector<std::string> & texts)
+{
+  // The texts as they are written are the first half
+  for (size_t i = 0; i < texts.size() / 2; i++)
+    {
+      if (texts[i].find("@re\"") != std::string::npos)
+        return true;
+    }
+  return false;
+}
+
+// The texts where the names that @a xre refers to can occur: @a xre and
+// the functions that it calls, also by other functions, first as they
+// are written and then without escapes and quotes. A name is looked for
+// everywhere in the texts, which may include some names that are not
+// used but never leaves out one that is. The functions are inserted to
+// @a functions.
+std::vector<std::string>
+XreCompiler::referenced_texts(const std::string& xre,
+                              std::set<std::string> & functions)
+{
+  std::vector<std::string> texts(1, xre);
+  for (size_t i = 0; i < texts.size(); i++)
+    {
+      for (std::map<std::string, std::string>::const_iterator it
+             = function_definitions_.begin();
+           it != function_definitions_.end(); it++)
+        {
+          if (functions.find(it->first) == functions.end() &&
+              texts[i].find(it->first) != std::string::npos)
+            {
+              functions.insert(it->first);
+              texts.push_back(it->second);
+            }
+        }
+    }
+
+  // Names can also be written with escapes and quotes
+  size_t text_count = texts.size();
+  for (size_t i = 0; i < text_count; i++)
+    {
+      std::string unescaped;
+      for (std::string::const_iterator it = texts[i].begin();
+           it != texts[i].end(); it++)
+        {
+          if (*it != '%' && *it != '"')
+            unescaped.push_back(*it);
+        }
+      texts.push_back(unescaped);
+    }
+  return texts;
+}
+
+// Read back the spilled definitions that @a xre may refer to. A regex
+// read with @re"FILE" may refer to any of them.
+void
+XreCompiler::reload_definitions(const std::string& xre)
+{
+  if (spilled_definitions_.empty())
+    return;
+  std::set<std::string> functions;
+  std::vector<std::string> texts = referenced_texts(xre, functions);
+  bool reads_files = reads_regex_files(texts);
+  for (std::map<std::string, unsigned int>::const_iterator it
+         = spilled_definitions_.begin(); it != spilled_definitions_.end(); it++)
+    {
+      if (definitions_.find(it->first) == definitions_.end() &&
+          (reads_files || occurs_in(it->first, texts)))
+        definitions_[it->first] = spill_store_->get(it->second);
+    }
+}
+
+const std::string &
+XreCompiler::definition_key(const std::string& name)
+{
+  std::string & key = definition_keys_[name];
+  if (key.empty())
+    key = hfst::HfstCompilationCache::hash(*definitions_[name]);
+  return key;
+}
+
+std::string
+XreCompiler::cache_key(const std::string& xre)
+{
+  std::set<std::string> functions;
+  std::vector<std::string> texts = referenced_texts(xre, functions);
+  // The regex in the file may refer to any definition, which would all
+  // have to be keyed
+  if (reads_regex_files(texts))
+    return std::string(); // not cached
+
+  size_t extent;
+  hfst::HfstCompilationCache::Key key("xre", format_);
+  key.add(normalize(xre, extent))
+    .add((long)expand_definitions)
+    .add((long)harmonize_)
+    .add((long)harmonize_flags_);
+  if (defined_multichar_symbols_ != NULL)
+    {
+      for (std::set<std::string>::const_iterator it
+             = defined_multichar_symbols_->begin();
+           it != defined_multichar_symbols_->end(); it++)
+        key.add(*it);
+    }
+
+  for (std::set<std::string>::const_iterator it = functions.begin();
+       it != functions.end(); it++)
+    {
+      key.add(*it)
+        .add((long)function_arguments_[*it])
+        .add(function_definitions_[*it]);
+    }
+
+  for (std::map<std::string, HfstTransducer*>::const_iterator it
+         = definitions_.begin(); it != definitions_.end(); it++)
+    {
+      if (occurs_in(it->first, texts))
+        key.add(it->first).add(definition_key(it->first));
+    }
+  for (std::map<std::string, std::set<std::string> >::const_iterator it
+         = list_definitions_.begin(); it != list_definitions_.end(); it++)
+    {
+      if (! occurs_in(it->first, texts))
+        continue;
+      key.add(it->first).add((long)it->second.size());
+      for (std::set<std::string>::const_iterator symbol = it->second.begin();
+           symbol != it->second.end(); symbol++)
+        key.add(*symbol);
+    }
+
+  // The texts as they are written are the first half
+  for (size_t i = 0; i < texts.size() / 2; i++)
+    {
+      if (! key.add_referenced_files(texts[i], ""))
+        return std::string(); // cannot be cached
+    }
+  return key.str();
+}
+
 HfstTransducer*
 XreCompiler::compile(const std::string& xre)
 {
+  reload_definitions(xre);
+  std::string key = (cache_ != NULL) ? cache_key(xre) : std::string();
+  if (! key.empty())
+    {
+      HfstTransducer * cached = cache_->get(key);
+      if (cached != NULL)
+        {
+          contains_only_comments = false;
+          return cached;
+        }
+    }
   // debug
   //std::cerr << "XreCompiler: " << this << " : compile(\"" << xre << "\")" << std::endl;
   unsigned int cr_before = cr;
@@ -287,6 +582,8 @@ XreCompiler::compile(const std::string& xre)
     {
       HfstTransducer * retval = hfst::xre::compile(xre, definitions_, function_definitions_, function_arguments_, list_definitions_, format_);
       cr = cr_before;
+      if (retval != NULL && ! key.empty())
+        cache_->put(key, *retval);
       return retval;
     }
   catch (const char * msg)
@@ -301,6 +598,26 @@ XreCompiler::compile(const std::string& xre)
 HfstTransducer*
 XreCompiler::compile_first(const std::string& xre, unsigned int & chars_read)
 {
+  reload_definitions(xre);
+  // Only the first regex is compiled, so only it is a part of the key
+  std::string key;
+  size_t extent = std::string::npos;
+  if (cache_ != NULL)
+    {
+      normalize(xre, extent);
+      if (extent != std::string::npos)
+        key = cache_key(xre.substr(0, extent));
+    }
+  if (! key.empty())
+    {
+      HfstTransducer * cached = cache_->get(key);
+      if (cached != NULL)
+        {
+          contains_only_comments = false;
+          chars_read = (unsigned int)extent;
+          return cached;
+        }
+    }
   // debug
   //std::cerr << "XreCompiler: " << this << " : compile_first(\"" << xre << "\"";
   unsigned int cr_before = cr;
@@ -310,6 +627,8 @@ XreCompiler::compile_first(const std::string& xre, unsigned int & chars_read)
       HfstTransducer * retval = hfst::xre::compile_first(xre, definitions_, function_definitions_, function_arguments_, list_definitions_, format_, chars_read);
       //std::cerr << ", " << chars_read << ")" << std::endl;
       cr = cr_before;
+      if (retval != NULL && ! key.empty() && chars_read == extent)
+        cache_->put(key, *retval);
       return retval;
     }
   catch (const char * msg)
@@ -324,6 +643,7 @@ XreCompiler::compile_first(const std::string& xre, unsigned int & chars_read)
 bool XreCompiler::get_positions_of_symbol_in_xre
 (const std::string & symbol, const std::string & xre, std::set<unsigned int> & positions_)
 {
+  reload_definitions(xre);
   position_symbol = strdup(symbol.c_str());
   positions.clear();
   unsigned int cr_before = cr;
@@ -32,6 +32,8 @@
 #include "../HfstDataTypes.h"
 
 namespace hfst {
+class HfstCompilationCache;
+class HfstSpillStore;
 //! @brief hfst::xre namespace is used for all functions related to Xerox
 //! Regular Expresisions (XRE) parsing.
 namespace xre {
@@ -147,6 +149,21 @@ class XreCompiler
   //!        Default is false.
   void set_flag_harmonization(bool harmonize_flags);
 
+  //! @brief Look up compiled regexes in @a cache before compiling them and
+  //!        store the results there. The cache is not owned by the compiler.
+  //!        Default is NULL, i.e. no cache.
+  void set_cache(hfst::HfstCompilationCache * cache);
+
+  //! @brief Keep the definitions in @a store while they are not in use,
+  //!        see #spill_definitions. A definition is read back when a
+  //!        regex refers to it. The store is not owned by the compiler.
+  //!        Default is NULL, i.e. all definitions are kept in memory.
+  void set_spill_store(hfst::HfstSpillStore * store);
+
+  //! @brief Move the definitions that are large enough to the spill store
+  //!        and out of memory. Does nothing if there is no spill store.
+  void spill_definitions();
+
   void set_verbosity(bool verbose);
   bool get_verbosity();
   void set_error_stream(std::ostream * os);
@@ -166,6 +183,19 @@ class XreCompiler
   std::map<std::string, std::set<std::string> > list_definitions_;
   hfst::ImplementationType format_;
   bool verbose_;
+  hfst::HfstCompilationCache * cache_;
+  // cache keys of definitions, computed when they are first needed
+  std::map<std::string, std::string> definition_keys_;
+  hfst::HfstSpillStore * spill_store_;
+  // where definitions are stored in spill_store_; the definitions that
+  // are not in definitions_ are only there
+  std::map<std::string, unsigned int> spilled_definitions_;
+
+  std::vector<std::string> referenced_texts(const std::string& xre,
+                                            std::set<std::string> & functions);
+  void reload_definitions(const std::string& xre);
+  std::string cache_key(const std::string& xre);
+  const std::string & definition_key(const std::string& name);
 #ifdef WINDOWS
   bool output_to_console_;
   // global std::ostringstream * winoss_;
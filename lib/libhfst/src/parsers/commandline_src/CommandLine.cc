@@ -86,6 +86,8 @@ void CommandLine::print_help(void)
         << "  -D, --dont-resolve-right Don't resolve right-arrow conflicts."
         << std::endl
         << "  -f, --format=FORMAT      Store result in format FORMAT."
+        << std::endl
+        << "  -j, --jobs=N             Compile rules using N threads."
         << std::endl << std::endl;
 
   std::cerr << "Format may be one of openfst-log, openfst-tropical, foma or sfst."
@@ -95,6 +97,12 @@ void CommandLine::print_help(void)
             << std::endl
             << "conflicts are resolved and left arrow conflicts are not resolved."
             << std::endl << std::endl;
+
+  std::cerr << "Rules are compiled using one thread by default. Only the"
+            << std::endl
+            << "openfst formats can use more. The result is the same with any"
+            << std::endl
+            << "number of threads." << std::endl << std::endl;
 }
 
 int CommandLine::parse_options(int argc, char** argv)
@@ -109,6 +117,7 @@ int CommandLine::parse_options(int argc, char** argv)
   bool isDebug = false;
   char * infilename = NULL;
   char * debug_file_name = NULL;
+  long job_count = 1;
   ImplementationType form = hfst::TROPICAL_OPENFST_TYPE;
 
   // use of this function requires options are settable on global scope
@@ -128,12 +137,13 @@ int CommandLine::parse_options(int argc, char** argv)
       {"dont-resolve-right",no_argument, 0, 'D'},
       {"debug_file",required_argument, 0, 'd'},
       {"format",required_argument, 0, 'f'},
+      {"jobs",required_argument, 0, 'j'},
       {0,0,0,0}
         };
       int option_index = 0;
       // add tool-specific options here
       int c = getopt_long(argc, argv,
-               ":hVvqsu" "i:o:" "RDi:d:f:",
+               ":hVvqsu" "i:o:" "RDi:d:f:j:",
                long_options, &option_index);
       if (-1 == c)
         {
@@ -215,6 +225,19 @@ int CommandLine::parse_options(int argc, char** argv)
           exit(1);
         }
       break;
+    case 'j':
+      {
+        char * endptr = NULL;
+        job_count = strtol(optarg, &endptr, 10);
+        if (*endptr != '\0' || job_count < 1)
+          {
+            std::cerr << "Invalid number of jobs \"" << optarg << "\". "
+                      << "Try running with option -h or --help."
+                      << std::endl;
+            exit(1);
+          }
+        break;
+      }
     case ':':
       std::cerr << "Missing argument for -" << (char)optopt
             << ". Try using --help."
@@ -265,6 +288,7 @@ int CommandLine::parse_options(int argc, char** argv)
   if (this->has_output_file)
     { this->output_file_name = outfilename; }
   this->format = form;
+  this->jobs = (unsigned int)job_count;
   //this->help = help;
   //this->usage = usage;
   //this->version = version;
@@ -290,6 +314,7 @@ CommandLine::CommandLine(int argc,char * argv[]):
   output_file(NULL),
   resolve_left_conflicts(false),
   resolve_right_conflicts(true),
+  jobs(1),
   help(false),
   version(false),
   usage(false),
@@ -17,6 +17,17 @@
 #include <cstdlib>
 #include <cstring>
 #include <sstream>
+#include <thread>
+
+#if defined(__AVX__)
+#  include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#  define PMATCH_SSE_DOT_PRODUCT
+#  include <xmmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#  include <arm_neon.h>
+#endif
 
 #include "HfstTransducer.h"
 #include "HfstExceptionDefs.h"
@@ -25,6 +36,7 @@
 #include "xre_utils.h"
 //#include "tools/src/HfstUtf8.h"
 #include "implementations/optimized-lookup/pmatch.h"
+#include "implementations/HfstLexiconBuilder.h"
 
 using std::string;
 using std::map;
@@ -93,7 +105,7 @@ std::set<std::string> unsatisfied_insertions;
 std::set<std::string> used_definitions;
 std::set<std::string> function_names;
 std::set<std::string> capture_names;
-std::vector<WordVector> word_vectors;
+WordVectorMatrix word_vectors;
 char* startptr;
 hfst::ImplementationType format;
 size_t len;
@@ -332,105 +344,223 @@ PmatchObject * make_with_tag_exit(std::string key)
     return new PmatchString("@C.PMATCH_GLOBAL_" + key + "@");
 }
 
-// Get the n best candidates in the original space using an insertion sort
-std::vector<std::pair<WordVector, WordVecFloat> > get_top_n(size_t n,
-                                                            std::vector<WordVector> & vecs,
-                                                            WordVector & comparison_point)
-{
-    std::vector<std::pair<WordVector, WordVecFloat> > retval;
-    for (std::vector<WordVector>::const_iterator it = vecs.begin();
-         it != vecs.end(); ++it) {
-        WordVecFloat cosdist = cosine_distance(*it, comparison_point);
-        for (size_t i = 0; i <= retval.size(); ++i) {
-            if (i == retval.size()) {
-                // We made it to the top
-                retval.push_back(std::pair<WordVector, WordVecFloat>(
-                                     WordVector(*it), cosdist));
-                break;
-            } else {
-                // Walking the list
-                if (cosdist >= retval[i].second) {
-                    if (i == 0 && retval.size() == n) {
-                        break;
-                    }
-                    retval.insert(retval.begin() + i, std::pair<WordVector, WordVecFloat>(
-                                      WordVector(*it), cosdist));
-                    break;
-                } else {
-                    continue;
-                }
-            }
+size_t WordVectorMatrix::find(const std::string & word) const
+{
+    std::unordered_map<std::string, size_t>::const_iterator it =
+        word_indices.find(word);
+    return it == word_indices.end() ? size() : it->second;
+}
+
+void WordVectorMatrix::add(const std::string & word,
+                           const WordVecFloat * vector)
+{
+    // The first occurrence of a word is the one that is found
+    word_indices.insert(std::pair<std::string, size_t>(word, size()));
+    words.push_back(word);
+    components.insert(components.end(), vector, vector + dimension);
+    norms.push_back(sqrt(packed_dot_product(vector, vector, dimension)));
+}
+
+void WordVectorMatrix::clear(void)
+{
+    words.clear();
+    components.clear();
+    norms.clear();
+    word_indices.clear();
+    dimension = 0;
+}
+
+// Dot product of two packed vectors of length n, using whatever vector
+// instructions the compiler targets, with the remainder done serially.
+WordVecFloat packed_dot_product(const WordVecFloat * l,
+                                const WordVecFloat * r,
+                                size_t n)
+{
+    size_t i = 0;
+    WordVecFloat ret = 0;
+#if defined(__AVX__)
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(l + i),
+                                                 _mm256_loadu_ps(r + i)));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(l + i + 8),
+                                                 _mm256_loadu_ps(r + i + 8)));
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, _mm256_add_ps(acc0, acc1));
+    for (size_t j = 0; j < 8; ++j) {
+        ret += lanes[j];
+    }
+#elif defined(PMATCH_SSE_DOT_PRODUCT)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(l + i),
+                                           _mm_loadu_ps(r + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(l + i + 4),
+                                           _mm_loadu_ps(r + i + 4)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+    ret = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    float32x4_t acc0 = vdupq_n_f32(0);
+    float32x4_t acc1 = vdupq_n_f32(0);
+    for (; i + 8 <= n; i += 8) {
+        acc0 = vfmaq_f32(acc0, vld1q_f32(l + i), vld1q_f32(r + i));
+        acc1 = vfmaq_f32(acc1, vld1q_f32(l + i + 4), vld1q_f32(r + i + 4));
+    }
+    ret = vaddvq_f32(vaddq_f32(acc0, acc1));
+#else
+    WordVecFloat acc[4] = { 0, 0, 0, 0 };
+    for (; i + 4 <= n; i += 4) {
+        for (size_t j = 0; j < 4; ++j) {
+            acc[j] += l[i + j] * r[i + j];
         }
-        if (retval.size() > n) {
-            retval.erase(retval.begin());
+    }
+    ret = acc[0] + acc[1] + acc[2] + acc[3];
+#endif
+    for (; i < n; ++i) {
+        ret += l[i] * r[i];
+    }
+    return ret;
+}
+
+typedef std::pair<WordVecFloat, size_t> RankedRow;
+
+// Push into a max-heap of at most n rows, so the heap keeps the n rows
+// with the smallest distances (ties going to the earlier row).
+static void push_bounded(std::vector<RankedRow> & heap, size_t n,
+                         RankedRow candidate)
+{
+    if (heap.size() < n) {
+        heap.push_back(candidate);
+        std::push_heap(heap.begin(), heap.end());
+    } else if (n > 0 && candidate < heap.front()) {
+        std::pop_heap(heap.begin(), heap.end());
+        heap.back() = candidate;
+        std::push_heap(heap.begin(), heap.end());
+    }
+}
+
+// Below this many vector components the scan is not worth splitting
+// between threads.
+const size_t PARALLEL_TOP_N_THRESHOLD = 1 << 22;
+
+// Get the n rows of vecs with the smallest distance(row), nearest first.
+// Large matrices are scanned in slices by several threads, each keeping
+// its own heap, and the heaps are merged at the end.
+template<typename Distance>
+std::vector<std::pair<size_t, WordVecFloat> > top_n_rows(
+    size_t n, const WordVectorMatrix & vecs, Distance distance)
+{
+    size_t rows = vecs.size();
+    size_t threads = 1;
+    if (rows * vecs.dimension >= PARALLEL_TOP_N_THRESHOLD) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = std::min(threads,
+                           rows * vecs.dimension / (PARALLEL_TOP_N_THRESHOLD / 4));
+    }
+    std::vector<std::vector<RankedRow> > heaps(threads);
+    auto scan = [&](size_t slice) {
+        size_t end = rows * (slice + 1) / threads;
+        for (size_t i = rows * slice / threads; i < end; ++i) {
+            WordVecFloat dist = distance(i);
+            if (dist != dist) {
+                // NaN from a zero vector, rank it as far away as possible
+                dist = 2.0;
+            }
+            push_bounded(heaps[slice], n, RankedRow(dist, i));
         }
+    };
+    std::vector<std::thread> workers;
+    for (size_t slice = 1; slice < threads; ++slice) {
+        workers.push_back(std::thread(scan, slice));
+    }
+    scan(0);
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i].join();
+    }
+
+    std::vector<RankedRow> best;
+    for (size_t slice = 0; slice < threads; ++slice) {
+        best.insert(best.end(), heaps[slice].begin(), heaps[slice].end());
+    }
+    std::sort(best.begin(), best.end());
+    if (best.size() > n) {
+        best.resize(n);
+    }
+    std::vector<std::pair<size_t, WordVecFloat> > retval;
+    for (size_t i = 0; i < best.size(); ++i) {
+        retval.push_back(std::pair<size_t, WordVecFloat>(best[i].second,
+                                                         best[i].first));
     }
     return retval;
 }
 
-// Get the n best candidates in the transformed space using an insertion sort
-std::vector<std::pair<WordVector, WordVecFloat> > get_top_n_transformed(
+// Get the n best candidates in the original space
+std::vector<std::pair<size_t, WordVecFloat> > get_top_n(
+    size_t n,
+    const WordVectorMatrix & vecs,
+    size_t comparison_point)
+{
+    const WordVecFloat * point = vecs.row(comparison_point);
+    WordVecFloat point_norm = vecs.norms[comparison_point];
+    return top_n_rows(
+        n, vecs,
+        [&vecs, point, point_norm](size_t i) {
+            // Sometimes very nearby vectors combined with rounding error
+            // will produce a slightly negative distance, so make sure to
+            // return at least 0.0
+            WordVecFloat cosdist = 1.0 -
+                packed_dot_product(vecs.row(i), point, vecs.dimension) /
+                (vecs.norms[i] * point_norm);
+            return std::max(static_cast<WordVecFloat>(0.0), cosdist);
+        });
+}
+
+// Get the n best candidates in the transformed space
+std::vector<std::pair<size_t, WordVecFloat> > get_top_n_transformed(
     size_t n,
-    const std::vector<WordVector> & vecs,
-    std::vector<WordVecFloat> plane_vec,
-    std::vector<WordVecFloat> comparison_point,
+    const WordVectorMatrix & vecs,
+    const std::vector<WordVecFloat> & plane_vec,
+    const std::vector<WordVecFloat> & comparison_point,
     WordVecFloat translation_term,
     bool negative)
 {
-    std::vector<std::pair<WordVector, WordVecFloat> > retval;
     WordVecFloat plane_vec_square_sum = square_sum(plane_vec);
     WordVecFloat comparison_point_norm = norm(comparison_point);
-    for (std::vector<WordVector>::const_iterator it = vecs.begin();
-         it != vecs.end(); ++it) {
-        WordVector transformed_vec(*it);
-
-        /*
-         * First, given a plane "plane_vec = translation term" and a point,
-         * find the multiple of plane_vec which produces a vector going
-         * from point to the nearest point in the plane.
-         */
-
-        WordVecFloat transformed_vec_scaler =
-            (translation_term - dot_product(transformed_vec.vector, plane_vec))
-            / plane_vec_square_sum;
-        transformed_vec_scaler *= vector_similarity_projection_factor;
-        if(negative) {
-            transformed_vec.vector =
-                pointwise_minus(transformed_vec.vector,
-                                pointwise_multiplication(transformed_vec_scaler, plane_vec));
-        } else {
-            transformed_vec.vector =
-                pointwise_plus(transformed_vec.vector,
-                               pointwise_multiplication(transformed_vec_scaler, plane_vec));
-        }
-        transformed_vec.norm = norm(transformed_vec.vector);
-        WordVecFloat cosdist = 1 - dot_product(transformed_vec.vector, comparison_point)
-            / (transformed_vec.norm * comparison_point_norm);
-        for (size_t i = 0; i <= retval.size(); ++i) {
-            if (i == retval.size()) {
-                // We made it to the top
-                retval.push_back(std::pair<WordVector, WordVecFloat>(transformed_vec,
-                                                                     cosdist));
-                break;
-            } else {
-                // Walking the list
-                if (cosdist >= retval[i].second) {
-                    if (i == 0 && retval.size() == n) {
-                        break;
-                    }
-                    retval.insert(retval.begin() + i,
-                                  std::pair<WordVector, WordVecFloat>(transformed_vec, cosdist));
-                    break;
-                } else {
-                    continue;
-                }
-            }
-        }
-        if (retval.size() > n) {
-            retval.erase(retval.begin());
-        }
-    }
-    return retval;
+    WordVecFloat plane_dot_point = dot_product(plane_vec, comparison_point);
+    WordVecFloat sign = negative ? -1.0 : 1.0;
+    const WordVecFloat * plane = plane_vec.data();
+    const WordVecFloat * point = comparison_point.data();
+    return top_n_rows(
+        n, vecs,
+        [&](size_t i) {
+            /*
+             * First, given a plane "plane_vec = translation term" and a
+             * point, find the multiple of plane_vec which produces a
+             * vector going from point to the nearest point in the plane.
+             * The transformed vector is then row + sign * scaler * plane,
+             * and its dot product with the comparison point and its norm
+             * follow from the dot products of the untransformed row.
+             */
+            const WordVecFloat * row = vecs.row(i);
+            WordVecFloat row_dot_plane =
+                packed_dot_product(row, plane, vecs.dimension);
+            WordVecFloat row_dot_point =
+                packed_dot_product(row, point, vecs.dimension);
+            WordVecFloat scaler = sign *
+                (translation_term - row_dot_plane) / plane_vec_square_sum *
+                vector_similarity_projection_factor;
+            WordVecFloat transformed_norm =
+                sqrt(vecs.norms[i] * vecs.norms[i] +
+                     2 * scaler * row_dot_plane +
+                     scaler * scaler * plane_vec_square_sum);
+            return 1 - (row_dot_point + scaler * plane_dot_point)
+                / (transformed_norm * comparison_point_norm);
+        });
 }
 
 template<typename T> std::vector<T> pointwise_minus(std::vector<T> l,
@@ -487,15 +617,6 @@ template<typename T> T norm(std::vector<T> v)
     return sqrt(square_sum(v));
 }
 
-WordVecFloat cosine_distance(WordVector left, WordVector right)
-{
-    // Sometimes very nearby vectors combined with rounding error will produce
-    // a slightly negative distance, so make sure to return at least 0.0
-    WordVecFloat retval = 1.0 - dot_product(left.vector, right.vector) /
-        (left.norm * right.norm);
-    return std::max(static_cast<WordVecFloat>(0.0), retval);
-}
-
 WordVecFloat cosine_distance(std::vector<WordVecFloat> left, std::vector<WordVecFloat> right)
 {
     WordVecFloat retval = 1.0 - dot_product(left, right) / (norm(left) * norm(right));
@@ -506,15 +627,8 @@ WordVecFloat cosine_distance(std::vector<WordVecFloat> left, std::vector<WordVec
 PmatchObject * compile_like_arc(std::string word,
                                 unsigned int nwords)
 {
-    WordVector this_word;
-    for (std::vector<WordVector>::iterator it = word_vectors.begin();
-         it != word_vectors.end(); ++it) {
-        if (word == it->word) {
-            this_word = *it;
-            break;
-        }
-    }
-    if (this_word.word.empty()) {
+    size_t this_word = word_vectors.find(word);
+    if (this_word == word_vectors.size()) {
         // got no matches
         PmatchString * word_o = new PmatchString(word);
         word_o->multichar = true;
@@ -522,7 +636,7 @@ PmatchObject * compile_like_arc(std::string word,
         return word_o;
     }
 
-    std::vector<std::pair<WordVector, WordVecFloat> > top_n = get_top_n(nwords, word_vectors, this_word);
+    std::vector<std::pair<size_t, WordVecFloat> > top_n = get_top_n(nwords, word_vectors, this_word);
 
     HfstTokenizer tok;
     HfstTransducer * retval = new HfstTransducer(format);
@@ -531,9 +645,9 @@ PmatchObject * compile_like_arc(std::string word,
     }
     for (size_t i = 0; i < top_n.size(); ++i) {
         if (verbose) {
-            std::cerr << "  " << top_n[i].first.word << std::endl;
+            std::cerr << "  " << word_vectors.words[top_n[i].first] << std::endl;
         }
-        HfstTransducer tmp(top_n[i].first.word, tok, format);
+        HfstTransducer tmp(word_vectors.words[top_n[i].first], tok, format);
         if (include_cosine_distances) {
             tmp.set_final_weights(top_n[i].second);
         }
@@ -546,19 +660,11 @@ PmatchObject * compile_like_arc(std::string word,
 PmatchObject * compile_like_arc(std::string word1, std::string word2,
                                 unsigned int nwords, bool is_negative)
 {
-    WordVector this_word1;
-    WordVector this_word2;
-    for (std::vector<WordVector>::iterator it = word_vectors.begin();
-         (it != word_vectors.end() &&
-          (this_word1.word.empty() || this_word2.word.empty())); ++it) {
-        if (word1 == it->word) {
-            this_word1 = *it;
-        }
-        if (word2 == it->word) {
-            this_word2 = *it;
-        }
-    }
-    if (this_word1.word.empty() && this_word2.word.empty()) {
+    size_t this_word1 = word_vectors.find(word1);
+    size_t this_word2 = word_vectors.find(word2);
+    bool found_word1 = this_word1 != word_vectors.size();
+    bool found_word2 = this_word2 != word_vectors.size();
+    if (!found_word1 && !found_word2) {
         // got no matches
         PmatchString * word1_o = new PmatchString(word1);
         PmatchString * word2_o = new PmatchString(word2);
@@ -567,22 +673,22 @@ PmatchObject * compile_like_arc(std::string word1, std::string word2,
         return new PmatchBinaryOperation(Disjunct, word1_o, word2_o);
     }
 
-    if (this_word1.word.empty() || this_word2.word.empty()) {
+    if (!found_word1 || !found_word2) {
         // just one match
         pmatchwarning("only one match for arguments to Like() operation, using nearest neighbours");
-        WordVector this_word = (this_word1.word.empty() ? this_word2 : this_word1);
-        std::vector<std::pair<WordVector, WordVecFloat> > top_n = get_top_n(nwords, word_vectors, this_word);
+        size_t this_word = (found_word1 ? this_word1 : this_word2);
+        std::vector<std::pair<size_t, WordVecFloat> > top_n = get_top_n(nwords, word_vectors, this_word);
         HfstTokenizer tok;
         HfstTransducer * retval = new HfstTransducer(format);
         if (verbose) {
-            std::cerr << "Inserting into Like(" << this_word.word << "):" << std::endl;
+            std::cerr << "Inserting into Like(" << word_vectors.words[this_word] << "):" << std::endl;
         }
 
         for (size_t i = 0; i < top_n.size(); ++i) {
             if (verbose) {
-                std::cerr << "  " << top_n[i].first.word << std::endl;
+                std::cerr << "  " << word_vectors.words[top_n[i].first] << std::endl;
             }
-            HfstTransducer tmp(top_n[i].first.word, tok, format);
+            HfstTransducer tmp(word_vectors.words[top_n[i].first], tok, format);
             if (include_cosine_distances) {
                 tmp.set_final_weights(top_n[i].second);
             }
@@ -611,29 +717,31 @@ PmatchObject * compile_like_arc(std::string word1, std::string word2,
      *
      */
 
+    std::vector<WordVecFloat> word1_vector = word_vectors.vector(this_word1);
+    std::vector<WordVecFloat> word2_vector = word_vectors.vector(this_word2);
     std::vector<WordVecFloat> B_minus_A = pointwise_minus(
-        this_word1.vector, this_word2.vector);
-    WordVecFloat hyperplane_translation_term = dot_product(B_minus_A, this_word1.vector)
+        word1_vector, word2_vector);
+    WordVecFloat hyperplane_translation_term = dot_product(B_minus_A, word1_vector)
         - square_sum(B_minus_A) * 0.5;
 
     std::vector<WordVecFloat> comparison_point;
     if (is_negative == true) {
         if (verbose) {
-            std::cerr << "Inserting into Unlike(" << this_word1.word << ", " << this_word2.word << "):" << std::endl;
+            std::cerr << "Inserting into Unlike(" << word1 << ", " << word2 << "):" << std::endl;
         }
         WordVecFloat comparison_scaler =
-            (hyperplane_translation_term - dot_product(this_word1.vector, B_minus_A)) / square_sum(B_minus_A);
+            (hyperplane_translation_term - dot_product(word1_vector, B_minus_A)) / square_sum(B_minus_A);
         comparison_scaler *= vector_similarity_projection_factor;
-        comparison_point = pointwise_minus(this_word1.vector, pointwise_multiplication(comparison_scaler, B_minus_A));
+        comparison_point = pointwise_minus(word1_vector, pointwise_multiplication(comparison_scaler, B_minus_A));
     } else {
         if (verbose) {
-            std::cerr << "Inserting into Like(" << this_word1.word << ", " << this_word2.word << "):" << std::endl;
+            std::cerr << "Inserting into Like(" << word1 << ", " << word2 << "):" << std::endl;
         }
-        comparison_point = pointwise_plus(this_word2.vector, pointwise_multiplication(
+        comparison_point = pointwise_plus(word2_vector, pointwise_multiplication(
                                               static_cast<WordVecFloat>(0.5), B_minus_A));
     }
 
-    std::vector<std::pair<WordVector, WordVecFloat> > top_n = get_top_n_transformed(nwords,
+    std::vector<std::pair<size_t, WordVecFloat> > top_n = get_top_n_transformed(nwords,
                                                                                     word_vectors,
                                                                                     B_minus_A,
                                                                                     comparison_point,
@@ -643,9 +751,9 @@ PmatchObject * compile_like_arc(std::string word1, std::string word2,
     HfstTransducer * retval = new HfstTransducer(format);
     for (size_t i = 0; i < top_n.size() && i <= nwords; ++i) {
         if (verbose) {
-            std::cerr << "  " << top_n[i].first.word << std::endl;
+            std::cerr << "  " << word_vectors.words[top_n[i].first] << std::endl;
         }
-        HfstTransducer tmp(top_n[i].first.word, tok, format);
+        HfstTransducer tmp(word_vectors.words[top_n[i].first], tok, format);
         if (include_cosine_distances) {
             tmp.set_final_weights(top_n[i].second);
         }
@@ -1437,27 +1545,24 @@ HfstTransducer * read_text(std::string filename, ImplementationType type,
     std::string line;
     infile.open(filename.c_str());
     HfstTokenizer tok;
-    HfstTransducer * retval = new HfstTransducer(type);
+    hfst::implementations::HfstLexiconBuilder builder;
     if(!infile.good()) {
         std::cerr << "Pmatch: could not open text file " << filename <<
             " for reading\n";
     } else {
-        size_t n = 0;
         while(infile.good()) {
             std::getline(infile, line);
             if(!line.empty()) {
-                ++n;
                 if (spaced_text) {
-                    StringPairVector spv = tok.tokenize_space_separated(line);
+                    builder.add(tok.tokenize_space_separated(line));
                 } else {
-                    StringPairVector spv = tok.tokenize(line);
-                    retval->disjunct(spv);
+                    builder.add(tok.tokenize(line));
                 }
             }
         }
     }
     infile.close();
-    return retval;
+    return new HfstTransducer(builder.get_transducer(), type);
 }
 
 HfstTransducer * read_spaced_text(std::string filename, ImplementationType type)
@@ -1492,7 +1597,7 @@ void read_vec(std::string filename)
     std::string line;
     size_t lexicon_size;
     size_t dimension;
-    infile.open(filename.c_str());
+    infile.open(filename.c_str(), std::ios::in | std::ios::binary);
     if(!infile.good()) {
         std::cerr << "pmatch: could not open vector file " << filename <<
             " for reading\n";
@@ -1503,31 +1608,37 @@ void read_vec(std::string filename)
     ss >> lexicon_size;
     ss.ignore(1);
     ss >> dimension;
-    word_vectors.reserve(lexicon_size + 1);
     size_t words_read = 0;
     if (binary_format) {
+        // The actual number of vectors is 1 more than lexicon_size
+        // due to <s>
+        word_vectors.dimension = dimension;
+        word_vectors.words.reserve(lexicon_size + 1);
+        word_vectors.norms.reserve(lexicon_size + 1);
+        word_vectors.components.reserve((lexicon_size + 1) * dimension);
+        // This will not compile is WordVectorFloat is not float,
+        // in which case a conversion needs to happen, but
+        // we can reasonably expect it to be a float for the
+        // foreseeable future
+        std::vector<float> vector_data(dimension);
         size_t vector_data_size = sizeof(float) * dimension;
-        std::vector<char> vector_data(vector_data_size);
         while (infile.good() && words_read <= lexicon_size) {
-            // The actual number of vectors is 1 more than lexicon_size
-            // due to <s>
             std::getline(infile, line, separator);
-            infile.read(&vector_data[0], vector_data_size);
+            infile.read((char*) vector_data.data(), vector_data_size);
+            if (infile.gcount() != (std::streamsize) vector_data_size) {
+                break;
+            }
             infile.ignore(1);
-            WordVector wv;
-            wv.word = line;
-            // This will not compile is WordVectorFloat is not float,
-            // in which case a conversion needs to happen, but
-            // we can reasonably expect it to be a float for the
-            // foreseeable future
-            wv.vector.assign((float*) vector_data.data(), (float*) (vector_data.data() + vector_data_size));
-            wv.norm = norm(wv.vector);
-            word_vectors.push_back(wv);
+            word_vectors.add(line, vector_data.data());
             ++words_read;
         }
     } else {
+        std::vector<WordVecFloat> components;
         while(infile.good() && words_read <= lexicon_size) {
             std::getline(infile, line);
+            if (!line.empty() && line.back() == '\r') {
+                line.erase(line.size() - 1);
+            }
             if (line.empty()) { continue; }
             ++words_read;
             size_t pos = line.find(separator);
@@ -1541,32 +1652,34 @@ void read_vec(std::string filename)
                 }
             }
             std::string word = line.substr(0, pos);
-            std::vector<WordVecFloat> components;
+            components.clear();
             size_t nextpos;
             while (std::string::npos != (nextpos = line.find(separator, pos + 1))) {
-                components.push_back(strtod(line.substr(pos + 1, nextpos - pos).c_str(), NULL));
+                components.push_back(strtod(line.c_str() + pos + 1, NULL));
                 pos = nextpos;
             }
             // there can be one more from pos to the newline if there isn't a
             // separator at the end
             if (line.back() != separator) {
 #if defined _MSC_VER && 1200 <= _MSC_VER
-                components.push_back((float)strtod(line.substr(pos + 1).c_str(), NULL));
+                components.push_back((float)strtod(line.c_str() + pos + 1, NULL));
             }
 #else
-                components.push_back(strtof(line.substr(pos + 1).c_str(), NULL));
+                components.push_back(strtof(line.c_str() + pos + 1, NULL));
             }
 #endif
-            if (word_vectors.size() != 0 && word_vectors[0].vector.size() != components.size()) {
+            if (word_vectors.size() == 0) {
+                word_vectors.dimension = components.size();
+                word_vectors.words.reserve(lexicon_size + 1);
+                word_vectors.norms.reserve(lexicon_size + 1);
+                word_vectors.components.reserve(
+                    (lexicon_size + 1) * components.size());
+            } else if (word_vectors.dimension != components.size()) {
                 std::cerr << "pmatch warning: vector file " << filename <<
                     " appears malformed\n  (reading line " << words_read + 1 << ")\n";
                 continue;
             }
-            WordVector wv;
-            wv.word = word;
-            wv.vector = components;
-            wv.norm = norm(components);
-            word_vectors.push_back(wv);
+            word_vectors.add(word, components.data());
         }
     }
     infile.close();
@@ -1574,7 +1687,7 @@ void read_vec(std::string filename)
         if (word_vectors.size() == 0) {
             std::cerr << "Tried to read word vector file, empty result\n";
         }
-        std::cerr << "Read " << word_vectors.size() << " vectors of dimensionality " << word_vectors[0].vector.size() << std::endl;
+        std::cerr << "Read " << word_vectors.size() << " vectors of dimensionality " << word_vectors.dimension << std::endl;
     }
 }
 
@@ -20,6 +20,7 @@
 #include <map>
 #include <vector>
 #include <set>
+#include <unordered_map>
 #include <time.h>
 #include <iomanip>
 #include <cmath>
@@ -41,7 +42,7 @@ struct PmatchTransducerContainer;
 
 typedef std::pair<std::string, std::string> StringPair;
 typedef float WordVecFloat;
-struct WordVector;
+struct WordVectorMatrix;
 
 extern char* data;
 extern char* startptr;
@@ -57,7 +58,7 @@ extern std::set<std::string> unsatisfied_insertions;
 extern std::set<std::string> used_definitions;
 extern std::set<std::string> function_names;
 extern std::set<std::string> capture_names;
-extern std::vector<WordVector> word_vectors;
+extern WordVectorMatrix word_vectors;
 extern ImplementationType format;
 extern bool verbose;
 extern bool flatten;
@@ -143,16 +144,16 @@ PmatchTransducerContainer * make_captured_tag(std::string tag);
 PmatchObject * make_with_tag_entry(std::string key, std::string value);
 PmatchObject * make_with_tag_exit(std::string key);
 
-std::vector<std::pair<WordVector, WordVecFloat> > get_top_n(
+std::vector<std::pair<size_t, WordVecFloat> > get_top_n(
     size_t n,
-    const std::vector<WordVector> & vecs,
-    WordVector & comparison_point);
+    const WordVectorMatrix & vecs,
+    size_t comparison_point);
 
-std::vector<std::pair<WordVector, WordVecFloat> > get_top_n_transformed(
+std::vector<std::pair<size_t, WordVecFloat> > get_top_n_transformed(
     size_t n,
-    const std::vector<WordVector> & vecs,
-    std::vector<WordVecFloat> plane_vec,
-    std::vector<WordVecFloat> comparison_point,
+    const WordVectorMatrix & vecs,
+    const std::vector<WordVecFloat> & plane_vec,
+    const std::vector<WordVecFloat> & comparison_point,
     WordVecFloat translation_term,
     bool negative);
 
@@ -166,7 +167,9 @@ template<typename T> T dot_product(std::vector<T> l,
                                    std::vector<T> r);
 template<typename T> T square_sum(std::vector<T> v);
 template<typename T> T norm(std::vector<T> v);
-WordVecFloat cosine_distance(WordVector left, WordVector right);
+WordVecFloat packed_dot_product(const WordVecFloat * l,
+                                const WordVecFloat * r,
+                                size_t n);
 PmatchObject * compile_like_arc(std::string word1, std::string word2,
                                 unsigned int nwords = 10, bool is_negative = false);
 PmatchObject * compile_like_arc(std::string word,
@@ -245,11 +248,28 @@ HfstTransducer * read_spaced_text(std::string filename,
  */
 std::string path_from_filename(const char * filename);
 
-struct WordVector
+/**
+ * @brief Word vectors packed row by row into one matrix, with their norms
+ * precomputed, as read by read_vec()
+ */
+struct WordVectorMatrix
 {
-    std::string word;
-    std::vector<WordVecFloat> vector;
-    WordVecFloat norm;
+    std::vector<std::string> words;
+    std::vector<WordVecFloat> components;
+    std::vector<WordVecFloat> norms;
+    std::unordered_map<std::string, size_t> word_indices;
+    size_t dimension;
+
+    WordVectorMatrix(void): dimension(0) {}
+    size_t size(void) const { return words.size(); }
+    const WordVecFloat * row(size_t i) const
+    { return components.data() + i * dimension; }
+    std::vector<WordVecFloat> vector(size_t i) const
+    { return std::vector<WordVecFloat>(row(i), row(i) + dimension); }
+    /** @brief The row of @a word, or size() if there is none */
+    size_t find(const std::string & word) const;
+    void add(const std::string & word, const WordVecFloat * vector);
+    void clear(void);
 };
 
 /**
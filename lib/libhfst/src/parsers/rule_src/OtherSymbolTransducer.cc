@@ -87,6 +87,9 @@ void OtherSymbolTransducer::set_transducer_type
 (ImplementationType transducer_type)
 { OtherSymbolTransducer::transducer_type = transducer_type; }
 
+ImplementationType OtherSymbolTransducer::get_transducer_type(void)
+{ return OtherSymbolTransducer::transducer_type; }
+
 OtherSymbolTransducer::OtherSymbolTransducer(void):
   is_broken(false),
   transducer(transducer_type)
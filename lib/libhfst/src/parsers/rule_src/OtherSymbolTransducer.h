@@ -141,6 +141,9 @@ class OtherSymbolTransducer
   //! @brief Set the type of transducer to be used
   static void set_transducer_type(ImplementationType transducer_type);
 
+  //! @brief Get the type of transducer that is used
+  static ImplementationType get_transducer_type(void);
+
   //! @brief Construct empty transducer.
   OtherSymbolTransducer(void);
 
@@ -18,6 +18,11 @@
 
 #include "RuleContainer.h"
 
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
 RuleContainer::RuleContainer(void):
   report(true)
 {}
@@ -46,6 +51,64 @@ void RuleContainer::compile(std::ostream &msg_out,bool be_verbose)
     }
 }
 
+void RuleContainer::compile
+(const std::vector<RuleContainer*> &containers,std::ostream &msg_out,
+ bool be_verbose,unsigned int jobs)
+{
+  RuleVector rules;
+  for (std::vector<RuleContainer*>::const_iterator it = containers.begin();
+       it != containers.end();
+       ++it)
+    { rules.insert(rules.end(),(*it)->rule_vector.begin(),
+                   (*it)->rule_vector.end()); }
+
+  if (jobs > rules.size())
+    { jobs = rules.size(); }
+  if (jobs <= 1)
+    {
+      for (std::vector<RuleContainer*>::const_iterator it =
+             containers.begin();
+           it != containers.end();
+           ++it)
+        { (*it)->compile(msg_out,be_verbose); }
+      return;
+    }
+
+  std::atomic<size_t> next_rule(0);
+  std::mutex msg_mutex;
+  std::vector<std::exception_ptr> errors(rules.size());
+  auto compile_rules = [&]()
+    {
+      for (size_t i = next_rule++; i < rules.size(); i = next_rule++)
+        {
+          if (be_verbose)
+            {
+              std::lock_guard<std::mutex> lock(msg_mutex);
+              msg_out << "Compiling "
+                      << Rule::get_print_name(rules[i]->get_name())
+                      << std::endl;
+            }
+          try
+            { rules[i]->compile(); }
+          catch (...)
+            { errors[i] = std::current_exception(); }
+        }
+    };
+
+  std::vector<std::thread> threads;
+  for (unsigned int i = 1; i < jobs; ++i)
+    { threads.push_back(std::thread(compile_rules)); }
+  compile_rules();
+  for (size_t i = 0; i < threads.size(); ++i)
+    { threads[i].join(); }
+
+  for (size_t i = 0; i < errors.size(); ++i)
+    {
+      if (errors[i])
+        { std::rethrow_exception(errors[i]); }
+    }
+}
+
 void RuleContainer::store
 (HfstOutputStream &out,std::ostream &msg_out,bool be_verbose)
 {
@@ -39,6 +39,16 @@ class RuleContainer
   virtual void add_rule(Rule * rule);
   virtual ~RuleContainer(void);
   void compile(std::ostream &msg_out,bool be_verbose);
+
+  //! @brief Compile the rules of all @a containers using @a jobs threads.
+  //!
+  //! Rules are independent of each other, so their compilation order
+  //! does not affect the result. Each worker takes the next uncompiled
+  //! rule until none remain. If a rule throws, the exception of the
+  //! first such rule is rethrown once all workers have finished.
+  static void compile(const std::vector<RuleContainer*> &containers,
+                      std::ostream &msg_out,bool be_verbose,
+                      unsigned int jobs);
   void store(HfstOutputStream &out,std::ostream &msg_out,bool be_verbose);
   void add_missing_symbols_freely(const SymbolRange &diacritics);
 };
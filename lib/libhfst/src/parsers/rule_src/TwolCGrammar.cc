@@ -24,7 +24,8 @@ TwolCGrammar::TwolCGrammar(bool be_quiet,
                            bool resolve_left_conflicts,
                            bool resolve_right_conflicts):
   be_quiet(be_quiet),
-  be_verbose(be_verbose)
+  be_verbose(be_verbose),
+  jobs(1)
 {
   left_arrow_rule_container.set_report_left_arrow_conflicts(! be_quiet);
   left_arrow_rule_container.set_resolve_left_arrow_conflicts
@@ -35,6 +36,9 @@ TwolCGrammar::TwolCGrammar(bool be_quiet,
     (resolve_right_conflicts);
 }
 
+void TwolCGrammar::set_jobs(unsigned int jobs)
+{ this->jobs = jobs; }
+
 void TwolCGrammar::define_diacritics(const SymbolRange &diacritics)
 {
   this->diacritics = diacritics;
@@ -63,7 +67,7 @@ void TwolCGrammar::add_rule(const std::string &name,
       rule = new ConflictResolvingRightArrowRule(name,center,contexts);
       right_arrow_rule_container.add_rule_and_display_and_resolve_conflicts
     (static_cast<ConflictResolvingRightArrowRule*>(rule),std::cerr);
-      name_to_rule_subcases[get_original_name(name)].insert(rule);
+      name_to_rule_subcases[get_original_name(name)].push_back(rule);
       rule = new ConflictResolvingLeftArrowRule(name,center,contexts);
       left_arrow_rule_container.add_rule_and_display_and_resolve_conflicts
     (static_cast<ConflictResolvingLeftArrowRule*>(rule),std::cerr);
@@ -76,7 +80,7 @@ void TwolCGrammar::add_rule(const std::string &name,
     default:
       assert(false);
     }
-  name_to_rule_subcases[get_original_name(name)].insert(rule);
+  name_to_rule_subcases[get_original_name(name)].push_back(rule);
 }
 
 void TwolCGrammar::add_rule(const std::string &name,
@@ -103,7 +107,7 @@ void TwolCGrammar::add_rule(const std::string &name,
       rule = new RightArrowRule(name,center_fst,contexts);
       other_rule_container.add_rule
     (static_cast<RightArrowRule*>(rule));
-      name_to_rule_subcases[get_original_name(name)].insert(rule);
+      name_to_rule_subcases[get_original_name(name)].push_back(rule);
       rule = new LeftArrowRule(name,center_fst,contexts);
       other_rule_container.add_rule
     (static_cast<LeftArrowRule*>(rule));
@@ -116,7 +120,7 @@ void TwolCGrammar::add_rule(const std::string &name,
     default:
       assert(false);
     }
-  name_to_rule_subcases[get_original_name(name)].insert(rule);
+  name_to_rule_subcases[get_original_name(name)].push_back(rule);
 }
 
 void TwolCGrammar::add_rule(const std::string &name,
@@ -153,7 +157,7 @@ void TwolCGrammar::add_rule(const std::string &name,
           rule = new ConflictResolvingRightArrowRule(center_name,*it,contexts);
           right_arrow_rule_container.add_rule_and_display_and_resolve_conflicts
             (static_cast<ConflictResolvingRightArrowRule*>(rule),std::cerr);
-          name_to_rule_subcases[get_original_name(center_name)].insert(rule);
+          name_to_rule_subcases[get_original_name(center_name)].push_back(rule);
 
           rule = new ConflictResolvingLeftArrowRule(center_name,*it,contexts);
           left_arrow_rule_container.add_rule_and_display_and_resolve_conflicts
@@ -168,7 +172,7 @@ void TwolCGrammar::add_rule(const std::string &name,
           assert(false);
         }
       
-      name_to_rule_subcases[get_original_name(center_name)].insert(rule);
+      name_to_rule_subcases[get_original_name(center_name)].push_back(rule);
     }
 
 }
@@ -178,9 +182,19 @@ void TwolCGrammar::compile_and_store(HfstOutputStream &out)
   if (! be_quiet)
     { std::cerr << "Compiling rules." << std::endl; }
 
-  left_arrow_rule_container.compile(std::cerr,(! be_quiet) && be_verbose);
-  right_arrow_rule_container.compile(std::cerr,(! be_quiet) && be_verbose);
-  other_rule_container.compile(std::cerr,(! be_quiet) && be_verbose);
+  // SFST and foma keep global state, so only OpenFst transducers
+  // can be compiled in parallel.
+  ImplementationType type = OtherSymbolTransducer::get_transducer_type();
+  unsigned int compile_jobs =
+    (type == hfst::TROPICAL_OPENFST_TYPE || type == hfst::LOG_OPENFST_TYPE) ?
+    jobs : 1;
+
+  std::vector<RuleContainer*> containers;
+  containers.push_back(&left_arrow_rule_container);
+  containers.push_back(&right_arrow_rule_container);
+  containers.push_back(&other_rule_container);
+  RuleContainer::compile(containers,std::cerr,(! be_quiet) && be_verbose,
+                         compile_jobs);
 
   for (StringRuleSetMap::const_iterator it = name_to_rule_subcases.begin();
        it != name_to_rule_subcases.end();
@@ -48,10 +48,13 @@ namespace op
 class TwolCGrammar
 {
  protected:
-  typedef HandySet<Rule*> RuleSet;
+  // Subcases are kept in the order they were added, so that the rules
+  // they make up are compiled the same way on every run.
+  typedef Rule::RuleVector RuleSet;
   typedef HandyMap<std::string,RuleSet> StringRuleSetMap;
   bool be_quiet;
   bool be_verbose;
+  unsigned int jobs;
   StringRuleSetMap name_to_rule_subcases;
 
   LeftArrowRuleContainer left_arrow_rule_container;
@@ -70,6 +73,12 @@ class TwolCGrammar
                bool resolve_left_conflicts,
                bool resolve_right_conflicts);
   void define_diacritics(const SymbolRange &diacritics);
+
+  //! @brief Compile rules using @a jobs threads.
+  //!
+  //! Only the OpenFst transducer types can be used from several
+  //! threads, for other types rules are always compiled one at a time.
+  void set_jobs(unsigned int jobs);
   void add_rule(const std::string &name,
         const SymbolPair &center,
         op::OPERATOR oper,
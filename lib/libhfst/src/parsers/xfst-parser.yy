@@ -100,8 +100,8 @@ XFST_SCRIPT: COMMAND_LIST
            | COMMAND_LIST CTRLD
            ;
 
-COMMAND_LIST: COMMAND_LIST COMMAND
-            | COMMAND
+COMMAND_LIST: COMMAND_LIST COMMAND { hfst::xfst::xfst_->end_command(); }
+            | COMMAND { hfst::xfst::xfst_->end_command(); }
             ;
 
 COMMAND: ADD_PROPS REDIRECT_IN END_COMMAND {
@@ -1710,6 +1710,17 @@ class HfstTransducer:
     def lookup(self, input, kwargs):
         pass
 
+    ## Lookup each string in \a inputs.
+    # @param inputs A list of inputs, each a string or a pre-tokenized tuple of strings.
+    # @param kwargs Possible parameters and their default values are: obey_flags=True,
+    #               max_number=-1, time_cutoff=0.0, jobs=0
+    # @param jobs The number of threads used for the lookups, defaults to 0, i.e. one per core.
+    # @return A list that has for each input a tuple of (output, weight) pairs, as returned by #lookup.
+    # @note The global interpreter lock is released during the lookups, so other Python
+    #       threads can run meanwhile.
+    def lookup_many(self, inputs, kwargs):
+        pass
+
     ## Optimize the transducer for lookup.
     # This effectively converts the transducer into #hfst.ImplementationType.HFST_OL_TYPE.
     def lookup_optimize(self):
@@ -2383,6 +2394,11 @@ class PmatchContainer:
   ## Match input \a input.
   def match(self, input, time_cutoff = 0):
       pass
+  ## Tokenize each string in \a inputs.
+  # @return A list that has for each input a tuple of its tokens.
+  # @note The global interpreter lock is released during tokenization.
+  def tokenize_many(self, inputs):
+      pass
   ## todo
   def get_profiling_info(self):
       pass
@@ -1,5 +1,37 @@
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 namespace hfst {
 
+/* Releases the global interpreter lock for the lifetime of the object, so
+   that other Python threads can run while a lookup is in progress. No Python
+   API may be used while the lock is released. */
+class GilReleaser
+{
+ public:
+  GilReleaser(): state(PyEval_SaveThread()) {}
+  ~GilReleaser() { PyEval_RestoreThread(state); }
+ private:
+  PyThreadState * state;
+  GilReleaser(const GilReleaser &);
+  GilReleaser & operator=(const GilReleaser &);
+};
+
+/* Optimized-lookup transducers and pmatch containers keep the state of the
+   current search in the object itself, so two threads must not search with
+   the same object at the same time. Objects are mapped to a fixed number of
+   mutexes by their address. */
+std::mutex & lookup_mutex(const void * object)
+{
+  static std::mutex mutexes[64];
+  return mutexes[(reinterpret_cast<size_t>(object) >> 4) % 64];
+}
+
 std::string one_level_paths_to_string(const hfst::HfstOneLevelPaths & paths)
 {
     std::ostringstream oss;
@@ -48,19 +80,50 @@ std::string two_level_paths_to_string(const hfst::HfstTwoLevelPaths & paths)
 
 // *** Wrappers for lookup functions *** //
 
+bool is_optimized_lookup(const hfst::HfstTransducer * tr)
+{
+  return tr->get_type() == hfst::HFST_OL_TYPE || tr->get_type() == hfst::HFST_OLW_TYPE;
+}
+
+HfstOneLevelPaths optimized_lookup(const hfst::HfstTransducer * tr, bool fd, const StringVector& s, int limit, double time_cutoff)
+{
+  HfstOneLevelPaths *res_ptr = \
+    fd ? tr->lookup_fd(s, limit, time_cutoff) : tr->lookup(s, limit, time_cutoff);
+  HfstOneLevelPaths res = *res_ptr;
+  delete res_ptr;
+  return res;
+}
+
+HfstOneLevelPaths optimized_lookup(const hfst::HfstTransducer * tr, bool fd, const std::string& s, int limit, double time_cutoff)
+{
+  HfstOneLevelPaths *res_ptr = \
+    fd ? tr->lookup_fd(s, limit, time_cutoff) : tr->lookup(s, limit, time_cutoff);
+  HfstOneLevelPaths res = *res_ptr;
+  delete res_ptr;
+  return res;
+}
+
+/* HfstTokenizer cannot be copied, so it is filled in place. */
+void add_input_symbols(hfst::HfstTokenizer & tok, const hfst::HfstBasicTransducer & fsm)
+{
+  hfst::StringSet alpha = fsm.get_input_symbols();
+  for (hfst::StringSet::const_iterator it = alpha.begin(); it != alpha.end(); it++)
+    { tok.add_multichar_symbol(*it); }
+}
+
 HfstOneLevelPaths lookup_vector(const hfst::HfstTransducer * tr, bool fd, const StringVector& s, int limit = -1, double time_cutoff = 0.0) throw(TransducerIsCyclicException, FunctionNotImplementedException)
 {
-  if (tr->get_type() == hfst::HFST_OL_TYPE || tr->get_type() == hfst::HFST_OLW_TYPE)
+  GilReleaser gil;
+  if (is_optimized_lookup(tr))
     {
-      HfstOneLevelPaths *res_ptr = \
-        fd ? tr->lookup_fd(s, limit, time_cutoff) : tr->lookup(s, limit, time_cutoff);
-      HfstOneLevelPaths res = *res_ptr;
-      delete res_ptr;
-      return res;
+      std::lock_guard<std::mutex> lock(lookup_mutex(tr));
+      return optimized_lookup(tr, fd, s, limit, time_cutoff);
     }
 
   hfst::HfstTwoLevelPaths result;
+  std::unique_lock<std::mutex> lock(lookup_mutex(tr));
   hfst::HfstBasicTransducer fsm(*tr);
+  lock.unlock();
   (void)time_cutoff;
   fsm.lookup(s, result, NULL, NULL, limit, fd);
   return hfst::extract_output_side(result);
@@ -68,19 +131,17 @@ HfstOneLevelPaths lookup_vector(const hfst::HfstTransducer * tr, bool fd, const
 
 HfstOneLevelPaths lookup_string(const hfst::HfstTransducer * tr, bool fd, const std::string& s, int limit = -1, double time_cutoff = 0.0) throw(TransducerIsCyclicException, FunctionNotImplementedException)
 {
-  if (tr->get_type() == hfst::HFST_OL_TYPE || tr->get_type() == hfst::HFST_OLW_TYPE)
+  GilReleaser gil;
+  if (is_optimized_lookup(tr))
     {
-      HfstOneLevelPaths *res_ptr = \
-        fd ? tr->lookup_fd(s, limit, time_cutoff) : tr->lookup(s, limit, time_cutoff);
-      HfstOneLevelPaths res = *res_ptr;
-      delete res_ptr;
-      return res;
+      std::lock_guard<std::mutex> lock(lookup_mutex(tr));
+      return optimized_lookup(tr, fd, s, limit, time_cutoff);
     }
+  std::unique_lock<std::mutex> lock(lookup_mutex(tr));
   hfst::HfstBasicTransducer fsm(*tr);
-  hfst::StringSet alpha = fsm.get_input_symbols();
+  lock.unlock();
   hfst::HfstTokenizer tok;
-  for (hfst::StringSet::const_iterator it = alpha.begin(); it != alpha.end(); it++)
-    { tok.add_multichar_symbol(*it); }
+  add_input_symbols(tok, fsm);
   StringVector sv = tok.tokenize_one_level(s);
   hfst::HfstTwoLevelPaths result;
   (void)time_cutoff;
@@ -88,4 +149,302 @@ HfstOneLevelPaths lookup_string(const hfst::HfstTransducer * tr, bool fd, const
   return hfst::extract_output_side(result);
 }
 
+// *** Batched lookup *** //
+
+/* Fewer inputs than this per thread are not worth starting a thread for. */
+const size_t MIN_INPUTS_PER_LOOKUP_THREAD = 256;
+
+/* Inputs are taken by the threads in chunks of this size. */
+const size_t LOOKUP_CHUNK_SIZE = 64;
+
+/* Threads that lookup_many keeps from one call to the next, so that a
+   batch does not pay for starting threads. One batch runs on the pool at a
+   time; a call made while it is busy does its work on the calling thread. */
+class LookupThreadPool
+{
+ public:
+  static LookupThreadPool & get()
+  {
+    static LookupThreadPool pool;
+    return pool;
+  }
+
+  /* Call TASK(0) on the calling thread and TASK(1) ... TASK(COUNT - 1) on
+     threads of the pool, and return when all of them have returned. TASK
+     must not throw. */
+  void run(size_t count, const std::function<void(size_t)> & task)
+  {
+    std::unique_lock<std::mutex> busy(run_mutex, std::try_to_lock);
+    if (count <= 1 || ! busy.owns_lock())
+      {
+        task(0);
+        return;
+      }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      while (threads.size() < count - 1)
+        threads.push_back(std::thread(&LookupThreadPool::work, this));
+      current_task = &task;
+      next_index = 1;
+      task_count = count;
+      running = count - 1;
+      ++generation;
+    }
+    work_ready.notify_all();
+    task(0);
+    std::unique_lock<std::mutex> lock(mutex);
+    work_done.wait(lock, [this]() { return running == 0; });
+  }
+
+  ~LookupThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    work_ready.notify_all();
+    for (size_t i = 0; i < threads.size(); i++)
+      threads[i].join();
+  }
+
+ private:
+  std::mutex run_mutex;
+  std::mutex mutex;
+  std::condition_variable work_ready;
+  std::condition_variable work_done;
+  std::vector<std::thread> threads;
+  const std::function<void(size_t)> * current_task;
+  size_t next_index;
+  size_t task_count;
+  size_t running;
+  unsigned long generation;
+  bool stopping;
+
+  LookupThreadPool():
+    current_task(NULL), next_index(0), task_count(0), running(0),
+    generation(0), stopping(false) {}
+  LookupThreadPool(const LookupThreadPool &);
+  LookupThreadPool & operator=(const LookupThreadPool &);
+
+  /* Each thread takes at most one index of each batch. */
+  void work()
+  {
+    unsigned long seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+      {
+        work_ready.wait(lock, [&]() { return stopping || generation != seen; });
+        if (stopping)
+          return;
+        seen = generation;
+        if (next_index >= task_count)
+          continue;
+        size_t index = next_index++;
+        const std::function<void(size_t)> & task = *current_task;
+        lock.unlock();
+        task(index);
+        lock.lock();
+        if (--running == 0)
+          work_done.notify_all();
+      }
+  }
+};
+
+/* One input of lookup_many: a string, or a tuple of symbols if
+   pre_tokenized is set. */
+struct LookupInput
+{
+  bool pre_tokenized;
+  std::string string;
+  StringVector symbols;
+};
+
+/* Copy the inputs out of the Python sequence INPUTS while the interpreter
+   lock is still held. Returns false with a Python exception set if an
+   input is neither a string nor a tuple of strings. */
+bool get_lookup_inputs(PyObject * inputs, std::vector<LookupInput> & result)
+{
+  PyObject * seq = PySequence_Fast(inputs, "lookup_many: inputs must be a sequence");
+  if (seq == NULL)
+    return false;
+  Py_ssize_t size = PySequence_Fast_GET_SIZE(seq);
+  result.resize(size);
+  for (Py_ssize_t i = 0; i < size; i++)
+    {
+      PyObject * item = PySequence_Fast_GET_ITEM(seq, i);
+      if (PyUnicode_Check(item))
+        {
+          const char * str = PyUnicode_AsUTF8(item);
+          if (str == NULL)
+            { Py_DECREF(seq); return false; }
+          result[i].pre_tokenized = false;
+          result[i].string = str;
+          continue;
+        }
+      if (PyTuple_Check(item))
+        {
+          result[i].pre_tokenized = true;
+          for (Py_ssize_t j = 0; j < PyTuple_GET_SIZE(item); j++)
+            {
+              PyObject * symbol = PyTuple_GET_ITEM(item, j);
+              const char * str = PyUnicode_Check(symbol) ? PyUnicode_AsUTF8(symbol) : NULL;
+              if (str == NULL)
+                {
+                  if (! PyErr_Occurred())
+                    PyErr_SetString(PyExc_TypeError, "lookup_many: a tuple of symbols must contain only strings");
+                  Py_DECREF(seq);
+                  return false;
+                }
+              result[i].symbols.push_back(str);
+            }
+          continue;
+        }
+      PyErr_SetString(PyExc_TypeError, "lookup_many: each input must be a string or a tuple of strings");
+      Py_DECREF(seq);
+      return false;
+    }
+  Py_DECREF(seq);
+  return true;
+}
+
+/* Build a tuple of (output, weight) pairs in the order of PATHS. */
+PyObject * one_level_paths_to_python(const HfstOneLevelPaths & paths)
+{
+  PyObject * result = PyTuple_New(paths.size());
+  if (result == NULL)
+    return NULL;
+  Py_ssize_t index = 0;
+  for (HfstOneLevelPaths::const_iterator it = paths.begin(); it != paths.end(); it++, index++)
+    {
+      std::string output;
+      for (StringVector::const_iterator svit = it->second.begin(); svit != it->second.end(); svit++)
+        output += *svit;
+      PyObject * str = PyUnicode_DecodeUTF8(output.c_str(), output.size(), "surrogateescape");
+      PyObject * weight = PyFloat_FromDouble(it->first);
+      PyObject * pair = (str == NULL || weight == NULL) ? NULL : PyTuple_Pack(2, str, weight);
+      Py_XDECREF(str);
+      Py_XDECREF(weight);
+      if (pair == NULL)
+        { Py_DECREF(result); return NULL; }
+      PyTuple_SET_ITEM(result, index, pair);
+    }
+  return result;
+}
+
+/* Look up each string or tuple of symbols in INPUTS and return a list that
+   has for each input a tuple of (output, weight) pairs. The interpreter lock
+   is released during the lookups, which are divided among JOBS threads
+   (0 means one per core) of a pool that is kept between calls. */
+PyObject * lookup_many(const hfst::HfstTransducer * tr, PyObject * inputs, bool fd, int limit, double time_cutoff, unsigned int jobs) throw(TransducerIsCyclicException, FunctionNotImplementedException)
+{
+  std::vector<LookupInput> lookup_inputs;
+  if (! get_lookup_inputs(inputs, lookup_inputs))
+    return NULL;
+
+  size_t size = lookup_inputs.size();
+  std::vector<HfstOneLevelPaths> results(size);
+  std::exception_ptr error;
+  {
+    GilReleaser gil;
+    if (jobs == 0)
+      jobs = std::max(1u, std::thread::hardware_concurrency());
+    size_t threads = std::min<size_t>(jobs, size / MIN_INPUTS_PER_LOOKUP_THREAD);
+    if (threads == 0)
+      threads = 1;
+
+    // TR is locked for the whole batch, because the copies share its
+    // tables. The first thread searches with TR itself and the others
+    // with copies that have a search state of their own. Non-optimized
+    // transducers are converted only once.
+    std::lock_guard<std::mutex> lock(lookup_mutex(tr));
+    bool optimized = is_optimized_lookup(tr);
+    std::vector<std::unique_ptr<hfst_ol::Transducer> > copies;
+    std::vector<hfst::HfstBasicTransducer> fsms;
+    hfst::HfstTokenizer tokenizer;
+    try
+      {
+        if (optimized)
+          {
+            while (copies.size() + 1 < threads)
+              copies.push_back(std::unique_ptr<hfst_ol::Transducer>(tr->create_lookup_copy()));
+          }
+        else
+          {
+            fsms.reserve(threads);
+            fsms.push_back(hfst::HfstBasicTransducer(*tr));
+            add_input_symbols(tokenizer, fsms[0]);
+            while (fsms.size() < threads)
+              fsms.push_back(fsms[0]);
+          }
+      }
+    catch (...)
+      {
+        error = std::current_exception();
+        threads = 0;
+      }
+
+    std::atomic<size_t> next_chunk(0);
+    std::vector<std::exception_ptr> errors(threads);
+    std::function<void(size_t)> look_up = [&](size_t thread)
+      {
+        try
+          {
+            for (size_t chunk = next_chunk++; chunk * LOOKUP_CHUNK_SIZE < size; chunk = next_chunk++)
+              {
+                size_t end = std::min(size, (chunk + 1) * LOOKUP_CHUNK_SIZE);
+                for (size_t i = chunk * LOOKUP_CHUNK_SIZE; i < end; i++)
+                  {
+                    const LookupInput & input = lookup_inputs[i];
+                    if (optimized && thread == 0)
+                      {
+                        results[i] = input.pre_tokenized ?
+                          optimized_lookup(tr, fd, input.symbols, limit, time_cutoff) :
+                          optimized_lookup(tr, fd, input.string, limit, time_cutoff);
+                      }
+                    else if (optimized)
+                      {
+                        // Lookup of a copy always obeys flag diacritics,
+                        // as HfstTransducer::lookup does.
+                        hfst_ol::Transducer & copy = *copies[thread - 1];
+                        std::unique_ptr<HfstOneLevelPaths> paths(input.pre_tokenized ?
+                          copy.lookup_fd(input.symbols, limit, time_cutoff) :
+                          copy.lookup_fd(input.string, limit, time_cutoff));
+                        results[i] = *paths;
+                      }
+                    else
+                      {
+                        hfst::HfstTwoLevelPaths paths;
+                        fsms[thread].lookup(input.pre_tokenized ? input.symbols : tokenizer.tokenize_one_level(input.string),
+                                            paths, NULL, NULL, limit, fd);
+                        results[i] = hfst::extract_output_side(paths);
+                      }
+                  }
+              }
+          }
+        catch (...)
+          {
+            errors[thread] = std::current_exception();
+          }
+      };
+    if (threads > 0)
+      LookupThreadPool::get().run(threads, look_up);
+    for (size_t i = 0; i < errors.size() && ! error; i++)
+      error = errors[i];
+  }
+  if (error)
+    std::rethrow_exception(error);
+
+  PyObject * result = PyList_New(size);
+  if (result == NULL)
+    return NULL;
+  for (size_t i = 0; i < size; i++)
+    {
+      PyObject * paths = one_level_paths_to_python(results[i]);
+      if (paths == NULL)
+        { Py_DECREF(result); return NULL; }
+      PyList_SET_ITEM(result, i, paths);
+    }
+  return result;
+}
+
 }
@@ -5,6 +5,8 @@ namespace hfst
    const std::string & input,
    double time_cutoff = 0.0)
   {
+    GilReleaser gil;
+    std::lock_guard<std::mutex> lock(lookup_mutex(cont));
     return cont->locate(input, time_cutoff);
   }
 
@@ -14,10 +16,74 @@ namespace hfst
    double time_cutoff,
    float weight_cutoff)
   {
+    GilReleaser gil;
+    std::lock_guard<std::mutex> lock(lookup_mutex(cont));
     return cont->locate(input, time_cutoff, weight_cutoff);
   }
 
-  std::ostringstream pmatch_tokenize_ostringstream;
+  /* Tokenize each string in INPUTS and return a list that has for each
+     input a tuple of its matched tokens. All inputs are processed in one
+     call with the interpreter lock released. A container cannot be copied,
+     so the inputs are processed one after another; separate containers
+     can be used from separate Python threads. */
+  PyObject * pmatch_tokenize_many
+  (hfst_ol::PmatchContainer * cont,
+   PyObject * inputs)
+  {
+    PyObject * seq = PySequence_Fast(inputs, "tokenize_many: inputs must be a sequence");
+    if (seq == NULL)
+      return NULL;
+    std::vector<std::string> strings;
+    for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(seq); i++)
+      {
+        PyObject * item = PySequence_Fast_GET_ITEM(seq, i);
+        const char * str = PyUnicode_Check(item) ? PyUnicode_AsUTF8(item) : NULL;
+        if (str == NULL)
+          {
+            if (! PyErr_Occurred())
+              PyErr_SetString(PyExc_TypeError, "tokenize_many: each input must be a string");
+            Py_DECREF(seq);
+            return NULL;
+          }
+        strings.push_back(str);
+      }
+    Py_DECREF(seq);
+
+    std::vector<std::vector<std::string> > tokens(strings.size());
+    {
+      GilReleaser gil;
+      std::lock_guard<std::mutex> lock(lookup_mutex(cont));
+      for (size_t i = 0; i < strings.size(); i++)
+        {
+          hfst_ol::LocationVectorVector locations = cont->locate(strings[i]);
+          for (hfst_ol::LocationVectorVector::const_iterator it = locations.begin();
+               it != locations.end(); it++)
+            {
+              if (it->size() > 0 && it->at(0).output != "@_NONMATCHING_@")
+                tokens[i].push_back(it->at(0).input);
+            }
+        }
+    }
+
+    PyObject * result = PyList_New(tokens.size());
+    if (result == NULL)
+      return NULL;
+    for (size_t i = 0; i < tokens.size(); i++)
+      {
+        PyObject * tuple = PyTuple_New(tokens[i].size());
+        if (tuple == NULL)
+          { Py_DECREF(result); return NULL; }
+        PyList_SET_ITEM(result, i, tuple);
+        for (size_t j = 0; j < tokens[i].size(); j++)
+          {
+            PyObject * token = PyUnicode_DecodeUTF8(tokens[i][j].c_str(), tokens[i][j].size(), "surrogateescape");
+            if (token == NULL)
+              { Py_DECREF(result); return NULL; }
+            PyTuple_SET_ITEM(tuple, j, token);
+          }
+      }
+    return result;
+  }
 
   std::string pmatch_get_tokenized_output
   (hfst_ol::PmatchContainer * cont,
@@ -32,7 +98,6 @@ namespace hfst
    float beam,
    bool tokenize_multichar)
   {
-    pmatch_tokenize_ostringstream.str("");
     hfst_ol_tokenize::TokenizeSettings settings;
     if (output_format == "tokenize")
       settings.output_format=hfst_ol_tokenize::OutputFormat::tokenize;
@@ -61,7 +126,10 @@ namespace hfst
     settings.verbose = verbose;
     settings.beam = beam;
     settings.tokenize_multichar = tokenize_multichar;
-    hfst_ol_tokenize::match_and_print(*cont, pmatch_tokenize_ostringstream, input_text, settings);
-    return pmatch_tokenize_ostringstream.str();
+    std::ostringstream oss;
+    GilReleaser gil;
+    std::lock_guard<std::mutex> lock(lookup_mutex(cont));
+    hfst_ol_tokenize::match_and_print(*cont, oss, input_text, settings);
+    return oss.str();
   }
 }
@@ -24,6 +24,10 @@
 // We want warnings to be printed to standard error.
 %init %{
     hfst::set_warning_stream(&std::cerr);
+#if PY_VERSION_HEX < 0x03070000
+    // lookups release the global interpreter lock
+    PyEval_InitThreads();
+#endif
 %}
 
 // Make swig aware of what hfst offers.
@@ -54,10 +58,11 @@ namespace hfst { typedef std::pair<hfst::HfstTransducer*,unsigned int> HfstTrans
 #include "hfst_extensions.cpp"
 #include "hfst_lexc_extensions.cpp"
 #include "hfst_xfst_extensions.cpp"
+// The pmatch extensions use GilReleaser and lookup_mutex from here.
+#include "hfst_lookup_extensions.cpp"
 #include "hfst_pmatch_extensions.cpp"
 #include "hfst_pmatch_tokenize_extensions.cpp"
 #include "hfst_sfst_extensions.cpp"
-#include "hfst_lookup_extensions.cpp"
 #include "hfst_rules_extensions.cpp"
 #include "hfst_prolog_extensions.cpp"
 %}
@@ -344,7 +349,6 @@ public:
   bool is_cyclic() const;
   bool is_automaton() const;
   bool is_infinitely_ambiguous() const;
-  bool is_lookup_infinitely_ambiguous(const std::string &) const;
   bool has_flag_diacritics() const;
   void insert_to_alphabet(const std::string &);
   void remove_from_alphabet(const std::string &);
@@ -367,12 +371,12 @@ public:
   void shuffle(const HfstTransducer &another, bool harmonize=true) { self->shuffle(another, harmonize); }
   void remove_epsilons() { self->remove_epsilons(); }
   void determinize() { self->determinize(); }
-  void minimize() { self->minimize(); }
+  void minimize() { std::lock_guard<std::mutex> lock(hfst::lookup_mutex(self)); self->minimize(); }
   void prune() { self->prune(); }
   void eliminate_flags() { self->eliminate_flags(); }
   void eliminate_flag(const std::string& f) throw(HfstException) { self->eliminate_flag(f); }
   void n_best(unsigned int n) { self->n_best(n); }
-  void convert(ImplementationType impl) { self->convert(impl); }
+  void convert(ImplementationType impl) { std::lock_guard<std::mutex> lock(hfst::lookup_mutex(self)); self->convert(impl); }
   void repeat_star() { self->repeat_star(); }
   void repeat_plus() { self->repeat_plus(); }
   void repeat_n(unsigned int n) { self->repeat_n(n); }
@@ -404,8 +408,12 @@ public:
 
   // Then the actual extensions:
 
-  void lookup_optimize() { self->convert(hfst::HFST_OLW_TYPE); }
-  void remove_optimization() { self->convert(hfst::get_default_fst_type()); }
+  void lookup_optimize() { std::lock_guard<std::mutex> lock(hfst::lookup_mutex(self)); self->convert(hfst::HFST_OLW_TYPE); }
+  void remove_optimization() { std::lock_guard<std::mutex> lock(hfst::lookup_mutex(self)); self->convert(hfst::get_default_fst_type()); }
+
+  // Lookups run without the interpreter lock. Like minimize and convert
+  // above, this waits for lookups of the transducer in other threads.
+  bool is_lookup_infinitely_ambiguous(const std::string & s) const { std::lock_guard<std::mutex> lock(hfst::lookup_mutex(self)); return self->is_lookup_infinitely_ambiguous(s); }
 
     HfstTransducer() { return hfst::empty_transducer(); }
     HfstTransducer(const hfst::HfstTransducer & t) { return hfst::copy_hfst_transducer(t); }
@@ -481,6 +489,10 @@ public:
     {
       return hfst::lookup_string($self, false /*fd*/, s, limit, time_cutoff);
     }
+    PyObject * _lookup_many(PyObject * inputs, bool fd, int limit = -1, double time_cutoff = 0.0, unsigned int jobs = 1) const throw(TransducerIsCyclicException, FunctionNotImplementedException)
+    {
+      return hfst::lookup_many($self, inputs, fd, limit, time_cutoff, jobs);
+    }
 
 %pythoncode %{
 
@@ -617,6 +629,9 @@ public:
           else:
              print('Warning: ignoring unknown argument %s.' % (k))
 
+      if output == 'tuple' and isinstance(input, (str, tuple)):
+         return self._lookup_many((input,), obey_flags, max_number, time_cutoff)[0]
+
       retval=0
 
       if isinstance(input, tuple):
@@ -645,6 +660,56 @@ public:
       else:
          return retval
 
+  def lookup_many(self, inputs, **kwargs):
+      """
+      Lookup each string in *inputs*.
+
+      Parameters
+      ----------
+      * `inputs` :
+          A list of inputs. Each input is a string or a pre-tokenized tuple of symbols.
+      * `kwargs` :
+          Possible parameters and their default values are: obey_flags=True,
+          max_number=-1, time_cutoff=0.0, jobs=0
+      * `obey_flags` :
+          Whether flag diacritics are obeyed. Always True for HFST_OL(W)_TYPE transducers.
+      * `max_number` :
+          Maximum number of results returned for each input, defaults to -1, i.e. infinity.
+      * `time_cutoff` :
+          How long the function can search for results for each input, expressed in
+          seconds. Defaults to 0.0, i.e. infinitely. Always 0.0 for transducers that are
+          not of HFST_OL(W)_TYPE.
+      * `jobs` :
+          The number of threads used for the lookups, defaults to 0, i.e. one per core.
+          Small batches are looked up in fewer threads.
+
+      Returns a list that has for each input a tuple of (output, weight) pairs, in the
+      same form as lookup(input) returns them.
+
+      The lookups are done without holding the global interpreter lock, so other
+      Python threads can run meanwhile.
+      """
+      obey_flags=True
+      max_number=-1
+      time_cutoff=0.0
+      jobs=0
+
+      for k,v in kwargs.items():
+          if k == 'obey_flags':
+             obey_flags = bool(v)
+          elif k == 'max_number' :
+             max_number=v
+          elif k == 'time_cutoff' :
+             time_cutoff=v
+          elif k == 'jobs' :
+             if v < 0:
+                raise RuntimeError('jobs must not be negative.')
+             jobs=v
+          else:
+             print('Warning: ignoring unknown argument %s.' % (k))
+
+      return self._lookup_many(inputs, obey_flags, max_number, time_cutoff, jobs)
+
   def extract_longest_paths(self, **kwargs):
       """
       Extract longest paths of the transducer.
@@ -1731,6 +1796,10 @@ namespace hfst_ol {
 	    {
 	      return hfst::pmatch_locate(self, input, time_cutoff, weight_cutoff);
 	    };
+	  PyObject * _tokenize_many(PyObject * inputs)
+	    {
+	      return hfst::pmatch_tokenize_many(self, inputs);
+	    };
 %pythoncode %{
   def get_tokenized_output(self, input, **kwargs):
       """
@@ -1810,12 +1879,21 @@ namespace hfst_ol {
       * `input` :
           The string to be tokenized.
       """
-      retval = []
-      locations = self.locate(input)
-      for loc in locations:
-         if loc[0].output != "@_NONMATCHING_@":
-            retval.append(loc[0].input)
-      return retval
+      return list(self._tokenize_many((input,))[0])
+
+  def tokenize_many(self, inputs):
+      """
+      Tokenize each string in *inputs*.
+
+      Parameters
+      ----------
+      * `inputs` :
+          A list of strings to be tokenized.
+
+      Returns a list that has for each input a tuple of its tokens. All inputs are
+      tokenized without holding the global interpreter lock.
+      """
+      return self._tokenize_many(inputs)
 
 %}
 
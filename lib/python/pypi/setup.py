@@ -200,6 +200,8 @@ libhfst_source_files = ["libhfst/src/parsers/XfstCompiler" + cpp,
                         "libhfst/src/HfstDataTypes" + cpp,
                         "libhfst/src/HfstSymbolDefs" + cpp,
                         "libhfst/src/HfstTokenizer" + cpp,
+                        "libhfst/src/HfstCompilationCache" + cpp,
+                        "libhfst/src/HfstSpillStore" + cpp,
                         "libhfst/src/HfstFlagDiacritics" + cpp,
                         "libhfst/src/HfstExceptionDefs" + cpp,
                         "libhfst/src/HarmonizeUnknownAndIdentitySymbols" + cpp,
@@ -212,6 +214,9 @@ libhfst_source_files = ["libhfst/src/parsers/XfstCompiler" + cpp,
                         "libhfst/src/string-utils" + cpp,
                         "libhfst/src/implementations/HfstBasicTransducer" + cpp,
                         "libhfst/src/implementations/HfstBasicTransition" + cpp,
+                        "libhfst/src/implementations/HfstTrieBuilder" + cpp,
+                        "libhfst/src/implementations/HfstLexiconBuilder" + cpp,
+                        "libhfst/src/implementations/HfstSymbolInterner" + cpp,
                         "libhfst/src/implementations/ConvertTransducerFormat" + cpp,
                         "libhfst/src/implementations/HfstTropicalTransducerTransitionData" + cpp,
                         "libhfst/src/implementations/ConvertTropicalWeightTransducer" + cpp,
@@ -219,6 +224,7 @@ libhfst_source_files = ["libhfst/src/parsers/XfstCompiler" + cpp,
                         "libhfst/src/implementations/ConvertFomaTransducer" + cpp,
                         "libhfst/src/implementations/ConvertOlTransducer" + cpp,
                         "libhfst/src/implementations/TropicalWeightTransducer" + cpp,
+                        "libhfst/src/implementations/TropicalWeightTransducerParallel" + cpp,
                         "libhfst/src/implementations/LogWeightTransducer" + cpp,
                         "libhfst/src/implementations/FomaTransducer" + cpp,
                         "libhfst/src/implementations/HfstOlTransducer" + cpp,
@@ -233,6 +239,7 @@ libhfst_source_files = ["libhfst/src/parsers/XfstCompiler" + cpp,
                         "libhfst/src/implementations/optimized-lookup/pmatch" + cpp,
                         "libhfst/src/implementations/optimized-lookup/pmatch_tokenize" + cpp,
                         "libhfst/src/implementations/optimized-lookup/find_epsilon_loops" + cpp,
+                        "libhfst/src/implementations/optimized-lookup/cascade" + cpp,
                         "libhfst/src/parsers/xre_lex" + cpp,
                         "libhfst/src/parsers/xre_parse" + cpp,
                         "libhfst/src/parsers/pmatch_parse" + cpp,
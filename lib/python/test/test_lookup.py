@@ -20,3 +20,20 @@ for type in [hfst.ImplementationType.SFST_TYPE, hfst.ImplementationType.TROPICAL
         result = tr.lookup('foo')
         assert(len(result) == 1)
         assert(result[0][0] == 'bar')
+        results = tr.lookup_many(['foo', 'bar', ('f', 'o', 'o')], jobs=2)
+        assert(len(results) == 3)
+        assert(results[0] == tr.lookup('foo'))
+        assert(results[1] == ())
+        assert(results[2] == tr.lookup(('f', 'o', 'o')))
+        results = tr.lookup_many(['foo'] * 2000)
+        assert(all(result == results[0] for result in results))
+        for ol_type in [hfst.ImplementationType.HFST_OL_TYPE, hfst.ImplementationType.HFST_OLW_TYPE]:
+            ol = hfst.HfstTransducer(tr)
+            ol.convert(ol_type)
+            assert(ol.lookup_many(['foo'] * 2000, jobs=4) == [ol.lookup('foo')] * 2000)
+            # Inputs with symbols unknown to the transducer, in a second batch
+            inputs = ['foo', 'fé', 'bar'] * 1000
+            assert(ol.lookup_many(inputs, jobs=4) == ol.lookup_many(inputs, jobs=1))
+            assert(not ol.is_lookup_infinitely_ambiguous('foo'))
+            ol.convert(type)
+            assert(ol.lookup('foo') == tr.lookup('foo'))
@@ -49,6 +49,8 @@ for type in [hfst.ImplementationType.SFST_TYPE, hfst.ImplementationType.TROPICAL
         assert tokenization.rstrip() == "avenue des Ternes"
         tokenization = cont.tokenize("Je marche seul dans l'avenue des Ternes.")
         assert tokenization == ["avenue des Ternes"]
+        tokenizations = cont.tokenize_many(["Je marche seul dans l'avenue des Ternes.", "", "rien"])
+        assert tokenizations == [("avenue des Ternes",), (), ()]
 
         # (7) Test Finnish tokenizer
         if os.path.isfile('finnish-tokenizer.hfstol'):
@@ -134,6 +134,7 @@ HfstDataTypes.h HfstEpsilonHandler.h HfstExceptionDefs.h \
 HfstExtractStrings.h HfstFlagDiacritics.h \
 HfstInputStream.h HfstLookupFlagDiacritics.h HfstOutputStream.h \
 HfstSymbolDefs.h HfstTokenizer.h HfstTransducer.h HfstXeroxRules.h \
+HfstCompilationCache.h HfstSpillStore.h \
 HfstStrings2FstTokenizer.h hfst.h hfst.hpp.in hfst_apply_schemas.h hfstdll.h \
 hfst-string-conversions.h HfstPrintDot.h HfstPrintPCKimmo.h \
 string-utils.h;
@@ -146,6 +147,7 @@ HarmonizeUnknownAndIdentitySymbols HfstApply HfstDataTypes \
 HfstEpsilonHandler HfstExceptionDefs HfstFlagDiacritics \
 HfstInputStream HfstLookupFlagDiacritics HfstOutputStream HfstRules \
 HfstSymbolDefs HfstTokenizer HfstTransducer HfstXeroxRules \
+HfstCompilationCache HfstSpillStore \
 hfst-string-conversions \
 HfstStrings2FstTokenizer HfstXeroxRulesTest HfstPrintDot HfstPrintPCKimmo \
 string-utils;
@@ -158,7 +160,7 @@ for file in \
 ConvertTransducerFormat.h FomaTransducer.h \
 HfstOlTransducer.h HfstBasicTransition.h HfstBasicTransducer.h \
 HfstTropicalTransducerTransitionData.h LogWeightTransducer.h \
-TropicalWeightTransducer.h;
+TropicalWeightTransducer.h HfstTrieBuilder.h HfstLexiconBuilder.h HfstSymbolInterner.h;
 do
     cp libhfst/src/implementations/$file $1/libhfst/src/implementations/
 done
@@ -167,7 +169,10 @@ for file in \
 ConvertFomaTransducer ConvertLogWeightTransducer ConvertOlTransducer \
 ConvertTransducerFormat ConvertTropicalWeightTransducer FomaTransducer \
 HfstOlTransducer HfstBasicTransducer HfstBasicTransition HfstTropicalTransducerTransitionData \
-LogWeightTransducer TropicalWeightTransducer;
+LogWeightTransducer TropicalWeightTransducer TropicalWeightTransducerParallel \
+HfstTrieBuilder \
+HfstLexiconBuilder \
+HfstSymbolInterner;
 do
     cp libhfst/src/implementations/$file.cc $1/libhfst/src/implementations/$file.cpp
 done
@@ -185,7 +190,7 @@ done
 
 # implementations/optimized-lookup
 for file in \
-convert pmatch transducer;
+convert pmatch transducer cascade;
 do
     cp libhfst/src/implementations/optimized-lookup/$file.cc \
         $1/libhfst/src/implementations/optimized-lookup/$file.cpp
@@ -35,6 +35,8 @@ HfstXeroxRules.cpp ^
 HfstDataTypes.cpp ^
 HfstSymbolDefs.cpp ^
 HfstTokenizer.cpp ^
+HfstCompilationCache.cpp ^
+HfstSpillStore.cpp ^
 HfstFlagDiacritics.cpp ^
 HfstExceptionDefs.cpp ^
 HarmonizeUnknownAndIdentitySymbols.cpp ^
@@ -53,6 +55,10 @@ implementations\ConvertLogWeightTransducer.cpp ^
 implementations\ConvertFomaTransducer.cpp ^
 implementations\ConvertOlTransducer.cpp ^
 implementations\TropicalWeightTransducer.cpp ^
+implementations\TropicalWeightTransducerParallel.cpp ^
+implementations\HfstTrieBuilder.cpp ^
+implementations\HfstLexiconBuilder.cpp ^
+implementations\HfstSymbolInterner.cpp ^
 implementations\LogWeightTransducer.cpp ^
 implementations\FomaTransducer.cpp ^
 implementations\HfstOlTransducer.cpp ^
@@ -66,6 +72,7 @@ implementations\optimized-lookup\convert.cpp ^
 implementations\optimized-lookup\ospell.cpp ^
 implementations\optimized-lookup\pmatch.cpp ^
 implementations\optimized-lookup\find_epsilon_loops.cpp ^
+implementations\optimized-lookup\cascade.cpp ^
 parsers\xre_lex.cpp ^
 parsers\xre_parse.cpp ^
 parsers\pmatch_parse.cpp ^
@@ -45,6 +45,8 @@ HfstXeroxRules.cpp ^
 HfstDataTypes.cpp ^
 HfstSymbolDefs.cpp ^
 HfstTokenizer.cpp ^
+HfstCompilationCache.cpp ^
+HfstSpillStore.cpp ^
 HfstFlagDiacritics.cpp ^
 HfstExceptionDefs.cpp ^
 HarmonizeUnknownAndIdentitySymbols.cpp ^
@@ -63,6 +65,10 @@ implementations\ConvertLogWeightTransducer.cpp ^
 implementations\ConvertFomaTransducer.cpp ^
 implementations\ConvertOlTransducer.cpp ^
 implementations\TropicalWeightTransducer.cpp ^
+implementations\TropicalWeightTransducerParallel.cpp ^
+implementations\HfstTrieBuilder.cpp ^
+implementations\HfstLexiconBuilder.cpp ^
+implementations\HfstSymbolInterner.cpp ^
 implementations\LogWeightTransducer.cpp ^
 implementations\FomaTransducer.cpp ^
 implementations\HfstOlTransducer.cpp ^
@@ -76,6 +82,7 @@ implementations\optimized-lookup\convert.cpp ^
 implementations\optimized-lookup\ospell.cpp ^
 implementations\optimized-lookup\pmatch.cpp ^
 implementations\optimized-lookup\find_epsilon_loops.cpp ^
+implementations\optimized-lookup\cascade.cpp ^
 parsers\xre_lex.cpp ^
 parsers\xre_parse.cpp ^
 parsers\pmatch_parse.cpp ^
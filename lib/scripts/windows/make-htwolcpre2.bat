@@ -37,6 +37,8 @@ HfstXeroxRules.cpp ^
 HfstDataTypes.cpp ^
 HfstSymbolDefs.cpp ^
 HfstTokenizer.cpp ^
+HfstCompilationCache.cpp ^
+HfstSpillStore.cpp ^
 HfstFlagDiacritics.cpp ^
 HfstExceptionDefs.cpp ^
 HarmonizeUnknownAndIdentitySymbols.cpp ^
@@ -55,6 +57,10 @@ implementations\ConvertLogWeightTransducer.cpp ^
 implementations\ConvertFomaTransducer.cpp ^
 implementations\ConvertOlTransducer.cpp ^
 implementations\TropicalWeightTransducer.cpp ^
+implementations\TropicalWeightTransducerParallel.cpp ^
+implementations\HfstTrieBuilder.cpp ^
+implementations\HfstLexiconBuilder.cpp ^
+implementations\HfstSymbolInterner.cpp ^
 implementations\LogWeightTransducer.cpp ^
 implementations\FomaTransducer.cpp ^
 implementations\HfstOlTransducer.cpp ^
@@ -68,6 +74,7 @@ implementations\optimized-lookup\convert.cpp ^
 implementations\optimized-lookup\ospell.cpp ^
 implementations\optimized-lookup\pmatch.cpp ^
 implementations\optimized-lookup\find_epsilon_loops.cpp ^
+implementations\optimized-lookup\cascade.cpp ^
 parsers\xre_lex.cpp ^
 parsers\xre_parse.cpp ^
 parsers\pmatch_parse.cpp ^
@@ -7,6 +7,10 @@ ConvertLogWeightTransducer.cpp ^
 ConvertFomaTransducer.cpp ^
 ConvertOlTransducer.cpp ^
 TropicalWeightTransducer.cpp ^
+HfstTrieBuilder.cpp ^
+HfstLexiconBuilder.cpp ^
+HfstSymbolInterner.cpp ^
+TropicalWeightTransducerParallel.cpp ^
 LogWeightTransducer.cpp ^
 FomaTransducer.cpp ^
 HfstOlTransducer.cpp ^
@@ -19,4 +23,5 @@ optimized-lookup\transducer.cpp ^
 optimized-lookup\convert.cpp ^
 optimized-lookup\ospell.cpp ^
 optimized-lookup\pmatch.cpp ^
-optimized-lookup\find_epsilon_loops.cpp
+optimized-lookup\find_epsilon_loops.cpp ^
+optimized-lookup\cascade.cpp
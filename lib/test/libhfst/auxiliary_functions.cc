@@ -1,3 +1,7 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+
 const bool VERBOSE=true;
 
 void verbose_print(const char *msg,
@@ -41,3 +45,34 @@ unsigned char get_bin(size_t fact_128, size_t fact_64, size_t fact_32,
     fact_128*128 + fact_64*64 + fact_32*32 + fact_16*16 + fact_8*8 +
     fact_4*4 + fact_2*2+ fact_1*1;
 }
+
+/* A simple generator, so that the transducers and inputs generated by the
+   benchmarks are the same on every platform. */
+uint64_t next_random(uint64_t & state)
+{
+  state = state * UINT64_C(6364136223846793005) + UINT64_C(1442695040888963407);
+  return (state >> 33);
+}
+
+/* The benchmarks take their sizes and the seed of next_random as optional
+   numeric arguments: argument N, or DEFAULT_VALUE if it is not given. */
+unsigned long numeric_argument(int argc, char **argv, int n,
+                               unsigned long default_value)
+{
+  return (argc > n) ? strtoul(argv[n], NULL, 10) : default_value;
+}
+
+/* Wall-clock time since the timer was made. */
+class BenchmarkTimer
+{
+ protected:
+  std::chrono::steady_clock::time_point start;
+ public:
+  BenchmarkTimer(): start(std::chrono::steady_clock::now()) {}
+  double seconds() const
+  {
+    std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+  }
+};
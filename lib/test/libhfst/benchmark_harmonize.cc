@@ -0,0 +1,116 @@
+/*
+   Benchmark for harmonizing unknown and identity symbols of transducers
+   with large alphabets.
+
+   Generates a lexicon of multicharacter symbols and a rule transducer
+   over a small alphabet and harmonizes them (see
+   hfst::implementations::HfstBasicTransducer::harmonize). Each lexicon
+   symbol is unknown to the rule, so its identity, "?:x", "x:?" and "?:?"
+   transitions are expanded with every one of them. The rule is:
+
+     identity:    every state has an identity transition
+     unknown:     every state has "?:x" and "x:?" transitions
+     cross:       every RATE-th state also has a "?:?" transition
+
+   The wall-clock time and the sizes of the results are printed.
+
+   Usage: benchmark_harmonize [SYMBOLS [STATES [RATE [SEED]]]]
+*/
+
+#include "HfstTransducer.h"
+#include "auxiliary_functions.cc"
+#include "implementations/HfstBasicTransducer.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+using namespace hfst;
+using hfst::implementations::HfstBasicTransducer;
+using hfst::implementations::HfstBasicTransition;
+using hfst::implementations::HfstState;
+
+static std::string symbol(unsigned long number)
+{
+  std::ostringstream oss;
+  oss << "+Tag" << number;
+  return oss.str();
+}
+
+/* Paths of a few symbols each, so that every symbol occurs. */
+static HfstBasicTransducer lexicon(unsigned long symbols,
+                                   uint64_t & state)
+{
+  HfstBasicTransducer t;
+  for (unsigned long i = 0; i < symbols; i++)
+    {
+      HfstState s = t.add_state();
+      t.add_transition(0, HfstBasicTransition(s, symbol(i), symbol(i), 0));
+      HfstState target = t.add_state();
+      std::string other = symbol(next_random(state) % symbols);
+      t.add_transition(s, HfstBasicTransition(target, other, other, 0));
+      t.set_final_weight(target, 0);
+    }
+  return t;
+}
+
+static HfstBasicTransducer rule(unsigned long states, unsigned long rate,
+                                uint64_t & state)
+{
+  HfstBasicTransducer t;
+  for (unsigned long s = 1; s < states; s++)
+    t.add_state();
+  for (unsigned long s = 0; s < states; s++)
+    {
+      HfstState target = next_random(state) % states;
+      std::string letter(1, (char)('a' + next_random(state) % 26));
+      float weight = (float)(next_random(state) % 10);
+      t.add_transition(s, HfstBasicTransition
+                       (target, internal_identity, internal_identity, 0));
+      t.add_transition(s, HfstBasicTransition
+                       (target, internal_unknown, letter, weight));
+      t.add_transition(s, HfstBasicTransition
+                       ((s + 1) % states, letter, internal_unknown, weight));
+      if (rate > 0 && s % rate == 0)
+        t.add_transition(s, HfstBasicTransition
+                         (s, internal_unknown, internal_unknown, weight));
+      t.set_final_weight(s, 0);
+    }
+  return t;
+}
+
+static unsigned long number_of_arcs(const HfstBasicTransducer & t)
+{
+  unsigned long arcs = 0;
+  for (HfstBasicTransducer::const_iterator it = t.begin(); it != t.end(); it++)
+    arcs += it->size();
+  return arcs;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned long symbols = numeric_argument(argc, argv, 1, 2000);
+  unsigned long states = numeric_argument(argc, argv, 2, 2000);
+  unsigned long rate = numeric_argument(argc, argv, 3, 200);
+  uint64_t state = numeric_argument(argc, argv, 4, 1);
+  if (states < 1)
+    states = 1;
+
+  HfstBasicTransducer words = lexicon(symbols, state);
+  HfstBasicTransducer rules = rule(states, rate, state);
+  std::cout << "lexicon: " << symbols << " symbols, "
+            << number_of_arcs(words) << " arcs" << std::endl
+            << "rule: " << states << " states, "
+            << number_of_arcs(rules) << " arcs" << std::endl;
+
+  BenchmarkTimer timer;
+  rules.harmonize(words);
+  double seconds = timer.seconds();
+
+  std::cout << "harmonized rule: " << number_of_arcs(rules) << " arcs, "
+            << rules.get_alphabet().size() << " symbols" << std::endl
+            << "harmonized lexicon: " << number_of_arcs(words) << " arcs, "
+            << words.get_alphabet().size() << " symbols" << std::endl
+            << "time: " << seconds << " s" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,211 @@
+/*
+   Benchmark for determinizing and minimizing tropical transducers on
+   several threads.
+
+   Generates lexicons of the size of real morphological lexicons and
+   minimizes each of them on one thread and on JOBS threads (see
+   hfst::set_minimization_jobs). The lexicons are:
+
+     words:       a word list where every word is a path of its own
+     paradigms:   stems with inflectional endings and tags, the stems
+                  of a paradigm sharing their continuation classes
+     compounds:   a weighted word list whose words can be compounded
+
+   The wall-clock times and the sizes of the results are printed. The
+   results must have the same number of states and arcs.
+
+   Usage: benchmark_minimize [WORDS [JOBS [SEED]]]
+*/
+
+#include "HfstTransducer.h"
+#include "auxiliary_functions.cc"
+#include "implementations/HfstBasicTransducer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+using namespace hfst;
+using hfst::implementations::HfstBasicTransducer;
+using hfst::implementations::HfstBasicTransition;
+using hfst::implementations::HfstState;
+
+/* Letters are drawn so that the start of words is shared more often
+   than the end, as in real lexicons. */
+static std::string random_word(uint64_t & state)
+{
+  std::string word;
+  unsigned long length = 3 + next_random(state) % 9;
+  for (unsigned long i = 0; i < length; i++)
+    {
+      unsigned long letters = (i < 2) ? 6 : 26;
+      word.push_back((char)('a' + next_random(state) % letters));
+    }
+  return word;
+}
+
+/* Add a path from START that maps INPUT to OUTPUT letter by letter and
+   return the state where it ends. */
+static HfstState add_path(HfstBasicTransducer & t, HfstState start,
+                          const std::string & input,
+                          const std::string & output, float weight)
+{
+  HfstState s = start;
+  size_t length = std::max(input.size(), output.size());
+  for (size_t i = 0; i < length; i++)
+    {
+      HfstState target = t.add_state();
+      std::string isymbol = (i < input.size()) ?
+        input.substr(i, 1) : internal_epsilon;
+      std::string osymbol = (i < output.size()) ?
+        output.substr(i, 1) : internal_epsilon;
+      t.add_transition
+        (s, HfstBasicTransition(target, isymbol, osymbol,
+                                (i == 0) ? weight : 0));
+      s = target;
+    }
+  return s;
+}
+
+static HfstBasicTransducer word_list(unsigned long words,
+                                     uint64_t & state)
+{
+  HfstBasicTransducer t;
+  for (unsigned long i = 0; i < words; i++)
+    {
+      std::string word = random_word(state);
+      t.set_final_weight(add_path(t, 0, word, word, 0), 0);
+    }
+  return t;
+}
+
+static HfstBasicTransducer paradigms(unsigned long words,
+                                     uint64_t & state)
+{
+  static const char * endings[] = { "", "s", "en", "er", "est", "ing", "ed" };
+  static const char * tags[] = { "+Sg", "+Pl", "+Pl", "+Cmp", "+Sup",
+                                 "+Prs", "+Pst" };
+  const unsigned long paradigm_count = 40;
+
+  HfstBasicTransducer t;
+  std::vector<HfstState> continuations;
+  for (unsigned long p = 0; p < paradigm_count; p++)
+    {
+      HfstState c = t.add_state();
+      continuations.push_back(c);
+      for (unsigned long e = 0; e < 7; e++)
+        {
+          if (next_random(state) % 3 == 0)
+            continue;
+          // The analysis side has the tag, the surface side the ending
+          std::string tag = tags[e];
+          HfstState s = c;
+          for (size_t i = 0; i < std::max(tag.size(), strlen(endings[e]));
+               i++)
+            {
+              HfstState target = t.add_state();
+              std::string isymbol = (i == 0) ? tag : internal_epsilon;
+              std::string osymbol = (i < strlen(endings[e])) ?
+                std::string(1, endings[e][i]) : internal_epsilon;
+              t.add_transition(s, HfstBasicTransition(target, isymbol,
+                                                      osymbol, 0));
+              s = target;
+            }
+          t.set_final_weight(s, 0);
+        }
+    }
+  for (unsigned long i = 0; i < words; i++)
+    {
+      std::string stem = random_word(state);
+      HfstState s = add_path(t, 0, stem, stem, 0);
+      HfstState c = continuations[next_random(state) % paradigm_count];
+      t.add_transition(s, HfstBasicTransition(c, internal_epsilon,
+                                              internal_epsilon, 0));
+    }
+  return t;
+}
+
+static HfstBasicTransducer compounds(unsigned long words,
+                                     uint64_t & state)
+{
+  HfstBasicTransducer t;
+  HfstState boundary = t.add_state();
+  for (unsigned long i = 0; i < words; i++)
+    {
+      std::string word = random_word(state);
+      float weight = (float)(next_random(state) % 100) / 10;
+      HfstState s = add_path(t, 0, word, word, weight);
+      t.set_final_weight(s, 0);
+      if (next_random(state) % 4 == 0)
+        t.add_transition(s, HfstBasicTransition(boundary, "#", "#", 1));
+    }
+  t.add_transition(boundary, HfstBasicTransition(0, internal_epsilon,
+                                                 internal_epsilon, 0));
+  return t;
+}
+
+/* Minimize a copy of T on JOBS threads and return the time in seconds. */
+static double time_minimize(const HfstTransducer & t, unsigned int jobs,
+                            HfstTransducer & result)
+{
+  set_minimization_jobs(jobs);
+  result = t;
+  BenchmarkTimer timer;
+  result.minimize();
+  return timer.seconds();
+}
+
+int main(int argc, char **argv)
+{
+  unsigned long words = numeric_argument(argc, argv, 1, 200000);
+  unsigned int jobs = (unsigned int)numeric_argument
+    (argc, argv, 2, std::thread::hardware_concurrency());
+  uint64_t state = numeric_argument(argc, argv, 3, 1);
+  if (jobs < 2)
+    jobs = 2;
+
+  if (! HfstTransducer::is_implementation_type_available
+      (TROPICAL_OPENFST_TYPE))
+    {
+      std::cerr << "OpenFst is not available" << std::endl;
+      return 77; // skipped
+    }
+
+  const char * names[] = { "words", "paradigms", "compounds" };
+  int retval = EXIT_SUCCESS;
+  for (int i = 0; i < 3; i++)
+    {
+      HfstBasicTransducer basic =
+        (i == 0) ? word_list(words, state) :
+        (i == 1) ? paradigms(words, state) :
+        compounds(words, state);
+      HfstTransducer lexicon(basic, TROPICAL_OPENFST_TYPE);
+
+      HfstTransducer serial(TROPICAL_OPENFST_TYPE);
+      HfstTransducer parallel(TROPICAL_OPENFST_TYPE);
+      double serial_time = time_minimize(lexicon, 1, serial);
+      double parallel_time = time_minimize(lexicon, jobs, parallel);
+
+      std::cout << names[i] << ": "
+                << lexicon.number_of_states() << " states, "
+                << lexicon.number_of_arcs() << " arcs" << std::endl
+                << "  minimized: " << serial.number_of_states()
+                << " states, " << serial.number_of_arcs() << " arcs"
+                << std::endl
+                << "  1 thread: " << serial_time << " s" << std::endl
+                << "  " << jobs << " threads: " << parallel_time << " s"
+                << std::endl;
+      if (serial.number_of_states() != parallel.number_of_states() ||
+          serial.number_of_arcs() != parallel.number_of_arcs())
+        {
+          std::cerr << "  results differ: " << parallel.number_of_states()
+                    << " states, " << parallel.number_of_arcs() << " arcs"
+                    << std::endl;
+          retval = EXIT_FAILURE;
+        }
+    }
+  set_minimization_jobs(1);
+  return retval;
+}
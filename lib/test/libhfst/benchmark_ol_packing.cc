@@ -0,0 +1,86 @@
+/*
+   Benchmark for building optimized-lookup transducers.
+
+   Generates a random lexicon, builds it as a tropical transducer and
+   times its conversion to HFST_OLW_TYPE, which is dominated by packing
+   the transition index table. The sizes of the resulting tables are
+   printed so that packing density can be compared between versions.
+
+   Usage: benchmark_ol_packing [WORDS [ALPHABET_SIZE [SEED]]]
+*/
+
+#include "HfstTransducer.h"
+#include "auxiliary_functions.cc"
+#include "implementations/HfstLexiconBuilder.h"
+#include "implementations/optimized-lookup/transducer.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+using namespace hfst;
+using hfst::implementations::HfstLexiconBuilder;
+using hfst::implementations::ConversionFunctions;
+
+/* Half of the symbols are drawn from the 26 letters a-z and half from
+   the whole alphabet, the rest of which are multicharacter symbols. */
+static std::string random_symbol(uint64_t & state,
+                                 unsigned long alphabet_size)
+{
+  unsigned long n = next_random(state) % alphabet_size;
+  if (next_random(state) % 2 == 0)
+    n = n % 26;
+  if (n < 26)
+    return std::string(1, (char)('a' + n));
+  std::ostringstream oss;
+  oss << "<" << n << ">";
+  return oss.str();
+}
+
+int main(int argc, char **argv)
+{
+  unsigned long words = numeric_argument(argc, argv, 1, 300000);
+  unsigned long alphabet_size = numeric_argument(argc, argv, 2, 26);
+  uint64_t state = numeric_argument(argc, argv, 3, 1);
+  if (alphabet_size == 0)
+    alphabet_size = 1;
+
+  if (! HfstTransducer::is_implementation_type_available
+      (TROPICAL_OPENFST_TYPE))
+    {
+      std::cerr << "OpenFst is not available" << std::endl;
+      return 77; // skipped
+    }
+
+  HfstLexiconBuilder builder;
+  for (unsigned long i = 0; i < words; i++)
+    {
+      StringPairVector spv;
+      unsigned long length = 3 + next_random(state) % 10;
+      for (unsigned long j = 0; j < length; j++)
+        {
+          std::string symbol = random_symbol(state, alphabet_size);
+          spv.push_back(StringPair(symbol, symbol));
+        }
+      if (next_random(state) % 7 == 0)
+        spv.push_back(StringPair("@P.X.Y@", "@P.X.Y@"));
+      spv.push_back(StringPair("+N", internal_epsilon));
+      builder.add(spv, (float)(next_random(state) % 100) / 10);
+    }
+  HfstTransducer lexicon(builder.get_transducer(), TROPICAL_OPENFST_TYPE);
+
+  BenchmarkTimer timer;
+  lexicon.convert(HFST_OLW_TYPE);
+  double seconds = timer.seconds();
+
+  const hfst_ol::TransducerHeader & header =
+    ConversionFunctions::hfst_transducer_to_hfst_ol(&lexicon)->get_header();
+  std::cout << "words: " << words << std::endl
+            << "alphabet size: " << alphabet_size << std::endl
+            << "index table size: " << header.index_table_size() << std::endl
+            << "transition table size: " << header.target_table_size()
+            << std::endl
+            << "conversion time: "
+            << seconds << " s" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,122 @@
+/*
+   Benchmark input for hfst-proc.
+
+   Generates a random analyser with ambiguous surface forms, flag
+   diacritics and weights, writes it as an HFST_OLW_TYPE transducer
+   and writes a running text, most words of which the analyser
+   recognizes. Analysis speed is then measured with e.g.
+
+     time hfst-proc -a ANALYSER TEXT > /dev/null
+
+   Usage: benchmark_proc_analyser ANALYSER TEXT [WORDS [TOKENS [SEED]]]
+*/
+
+#include "HfstTransducer.h"
+#include "auxiliary_functions.cc"
+#include "HfstOutputStream.h"
+#include "implementations/HfstLexiconBuilder.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using namespace hfst;
+using hfst::implementations::HfstLexiconBuilder;
+
+static std::string random_word(uint64_t & state)
+{
+  std::string word;
+  unsigned long length = 3 + next_random(state) % 8;
+  for (unsigned long i = 0; i < length; i++)
+    word += (char)('a' + next_random(state) % 26);
+  return word;
+}
+
+/* Surface suffixes and the analyses they are given. The empty suffix
+   is ambiguous, which keeps several lookup paths alive. */
+static const char * suffixes[][3] =
+  { { "",    "+N",   "+Sg"   },
+    { "s",   "+N",   "+Pl"   },
+    { "",    "+V",   "+Inf"  },
+    { "s",   "+V",   "+Pres" },
+    { "ed",  "+V",   "+Past" },
+    { "ing", "+V",   "+Prog" },
+    { "er",  "+A",   "+Comp" } };
+
+static const char * flags[] = { "@U.NUM.SG@", "@U.NUM.PL@", "@U.NUM.SG@",
+                                "@U.NUM.SG@", "@U.NUM.SG@", "@U.NUM.SG@",
+                                "@U.NUM.SG@" };
+
+int main(int argc, char **argv)
+{
+  if (argc < 3)
+    {
+      std::cerr << "Usage: " << argv[0]
+                << " ANALYSER TEXT [WORDS [TOKENS [SEED]]]" << std::endl;
+      return EXIT_FAILURE;
+    }
+  unsigned long words = numeric_argument(argc, argv, 3, 200000);
+  unsigned long tokens = numeric_argument(argc, argv, 4, 1000000);
+  uint64_t state = numeric_argument(argc, argv, 5, 1);
+
+  if (! HfstTransducer::is_implementation_type_available
+      (TROPICAL_OPENFST_TYPE))
+    {
+      std::cerr << "OpenFst is not available" << std::endl;
+      return 77; // skipped
+    }
+
+  size_t suffix_count = sizeof(suffixes) / sizeof(suffixes[0]);
+  std::vector<std::string> surface_forms;
+
+  HfstLexiconBuilder builder;
+  for (unsigned long i = 0; i < words; i++)
+    {
+      std::string stem = random_word(state);
+      unsigned long analyses = 1 + next_random(state) % 3;
+      for (unsigned long j = 0; j < analyses; j++)
+        {
+          size_t k = next_random(state) % suffix_count;
+          std::string suffix = suffixes[k][0];
+
+          StringPairVector spv;
+          for (size_t c = 0; c < stem.size(); c++)
+            spv.push_back(StringPair(stem.substr(c, 1), stem.substr(c, 1)));
+          if (next_random(state) % 5 == 0)
+            spv.push_back(StringPair(flags[k], flags[k]));
+          for (size_t c = 0; c < suffix.size(); c++)
+            spv.push_back(StringPair(suffix.substr(c, 1), internal_epsilon));
+          spv.push_back(StringPair(internal_epsilon, suffixes[k][1]));
+          spv.push_back(StringPair(internal_epsilon, suffixes[k][2]));
+          builder.add(spv, (float)(next_random(state) % 100) / 10);
+
+          surface_forms.push_back(stem + suffix);
+        }
+    }
+  HfstTransducer analyser(builder.get_transducer(), TROPICAL_OPENFST_TYPE);
+  analyser.minimize();
+  analyser.convert(HFST_OLW_TYPE);
+
+  HfstOutputStream out(argv[1], HFST_OLW_TYPE);
+  out << analyser;
+  out.close();
+
+  /* Nine tokens out of ten are known words and the rest are unknown,
+     with some punctuation in between. */
+  std::ofstream text(argv[2]);
+  for (unsigned long i = 0; i < tokens; i++)
+    {
+      if (next_random(state) % 10 == 0)
+        text << random_word(state);
+      else
+        text << surface_forms[next_random(state) % surface_forms.size()];
+      if (i % 15 == 14)
+        text << ".\n";
+      else if (next_random(state) % 10 == 0)
+        text << ", ";
+      else
+        text << " ";
+    }
+  return EXIT_SUCCESS;
+}
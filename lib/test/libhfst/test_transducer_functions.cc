@@ -7,6 +7,7 @@
    - insert_freely
    - is_cyclic
    - is_lookup_infinitely_ambiguous, lookup and lookup_fd
+   - lookdown and lookup_cascade
    - n_best
    - push_weights
    - set_final_weights
@@ -272,6 +273,21 @@ int main(int argc, char **argv)
         /* Weights are the same on each path. */
         assert(t6.compare(t7));
       }
+
+    /* Minimization in several threads. */
+    HfstTransducer t9("foo", "bar", types[i]);
+    HfstTransducer t10("fo", "bar", types[i]);
+    t10.set_final_weights(1);
+    HfstTransducer t11("foofoo", "barbar", types[i]);
+    t9.disjunct(t10);
+    t9.disjunct(t11);
+    HfstTransducer t12(t9);
+    t9.minimize();
+    set_minimization_jobs(3);
+    t12.minimize();
+    set_minimization_jobs(1);
+    assert(t9.compare(t12));
+    assert(t9.number_of_states() == t12.number_of_states());
       }
 
 
@@ -287,6 +303,70 @@ int main(int argc, char **argv)
     t3.set_final_weights(5);
     t1.compose(t2);
     assert(t1.compare(t3));
+
+    /* The same with label lookahead, where t2 cannot continue the
+       path foo:qux. */
+    HfstTransducer t4("foo", "bar", types[i]);
+    t4.set_final_weights(2);
+    HfstTransducer t5("foo", "qux", types[i]);
+    t4.disjunct(t5);
+    set_lookahead_composition(true);
+    t4.compose(t2);
+    set_lookahead_composition(false);
+    assert(t4.compare(t3));
+
+    /* Label lookahead gives the same paths and weights as eager
+       composition with transducers of several states, where the first
+       one has epsilon outputs and the second one rejects some of its
+       paths. The epsilons of a path may be aligned differently. */
+    hfst::HfstTokenizer tok;
+    HfstTransducer lexicon("cats", "cat", tok, types[i]);
+    lexicon.set_final_weights(1);
+    HfstTransducer dog("dog", "dogs", tok, types[i]);
+    dog.set_final_weights(2);
+    HfstTransducer cab("cab", "cb", tok, types[i]);
+    cab.set_final_weights(3);
+    HfstTransducer ca("ca", "cat", tok, types[i]);
+    ca.set_final_weights(0.5);
+    lexicon.disjunct(dog);
+    lexicon.disjunct(cab);
+    lexicon.disjunct(ca);
+
+    HfstTransducer rules("cat", "kat", tok, types[i]);
+    rules.set_final_weights(0.25);
+    HfstTransducer katt("cat", "katt", tok, types[i]);
+    katt.set_final_weights(0.75);
+    HfstTransducer dogs("dogs", "dg", tok, types[i]);
+    rules.disjunct(katt);
+    rules.disjunct(dogs);
+
+    HfstTransducer eager(lexicon);
+    eager.compose(rules);
+    set_lookahead_composition(true);
+    lexicon.compose(rules);
+    set_lookahead_composition(false);
+    HfstTwoLevelPaths eager_paths;
+    HfstTwoLevelPaths lookahead_paths;
+    eager.extract_paths(eager_paths);
+    lexicon.extract_paths(lookahead_paths);
+    assert(eager_paths.size() == 5);
+    assert(lookahead_paths.size() == eager_paths.size());
+    for (HfstTwoLevelPaths::const_iterator it = eager_paths.begin();
+         it != eager_paths.end(); it++)
+      {
+        std::string istring;
+        std::string ostring;
+        for (StringPairVector::const_iterator IT = it->second.begin();
+             IT != it->second.end(); IT++)
+          {
+            if (IT->first.compare("@_EPSILON_SYMBOL_@") != 0)
+              istring.append(IT->first);
+            if (IT->second.compare("@_EPSILON_SYMBOL_@") != 0)
+              ostring.append(IT->second);
+          }
+        assert(do_results_contain(lookahead_paths, istring, ostring,
+                                  it->first, true));
+      }
       }
 
       /* Function shuffle. */
@@ -458,7 +538,30 @@ int main(int argc, char **argv)
     assert(not animals_ol.is_lookup_infinitely_ambiguous
            (lookup_hippopotamus));
 
-    // todo: more is_lookup_infinitely_ambiguous tests...
+    /* an input epsilon cycle that is reached only after "ab" */
+    {
+      HfstBasicTransducer cyclic;
+      cyclic.add_transition(0, HfstBasicTransition(1, "a", "a", 0));
+      cyclic.add_transition(0, HfstBasicTransition(2, "b", "b", 0));
+      cyclic.add_transition(1, HfstBasicTransition(3, "b", "b", 0));
+      cyclic.add_transition
+        (3, HfstBasicTransition(3, internal_epsilon, "c", 0));
+      cyclic.set_final_weight(2, 0);
+      cyclic.set_final_weight(3, 0);
+      HfstTransducer cyclic_ol(cyclic, types[i]);
+      cyclic_ol.convert(animals_ol.get_type());
+
+      assert(cyclic_ol.is_lookup_infinitely_ambiguous
+             (tok.tokenize_one_level("ab")));
+      assert(not cyclic_ol.is_lookup_infinitely_ambiguous
+             (tok.tokenize_one_level("a")));
+      assert(not cyclic_ol.is_lookup_infinitely_ambiguous
+             (tok.tokenize_one_level("b")));
+      /* but the animals have no cycles at all */
+      assert(not animals_ol.is_lookup_infinitely_ambiguous
+             (tok.tokenize_one_level("xyz")));
+    }
+
 
     /* perform lookups */
     results_cat = animals_ol.lookup(lookup_cat, limit);
@@ -503,6 +606,107 @@ int main(int argc, char **argv)
       assert(do_hfst_lookup_paths_contain
          (*results_hippopotamus, expected_path, 1.4, test_weight));
 
+    /* Function lookdown. */
+    verbose_print("function lookdown", types[i]);
+
+    assert(not animals_ol.is_lookdown_infinitely_ambiguous
+           (tok.tokenize_one_level("mice")));
+
+    HfstOneLevelPaths * results_mice =
+      animals_ol.lookdown(tok.tokenize_one_level("mice"), limit);
+    HfstOneLevelPaths * results_hippopotami =
+      animals_ol.lookdown(tok.tokenize_one_level("hippopotami"), limit);
+    HfstOneLevelPaths * results_mouse_down =
+      animals_ol.lookdown(lookup_mouse, limit);
+
+    assert(results_mice->size() == 1);
+    assert(do_hfst_lookup_paths_contain
+           (*results_mice, lookup_mouse, 1.7, test_weight));
+    if (types[i] != LOG_OPENFST_TYPE)
+      assert(do_hfst_lookup_paths_contain
+             (*results_hippopotami, lookup_hippopotamus, 1.2, test_weight));
+    assert(results_mouse_down->empty());
+
+    delete results_mice;
+    delete results_hippopotami;
+    delete results_mouse_down;
+
+    /* Function lookup_cascade. */
+    verbose_print("function lookup_cascade", types[i]);
+
+    /* A second level that changes i into y between a pair of flag
+       diacritics, the path with the wrong pair being heavier. */
+    {
+      HfstBasicTransducer spelling;
+      spelling.add_transition
+        (0, HfstBasicTransition(1, "@P.F.A@", "@P.F.A@", 0));
+      spelling.add_transition
+        (0, HfstBasicTransition(1, "@P.F.B@", "@P.F.B@", 1));
+      spelling.add_transition
+        (1, HfstBasicTransition(1, "@_IDENTITY_SYMBOL_@",
+                                "@_IDENTITY_SYMBOL_@", 0));
+      spelling.add_transition(1, HfstBasicTransition(1, "i", "y", 0.5));
+      spelling.add_transition
+        (1, HfstBasicTransition(2, "@R.F.A@", "@R.F.A@", 0));
+      spelling.set_final_weight(2, 0);
+      HfstTransducer spelling_ol(spelling, types[i]);
+      spelling_ol.convert(animals_ol.get_type());
+
+      std::vector<HfstTransducer> cascade;
+      cascade.push_back(animals_ol);
+      cascade.push_back(spelling_ol);
+
+      assert(not HfstTransducer::is_cascade_lookup_infinitely_ambiguous
+             (cascade, lookup_mouse));
+      HfstOneLevelPaths * results_cascade =
+        HfstTransducer::lookup_cascade(cascade, lookup_mouse, limit);
+      assert(results_cascade->size() == 1);
+      assert(do_hfst_lookup_paths_contain
+             (*results_cascade,
+              tok.tokenize_one_level("@P.F.A@myce@R.F.A@"), 2.2,
+              test_weight));
+      delete results_cascade;
+
+      /* "cats" has no i to change */
+      results_cascade =
+        HfstTransducer::lookup_cascade(cascade, lookup_cat, limit);
+      assert(results_cascade->size() == 1);
+      assert(do_hfst_lookup_paths_contain
+             (*results_cascade,
+              tok.tokenize_one_level("@P.F.A@cats@R.F.A@"), 3,
+              test_weight));
+      delete results_cascade;
+
+      /* nothing goes through the first level */
+      results_cascade = HfstTransducer::lookup_cascade
+        (cascade, tok.tokenize_one_level("mice"), limit);
+      assert(results_cascade->empty());
+      delete results_cascade;
+
+      /* the same lookups through one cascade object */
+      hfst_ol::TransducerCascade * lookup_cascade =
+        HfstTransducer::create_lookup_cascade(cascade);
+      for (unsigned int n = 0; n < 2; n++)
+        {
+          results_cascade = lookup_cascade->lookup_fd(lookup_mouse, limit);
+          assert(results_cascade->size() == 1);
+          assert(do_hfst_lookup_paths_contain
+                 (*results_cascade,
+                  tok.tokenize_one_level("@P.F.A@myce@R.F.A@"), 2.2,
+                  test_weight));
+          delete results_cascade;
+
+          results_cascade = lookup_cascade->lookup_fd(lookup_cat, limit);
+          assert(results_cascade->size() == 1);
+          assert(do_hfst_lookup_paths_contain
+                 (*results_cascade,
+                  tok.tokenize_one_level("@P.F.A@cats@R.F.A@"), 3,
+                  test_weight));
+          delete results_cascade;
+        }
+      delete lookup_cascade;
+    }
+
 
     // if type is LOG_OPENFST_TYPE:
     // FATAL: SingleShortestPath: Weight needs to have the path property
@@ -28,6 +28,22 @@ if ! echo "cat" | $TOOL pmatch_endtag.pmatch > test.pmatch;
         exit 1
     fi
     
+if [ "$1" != '--python' ]; then
+    # --profile-file writes the profile there and not to the output
+    if ! echo "cat" | $TOOL --profile --profile-file=test.profile pmatch_endtag.pmatch > test.pmatch ; then
+        exit 1
+    fi
+    if ! grep -q "Profiling information" test.profile; then
+        echo "FAIL: profile should be written to test.profile"
+        exit 1
+    fi
+    if grep -q "Profiling information" test.pmatch; then
+        echo "FAIL: profile should not be written to the output"
+        exit 1
+    fi
+    rm test.profile
+fi
+
 rm test.pmatch test.lookups
 
 if [ "$1" != '--python' ]; then
@@ -963,3 +963,28 @@ test_begin "Exc()"
 check_compile_run \
     --code 'Match runs of characters not in {a, b, c}' 'set need-separators off regex Exc({abc})+ EndTag(A);' \
     --inout '' 'aa bb aabqbcc xyaz' 'aa<A> </A>bb<A> </A>aab<A>q</A>bcc<A> xy</A>a<A>z</A>'
+
+# The input is encoded through a window that drops what is more than
+# max-context-length symbols behind the current position, once that is
+# a few thousand symbols. These inputs are long enough for the window to
+# move several times.
+
+repeat () {
+    awk "BEGIN { for (i = 0; i < $2; i++) printf \"%s\", \"$1\" }"
+}
+
+test_begin "Left contexts in long input"
+
+check_compile_run \
+    --code 'Short left context' \
+    'set need-separators off Define TOP LC({xy}) [{a} EndTag(A)];' \
+    --inout 'Matches throughout' \
+    "`repeat xyazya 2000`" "`repeat 'xy<A>a</A>zya' 2000`"
+
+b100=`repeat b 100`
+
+check_compile_run \
+    --code 'Left context of 101 symbols' \
+    'set need-separators off Define TOP LC({x} {b}^100) [{a} EndTag(A)];' \
+    --inout 'Contexts reaching behind the dropped input' \
+    "`repeat x${b100}aba 200`" "`repeat "x${b100}<A>a</A>ba" 200`"
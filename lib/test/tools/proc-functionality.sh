@@ -155,6 +155,49 @@ if ! diff test.strings $srcdir/proc-cat-NUL.strings ; then
     exit 1
 fi
 
+# --jobs checks: the output must be the same as with one thread, also
+# when the input is cut into null-flushed requests
+if [ "$1" != '--python' ]; then
+    i=0
+    : > proc-jobs-in.strings
+    : > proc-jobs-NUL-in.strings
+    while [ $i -lt 200 ]; do
+        cat $srcdir/proc-compounds.strings $srcdir/proc-caps-in.strings >> proc-jobs-in.strings
+        cat $srcdir/proc-compounds.strings >> proc-jobs-NUL-in.strings
+        if [ `expr $i % 20` -eq 19 ]; then
+            printf '\0' >> proc-jobs-NUL-in.strings
+        fi
+        i=`expr $i + 1`
+    done
+    for f in compounds proc-caps; do
+        if ! $TOOL $f.hfstol < proc-jobs-in.strings > test.strings ; then
+            echo jobs $f serial fail
+            exit 1
+        fi
+        if ! $TOOL --jobs 4 $f.hfstol < proc-jobs-in.strings > test-jobs.strings ; then
+            echo jobs $f fail
+            exit 1
+        fi
+        if ! cmp test.strings test-jobs.strings ; then
+            echo jobs $f diffs
+            exit 1
+        fi
+        if ! $TOOL -z $f.hfstol < proc-jobs-NUL-in.strings > test.strings ; then
+            echo jobs $f NUL flush serial fail
+            exit 1
+        fi
+        if ! $TOOL -z --jobs 4 $f.hfstol < proc-jobs-NUL-in.strings > test-jobs.strings ; then
+            echo jobs $f NUL flush fail
+            exit 1
+        fi
+        if ! cmp test.strings test-jobs.strings ; then
+            echo jobs $f NUL flush diffs
+            exit 1
+        fi
+    done
+    rm proc-jobs-in.strings proc-jobs-NUL-in.strings test-jobs.strings
+fi
+
 # Serial unicode ranges check (should really be tested for all --with-unicode-handler configurations):
 # TODO: [ıŀŉĸ] need exceptions in alphabet.cc
 perl -CS -e 'for(my $c=0x0100; $c < 0x017F; $c++){ my $l=chr $c; if($c != 0x0131 && $c != 0x0138 && $c != 0x0140 && $c != 0x149 && $l =~ m/\p{Lower}/){ print $l.":".$l." <n>\n"; }}' \
@@ -0,0 +1,109 @@
+#!/bin/sh
+
+if [ "$1" = "--python" ]; then
+    exit 77
+fi
+
+TOOLDIR=../../tools/src/hfst-tagger/src
+TOOL=$TOOLDIR/hfst-tag
+BUILD_TOOL=$TOOLDIR/hfst-build-tagger
+
+if ! test -x $TOOL; then
+    exit 77
+fi
+if ! test -x $BUILD_TOOL; then
+    exit 77
+fi
+
+if [ "$srcdir" = "" ]; then
+    srcdir="./";
+fi
+
+# The statistics that hfst-train-tagger would compute. The word forms
+# and suffixes are reversed. The sequence model is a tag unigram model.
+cat > tag-statistics.txt <<EOF
+START P(WORD_FORM | TAG)
+||	||	0
+eht	DT	0.2
+a	DT	0.9
+god	NN	1.0
+tac	NN	1.0
+snur	VB	1.2
+snur	NN	2.5
+speels	VB	1.2
+speels	NN	2.8
+.	.	0
+STOP P(WORD_FORM | TAG)
+START P(LOWER_SUFFIX_AND_TAG | LOWER_SUFFIX)
+<lower_suffix_and_tag>	NN	0.9
+<lower_suffix_and_tag>	VB	1.2
+<lower_suffix_and_tag>	DT	1.6
+s<lower_suffix_and_tag>	VB	0.4
+s<lower_suffix_and_tag>	NN	1.1
+STOP P(LOWER_SUFFIX_AND_TAG | LOWER_SUFFIX)
+START P(LOWER_SUFFIX)
+<lower_suffix>T	0
+s<lower_suffix>T	1.6
+STOP P(LOWER_SUFFIX)
+START P(LOWER_TAG)
+NN<lower_tag>T	0.9
+VB<lower_tag>T	1.2
+DT<lower_tag>T	1.6
+STOP P(LOWER_TAG)
+START P(UPPER_SUFFIX_AND_TAG | UPPER_SUFFIX)
+<upper_suffix_and_tag>	NN	0.5
+<upper_suffix_and_tag>	DT	1.5
+STOP P(UPPER_SUFFIX_AND_TAG | UPPER_SUFFIX)
+START P(UPPER_SUFFIX)
+<upper_suffix>T	0
+STOP P(UPPER_SUFFIX)
+START P(UPPER_TAG)
+NN<upper_tag>T	0.5
+DT<upper_tag>T	1.5
+STOP P(UPPER_TAG)
+START SEQUENCE-MODEL:N=1 TAG UNIGRAMS
+PENALTY_WEIGHT=3.0
+<NONE>	||	0.5
+<NONE>	DT	1.0
+<NONE>	NN	0.8
+<NONE>	VB	1.1
+<NONE>	.	0.5
+STOP SEQUENCE-MODEL:N=1 TAG UNIGRAMS
+EOF
+
+if ! $BUILD_TOOL -o tag-tagger < tag-statistics.txt ; then
+    echo hfst-build-tagger fail
+    exit 1
+fi
+
+# Enough sentences for several batches of parallel tagging, with
+# words in and out of the lexicon
+rm -f tag-input.txt
+i=0
+while [ $i -lt 300 ]; do
+    printf 'the\ndog\nruns\n.\n\nA\ncat\nwalks\nthe\ndogs%s\n.\n\n' $i \
+        >> tag-input.txt
+    i=`expr $i + 1`
+done
+
+if ! $TOOL tag-tagger < tag-input.txt > test.tags ; then
+    echo hfst-tag fail
+    exit 1
+fi
+if ! grep "runs	VB" test.tags > /dev/null ; then
+    echo hfst-tag wrong result
+    exit 1
+fi
+for jobs in 2 3; do
+    if ! $TOOL -j $jobs tag-tagger < tag-input.txt > test-jobs.tags ; then
+        echo hfst-tag -j $jobs fail
+        exit 1
+    fi
+    if ! cmp test.tags test-jobs.tags ; then
+        echo hfst-tag -j $jobs diffs
+        exit 1
+    fi
+done
+
+rm -f tag-statistics.txt tag-tagger tag-tagger.lex tag-tagger.seq \
+    tag-input.txt test.tags test-jobs.tags
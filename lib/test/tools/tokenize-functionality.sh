@@ -80,5 +80,20 @@ if ! diff test.strings $srcdir/tokenize-dog-out-giella-cg-superblank.strings ; t
     exit 1
 fi
 
-rm test.strings tokenize-dog.pmhfst tokenize-dog.hfst tokenize-dog-gen.hfst
+# --profile-file
+if ! echo "test dog be dog catdog" | $TOOLDIR/hfst-tokenize --profile --profile-file=test.profile $srcdir/tokenize-dog.pmhfst > test.strings ; then
+    echo tokenize --profile-file fail:
+    cat test.strings
+    exit 1
+fi
+if ! grep -q "Profiling information" test.profile ; then
+    echo tokenize --profile-file wrote no profile
+    exit 1
+fi
+if ! diff test.strings $srcdir/tokenize-dog-out.strings ; then
+    echo diff test.strings $srcdir/tokenize-dog-out.strings
+    exit 1
+fi
+
+rm test.profile test.strings tokenize-dog.pmhfst tokenize-dog.hfst tokenize-dog-gen.hfst
 exit 0
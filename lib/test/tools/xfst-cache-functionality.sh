@@ -0,0 +1,51 @@
+#!/bin/sh
+
+if [ "$1" = "--python" ]; then
+    exit 77
+fi
+
+TOOLDIR=../../tools/src
+TOOL=$TOOLDIR/parsers/hfst-xfst
+
+if ! test -x $TOOL; then
+    exit 77
+fi
+
+if [ "$srcdir" = "" ]; then
+    srcdir="./";
+fi
+
+rm -rf xfst-cache.dir
+
+# A definition used only in a regex read with @re"FILE" must not give
+# the result cached with its earlier value
+printf 'X\n' > xfst-cache.xre
+for word in cat dog; do
+    printf 'define X {%s} ;\nregex @re"xfst-cache.xre" ;\nprint words\n' \
+        $word > xfst-cache.xfst
+    if ! $TOOL --cache=xfst-cache.dir -F xfst-cache.xfst > test.strings ; then
+        echo cache @re $word fail
+        exit 1
+    fi
+    if ! grep $word test.strings > /dev/null ; then
+        echo cache @re $word wrong result
+        cat test.strings
+        exit 1
+    fi
+done
+
+# Regexes that do not read files are still cached
+printf 'define X {cat} ;\nregex X ;\nprint words\n' > xfst-cache.xfst
+for run in 1 2; do
+    if ! $TOOL --cache=xfst-cache.dir -F xfst-cache.xfst > test.strings ; then
+        echo cache run $run fail
+        exit 1
+    fi
+    if ! grep cat test.strings > /dev/null ; then
+        echo cache run $run wrong result
+        cat test.strings
+        exit 1
+    fi
+done
+
+rm -rf xfst-cache.dir xfst-cache.xre xfst-cache.xfst test.strings
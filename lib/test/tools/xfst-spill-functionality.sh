@@ -0,0 +1,71 @@
+#!/bin/sh
+
+if [ "$1" = "--python" ]; then
+    exit 77
+fi
+
+TOOLDIR=../../tools/src
+TOOL=$TOOLDIR/parsers/hfst-xfst
+
+if ! test -x $TOOL; then
+    exit 77
+fi
+
+if [ "$srcdir" = "" ]; then
+    srcdir="./";
+fi
+
+# The networks have over 1000 states, so that they are spilled
+cat > xfst-spill.xfst <<EOF
+define Cat [a|b]^<1000 {cat} ;
+define Dog [a|b]^<1000 {dog} ;
+regex Cat ;
+regex Dog ;
+regex Cat | Dog ;
+name net Both
+regex Cat ;
+pop stack
+print name
+print stack
+rotate stack
+print size
+apply down acat
+apply down bdog
+turn stack
+print size
+apply down bdog
+undefine Cat
+define Cat [a|b]^<1000 {mouse} ;
+define Dog [a|b]^<1000 {bird} ;
+regex Cat | Dog ;
+apply down amouse
+apply down bbird
+apply down acat
+pop stack
+print size
+pop stack
+print size
+print defined
+EOF
+
+if ! $TOOL -F xfst-spill.xfst > test.strings ; then
+    echo xfst fail
+    exit 1
+fi
+rm -rf xfst-spill.dir
+mkdir xfst-spill.dir
+if ! $TOOL --spill=xfst-spill.dir -F xfst-spill.xfst > test-spill.strings ; then
+    echo xfst --spill fail
+    exit 1
+fi
+if ! cmp test.strings test-spill.strings ; then
+    echo xfst --spill diffs
+    exit 1
+fi
+# The temporary directory is removed at exit
+if [ "`ls xfst-spill.dir`" != "" ] ; then
+    echo xfst --spill directory not removed
+    exit 1
+fi
+
+rm -rf xfst-spill.dir xfst-spill.xfst test.strings test-spill.strings
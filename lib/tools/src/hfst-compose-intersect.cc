@@ -61,6 +61,7 @@ static bool invert=false;
 static bool encode_weights=false;
 static bool fast_ci=false;
 static bool harmonize=false;
+static unsigned int jobs=1;
 
 void
 print_usage()
@@ -81,6 +82,8 @@ print_usage()
             "  -e, --encode-weights         Encode weights when minimizing\n"
             "                               (default is false).\n"
             "  -a, --harmonize              Harmonize symbols.\n"
+            "  -j, --jobs=N                 Compute the result in N threads\n"
+            "                               (default is 1).\n"
            );
         //print_common_binary_program_parameter_instructions(message_out);
         fprintf(message_out,
@@ -117,11 +120,12 @@ parse_options(int argc, char** argv)
           {"encode-weights", no_argument, 0, 'e'},
           {"fast", no_argument, 0, 'f'},
           {"harmonize", no_argument, 0, 'a'},
+          {"jobs", required_argument, 0, 'j'},
           {0,0,0,0}
         };
         int option_index = 0;
         int c = getopt_long(argc, argv, HFST_GETOPT_COMMON_SHORT
-                             HFST_GETOPT_BINARY_SHORT "FIeHfa",
+                             HFST_GETOPT_BINARY_SHORT "FIeHfaj:",
                              long_options, &option_index);
         if (-1 == c)
         {
@@ -144,6 +148,13 @@ parse_options(int argc, char** argv)
         case 'a':
           harmonize = true;
           break;
+        case 'j':
+          jobs = hfst_strtoul(optarg, 10);
+          if (jobs == 0)
+            {
+              error(EXIT_FAILURE, 0, "--jobs must be at least 1");
+            }
+          break;
         }
     }
 
@@ -449,6 +460,7 @@ int main( int argc, char **argv ) {
     {
         fclose(outfile);
     }
+    hfst::set_compose_intersect_jobs(jobs);
     verbose_printf("Reading from %s and %s, writing to %s\n",
         firstfilename, secondfilename, outfilename);
     // here starts the buffer handling part
@@ -67,6 +67,9 @@ print_usage()
 "  -x, --xerox-composition=VALUE Whether flag diacritics are treated as ordinary\n"
 "                                symbols in composition (default is false).\n"
 "  -X, --xfst=VARIABLE    Toggle xfst compatibility option VARIABLE.\n"
+"  -l, --lookahead        Compose with label lookahead, building no states\n"
+"                         that cannot lead anywhere (tropical weight only).\n"
+"                         Epsilons may be aligned differently.\n"
                 "Harmonization:\n"
                 "  -H, --do-not-harmonize Do not harmonize symbols.\n"
                 "  -F, --harmonize-flags  Harmonize flag diacritics.\n");
@@ -103,11 +106,12 @@ parse_options(int argc, char** argv)
           {"do-not-harmonize", no_argument, 0, 'H'},
           {"xerox-composition", required_argument, 0, 'x'},
           {"xfst", required_argument, 0, 'X'},
+          {"lookahead", no_argument, 0, 'l'},
           {0,0,0,0}
         };
         int option_index = 0;
         int c = getopt_long(argc, argv, HFST_GETOPT_COMMON_SHORT
-                             HFST_GETOPT_BINARY_SHORT "FHx:X:",
+                             HFST_GETOPT_BINARY_SHORT "FHx:X:l",
                              long_options, &option_index);
         if (-1 == c)
         {
@@ -159,6 +163,9 @@ parse_options(int argc, char** argv)
               }
           }
           break;
+        case 'l':
+          hfst::set_lookahead_composition(true);
+          break;
 #include "inc/getopt-cases-error.h"
         }
     }
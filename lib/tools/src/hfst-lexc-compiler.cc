@@ -42,6 +42,7 @@
 
 #include "HfstTransducer.h"
 #include "HfstOutputStream.h"
+#include "HfstCompilationCache.h"
 #include "parsers/LexcCompiler.h"
 
 using hfst::HfstTransducer;
@@ -67,6 +68,8 @@ static bool rename_flags = false;
 static bool treat_warnings_as_errors = false;
 static bool xerox_composition = true;  // Compatibility with Xerox tools is the default
 static bool encode_weights = false;
+static unsigned int jobs = 1;
+static char* cache_directory = 0;
 static bool enc = false;
 
 void
@@ -84,13 +87,16 @@ print_usage()
                "  -A, --alignStrings      align characters in input and output strings\n"
                "  -E, --encode-weights    encode weights when minimizing (default is false)\n"
                "  -F, --withFlags         use flags to hyperminimize result\n"
+               "  -j, --jobs=N            minimize in N threads (default is 1)\n"
                "  -M, --minimizeFlags     if --withFlags is used, minimize the number of flags\n"
                "  -R, --renameFlags       if --withFlags and --minimizeFlags are used, rename\n"
                "                          flags (for testing)\n"
                "  -x, --xerox-composition=VALUE Whether flag diacritics are treated as ordinary\n"
                "                                symbols in composition (default is true).\n"
                "  -X, --xfst=VARIABLE     toggle xfst compatibility option VARIABLE.\n"
-               "  -W, --Werror            treat warnings as errors\n");
+               "  -W, --Werror            treat warnings as errors\n"
+               "      --cache=DIR         reuse lexicons compiled in earlier runs from\n"
+               "                          directory DIR and store new ones there\n");
         fprintf(message_out, "\n");
         fprintf(message_out,
                 "If INFILE or OUTFILE are omitted or -, standard streams will "
@@ -137,16 +143,18 @@ parse_options(int argc, char** argv)
           {"output", required_argument, 0, 'o'},
           {"alignStrings", no_argument,    0, 'A'},
           {"withFlags", no_argument,    0, 'F'},
+          {"jobs", required_argument,    0, 'j'},
           {"minimizeFlags", no_argument,    0, 'M'},
           {"renameFlags", no_argument,    0, 'R'},
           {"xerox-composition", required_argument,    0, 'x'},
           {"xfst", required_argument, 0, 'X'},
           {"Werror", no_argument,    0, 'W'},
+          {"cache", required_argument,    0, 'K'},
           {0,0,0,0}
         };
         int option_index = 0;
         int c = getopt_long(argc, argv, HFST_GETOPT_COMMON_SHORT
-                             "Ef:o:AFMRx:X:W",
+                             "Ef:o:AFj:MRx:X:W",
                              long_options, &option_index);
         if (-1 == c)
         {
@@ -167,6 +175,13 @@ parse_options(int argc, char** argv)
         case 'F':
           with_flags = true;
           break;
+        case 'j':
+          jobs = hfst_strtoul(optarg, 10);
+          if (jobs == 0)
+            {
+              error(EXIT_FAILURE, 0, "--jobs must be at least 1");
+            }
+          break;
         case 'M':
           minimize_flags = true;
           break;
@@ -212,6 +227,9 @@ parse_options(int argc, char** argv)
         case 'W':
           treat_warnings_as_errors = true;
           break;
+        case 'K':
+          cache_directory = hfst_strdup(optarg);
+          break;
 
 #include "inc/getopt-cases-error.h"
         }
@@ -342,6 +360,7 @@ int main( int argc, char **argv ) {
       {
         hfst::set_encode_weights(true);
       }
+    hfst::set_minimization_jobs(jobs);
 
     verbose_printf("Reading from ");
     for (unsigned int i = 0; i < lexccount; i++)
@@ -370,6 +389,12 @@ int main( int argc, char **argv ) {
       {
         lexc.setTreatWarningsAsErrors(true);
       }
+    std::unique_ptr<hfst::HfstCompilationCache> cache;
+    if (cache_directory != 0)
+      {
+        cache.reset(new hfst::HfstCompilationCache(cache_directory));
+        lexc.setCache(cache.get());
+      }
     retval = lexc_streams(lexc, *outstream);
     for (unsigned int i = 0; i < lexccount; i++)
       {
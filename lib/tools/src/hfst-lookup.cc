@@ -112,6 +112,9 @@ static int cascade_ = CASCADE_UNION;
 // symbols actually seen in (non-ol) transducers
 static std::vector<std::set<std::string> > cascade_symbols_seen;
 static std::vector<bool> cascade_unknown_or_identity_seen;
+// optimized-lookup cascade looked up in step, created at the first lookup
+// so that the symbols matched between the transducers are kept
+static hfst_ol::TransducerCascade * cascade_in_step = NULL;
 
 enum lookup_input_format
 {
@@ -284,7 +287,9 @@ print_usage()
     fprintf(message_out, "\n");
 
     fprintf(message_out, "CASCADE must be one of { union, priority-union, composition }.\n"
-            "If not specified, defaults to {union}.\n");
+            "If not specified, defaults to {union}. With {composition}, optimized\n"
+            "lookup transducers are looked up in step without composing them, so\n"
+            "flag diacritics of one transducer are not seen by the next.\n");
     fprintf(message_out, "\n");
 
     fprintf(message_out, "STREAM can be { input, output, both }. If not given, defaults to {both}.\n"
@@ -1436,6 +1441,43 @@ HfstOneLevelPaths*
 lookup_cascading(const HfstOneLevelPath& s, vector<HfstTransducer> & cascade,
                  bool* infinity)
 {
+  if ((cascade_ == CASCADE_COMPOSITION) && !print_pairs)
+    {
+      // traverse the transducers in step instead of looking up
+      // each intermediate result separately
+      if (cascade_in_step == NULL)
+        {
+          cascade_in_step = HfstTransducer::create_lookup_cascade(cascade);
+        }
+      std::string input_str;
+      for (StringVector::const_iterator it = s.second.begin();
+           it != s.second.end(); ++it)
+        {
+          input_str.append(*it);
+        }
+      ssize_t limit = max_number;
+      if (time_cutoff == 0.0 &&
+          cascade_in_step->is_lookup_infinitely_ambiguous(input_str))
+        {
+          limit = (max_number == -1)? MAX_NUMBER : max_number;
+          if (!silent) {
+            if (max_number == -1)
+              warning(0, 0, "Got infinite results, number of results limited to " SIZE_T_SPECIFIER "\n"
+                      "(can be controlled with --max-number=N)",
+                      (size_t)limit);
+            else
+              warning(0, 0, "Got infinite results, number of results limited to " SIZE_T_SPECIFIER "",
+                      (size_t)limit);
+          }
+          *infinity = true;
+        }
+      HfstOneLevelPaths* results =
+        cascade_in_step->lookup_fd(input_str, limit, time_cutoff);
+      verbose_printf("" SIZE_T_SPECIFIER " results @ level %u\n",
+                     results->size(), (unsigned int)(cascade.size() - 1));
+      return results;
+    }
+
   HfstOneLevelPaths* results = new HfstOneLevelPaths;
 
   // go through all transducers in the cascade
@@ -1958,6 +2000,8 @@ process_stream(HfstInputStream& inputstream, FILE* outstream)
       {
         fprintf(stderr, "%ld/%ld... Done\n", filepos, filesize);
       }
+    delete cascade_in_step;
+    cascade_in_step = NULL;
     free(line);
     if (print_statistics)
       {
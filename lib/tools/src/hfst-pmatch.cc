@@ -98,6 +98,8 @@ static int max_context = -1;
 static double time_cutoff = 0.0;
 static hfst_ol::Weight weight_cutoff = hfst_ol::INFINITE_WEIGHT;
 static bool profile = false;
+static hfst_ol::ProfileFormat profile_format = hfst_ol::profile_text;
+static std::string profile_filename;
 
 void
 print_usage()
@@ -121,7 +123,9 @@ print_usage()
             "      --max-recursion     Upper limit for recursion\n"
             "      --weight-cutoff=W   Upper limit for allowed weight\n"
             "  -t, --time-cutoff=S     Limit search after having used S seconds per input\n"
-            "  -p  --profile           Produce profiling data\n");
+            "  -p  --profile[=FORMAT]  Produce profiling data, FORMAT is text (default),\n"
+            "                          json or collapsed (stacks for flamegraph tools)\n"
+            "      --profile-file=FILE Write profiling data to FILE instead of output\n");
     fprintf(message_out,
             "Use standard streams for input and output.\n"
             "\n"
@@ -257,7 +261,16 @@ int process_input(hfst_ol::PmatchContainer & container,
         outstream << "\n" << container.get_pattern_count_info() << "\n";
     }
     if (profile) {
-        outstream << "\n" << container.get_profiling_info() << "\n";
+        if (!profile_filename.empty()) {
+            std::ofstream profile_stream(profile_filename.c_str());
+            if (!profile_stream.good()) {
+                std::cerr << "Could not open file " << profile_filename << std::endl;
+                return EXIT_FAILURE;
+            }
+            profile_stream << container.get_profiling_info(profile_format);
+        } else {
+            outstream << "\n" << container.get_profiling_info(profile_format) << "\n";
+        }
     }
     return EXIT_SUCCESS;
 }
@@ -284,11 +297,12 @@ int parse_options(int argc, char** argv)
                 {"max-recursion", required_argument, 0, 'r'},
                 {"weight-cutoff", required_argument, 0, 'W'},
                 {"time-cutoff", required_argument, 0, 't'},
-                {"profile", no_argument, 0, 'p'},
+                {"profile", optional_argument, 0, 'p'},
+                {"profile-file", required_argument, 0, 'P'},
                 {0,0,0,0}
             };
         int option_index = 0;
-        int c = getopt_long(argc, argv, HFST_GETOPT_COMMON_SHORT HFST_GETOPT_UNARY_SHORT "nxlwcdmb:r:W:t:p",
+        int c = getopt_long(argc, argv, HFST_GETOPT_COMMON_SHORT HFST_GETOPT_UNARY_SHORT "nxlwcdmb:r:W:t:p::",
                             long_options, &option_index);
         if (-1 == c)
         {
@@ -354,6 +368,16 @@ int parse_options(int argc, char** argv)
             break;
         case 'p':
             profile = true;
+            if (optarg != NULL &&
+                !hfst_ol::PmatchContainer::parse_profile_format(optarg, profile_format))
+            {
+                std::cerr << "Invalid argument for --profile\n";
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'P':
+            profile = true;
+            profile_filename = optarg;
             break;
 #include "inc/getopt-cases-error.h"
         }
@@ -61,6 +61,7 @@ using std::pair;
 #include "HfstOutputStream.h"
 #include "HfstExceptionDefs.h"
 #include "implementations/ConvertTransducerFormat.h"
+#include "HfstCompilationCache.h"
 #include "parsers/PmatchCompiler.h"
 #include "hfst-commandline.h"
 #include "hfst-program-options.h"
@@ -79,6 +80,8 @@ static char *epsilonname=NULL;
 //static bool line_separated = false;
 static bool flatten = false;
 static bool include_cosine_distances = false;
+static unsigned int jobs = 1;
+static char *cache_directory = NULL;
 static clock_t timer;
 
 #if HAVE_OPENFST
@@ -102,8 +105,11 @@ print_usage()
     print_common_unary_program_options(message_out);
     fprintf(message_out, "String and format options:\n"
             "  -e, --epsilon=EPS         Map EPS as zero\n"
+            "  -j, --jobs=N              Minimize in N threads (default is 1)\n"
             "      --flatten             Compile in all RTNs\n"
-            "      --cosine-distances    When compiling Like() operations, include cosine distance info\n");
+            "      --cosine-distances    When compiling Like() operations, include cosine distance info\n"
+            "      --cache=DIR           Reuse transducers compiled in earlier runs from\n"
+            "                            directory DIR and store new ones there\n");
     fprintf(message_out, "\n");
 
     fprintf(message_out,
@@ -135,13 +141,15 @@ parse_options(int argc, char** argv)
                 HFST_GETOPT_COMMON_LONG,
                 HFST_GETOPT_UNARY_LONG,
                 {"epsilon", required_argument, 0, 'e'},
+                {"jobs", required_argument, 0, 'j'},
                 {"flatten", no_argument, 0, '1'},
                 {"cosine-distances", no_argument, 0, '2'},
+                {"cache", required_argument, 0, 'K'},
                 {0,0,0,0}
             };
         int option_index = 0;
         int c = getopt_long(argc, argv, HFST_GETOPT_COMMON_SHORT
-                             HFST_GETOPT_UNARY_SHORT "e:",
+                             HFST_GETOPT_UNARY_SHORT "e:j:",
                              long_options, &option_index);
         if (-1 == c)
         {
@@ -155,12 +163,22 @@ parse_options(int argc, char** argv)
         case 'e':
             epsilonname = hfst_strdup(optarg);
             break;
+        case 'j':
+            jobs = hfst_strtoul(optarg, 10);
+            if (jobs == 0)
+            {
+                error(EXIT_FAILURE, 0, "--jobs must be at least 1");
+            }
+            break;
         case '1':
             flatten = true;
             break;
         case '2':
             include_cosine_distances = true;
             break;
+        case 'K':
+            cache_directory = hfst_strdup(optarg);
+            break;
 #include "inc/getopt-cases-error.h"
         }
     }
@@ -202,6 +220,11 @@ process_stream(HfstOutputStream& outstream)
     comp.set_verbose(verbose);
     comp.set_flatten(flatten);
     comp.set_include_cosine_distances(include_cosine_distances);
+    std::unique_ptr<hfst::HfstCompilationCache> cache;
+    if (cache_directory != NULL) {
+        cache.reset(new hfst::HfstCompilationCache(cache_directory));
+        comp.set_cache(cache.get());
+    }
     std::string file_contents;
     std::map<std::string, HfstTransducer*> definitions;
     int c;
@@ -385,6 +408,7 @@ int main( int argc, char **argv )
     {
         return retval;
     }
+    hfst::set_minimization_jobs(jobs);
     // close buffers, we use streams
     if (outfile != stdout)
     {
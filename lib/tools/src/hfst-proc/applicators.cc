@@ -11,6 +11,8 @@
 //       along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <sstream>
+#include <atomic>
+#include <thread>
 #include "applicators.h"
 #include "lookup-state.h"
 #include "lookup-path.h"
@@ -210,6 +212,202 @@ AnalysisApplicator::apply()
 }
 
 
+//////////Function definitions for ParallelAnalysisApplicator
+
+// A batch is read until it has this many bytes per chunk, or until a
+// null character when null flushing
+#define CHUNK_SIZE 65536
+// The number of chunks read at a time per thread
+#define CHUNKS_PER_JOB 4
+// A batch is cut into chunks of at least this many bytes, so that short
+// null-flushed requests are shared between the threads too
+#define MIN_CHUNK_SIZE 256
+
+ParallelAnalysisApplicator::ParallelAnalysisApplicator(
+  const ProcTransducer& t, TokenIOStream& ts, OutputFormatter& o,
+  CapitalizationMode c, unsigned int jobs):
+  Applicator(t,ts), formatter(o), caps_mode(c), jobs(jobs > 0 ? jobs : 1),
+  cut_after(256, false), cut_after_superblank(false)
+{
+  const ProcTransducerAlphabet& alphabet = transducer.get_alphabet();
+  
+  // superblanks are stepped as blanks
+  cut_after_superblank = !in_longer_symbol('[') && !in_longer_symbol(']') &&
+    !transducer.is_input_symbol(alphabet.get_blank_symbol());
+  
+  const char* spaces = " \t\n\r";
+  for(const char* c=spaces; *c!='\0'; c++)
+  {
+    SymbolNumber s = alphabet.get_symbolizer().find_symbol(std::string(1,*c).c_str());
+    cut_after[(unsigned char)*c] = !in_longer_symbol(*c) &&
+      (s == NO_SYMBOL_NUMBER || !transducer.is_input_symbol(s));
+  }
+}
+
+bool
+ParallelAnalysisApplicator::in_longer_symbol(char c) const
+{
+  const SymbolTable& symbols = transducer.get_alphabet().get_symbol_table();
+  for(size_t i=0; i<symbols.size(); i++)
+  {
+    if(symbols[i].size() > 1 && symbols[i].find(c) != std::string::npos)
+      return true;
+  }
+  return false;
+}
+
+bool
+ParallelAnalysisApplicator::read_batch(std::vector<Chunk>& chunks)
+{
+  std::string input;
+  std::vector<size_t> cuts;
+  bool more_input = read_input(input, cuts);
+
+  // Cut the batch into chunks of about the same size, so that each thread
+  // gets a share of it however short it is
+  size_t chunk_size = input.size() / (CHUNKS_PER_JOB*jobs) + 1;
+  if(chunk_size < MIN_CHUNK_SIZE)
+    chunk_size = MIN_CHUNK_SIZE;
+
+  chunks.clear();
+  size_t begin = 0;
+  for(size_t i=0; i<cuts.size(); i++)
+  {
+    if(cuts[i] - begin >= chunk_size)
+    {
+      chunks.push_back(Chunk());
+      chunks.back().input = input.substr(begin, cuts[i] - begin);
+      begin = cuts[i];
+    }
+  }
+  if(begin < input.size() || chunks.empty())
+  {
+    chunks.push_back(Chunk());
+    chunks.back().input = input.substr(begin);
+  }
+  return more_input;
+}
+
+bool
+ParallelAnalysisApplicator::read_input(std::string& input,
+                                       std::vector<size_t>& cuts)
+{
+  // This follows the way TokenIOStream reads escapes, superblanks and
+  // null characters, so that the input is only cut between tokens
+  std::streambuf* in = token_stream.istream().rdbuf();
+  bool raw = token_stream.get_raw();
+  const int eof = std::char_traits<char>::eof();
+  const size_t batch_size = CHUNK_SIZE*CHUNKS_PER_JOB*jobs;
+
+  while(true)
+  {
+    int c = in->sbumpc();
+    if(c == eof)
+      return false;
+    input += (char)c;
+
+    bool cut = false;
+    if(c == '\0')
+      return token_stream.get_null_flush(); // without null flushing it ends the input
+    else if(!raw && c == '\\')
+    {
+      if((c = in->sbumpc()) == eof)
+        return false;
+      input += (char)c;
+    }
+    else if(!raw && c == '[')
+    {
+      bool is_wblank = (in->sgetc() == '[');
+      while((c = in->sbumpc()) != eof)
+      {
+        input += (char)c;
+        if(c == '\\')
+        {
+          if((c = in->sbumpc()) == eof)
+            return false;
+          input += (char)c;
+        }
+        else if(c == ']')
+          break;
+      }
+      if(c == eof)
+        return false;
+      if(is_wblank && in->sgetc() == ']')
+        input += (char)in->sbumpc();
+      cut = cut_after_superblank;
+    }
+    else
+      cut = cut_after[c];
+
+    if(cut)
+    {
+      cuts.push_back(input.size());
+      if(input.size() >= batch_size)
+        return true;
+    }
+  }
+}
+
+void
+ParallelAnalysisApplicator::analyse(Chunk& chunk) const
+{
+  std::istringstream is(chunk.input);
+  std::ostringstream os;
+  TokenIOStream chunk_stream(is, os, transducer.get_alphabet(),
+                             token_stream.get_null_flush(),
+                             token_stream.get_raw());
+  OutputFormatter* chunk_formatter = formatter.clone(chunk_stream);
+  try
+  {
+    AnalysisApplicator(transducer, chunk_stream, *chunk_formatter, caps_mode).apply();
+  }
+  catch(...)
+  {
+    chunk.error = std::current_exception();
+  }
+  delete chunk_formatter;
+  chunk.output = os.str();
+}
+
+void
+ParallelAnalysisApplicator::apply()
+{
+  std::vector<Chunk> chunks;
+  bool more_input = true;
+  while(more_input)
+  {
+    more_input = read_batch(chunks);
+
+    // each thread takes the next chunk that nobody has taken yet
+    std::atomic<size_t> next_chunk(0);
+    std::vector<std::thread> threads;
+    for(unsigned int t=0; t<jobs && t<chunks.size(); t++)
+    {
+      threads.push_back(std::thread([this,&chunks,&next_chunk]()
+        {
+          for(size_t i=next_chunk++; i<chunks.size(); i=next_chunk++)
+            analyse(chunks[i]);
+        }));
+    }
+    for(size_t t=0; t<threads.size(); t++)
+      threads[t].join();
+
+    std::ostream& os = token_stream.ostream();
+    for(size_t i=0; i<chunks.size(); i++)
+    {
+      os << chunks[i].output;
+      if(chunks[i].error)
+      {
+        os.flush();
+        std::rethrow_exception(chunks[i].error);
+      }
+    }
+    if(token_stream.get_null_flush())
+      os.flush();
+  }
+}
+
+
 //////////Function definitions for GenerationApplicator
 
 void
@@ -13,6 +13,7 @@
 #ifndef _HFST_PROC_APPLICATORS_H_
 #define _HFST_PROC_APPLICATORS_H_
 
+#include <exception>
 #include "lookup-path.h"
 #include "tokenizer.h"
 #include "transducer.h"
@@ -56,6 +57,64 @@ class AnalysisApplicator: public Applicator
   void apply();
 };
 
+/**
+ * Does the same as AnalysisApplicator in several threads. The input is cut
+ * into chunks at points where AnalysisApplicator always starts a new lookup:
+ * after superblanks and whitespace that no transition of the transducer
+ * reads, and after null characters. Each chunk is analysed with its own
+ * token stream and formatter, and the results are written in input order.
+ */
+class ParallelAnalysisApplicator: public Applicator
+{
+ private:
+  struct Chunk
+  {
+    std::string input;
+    std::string output;
+    std::exception_ptr error;
+  };
+
+  OutputFormatter& formatter;
+  CapitalizationMode caps_mode;
+  unsigned int jobs;
+
+  /**
+   * Whether the input can be cut after each byte outside superblanks, and
+   * after a superblank. This is true for whitespace and superblanks that no
+   * transition of the transducer reads, since they end every lookup
+   */
+  std::vector<bool> cut_after;
+  bool cut_after_superblank;
+
+  /**
+   * Whether the character is a part of some symbol longer than one byte.
+   * The input isn't cut after such characters, and superblanks aren't
+   * trusted to be found correctly if brackets occur in symbols
+   */
+  bool in_longer_symbol(char c) const;
+
+  /**
+   * Read a batch of input that is large enough for all threads, or that
+   * ends at a null character when null flushing, and cut it into chunks
+   * of about the same size
+   * @return false if the input ended
+   */
+  bool read_batch(std::vector<Chunk>& chunks);
+
+  /**
+   * Read a batch of input, collecting the offsets where it may be cut
+   * @return false if the input ended
+   */
+  bool read_input(std::string& input, std::vector<size_t>& cuts);
+
+  void analyse(Chunk& chunk) const;
+ public:
+  ParallelAnalysisApplicator(const ProcTransducer& t, TokenIOStream& ts,
+                             OutputFormatter& o, CapitalizationMode c,
+                             unsigned int jobs);
+  void apply();
+};
+
 class GenerationApplicator: public Applicator
 {
  private:
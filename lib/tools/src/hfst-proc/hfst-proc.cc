@@ -126,6 +126,7 @@ bool print_usage(void)
     "                          (if the transducer is weighted, the N best analyses)\n" <<
     "  --weight-classes N      Output no more than N best weight classes\n" <<
     "                          (where analyses with equal weight constitute a class\n"
+    "  --jobs N                Analyse the input in N threads\n" <<
     "  -c, --case-sensitive    Perform lookup using the literal case of the input\n" <<
     "                          characters\n" <<
     "  -w  --dictionary-case   Output results using dictionary case instead of\n" <<
@@ -172,6 +173,7 @@ int main(int argc, char **argv)
   int capitalization = 0;
   bool filter_compound_analyses = true;
   bool null_flush = false;
+  int jobs = 1;
 
   while (true)
   {
@@ -204,6 +206,7 @@ int main(int argc, char **argv)
       {"dictionary-case",no_argument,       0, 'w'},
       {"null-flush",     no_argument,       0, 'z'},
       {"raw",            no_argument,       0, 'X'},
+      {"jobs",           required_argument, 0, 'J'},
       {0,                0,                 0,  0 }
     };
 
@@ -305,6 +308,15 @@ int main(int argc, char **argv)
         }
       break;
 
+    case 'J':
+      jobs = atoi(optarg);
+      if (jobs < 1)
+        {
+          std::cerr << "Invalid or no argument for job count\n";
+          return EXIT_FAILURE;
+        }
+      break;
+
     case 'e':
       processCompounds = true;
       break;
@@ -466,7 +478,10 @@ int main(int argc, char **argv)
           default:
             output_formatter = (OutputFormatter*)new ApertiumOutputFormatter(token_stream, filter_compound_analyses);
         }
-        applicator = new AnalysisApplicator(t, token_stream, *output_formatter, capitalization_mode);
+        if(jobs > 1)
+          applicator = new ParallelAnalysisApplicator(t, token_stream, *output_formatter, capitalization_mode, jobs);
+        else
+          applicator = new AnalysisApplicator(t, token_stream, *output_formatter, capitalization_mode);
         break;
     }
 
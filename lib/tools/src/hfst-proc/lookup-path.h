@@ -15,18 +15,15 @@
 
 #include "hfst-proc.h"
 #include "transducer.h"
-#include "HfstFlagDiacritics.h"
 
 /**
- * Represents a (possibly partial) path through a transducer. This is used
- * during lookup for storing lookup paths that are continued as input symbols
- * are provided.
+ * A complete lookup path, as handed out by LookupState once the path has
+ * reached a final state. The paths under construction are kept in the
+ * state's path pool and only converted into LookupPaths when asked for.
  */
 class LookupPath
 {
  protected:
-  const ProcTransducer& transducer;
- 
   /**
    * Points to the state in the transition index table or the transition table
    * where the path ends. This follows the normal semantics whereby values less
@@ -47,31 +44,12 @@ class LookupPath
   SymbolNumberVector output_symbols;
   
  public:
-  LookupPath(const ProcTransducer& t, const TransitionTableIndex initial):
-    transducer(t), index(initial), final(false), output_symbols() {}
-  
-  LookupPath(const LookupPath& o):
-    transducer(o.transducer), index(o.index), final(o.final), output_symbols(o.output_symbols) {}
+  LookupPath(const TransitionTableIndex index, bool final,
+             const SymbolNumberVector& output_symbols):
+    index(index), final(final), output_symbols(output_symbols) {}
   
   virtual ~LookupPath() {}
   
-  virtual LookupPath* clone() const {return new LookupPath(*this);}
-  
-  /**
-   * Follow the transition index, modifying our index
-   * @param index the index to follow
-   */
-  virtual void follow(const TransitionIndex& index);
-  
-  /**
-   * Follow the transition, appending the output symbol
-   * @param transition the transition to follow
-   * @true if following the transition succeeded. This can fail because of
-   *       e.g. flag diacritics in some subclasses
-   */
-  virtual bool follow(const Transition& transition);
-  
-  
   static bool compare_pointers(LookupPath* p1, LookupPath* p2) {return *p1<*p2;}
   
   virtual bool operator<(const LookupPath& o) const;
@@ -83,41 +61,6 @@ class LookupPath
 
 typedef std::set<LookupPath*, bool (*)(LookupPath*,LookupPath*)> LookupPathSet;
 
-/**
- * A base class used by lookup path types that handle flag diacritics
- */
-class PathFd
-{
- protected:
-  /**
-   * The values of the flag diacritic features at the end of the path
-   */
-  FdState<SymbolNumber> fd_state;
-  
-  bool evaluate_flag_diacritic(SymbolNumber s);
-  
-  PathFd(const FdTable<SymbolNumber>& table):
-    fd_state(table) {}
-  PathFd(const PathFd& o): fd_state(o.fd_state) {}
-  virtual ~PathFd() {}
-};
-
-/**
- * A lookup path which additionally stores the state of the flag diacritics on
- * the path and whose follow is conditional based on evaluation diacritics
- */
-class LookupPathFd : public LookupPath, PathFd
-{
- public:
-  LookupPathFd(const ProcTransducer& t, const TransitionTableIndex initial):
-    LookupPath(t, initial), PathFd(t.get_alphabet().get_fd_table()) {}
-  LookupPathFd(const LookupPathFd& o): LookupPath(o), PathFd(o) {}
-  
-  virtual LookupPath* clone() const {return new LookupPathFd(*this);}
-  
-  virtual bool follow(const Transition& transition);
-};
-
 /**
  * A lookup path which additionally stores the summed weight of the path
  */
@@ -134,15 +77,11 @@ class LookupPathW : public LookupPath
    */
   Weight final_weight;
  public:
-  LookupPathW(const ProcTransducer& t, const TransitionTableIndex initial):
-        LookupPath(t, initial), weight(0.0f), final_weight(0.0f) {}
-  LookupPathW(const LookupPathW& o): LookupPath(o), weight(o.weight),
-    final_weight(o.final_weight) {}
-  
-  virtual LookupPath* clone() const {return new LookupPathW(*this);}
-
-  virtual void follow(const TransitionIndex& index);
-  virtual bool follow(const Transition& transition);
+  LookupPathW(const TransitionTableIndex index, bool final,
+              const SymbolNumberVector& output_symbols,
+              Weight weight, Weight final_weight):
+    LookupPath(index, final, output_symbols), weight(weight),
+    final_weight(final_weight) {}
   
   static bool compare_weights(LookupPath* p1, LookupPath* p2) {
           LookupPathW* pw1 = dynamic_cast<LookupPathW*>(p1);
@@ -163,19 +102,4 @@ class LookupPathW : public LookupPath
   Weight get_weight() const {return at_final() ? weight+final_weight : weight;}
 };
 
-/**
- * A lookup path with weight and flag diacritics
- */
-class LookupPathWFd : public LookupPathW, PathFd
-{
- public:
-  LookupPathWFd(const ProcTransducer& t, const TransitionTableIndex initial):
-    LookupPathW(t, initial), PathFd(t.get_alphabet().get_fd_table()) {}
-  LookupPathWFd(const LookupPathWFd& o): LookupPathW(o), PathFd(o) {}
-  
-  virtual LookupPath* clone() const {return new LookupPathWFd(*this);}
-  
-  virtual bool follow(const Transition& transition);
-};
-
 #endif
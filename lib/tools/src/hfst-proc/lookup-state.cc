@@ -10,13 +10,42 @@
 //       You should have received a copy of the GNU General Public License
 //       along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
 #include "lookup-state.h"
 
+LookupState::LookupState(const ProcTransducer& t):
+  transducer(t), weighted(t.get_header().probe_flag(Weighted)),
+  has_flag_diacritics(t.get_alphabet().has_flag_diacritics()),
+  empty_output(), paths(), new_paths(), output_nodes(), fd_states(),
+  fd_state_numbers(), fd_transitions(), finals()
+{
+  const SymbolTable& symbols = t.get_alphabet().get_symbol_table();
+  empty_output.resize(symbols.size());
+  for(size_t i=0; i<symbols.size(); i++)
+    empty_output[i] = (t.get_alphabet().symbol_to_string(i) == "");
+  
+  if(has_flag_diacritics)
+    intern_fd_state(FdState<SymbolNumber>(t.get_alphabet().get_fd_table()));
+  else
+    fd_states.push_back(FdState<SymbolNumber>());
+  
+  reset();
+}
+
 void
-LookupState::init(LookupPath* initial)
+LookupState::init()
 {
   clear_paths();
+  
+  PooledPath initial;
+  initial.index = 0;
+  initial.final = false;
+  initial.output = NO_OUTPUT_NODE;
+  initial.fd_state = 0;
+  initial.weight = 0.0f;
+  initial.final_weight = 0.0f;
   paths.push_back(initial);
+  
   try_epsilons();
 }
 
@@ -30,6 +59,8 @@ LookupState::lookup(const SymbolNumberVector& input, CapitalizationMode mode)
 void
 LookupState::step(const SymbolNumber input, const SymbolNumber altinput)
 {
+  clear_finals();
+  
   if(input == NO_SYMBOL_NUMBER)
   {
     clear_paths();
@@ -62,106 +93,179 @@ LookupState::step(const SymbolNumber input, CapitalizationMode mode)
 void
 LookupState::clear_paths()
 {
-  for(LookupPathVector::const_iterator it = paths.begin(); it!=paths.end(); it++)
-    delete *it;
+  clear_finals();
   paths.clear();
+  // no path refers to the output nodes anymore
+  output_nodes.clear();
+}
+
+void
+LookupState::clear_finals()
+{
+  for(LookupPathVector::const_iterator it = finals.begin(); it!=finals.end(); it++)
+    delete *it;
+  finals.clear();
+}
+
+size_t
+LookupState::intern_fd_state(const FdState<SymbolNumber>& fd_state)
+{
+  std::map<std::vector<hfst::FdValue>, size_t>::const_iterator it =
+    fd_state_numbers.find(fd_state.get_values());
+  if(it != fd_state_numbers.end())
+    return it->second;
+  
+  size_t number = fd_states.size();
+  fd_states.push_back(fd_state);
+  fd_state_numbers[fd_state.get_values()] = number;
+  return number;
+}
+
+size_t
+LookupState::apply_flag_diacritic(size_t fd_state, SymbolNumber symbol)
+{
+  if(!has_flag_diacritics || !transducer.get_alphabet().is_flag_diacritic(symbol))
+    return fd_state;
+  
+  std::pair<size_t,SymbolNumber> key(fd_state, symbol);
+  std::map<std::pair<size_t,SymbolNumber>, size_t>::const_iterator it =
+    fd_transitions.find(key);
+  if(it != fd_transitions.end())
+    return it->second;
+  
+  FdState<SymbolNumber> next = fd_states[fd_state];
+  size_t result = NO_FD_STATE;
+  if(next.apply_operation(symbol))
+    result = intern_fd_state(next);
+  fd_transitions[key] = result;
+  return result;
+}
+
+bool
+LookupState::is_final_index(TransitionTableIndex index) const
+{
+  if(indexes_transition_index_table(index))
+    return transducer.get_index(index).final();
+  else
+    return transducer.get_transition(index).final();
+}
+
+Weight
+LookupState::get_final_weight(TransitionTableIndex index) const
+{
+  if(indexes_transition_index_table(index))
+    return static_cast<const TransitionWIndex&>(transducer.get_index(index)).final_weight();
+  else
+    return static_cast<const TransitionW&>(transducer.get_transition(index)).get_weight();
+}
+
+void
+LookupState::follow(PooledPath& path, const TransitionIndex& index) const
+{
+  path.index = index.get_target();
+  path.final = is_final_index(path.index);
+  if(weighted)
+    path.final_weight = get_final_weight(path.index);
+}
+
+bool
+LookupState::follow(PooledPath& path, const Transition& transition)
+{
+  size_t fd_state = apply_flag_diacritic(path.fd_state, transition.get_input_symbol());
+  if(fd_state == NO_FD_STATE)
+    return false;
+  path.fd_state = fd_state;
+  
+  if(weighted)
+    path.weight += static_cast<const TransitionW&>(transition).get_weight();
+  
+  path.index = transition.get_target();
+  path.final = is_final_index(path.index);
+  
+  SymbolNumber output = transition.get_output_symbol();
+  if(output >= empty_output.size() || !empty_output[output])
+  {
+    OutputNode node;
+    node.symbol = output;
+    node.parent = path.output;
+    path.output = output_nodes.size();
+    output_nodes.push_back(node);
+  }
+  
+  //**is this right? I'm not so sure about the precise semantics of weights
+  //  and finals in this system**
+  if(weighted)
+    path.final_weight = get_final_weight(path.index);
+  return true;
+}
+
+LookupPath*
+LookupState::make_lookup_path(const PooledPath& path) const
+{
+  SymbolNumberVector output_symbols;
+  for(size_t node=path.output; node!=NO_OUTPUT_NODE; node=output_nodes[node].parent)
+    output_symbols.push_back(output_nodes[node].symbol);
+  std::reverse(output_symbols.begin(), output_symbols.end());
+  
+  if(weighted)
+    return new LookupPathW(path.index, path.final, output_symbols,
+                           path.weight, path.final_weight);
+  return new LookupPath(path.index, path.final, output_symbols);
 }
 
 bool
 LookupState::is_final() const
 {
-  for(LookupPathVector::const_iterator i=paths.begin();
-      i!=paths.end(); ++i)
+  for(PooledPathVector::const_iterator i=paths.begin(); i!=paths.end(); ++i)
   {
-    TransitionTableIndex index = (*i)->get_index();
-    if(indexes_transition_index_table(index))
-    {
-      if(transducer.get_index(index).final())
-        return true;
-    }
-    else
-    {
-      if(transducer.get_transition(index).final())
-        return true;
-    }
+    if(is_final_index(i->index))
+      return true;
   }
   return false;
 }
 
 const LookupPathVector
-LookupState::get_finals() const
+LookupState::get_finals()
 {
-  LookupPathVector finals;
-  for(LookupPathVector::const_iterator i=paths.begin(); i!=paths.end(); ++i)
+  clear_finals();
+  for(PooledPathVector::const_iterator i=paths.begin(); i!=paths.end(); ++i)
   {
-    TransitionTableIndex index = (*i)->get_index();
-    if(indexes_transition_index_table(index))
-    {
-      if(transducer.get_index(index).final())
-        finals.push_back(*i);
-    }
-    else
-    {
-      if(transducer.get_transition(index).final())
-        finals.push_back(*i);
-    }
+    if(is_final_index(i->index))
+      finals.push_back(make_lookup_path(*i));
   }
   return finals;
 }
 
 const LookupPathSet
-LookupState::get_finals_set() const
+LookupState::get_finals_set()
 {
   if(printDebuggingInformationFlag)
     std::cout << "Calculating final paths" << std::endl;
-  LookupPathSet finals(LookupPath::compare_pointers);
-  for(LookupPathVector::const_iterator i=paths.begin(); i!=paths.end(); ++i)
+  LookupPathSet finals_set(LookupPath::compare_pointers);
+  const LookupPathVector final_paths = get_finals();
+  for(LookupPathVector::const_iterator i=final_paths.begin(); i!=final_paths.end(); ++i)
   {
-    bool is_final;
-    TransitionTableIndex index = (*i)->get_index();
-    
-    if(indexes_transition_index_table(index))
-      is_final = transducer.get_index(index).final();
-    else
-      is_final = transducer.get_transition(index).final();
+    if(printDebuggingInformationFlag)
+    {
+      std::cout << "  Final path found:";
+      for(SymbolNumberVector::const_iterator itr=(*i)->get_output_symbols().begin();itr!=(*i)->get_output_symbols().end(); itr++)
+        std::cout << " " << *itr;
+      std::cout << std::endl;
+    }
+    std::pair<LookupPathSet::iterator,bool> loc = finals_set.insert(*i);
     
-    if(is_final)
+    if(loc.second == false) // if this form was already in the set
     {
       if(printDebuggingInformationFlag)
+        std::cout << "  Duplicate LookupPath found" << std::endl;
+      if(LookupPathW::compare_weights(*i, *(loc.first))) // if this form has a lower weight than the one there
       {
-        std::cout << "  Final path found:";
-        for(SymbolNumberVector::const_iterator itr=(*i)->get_output_symbols().begin();itr!=(*i)->get_output_symbols().end(); itr++)
-          std::cout << " " << *itr;
-        std::cout << std::endl;
-      }
-      std::pair<LookupPathSet::iterator,bool> loc = finals.insert(*i);
-      
-      if(loc.second == false) // if this form was already in the set
-      {
-        if(printDebuggingInformationFlag)
-          std::cout << "  Duplicate LookupPath found" << std::endl;
-        if(*i < *(loc.first)) // if this form has a lower weight than the one there
-        {
-          finals.erase(loc.first);
-          finals.insert(*i);
-        }
+        finals_set.erase(loc.first);
+        finals_set.insert(*i);
       }
     }
   }
-  return finals;
-}
-
-void
-LookupState::add_path(LookupPath& path)
-{
-  paths.push_back(&path);
-}
-
-void
-LookupState::replace_paths(const LookupPathVector& new_paths)
-{
-  clear_paths();
-  paths = new_paths;
+  return finals_set;
 }
 
 
@@ -171,41 +275,39 @@ LookupState::try_epsilons()
 {
   for(size_t i=0; i<paths.size(); i++)
   {
-    const LookupPath& path = *paths[i];
-    
-    if(indexes_transition_index_table(path.get_index()))
-      try_epsilon_index(path);
+    if(indexes_transition_index_table(paths[i].index))
+      try_epsilon_index(paths[i]);
     else // indexes transition table
-      try_epsilon_transitions(path);
+      try_epsilon_transitions(paths[i]);
   }
 }
 
 void
-LookupState::try_epsilon_index(const LookupPath& path)
+LookupState::try_epsilon_index(const PooledPath path)
 {
   // if this path points to an entry in the transition index table
   // which indexes one or more epsilon transtions
-  const TransitionIndex& index = transducer.get_index(path.get_index()+1);
+  const TransitionIndex& index = transducer.get_index(path.index+1);
   
   if(index.matches(0))
   {
     // copy the current path, follow the index, add the new path to the list
-    LookupPath& epsilon_path = *path.clone();
-    epsilon_path.follow(index);
-    add_path(epsilon_path);
+    PooledPath epsilon_path = path;
+    follow(epsilon_path, index);
+    paths.push_back(epsilon_path);
   }
 }
 
 void
-LookupState::try_epsilon_transitions(const LookupPath& path)
+LookupState::try_epsilon_transitions(const PooledPath path)
 {
   TransitionTableIndex transition_index;
   
   // if the path is pointing to the "state" entry before the transitions
-  if(transducer.get_transition(path.get_index()).get_input_symbol() == NO_SYMBOL_NUMBER)
-    transition_index = path.get_index()+1;
+  if(transducer.get_transition(path.index).get_input_symbol() == NO_SYMBOL_NUMBER)
+    transition_index = path.index+1;
   else // the path is pointing directly to a transition
-    transition_index = path.get_index();
+    transition_index = path.index;
   
   while(true)
   {
@@ -214,14 +316,9 @@ LookupState::try_epsilon_transitions(const LookupPath& path)
     if(transducer.is_epsilon(transition))
     {
       // copy the path, follow the transition, add the new path to the list
-      LookupPath& epsilon_path = *path.clone();
-      if(epsilon_path.follow(transition))
-        add_path(epsilon_path);
-      else
-      {
-        // destroy the new path instead of pushing it
-        delete &epsilon_path;
-      }
+      PooledPath epsilon_path = path;
+      if(follow(epsilon_path, transition))
+        paths.push_back(epsilon_path);
     }
     else
       return;
@@ -234,71 +331,67 @@ LookupState::try_epsilon_transitions(const LookupPath& path)
 void
 LookupState::apply_input(const SymbolNumber input, const SymbolNumber altinput)
 {
-  LookupPathVector new_paths;
   if(input == 0)
   {
-    replace_paths(new_paths);
+    clear_paths();
     return;
   }
   
+  new_paths.clear();
   for(size_t i=0; i<paths.size(); i++)
   {
-    LookupPath& path = *paths[i];
+    const PooledPath& path = paths[i];
     
-    if(indexes_transition_index_table(path.get_index()))
+    if(indexes_transition_index_table(path.index))
     {
-      try_index(new_paths, path, input);
+      try_index(path, input);
       if(altinput != NO_SYMBOL_NUMBER)
-        try_index(new_paths, path, altinput);
-      //if(!try_index(new_paths, path, input) && altinput != NO_SYMBOL_NUMBER)
-      //  try_index(new_paths, path, altinput);
+        try_index(path, altinput);
+      //if(!try_index(path, input) && altinput != NO_SYMBOL_NUMBER)
+      //  try_index(path, altinput);
     }
     else // indexes transition table
     {
-      try_transitions(new_paths, path, input);
+      try_transitions(path, input);
       if(altinput != NO_SYMBOL_NUMBER)
-        try_transitions(new_paths, path, altinput);
-      //if(!try_transitions(new_paths, path, input) && altinput != NO_SYMBOL_NUMBER)
-      //  try_transitions(new_paths, path, altinput);
+        try_transitions(path, altinput);
+      //if(!try_transitions(path, input) && altinput != NO_SYMBOL_NUMBER)
+      //  try_transitions(path, altinput);
     }
   }
   
-  replace_paths(new_paths);
+  paths.swap(new_paths);
+  if(paths.empty())
+    output_nodes.clear();
 }
 
 bool
-LookupState::try_index(LookupPathVector& new_paths,
-                         const LookupPath& path,
-                         const SymbolNumber input) const
+LookupState::try_index(const PooledPath& path, const SymbolNumber input)
 {
   //??? is the +1 here correct?
-  TransitionIndex index = transducer.get_index(path.get_index()+input+1);
+  TransitionIndex index = transducer.get_index(path.index+input+1);
   
   if(index.matches(input))
   {
     // copy the path, follow the index, and handle the new transitions
-    LookupPath& extended_path = *path.clone();
-    extended_path.follow(index);
-    bool res = try_transitions(new_paths, extended_path, input);
-    delete &extended_path;
-    return res;
+    PooledPath extended_path = path;
+    follow(extended_path, index);
+    return try_transitions(extended_path, input);
   }
   return false;
 }
 
 bool
-LookupState::try_transitions(LookupPathVector& new_paths,
-                               const LookupPath& path,
-                               const SymbolNumber input) const
+LookupState::try_transitions(const PooledPath& path, const SymbolNumber input)
 {
   bool found = false;
   TransitionTableIndex transition_index;
   
   // if the path is pointing to the "state" entry before the transitions
-  if(transducer.get_transition(path.get_index()).get_input_symbol() == NO_SYMBOL_NUMBER)
-    transition_index = path.get_index()+1;
+  if(transducer.get_transition(path.index).get_input_symbol() == NO_SYMBOL_NUMBER)
+    transition_index = path.index+1;
   else // the path is pointing directly to a transition
-    transition_index = path.get_index();
+    transition_index = path.index;
   
   while(true)
   {
@@ -307,9 +400,9 @@ LookupState::try_transitions(LookupPathVector& new_paths,
     if(transition.matches(input))
     {
       // copy the path, follow the transition, add the new path to the list
-      LookupPath& extended_path = *path.clone();
-      extended_path.follow(transition);
-      new_paths.push_back(&extended_path);
+      PooledPath extended_path = path;
+      if(follow(extended_path, transition))
+        new_paths.push_back(extended_path);
       found = true;
     }
     else
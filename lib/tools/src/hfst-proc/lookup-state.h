@@ -22,42 +22,164 @@
 class LookupState
 {
  private:
+  /**
+   * An active path in a lookup operation. Paths are stored by value in a
+   * pool that is reused from one step to the next, so branching a path
+   * only copies this record. The output symbols live in a tree of output
+   * nodes where paths that have branched from each other share the prefix
+   * they have in common, and the values of the flag diacritics live in a
+   * table where each distinct combination is stored once.
+   */
+  struct PooledPath
+  {
+    /**
+     * Points to the state in the transition index table or the transition
+     * table where the path ends, with the same semantics as in LookupPath
+     */
+    TransitionTableIndex index;
+    
+    /**
+     * Whether the path ends at a final state
+     */
+    bool final;
+    
+    /**
+     * The node of the last output symbol of the path, or NO_OUTPUT_NODE if
+     * the path hasn't output anything
+     */
+    size_t output;
+    
+    /**
+     * The number of the flag diacritic values at the end of the path
+     */
+    size_t fd_state;
+    
+    /**
+     * The summed weight of the transitions this path has followed and the
+     * extra weight added when the path is at a final state
+     */
+    Weight weight;
+    Weight final_weight;
+  };
+  
+  typedef std::vector<PooledPath> PooledPathVector;
+  
+  /**
+   * An output symbol and the node of the symbol that precedes it
+   */
+  struct OutputNode
+  {
+    SymbolNumber symbol;
+    size_t parent;
+  };
+  
+  static const size_t NO_OUTPUT_NODE = static_cast<size_t>(-1);
+  static const size_t NO_FD_STATE = static_cast<size_t>(-1);
+  
   /**
    * The transducer in which the lookup is occurring
    */
   const ProcTransducer& transducer;
   
+  /**
+   * Whether the paths should track weights and flag diacritics
+   */
+  bool weighted;
+  bool has_flag_diacritics;
+  
+  /**
+   * Whether each symbol of the transducer is printed as an empty string.
+   * Such symbols are left out of the output of the paths
+   */
+  std::vector<bool> empty_output;
+  
   /**
    * The active paths in a lookup operation. At the start of a lookup this will
    * contain one path. The lookup has failed if it is ever empty.
    */
-  LookupPathVector paths;
+  PooledPathVector paths;
   
+  /**
+   * The paths generated by the current input symbol. Kept as a member so
+   * that its storage is reused
+   */
+  PooledPathVector new_paths;
   
   /**
-   * Delete all active paths and clear the list
+   * The output symbols of the paths. This only grows until the lookup is
+   * reset or the active paths die
    */
-  void clear_paths();
+  std::vector<OutputNode> output_nodes;
+  
+  /**
+   * The interned flag diacritic states, a map to their numbers and the
+   * results of applying flag diacritics to them
+   */
+  std::vector<FdState<SymbolNumber> > fd_states;
+  std::map<std::vector<hfst::FdValue>, size_t> fd_state_numbers;
+  std::map<std::pair<size_t,SymbolNumber>, size_t> fd_transitions;
   
   /**
-   * Add a new path to the list of active paths
-   * @param path the path to add
+   * The final paths handed out by get_finals. These are owned by the state
+   * and stay valid until the state is stepped or reset
    */
-  void add_path(LookupPath& path);
+  LookupPathVector finals;
+  
   
   /**
-   * Get rid of the current paths and replace the list with a new list.
-   * @param new_paths the new list of paths to store in the lookup state
+   * Delete all active paths and clear the list
    */
-  void replace_paths(const LookupPathVector& new_paths);
+  void clear_paths();
   
+  /**
+   * Delete the final paths handed out by get_finals
+   */
+  void clear_finals();
   
   /**
    * Setup the state with a single initial path ending at starting state and
    * try epsilons at the initial position
-   * @param initial an initial path to start the lookup
    */
-  void init(LookupPath* initial);
+  void init();
+  
+  /**
+   * Return the number of the given flag diacritic state, adding it to the
+   * table if it isn't there yet
+   */
+  size_t intern_fd_state(const FdState<SymbolNumber>& fd_state);
+  
+  /**
+   * Apply a symbol to an interned flag diacritic state
+   * @param fd_state the number of the state
+   * @param symbol the symbol, which need not be a flag diacritic
+   * @return the number of the resulting state or NO_FD_STATE if the flag
+   *         diacritic disallows the symbol
+   */
+  size_t apply_flag_diacritic(size_t fd_state, SymbolNumber symbol);
+  
+  bool is_final_index(TransitionTableIndex index) const;
+  Weight get_final_weight(TransitionTableIndex index) const;
+  
+  /**
+   * Have the path follow the transition index, modifying its index
+   * @param path the path to modify
+   * @param index the index to follow
+   */
+  void follow(PooledPath& path, const TransitionIndex& index) const;
+  
+  /**
+   * Have the path follow the transition, appending the output symbol
+   * @param path the path to modify
+   * @param transition the transition to follow
+   * @return true if following the transition succeeded. This can fail
+   *         because of flag diacritics
+   */
+  bool follow(PooledPath& path, const Transition& transition);
+  
+  /**
+   * Create a LookupPath with the output symbols of the given path
+   */
+  LookupPath* make_lookup_path(const PooledPath& path) const;
   
   
   /**
@@ -71,17 +193,19 @@ class LookupState
   /**
    * If the given path points to a place in the index table with an epsilon
    * index, generate an additional path by following it
-   * @param path a path pointing to the transition index table
+   * @param path a path pointing to the transition index table. This is a
+   *             copy because adding paths may move the active paths
    */
-  void try_epsilon_index(const LookupPath& path);
+  void try_epsilon_index(const PooledPath path);
   
   /**
    * If the given path points to one or more epsilon transitions, generate
    * additional paths by following them
    * @param path a path pointing to the beginning of a state in the transition
-   *             table or directly to transitions
+   *             table or directly to transitions. This is a copy because
+   *             adding paths may move the active paths
    */
-  void try_epsilon_transitions(const LookupPath& path);
+  void try_epsilon_transitions(const PooledPath path);
   
   
   /**
@@ -97,25 +221,22 @@ class LookupState
    * If the given path points to a place in the index table with an index for
    * the given input symbol, call try_transitions after having the path follow
    * the index
-   * @param new_paths any new paths generated get appended here
    * @param path a path pointing to the transition index table
    * @param input the input symbol to look up in the transition index table
    * @return whether the path has a continuation with the given input
    */
-  bool try_index(LookupPathVector& new_paths,
-                 const LookupPath& path, const SymbolNumber input) const;
+  bool try_index(const PooledPath& path, const SymbolNumber input);
   
   /**
    * If the given path points to one or more transitions whose inputs match
-   * the given input symbol, generate new paths by following them
-   * @param new_paths any new paths generated get appended here
+   * the given input symbol, generate new paths by following them and append
+   * them to new_paths
    * @param path a path pointing to the beginning of a state in the transition
    *             table or directly to transitions
    * @param input the input symbol to look up in the transition table
    * @return whether the path has a continuation with the given input
    */
-  bool try_transitions(LookupPathVector& new_paths,
-                       const LookupPath& path, const SymbolNumber input) const;
+  bool try_transitions(const PooledPath& path, const SymbolNumber input);
   
  public:
   /**
@@ -123,20 +244,18 @@ class LookupState
    * given transducer
    * @param t the transducer in which the lookup will occur
    */
-  LookupState(const ProcTransducer& t): transducer(t), paths()
-  {
-    reset();
-  }
+  LookupState(const ProcTransducer& t);
   
-  LookupState(const LookupState& o): transducer(o.transducer), paths()
-  {
-    for(LookupPathVector::const_iterator it=o.paths.begin(); it!=o.paths.end(); it++)
-      paths.push_back((*it)->clone());
-  }
+  LookupState(const LookupState& o):
+    transducer(o.transducer), weighted(o.weighted),
+    has_flag_diacritics(o.has_flag_diacritics), empty_output(o.empty_output),
+    paths(o.paths), new_paths(), output_nodes(o.output_nodes),
+    fd_states(o.fd_states), fd_state_numbers(o.fd_state_numbers),
+    fd_transitions(o.fd_transitions), finals() {}
   
   ~LookupState()
   {
-    clear_paths();
+    clear_finals();
   }
   
   /**
@@ -144,7 +263,7 @@ class LookupState
    */
   void reset()
   {
-    init(transducer.get_initial_path());
+    init();
   }
   
   /**
@@ -165,15 +284,17 @@ class LookupState
   bool is_final() const;
   
   /**
-   * Get a list of active paths that are at a final state
+   * Get a list of active paths that are at a final state. The paths are
+   * owned by the state and valid until it is stepped or reset
    * @return the active paths that are at a final state
    */
-  const LookupPathVector get_finals() const;
+  const LookupPathVector get_finals();
   
   /**
-   * Get the finals with duplicates removed
+   * Get the finals with duplicates removed. Of duplicates, the one with the
+   * lowest weight is kept
    */
-  const LookupPathSet get_finals_set() const;
+  const LookupPathSet get_finals_set();
   
   /**
    * Do a lookup using all the given symbols. This is equivalent to stepping the
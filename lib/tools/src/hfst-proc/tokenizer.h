@@ -224,8 +224,12 @@ class TokenIOStream
    */
   TokenIOStream& operator<<(const Token& t) {put_token(t); return *this;}
 
+  std::istream& istream() {return is;}
   std::ostream& ostream() {return os;}
 
+  bool get_null_flush() const {return null_flush;}
+  bool get_raw() const {return is_raw;}
+
   void write_escaped(const std::string str) {os << escape(str);}
   void write_escaped(const TokenVector& t) {os << tokens_to_string(t);}
 
@@ -20,17 +20,8 @@
 #include "formatter.h"
 
 
-static LookupPath* create_initial_path(const ProcTransducer& t) { return new LookupPath(t, 0);}
-static LookupPath* create_initial_path_fd(const ProcTransducer& t) { return new LookupPathFd(t, 0);}
-static LookupPath* create_initial_path_weighted(const ProcTransducer& t) { return new LookupPathW(t, 0);}
-static LookupPath* create_initial_path_weighted_fd(const ProcTransducer& t) { return new LookupPathWFd(t, 0);}
-
 //////////Function definitions for ProcTransducer
 
-InitialPathCreator ProcTransducer::initial_path_creators[2][2] =
-    {{create_initial_path, create_initial_path_fd},
-     {create_initial_path_weighted, create_initial_path_weighted_fd}};
-
 ProcTransducer::ProcTransducer(std::istream& is): Transducer()
 {
   header = new TransducerHeader(is);
@@ -69,9 +60,14 @@ ProcTransducer::is_epsilon(const Transition& transition) const
   return transition.matches(0) || alphabet->is_flag_diacritic(transition.get_input_symbol());
 }
 
-LookupPath*
-ProcTransducer::get_initial_path() const
+bool
+ProcTransducer::is_input_symbol(SymbolNumber symbol) const
 {
-  return (*initial_path_creators[header->probe_flag(Weighted)][alphabet->has_flag_diacritics()])(*this);
+  for(TransitionTableIndex i=0; i<header->target_table_size(); i++)
+  {
+    if(get_transition(i).get_input_symbol() == symbol)
+      return true;
+  }
+  return false;
 }
 
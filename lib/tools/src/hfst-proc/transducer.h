@@ -24,15 +24,9 @@
 
 using namespace hfst_ol;
 
-class ProcTransducer;
-
-typedef LookupPath* (*InitialPathCreator)(const ProcTransducer&);
-
 class ProcTransducer : public Transducer
 {
  protected:
-  static InitialPathCreator initial_path_creators[2][2];
-
   /**
    * Check if the transducer accepts an input string consisting of just a blank
    */
@@ -45,10 +39,9 @@ class ProcTransducer : public Transducer
   bool is_epsilon(const Transition& transition) const;
 
   /**
-   * Create a new lookup path appropriate for initializing a lookup operation.
-   * @return a new lookup path pointing to the beginning of the transducer
+   * Whether any transition of the transducer reads the given symbol
    */
-  LookupPath* get_initial_path() const;
+  bool is_input_symbol(SymbolNumber symbol) const;
 };
 
 #endif
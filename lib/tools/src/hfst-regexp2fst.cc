@@ -47,6 +47,7 @@ using std::pair;
 #include "HfstTransducer.h"
 #include "HfstInputStream.h"
 #include "HfstOutputStream.h"
+#include "HfstCompilationCache.h"
 #include "parsers/XreCompiler.h"
 #include "hfst-commandline.h"
 #include "hfst-program-options.h"
@@ -66,6 +67,8 @@ static bool disjunct_expressions=false;
 static bool line_separated=true;
 
 static bool encode_weights=false;
+static unsigned int jobs=1;
+static char *cache_directory=NULL;
 
 //static unsigned int sum_of_weights=0;
 //static bool sum_weights=false;
@@ -107,6 +110,10 @@ print_usage()
 "  -F, --harmonize-flags     Harmonize flag diacritics.\n"
 "  -E, --encode-weights      Encode weights when minimizing (default is false).\n"
 "  -M, --do-not-minimize     Determinize result instead of minimizing it.\n"
+"      --jobs=N              Determinize and minimize in N threads (default is 1).\n"
+"Other options:\n"
+"      --cache=DIR           Reuse transducers compiled in earlier runs from\n"
+"                            directory DIR and store new ones there.\n"
                 );
         fprintf(message_out, "\n");
 
@@ -160,6 +167,8 @@ parse_options(int argc, char** argv)
           {"xerox-composition", required_argument, 0, 'x'},
           {"xfst", required_argument, 0, 'X'},
           {"do-not-minimize", no_argument, 0, 'M'},
+          {"jobs", required_argument, 0, 'J'},
+          {"cache", required_argument, 0, 'K'},
           {0,0,0,0}
         };
         int option_index = 0;
@@ -211,6 +220,16 @@ parse_options(int argc, char** argv)
         case 'M':
           minimize_result=false;
           break;
+        case 'J':
+          jobs=hfst_strtoul(optarg, 10);
+          if (jobs == 0)
+            {
+              error(EXIT_FAILURE, 0, "--jobs must be at least 1");
+            }
+          break;
+        case 'K':
+          cache_directory=hfst_strdup(optarg);
+          break;
         case 'x':
           {
             const char * argument = hfst_strdup(optarg);
@@ -274,6 +293,12 @@ process_stream(HfstOutputStream& outstream)
   comp.set_error_stream(&std::cerr);
   comp.set_harmonization(harmonize);
   comp.set_flag_harmonization(harmonize_flags);
+  hfst::HfstCompilationCache * cache = NULL;
+  if (cache_directory != NULL)
+    {
+      cache = new hfst::HfstCompilationCache(cache_directory);
+      comp.set_cache(cache);
+    }
   hfst::set_minimization(minimize_result);
   HfstTransducer disjunction(output_format);
 
@@ -425,6 +450,7 @@ process_stream(HfstOutputStream& outstream)
     }
   free(line);
   free(first_line);
+  delete cache;
   return EXIT_SUCCESS;
 }
 
@@ -452,6 +478,7 @@ int main( int argc, char **argv )
       {
         hfst::set_encode_weights(true);
       }
+    hfst::set_minimization_jobs(jobs);
 
   // close buffers, we use streams
   if (outfile != stdout)
@@ -23,6 +23,7 @@
 
 #include <iostream>
 #include <fstream>
+#include <vector>
 
 #include <cstdio>
 #include <cstdlib>
@@ -42,6 +43,13 @@
 
 SentenceTagger * tagger = NULL;
 
+// Number of threads used for tagging.
+unsigned long jobs = 1;
+
+// Number of sentences read at a time per thread, when tagging in
+// several threads.
+#define SENTENCES_PER_JOB 64
+
 void
 print_usage()
 {
@@ -52,6 +60,9 @@ print_usage()
 
     print_common_program_options(message_out);
     print_common_unary_program_options(message_out);
+    fprintf(message_out, "Tagger options:\n"
+            "  -j, --jobs=N           Tag sentences in N threads "
+            "(default is 1)\n");
     fprintf(message_out, "\n");
     fprintf(message_out, "\n");
     print_report_bugs();
@@ -71,12 +82,13 @@ parse_options(int argc, char** argv)
         HFST_GETOPT_COMMON_LONG,
         HFST_GETOPT_UNARY_LONG,
           // add tool-specific options here
+          {"jobs", required_argument, 0, 'j'},
             {0,0,0,0}
         };
         int option_index = 0;
         // add tool-specific options here
         int c = getopt_long(argc, argv, HFST_GETOPT_COMMON_SHORT
-                             HFST_GETOPT_UNARY_SHORT "wDnf:",
+                             HFST_GETOPT_UNARY_SHORT "wDnf:j:",
                              long_options, &option_index);
         if (-1 == c)
         {
@@ -88,7 +100,13 @@ parse_options(int argc, char** argv)
 #include "inc/getopt-cases-common.h"
 #include "inc/getopt-cases-unary.h"
           // add tool-specific cases here
-        break;
+        case 'j':
+          jobs = hfst_strtoul(optarg, 10);
+          if (jobs == 0)
+            {
+              error(EXIT_FAILURE, 0, "Number of jobs must be positive");
+            }
+          break;
 #include "inc/getopt-cases-error.h"
         }
     }
@@ -192,11 +210,34 @@ int main(int argc, char * argv[])
   if (output_file_name != "<stdout>")
     { out = new std::ofstream(output_file_name.c_str()); }
 
-  while (std::cin.peek() != EOF)
+  if (jobs == 1)
+    {
+      while (std::cin.peek() != EOF)
+        {
+          StringVector v = get_sentence_vector();
+          WeightedStringPairVector res = (*tagger)[v];
+          print_analysis(res, out);
+        }
+    }
+  else
     {
-      StringVector v = get_sentence_vector();
-      WeightedStringPairVector res = (*tagger)[v];
-      print_analysis(res, out);
+      // Read a batch of sentences, tag them in parallel and print the
+      // results in input order.
+      std::vector<StringVector> sentences;
+      std::vector<WeightedStringPairVector> taggings;
+
+      while (std::cin.peek() != EOF)
+        {
+          sentences.clear();
+          while (std::cin.peek() != EOF &&
+                 sentences.size() < SENTENCES_PER_JOB*jobs)
+            { sentences.push_back(get_sentence_vector()); }
+
+          tagger->tag(sentences, taggings, jobs);
+
+          for (size_t i = 0; i < sentences.size(); ++i)
+            { print_analysis(taggings[i], out); }
+        }
     }
 
   delete out;
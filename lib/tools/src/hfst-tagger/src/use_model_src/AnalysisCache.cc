@@ -0,0 +1,144 @@
+#include "AnalysisCache.h"
+
+#ifndef MAIN_TEST
+
+Symbol TagTable::intern(const std::string &tag)
+{
+  Symbol2NumberMap::const_iterator it = tag_numbers.find(tag);
+
+  if (it != tag_numbers.end())
+    { return it->second; }
+
+  Symbol number = tag_strings.size();
+  tag_numbers[tag] = number;
+  tag_strings.push_back(tag);
+  return number;
+}
+
+const std::string &TagTable::get_tag(Symbol tag) const
+{ return tag_strings.at(tag); }
+
+size_t TagTable::size(void) const
+{ return tag_strings.size(); }
+
+void TagTable::intern(const WeightedStringVector &analyses,
+                      WeightedTagVector &tags)
+{
+  tags.clear();
+  tags.reserve(analyses.size());
+
+  for (WeightedStringVector::const_iterator it = analyses.begin();
+       it != analyses.end();
+       ++it)
+    { tags.push_back(WeightedTag(it->first,intern(it->second))); }
+}
+
+void TagTable::get_analyses(const WeightedTagVector &tags,
+                            WeightedStringVector &analyses) const
+{
+  analyses.resize(tags.size());
+
+  for (size_t i = 0; i < tags.size(); ++i)
+    {
+      analyses[i].first  = tags[i].first;
+      analyses[i].second = tag_strings[tags[i].second];
+    }
+}
+
+AnalysisCache::AnalysisCache(size_t capacity):
+  capacity(capacity)
+{}
+
+const WeightedTagVector * AnalysisCache::find(const std::string &word)
+{
+  EntryMap::iterator it = entries.find(word);
+
+  if (it == entries.end())
+    { return NULL; }
+
+  // Move word to the front of the list.
+  words.splice(words.begin(),words,it->second.position);
+  return &it->second.analyses;
+}
+
+void AnalysisCache::insert(const std::string &word,
+                           const WeightedTagVector &analyses)
+{
+  if (capacity == 0)
+    { return; }
+
+  EntryMap::iterator it = entries.find(word);
+
+  if (it != entries.end())
+    {
+      it->second.analyses = analyses;
+      words.splice(words.begin(),words,it->second.position);
+      return;
+    }
+
+  if (entries.size() >= capacity)
+    {
+      entries.erase(*words.back());
+      words.pop_back();
+    }
+
+  it = entries.insert(EntryMap::value_type(word,Entry())).first;
+  it->second.analyses = analyses;
+  words.push_front(&it->first);
+  it->second.position = words.begin();
+}
+
+size_t AnalysisCache::size(void) const
+{ return entries.size(); }
+
+#else // MAIN_TEST
+
+#include <cassert>
+
+int main(void)
+{
+  TagTable tag_table;
+  assert(tag_table.intern("NN") == 0);
+  assert(tag_table.intern("VB") == 1);
+  assert(tag_table.intern("NN") == 0);
+  assert(tag_table.get_tag(1) == "VB");
+
+  WeightedStringVector analyses;
+  analyses.push_back(WeightedString(1.0,"VB"));
+  analyses.push_back(WeightedString(2.0,"DT"));
+
+  WeightedTagVector tags;
+  tag_table.intern(analyses,tags);
+  assert(tag_table.size() == 3);
+  assert(tags.size() == 2);
+  assert(tags[0] == WeightedTag(1.0,1));
+  assert(tags[1] == WeightedTag(2.0,2));
+
+  WeightedStringVector strings;
+  tag_table.get_analyses(tags,strings);
+  assert(strings == analyses);
+
+  AnalysisCache cache(2);
+  cache.insert("a",tags);
+  cache.insert("b",WeightedTagVector());
+  assert(cache.size() == 2);
+
+  // "a" is used after "b", so "b" is removed, when "c" is added.
+  assert(cache.find("a") != NULL);
+  cache.insert("c",WeightedTagVector());
+  assert(cache.size() == 2);
+  assert(cache.find("b") == NULL);
+  assert(cache.find("c") != NULL);
+  assert(*cache.find("a") == tags);
+
+  // Now "c" is the least recently used one.
+  cache.insert("d",tags);
+  assert(cache.find("c") == NULL);
+  assert(cache.find("a") != NULL);
+  assert(cache.find("d") != NULL);
+
+  AnalysisCache no_cache(0);
+  no_cache.insert("a",tags);
+  assert(no_cache.find("a") == NULL);
+}
+#endif // MAIN_TEST
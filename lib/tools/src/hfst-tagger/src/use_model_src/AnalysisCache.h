@@ -0,0 +1,71 @@
+#ifndef HEADER_AnalysisCache_h
+#define HEADER_AnalysisCache_h
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <list>
+#include <unordered_map>
+
+#include "DataTypes.h"
+
+// A tag number and a weight. Analyses are stored using tag numbers, so
+// that each tag string is stored only once.
+typedef std::pair<Weight,Symbol> WeightedTag;
+typedef std::vector<WeightedTag> WeightedTagVector;
+
+// Numbers tags densely.
+class TagTable
+{
+ public:
+  Symbol intern(const std::string &tag);
+  const std::string &get_tag(Symbol tag) const;
+  size_t size(void) const;
+
+  // Set tags to the tag numbers of analyses.
+  void intern(const WeightedStringVector &analyses, WeightedTagVector &tags);
+
+  // Set analyses to the strings of tags.
+  void get_analyses(const WeightedTagVector &tags,
+                    WeightedStringVector &analyses) const;
+
+ protected:
+  Symbol2NumberMap tag_numbers;
+  Number2SymbolMap tag_strings;
+};
+
+// Maps words to their analyses. When the cache is full, the least
+// recently used word is removed.
+class AnalysisCache
+{
+ public:
+  AnalysisCache(size_t capacity);
+
+  // Return the analyses of word or NULL, if word is not in the
+  // cache. The pointer is valid until the next call to insert.
+  const WeightedTagVector * find(const std::string &word);
+
+  void insert(const std::string &word, const WeightedTagVector &analyses);
+
+  size_t size(void) const;
+
+ protected:
+  // The words from the most recently used one to the least recently
+  // used one. The strings are the keys of entries, which do not move.
+  typedef std::list<const std::string *> WordList;
+
+  struct Entry
+  {
+    WeightedTagVector  analyses;
+    WordList::iterator position;
+  };
+
+  typedef std::unordered_map<std::string,Entry> EntryMap;
+
+  size_t   capacity;
+  EntryMap entries;
+  WordList words;
+};
+
+#endif // HEADER_AnalysisCache_h
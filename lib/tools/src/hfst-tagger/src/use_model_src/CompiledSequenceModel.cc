@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <limits>
+
+#include "CompiledSequenceModel.h"
+
+#ifndef MAIN_TEST
+
+const Symbol CompiledSequenceModel::NO_SYMBOL = -1;
+
+typedef std::pair<Symbol,TransitionData> SymbolTransitionPair;
+typedef std::vector<SymbolTransitionPair> SymbolTransitionPairVector;
+
+static bool symbol_less(const SymbolTransitionPair &p1,
+                        const SymbolTransitionPair &p2)
+{ return p1.first < p2.first; }
+
+CompiledSequenceModel::CompiledSequenceModel(void)
+{}
+
+Symbol CompiledSequenceModel::add_symbol(const std::string &string_symbol)
+{
+  Symbol2NumberMap::const_iterator it =
+    symbol_to_number_map.find(string_symbol);
+
+  if (it != symbol_to_number_map.end())
+    { return it->second; }
+
+  Symbol symbol = symbol_to_number_map.size();
+  symbol_to_number_map[string_symbol] = symbol;
+  return symbol;
+}
+
+size_t CompiledSequenceModel::add_model(const HfstBasicTransducer &fst)
+{
+  models.push_back(Model());
+  Model &model = models.back();
+
+  State state_count = fst.get_max_state() + 1;
+
+  TransitionData no_transition;
+  no_transition.weight = std::numeric_limits<float>::infinity();
+  no_transition.target = -1;
+
+  model.transition_offsets.reserve(state_count + 1);
+  model.default_transitions.assign(state_count,no_transition);
+  model.final_weights.assign(state_count,
+                             std::numeric_limits<float>::infinity());
+
+  SymbolTransitionPairVector state_transitions;
+
+  for (State s = 0; s < state_count; ++s)
+    {
+      model.transition_offsets.push_back(model.transitions.size());
+
+      if (fst.is_final_state(s))
+        { model.final_weights[s] = fst.get_final_weight(s); }
+
+      const hfst::implementations::HfstBasicTransitions &transitions =
+        fst.transitions(s);
+
+      state_transitions.clear();
+
+      for (hfst::implementations::HfstBasicTransitions::const_iterator it =
+             transitions.begin();
+           it != transitions.end();
+           ++it)
+        {
+          TransitionData transition_data;
+          transition_data.weight = it->get_weight();
+          transition_data.target = it->get_target_state();
+
+          if (it->get_input_symbol() == DEFAULT_SYMBOL)
+            { model.default_transitions[s] = transition_data; }
+          else
+            {
+              state_transitions.push_back
+                (SymbolTransitionPair(add_symbol(it->get_input_symbol()),
+                                      transition_data));
+            }
+        }
+
+      std::stable_sort(state_transitions.begin(),state_transitions.end(),
+                       symbol_less);
+
+      for (SymbolTransitionPairVector::const_iterator it =
+             state_transitions.begin();
+           it != state_transitions.end();
+           ++it)
+        {
+          // As in SequenceModelComponent, the last one of transitions
+          // with the same symbol is used.
+          if (it + 1 != state_transitions.end() &&
+              (it + 1)->first == it->first)
+            { continue; }
+
+          model.transition_symbols.push_back(it->first);
+          model.transitions.push_back(it->second);
+        }
+    }
+
+  model.transition_offsets.push_back(model.transitions.size());
+
+  add_delayed_model(models.size() - 1, 0);
+  return models.size() - 1;
+}
+
+void CompiledSequenceModel::add_delayed_model(size_t model, size_t delay)
+{
+  Component component;
+  component.model = model;
+  component.delay = delay;
+  components.push_back(component);
+}
+
+size_t CompiledSequenceModel::get_component_count(void) const
+{ return components.size(); }
+
+Symbol CompiledSequenceModel::get_symbol(const std::string &string_symbol)
+  const
+{
+  Symbol2NumberMap::const_iterator it =
+    symbol_to_number_map.find(string_symbol);
+
+  if (it == symbol_to_number_map.end())
+    { return NO_SYMBOL; }
+
+  return it->second;
+}
+
+bool CompiledSequenceModel::get_transition(size_t component,
+                                           State state,
+                                           Symbol symbol,
+                                           TransitionData &transition) const
+{
+  const Component &c = components[component];
+
+  // A delayed component skips its first delay symbols.
+  if (state < c.delay)
+    {
+      transition.weight = 0.0;
+      transition.target = state + 1;
+      return true;
+    }
+
+  const Model &model = models[c.model];
+  State model_state = state - c.delay;
+
+  SymbolVector::const_iterator begin =
+    model.transition_symbols.begin() +
+    model.transition_offsets[model_state];
+  SymbolVector::const_iterator end =
+    model.transition_symbols.begin() +
+    model.transition_offsets[model_state + 1];
+  SymbolVector::const_iterator it = std::lower_bound(begin,end,symbol);
+
+  if (it != end && *it == symbol)
+    {
+      transition = model.transitions[it - model.transition_symbols.begin()];
+    }
+  else
+    {
+      transition = model.default_transitions[model_state];
+      if (transition.target == -1)
+        { return false; }
+    }
+
+  transition.target += c.delay;
+  return true;
+}
+
+Weight CompiledSequenceModel::get_final_weight(size_t component,
+                                               State state) const
+{
+  const Component &c = components[component];
+
+  if (state < c.delay)
+    { return 0.0; }
+
+  return models[c.model].final_weights[state - c.delay];
+}
+
+#else // MAIN_TEST
+
+#include <cassert>
+#include <iostream>
+
+#include "SequenceModelComponent.h"
+#include "DelayedSequenceModelComponent.h"
+
+using hfst::implementations::HfstBasicTransition;
+
+int main(void)
+{
+  // The same transducer as in the tests of SequenceModelComponent.
+  HfstBasicTransducer fst;
+  fst.add_state();
+  fst.add_state();
+  fst.add_state();
+  fst.set_final_weight(1,1.0);
+  fst.set_final_weight(3,2.0);
+  fst.add_transition(0,HfstBasicTransition(1,"a","a",0.1));
+  fst.add_transition(1,HfstBasicTransition(2,"a","a",0.2));
+  fst.add_transition(2,HfstBasicTransition(3,"a","a",0.3));
+  fst.add_transition(3,HfstBasicTransition(0,"a","a",0.4));
+  fst.add_transition(0,HfstBasicTransition(3,"b","b",1.1));
+  fst.add_transition(3,HfstBasicTransition(2,"b","b",1.2));
+  fst.add_transition(2,HfstBasicTransition(1,"b","b",1.3));
+  fst.add_transition(1,HfstBasicTransition(0,"b","b",1.4));
+  fst.add_transition(1,HfstBasicTransition(2,
+                                           DEFAULT_SYMBOL,
+                                           DEFAULT_SYMBOL,
+                                           10.0));
+
+  CompiledSequenceModel compiled_model;
+  size_t model = compiled_model.add_model(fst);
+  compiled_model.add_delayed_model(model,2);
+  assert(compiled_model.get_component_count() == 2);
+
+  assert(compiled_model.get_symbol("c") == CompiledSequenceModel::NO_SYMBOL);
+  assert(compiled_model.get_symbol(DEFAULT_SYMBOL) ==
+         CompiledSequenceModel::NO_SYMBOL);
+
+  SequenceModelComponent sequence_model_component(fst);
+  DelayedSequenceModelComponent delayed_sequence_model_component
+    (sequence_model_component,2);
+
+  const char * symbols[] = { "a", "b" };
+
+  // Compiled components agree with the components they are compiled
+  // from.
+  for (State s = 0; s < 4; ++s)
+    {
+      assert(compiled_model.get_final_weight(0,s) ==
+             sequence_model_component.get_final_weight(s));
+      assert(compiled_model.get_final_weight(1,s + 2) ==
+             delayed_sequence_model_component.get_final_weight(s + 2));
+
+      for (size_t i = 0; i < 2; ++i)
+        {
+          TransitionData transition;
+          assert(compiled_model.get_transition
+                 (0,s,compiled_model.get_symbol(symbols[i]),transition));
+
+          TransitionData expected = sequence_model_component.get_transition
+            (s,SequenceModelComponent::get_symbol(symbols[i]));
+          assert(transition.target == expected.target);
+          assert(transition.weight == expected.weight);
+
+          assert(compiled_model.get_transition
+                 (1,s + 2,compiled_model.get_symbol(symbols[i]),transition));
+          assert(transition.target == expected.target + 2);
+          assert(transition.weight == expected.weight);
+        }
+    }
+
+  // Delay states go forward with any symbol.
+  TransitionData transition;
+  assert(compiled_model.get_transition
+         (1,0,CompiledSequenceModel::NO_SYMBOL,transition));
+  assert(transition.target == 1);
+  assert(transition.weight == 0.0);
+  assert(compiled_model.get_final_weight(1,1) == 0.0);
+
+  // Unknown symbols use the default transition, if there is one.
+  assert(compiled_model.get_transition
+         (0,1,CompiledSequenceModel::NO_SYMBOL,transition));
+  assert(transition.target == 2);
+  assert(transition.weight == static_cast<float>(10.0));
+  assert(not compiled_model.get_transition
+         (0,0,CompiledSequenceModel::NO_SYMBOL,transition));
+}
+#endif // MAIN_TEST
@@ -0,0 +1,85 @@
+#ifndef HEADER_CompiledSequenceModel_h
+#define HEADER_CompiledSequenceModel_h
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <vector>
+
+#include "HfstTransducer.h"
+
+using hfst::implementations::HfstBasicTransducer;
+
+#include "DataTypes.h"
+
+// A read-only form of a sequence model, which can be shared by several
+// taggers running in different threads.
+//
+// The model consists of components, which correspond to
+// SequenceModelComponent and DelayedSequenceModelComponent objects
+// combined using SequenceModelComponentPair. The state of the model is
+// the vector of the states of its components and its weights are sums
+// of the weights of the components.
+//
+// Symbols are numbered densely by the model itself. Transitions of each
+// component state are stored in arrays sorted by symbol, with the
+// DEFAULT_SYMBOL transition kept apart, and found using binary search.
+class CompiledSequenceModel
+{
+ public:
+  // The symbol of strings that are not in the alphabet of any
+  // component. Only default transitions match it.
+  static const Symbol NO_SYMBOL;
+
+  CompiledSequenceModel(void);
+
+  // Add the model fst as a component and return its model number.
+  size_t add_model(const HfstBasicTransducer &fst);
+
+  // Add model number model delayed by delay symbols as a component,
+  // c.f. DelayedSequenceModelComponent.
+  void add_delayed_model(size_t model, size_t delay);
+
+  size_t get_component_count(void) const;
+
+  Symbol get_symbol(const std::string &string_symbol) const;
+
+  // Set transition to the transition of component from state with
+  // symbol and return true. Return false, if there is no such
+  // transition.
+  bool get_transition(size_t component,
+                      State state,
+                      Symbol symbol,
+                      TransitionData &transition) const;
+
+  Weight get_final_weight(size_t component, State state) const;
+
+ protected:
+  struct Model
+  {
+    // The transitions of state s are in positions
+    // [ transition_offsets[s], transition_offsets[s + 1] ).
+    std::vector<size_t>         transition_offsets;
+    SymbolVector                transition_symbols;
+    std::vector<TransitionData> transitions;
+
+    // Targets are -1 for states without a default transition.
+    std::vector<TransitionData> default_transitions;
+    StateFinalWeightMap         final_weights;
+  };
+
+  struct Component
+  {
+    size_t model;
+    State  delay;
+  };
+
+  std::vector<Model>     models;
+  std::vector<Component> components;
+  Symbol2NumberMap       symbol_to_number_map;
+
+  Symbol add_symbol(const std::string &string_symbol);
+};
+
+#endif // HEADER_CompiledSequenceModel_h
@@ -13,12 +13,32 @@ using hfst::HfstOneLevelPath;
 NewLexicalModel::NewLexicalModel(const std::string &filename, std::istream * paradigm_guess_stream):
   in(filename),
   lexical_model(in),
+  analysis_cache(ANALYSIS_CACHE_SIZE),
   upper_case_interpolator(8.79), // <----- FIX ME!!!
   lower_case_interpolator(31.0), // <----- FIX ME!!!
   id(0),
   lexical_model_is_broken(false),
   paradigm_guess_stream(paradigm_guess_stream)
-{ initialize_tag_probabilities(); }
+{
+  // Both suffix tries are built from one conversion of the model.
+  {
+    HfstBasicTransducer fst(lexical_model);
+    upper_case_suffixes = SuffixGuessTrie
+      (lexical_model,fst,"<upper_suffix_and_tag>","<upper_suffix>",tag_table);
+    lower_case_suffixes = SuffixGuessTrie
+      (lexical_model,fst,"<lower_suffix_and_tag>","<lower_suffix>",tag_table);
+  }
+  initialize_tag_probabilities();
+}
+
+void NewLexicalModel::add_oov_word(const std::string &word)
+{
+  // is_oov is asked about the words of the sentence that was just
+  // tagged, so older words can be forgotten.
+  if (o_o_v_words.size() >= ANALYSIS_CACHE_SIZE)
+    { o_o_v_words.clear(); }
+  o_o_v_words.insert(word);
+}
 
 void NewLexicalModel::initialize_tag_probabilities(void)
 {
@@ -99,10 +119,9 @@ const WeightedStringVector &NewLexicalModel::get_first_word_analysis
     {
       std::string lower_case_word = to_lower_case(word);
 
-      lexicon_o_o_v_words.insert(word);
       if (not is_lexicon_oov(lower_case_word))
 	{
-	  o_o_v_words.insert(word);
+	  add_oov_word(word);
 	  return operator[](lower_case_word);
 	}
       else
@@ -118,15 +137,13 @@ const WeightedStringVector &NewLexicalModel::operator[]
   if (lexical_model_is_broken)
     { throw BrokenLexicalModel(); }
 
-  AnalysisCache::const_iterator word_it = analysis_cache.find(word);
+  const WeightedTagVector * cached_analyses = analysis_cache.find(word);
 
-  if (word_it == analysis_cache.end())
-    {
-      const WeightedStringVector & v = cache_word_analyses(word);
-      return v;
-    }
+  if (cached_analyses == NULL)
+    { return cache_word_analyses(word); }
 
-  return word_it->second;
+  tag_table.get_analyses(*cached_analyses,analyses);
+  return analyses;
 }
 
 StringVector NewLexicalModel::split(const std::string &line)
@@ -159,8 +176,9 @@ const WeightedStringVector &NewLexicalModel::paradigm_guess
 (const std::string &word,
  const StringVector &guess_vector)
 {
-  WeightedStringVector &word_guesses = analysis_cache[word];
-  
+  WeightedStringVector &word_guesses = analyses;
+  word_guesses.clear();
+
   assert(guess_vector[0] == word);
   
   for (size_t i = 1; i < guess_vector.size(); ++(++i))
@@ -198,8 +216,6 @@ const WeightedStringVector &NewLexicalModel::cache_word_analyses
     {
       delete paths;
 
-      lexicon_o_o_v_words.insert(word);
-
       if (paradigm_guess_stream != 0)
 	{
 	  std::string line;
@@ -212,18 +228,29 @@ const WeightedStringVector &NewLexicalModel::cache_word_analyses
 	  if (line.find("+?") == std::string::npos)
 	    {
 	      assert((guesses.size() + 1) % 2 == 0);
-	      return paradigm_guess(word,guesses);
+	      paradigm_guess(word,guesses);
+	      return cache_analyses(word);
 	    }
 	}
-      o_o_v_words.insert(word);
-      return guess(word,upper_case,rev_tokenized_word);
+      add_oov_word(word);
+      guess(word,upper_case,rev_tokenized_word);
+      return cache_analyses(word);
     }
   else
     {
-      return cache_analyses(word,paths,analysis_cache);
+      read_analyses(paths);
+      return cache_analyses(word);
     }
 }
 
+const WeightedStringVector &NewLexicalModel::cache_analyses
+(const std::string &word)
+{
+  tag_table.intern(analyses,interned_analyses);
+  analysis_cache.insert(word,interned_analyses);
+  return analyses;
+}
+
 float NewLexicalModel::get_prob(float weight)
 { return exp(-1 * weight); }
 
@@ -246,22 +273,25 @@ const WeightedStringVector &NewLexicalModel::guess
 (const std::string &word,bool upper_case,
  const StringVector &rev_tokenized_word)
 {
-  WeightedStringVector &word_analyses = analysis_cache[word];
+  WeightedStringVector &word_analyses = analyses;
  
   word_analyses = upper_case ? upper_case_empty_suffix_null : lower_case_empty_suffix_null;
 
   size_t suffix_length = std::min(rev_tokenized_word.size(),
-				  static_cast<size_t>(100));
+				  static_cast<size_t>(MAX_GUESSED_SUFFIX_LENGTH));
+
+  // The suffixes of the word in the suffix guesses of the model.
+  (upper_case ? upper_case_suffixes : lower_case_suffixes).find_prefixes
+    (rev_tokenized_word.begin(),
+     rev_tokenized_word.begin() + suffix_length,
+     suffix_nodes);
 
   size_t last_found_suffix_length = suffix_length;
 
   for (size_t i = suffix_length; i > 0; --i)
     {
       const WeightedStringVector &suffix_analyses =
-	get_suffix_analyses(word,
-			    rev_tokenized_word.begin(),
-			    rev_tokenized_word.begin() + i,
-			    upper_case);
+	get_suffix_analyses(suffix_nodes[i]);
       
       if (suffix_analyses.empty())
 	{
@@ -276,13 +306,11 @@ const WeightedStringVector &NewLexicalModel::guess
  
   
   // For Finnish
-  word_analyses = get_suffix_analyses(word,
-				      rev_tokenized_word.begin(),
-				      rev_tokenized_word.begin() + last_found_suffix_length,
-				      upper_case);
+  word_analyses = get_suffix_analyses(suffix_nodes[last_found_suffix_length]);
 
   bayesian_invert
     (word_analyses,
+     suffix_nodes[last_found_suffix_length],
      to_string(rev_tokenized_word.begin(),
 	       rev_tokenized_word.begin() + last_found_suffix_length),
      upper_case);
@@ -304,96 +332,31 @@ bool NewLexicalModel::is_lexicon_oov(const std::string &word)
   return empty;
 }
 
-size_t NewLexicalModel::get_suffix_length(StringVector::const_iterator begin,
-					  StringVector::const_iterator end)
-{
-  size_t length = 0;
-
-  for ( ; begin != end; ++begin)
-    { length += begin->size(); }
-
-  return length;
-}
-
 const WeightedStringVector &NewLexicalModel::get_suffix_analyses
-(const std::string &word,
- StringVector::const_iterator begin,
- StringVector::const_iterator end,
- bool upper_case)
+(const SuffixGuessTrie::Node * suffix)
 {
-  AnalysisCache &suffix_cache = upper_case ? upper_case_suffix_cache : lower_case_suffix_cache;
-  std::string suffix = word.substr(word.size() - get_suffix_length(begin,end));
-
-  AnalysisCache::const_iterator suffix_it = suffix_cache.find(suffix);
-
-  
-  if (suffix_it == suffix_cache.end())
-    {
-      return cache_suffix_analyses(word,suffix,begin,end);
-    }
-
-  return suffix_it->second;
-}
-
-const WeightedStringVector &NewLexicalModel::cache_suffix_analyses
-(const std::string &word,
- const std::string &suffix,
- StringVector::const_iterator begin,
- StringVector::const_iterator end)
-{
- 
-  bool upper_case = false;
-  
-  if (not word.empty())
-    {
-      if (word[0] >= 65 and word[0] <= 90)
-	{ upper_case = true; }
-      else if (word.size() > 1)
-	{
-	  std::string initial_segment = word.substr(0,2);
-          if (initial_segment == "Å" or initial_segment == "Ä" or initial_segment == "Ö")
-	    { upper_case = true; }
-	}
-    }
- 
-
-  StringVector guess_string_vector(begin,end);
-  guess_string_vector.push_back(upper_case ? "<upper_suffix_and_tag>" : "<lower_suffix_and_tag>");
-  
-  HfstOneLevelPaths * paths = lexical_model.lookup(guess_string_vector);
+  if (suffix == NULL)
+    { suffix_guesses.clear(); }
+  else
+    { tag_table.get_analyses(suffix->analyses,suffix_guesses); }
 
-  return cache_analyses(suffix,paths,
-			upper_case ? upper_case_suffix_cache : lower_case_suffix_cache,true);
+  return suffix_guesses;
 }
 
-const WeightedStringVector &NewLexicalModel::cache_analyses
-(const std::string &word,
- HfstOneLevelPaths * paths,
- AnalysisCache &cache,
- bool convert_to_probabilities)
+void NewLexicalModel::read_analyses(HfstOneLevelPaths * paths)
 {
-  size_t number_of_tags = paths->size();
+  analyses.clear();
 
-  WeightedStringVector &word_analyses = cache[word];
-  word_analyses.insert(word_analyses.end(),
-		       number_of_tags,
-		       WeightedString());
-
-  size_t i = 0;
   for (HfstOneLevelPaths::const_iterator it = paths->begin();
        it != paths->end();
        ++it)
     {
       // Each entry in paths, is a weight analysis pair. The last entry in
       // the analysis is the tag.
-      word_analyses[i].first  =
-	convert_to_probabilities ? get_prob(it->first) : it->first;
-      word_analyses[i].second = *(it->second.rbegin());
-      ++i;
+      analyses.push_back(WeightedString(it->first,*(it->second.rbegin())));
     }
 
   delete paths;
-  return word_analyses;
 }
 
 void NewLexicalModel::merge_analyses
@@ -423,30 +386,17 @@ void NewLexicalModel::merge_analyses
     }
 }
 
-float NewLexicalModel::get_suffix_penalty(const std::string &suffix,
-					  bool upper_case)
+float NewLexicalModel::get_suffix_penalty
+(const SuffixGuessTrie::Node * suffix,
+ const std::string &suffix_string)
 {
-  ProbabilityMap::iterator it = (upper_case ? upper_case_suffix_penalties.find(suffix) : lower_case_suffix_penalties.find(suffix));
-
-  if (it == (upper_case ? upper_case_suffix_penalties.end() : lower_case_suffix_penalties.end()))
+  if (suffix == NULL or not suffix->has_penalty)
     {
-      HfstOneLevelPaths * suffix_penalty_paths =
-	lexical_model.lookup(suffix + (upper_case ? "<upper_suffix>" : "<lower_suffix>"));
-      
-      if (suffix_penalty_paths->empty())
-	{
-	  std::cerr <<  suffix << std::endl;
-	  delete suffix_penalty_paths;
-	  throw InvalidKey();
-	}
-
-      float penalty = suffix_penalty_paths->begin()->first;
-      delete suffix_penalty_paths;
-      (upper_case ? upper_case_suffix_penalties[suffix] : lower_case_suffix_penalties[suffix] )  = penalty;
-      return penalty;
+      std::cerr << suffix_string << std::endl;
+      throw InvalidKey();
     }
-  
-  return it->second;
+
+  return suffix->penalty;
 }
 
 float NewLexicalModel::get_tag_penalty(const std::string &tag,bool upper_case)
@@ -495,12 +445,13 @@ void preserve_n_best_analyses(WeightedStringVector &word_analyses,size_t number_
 }
 
 void NewLexicalModel::bayesian_invert(WeightedStringVector &word_analyses,
-				      const std::string &suffix,
+				      const SuffixGuessTrie::Node * suffix,
+				      const std::string &suffix_string,
 				      bool upper_case)
 {
   preserve_n_best_analyses(word_analyses,GUESSES_PRESERVED);
 
-  float suffix_penalty = get_suffix_penalty(suffix, upper_case);
+  float suffix_penalty = get_suffix_penalty(suffix,suffix_string);
   for (WeightedStringVector::iterator it = word_analyses.begin();
        it != word_analyses.end();
        ++it)
@@ -15,7 +15,9 @@ using std::unordered_set;
 
 #include <iostream>
 
+#include "AnalysisCache.h"
 #include "DataTypes.h"
+#include "SuffixGuessTrie.h"
 
 using hfst::HfstTransducer;
 using hfst::HfstInputStream;
@@ -25,27 +27,24 @@ using hfst::StringVector;
 
 #define GUESSES_PRESERVED 10
 
+// The number of words whose analyses are kept in memory.
+#define ANALYSIS_CACHE_SIZE 100000
+
 class NewLexicalModel
 {
  public:
   NewLexicalModel(const std::string &filename,
                   std::istream * paradigm_guess_stream = 0);
+
+  // The analyses are valid until the next call to operator[] or
+  // get_first_word_analysis.
   const WeightedStringVector &operator[] (const std::string &word);
   const WeightedStringVector &get_first_word_analysis(const std::string &word);
   bool is_oov(const std::string &word);
   bool is_lexicon_oov(const std::string &word);
  private:
-
-  typedef unordered_map<std::string,WeightedStringVector>
-    AnalysisCache;
-
-  AnalysisCache   analysis_cache;
-  AnalysisCache   upper_case_suffix_cache;
-  AnalysisCache   lower_case_suffix_cache;
   HfstTokenizer   tokenizer;
   StringWeightMap tag_probability_hash;
-  ProbabilityMap  upper_case_suffix_penalties;
-  ProbabilityMap  lower_case_suffix_penalties;
   ProbabilityMap  upper_case_tag_penalties;
   ProbabilityMap  lower_case_tag_penalties;
   StringWeightMap word_probability_hash;
@@ -56,48 +55,48 @@ class NewLexicalModel
   WeightedStringVector lower_case_empty_suffix_null;
   HfstInputStream in;
   HfstTransducer  lexical_model;
+  TagTable        tag_table;
+  SuffixGuessTrie upper_case_suffixes;
+  SuffixGuessTrie lower_case_suffixes;
+  AnalysisCache   analysis_cache;
+  WeightedStringVector analyses;
+  WeightedTagVector    interned_analyses;
+  WeightedStringVector suffix_guesses;
+  std::vector<const SuffixGuessTrie::Node *> suffix_nodes;
   float upper_case_interpolator;
   float lower_case_interpolator;
   size_t id;
   bool lexical_model_is_broken;
   std::istream * paradigm_guess_stream;
+  // The recently analysed words, which were not in the lexicon but
+  // were not given paradigm guesses either. At most ANALYSIS_CACHE_SIZE
+  // words are kept.
   unordered_set<std::string> o_o_v_words;
-  unordered_set<std::string> lexicon_o_o_v_words;
 
   void initialize_tag_probabilities(void);
+  void add_oov_word(const std::string &word);
 
   const WeightedStringVector &cache_word_analyses(const std::string &word);
   const WeightedStringVector &guess(const std::string &word,
                                     bool upper_case,
                                     const StringVector &rev_tokenized_word);
-  const WeightedStringVector &cache_analyses
-    (const std::string &word,
-     HfstOneLevelPaths * paths,
-     AnalysisCache &cache,
-     bool convert_to_probabilities=false);
+  const WeightedStringVector &cache_analyses(const std::string &word);
+  void read_analyses(HfstOneLevelPaths * paths);
 
   const WeightedStringVector &get_suffix_analyses
-    (const std::string &word,
-     StringVector::const_iterator begin,
-     StringVector::const_iterator end,
-     bool upper_case);
+    (const SuffixGuessTrie::Node * suffix);
 
   void merge_analyses(const WeightedStringVector &suffix_analyses,
                       WeightedStringVector &word_analyses,
                       bool  upper_case);
   
   void bayesian_invert(WeightedStringVector &word_analyses,
-                       const std::string &suffix,
+                       const SuffixGuessTrie::Node * suffix,
+                       const std::string &suffix_string,
                        bool upper_case);
-  size_t get_suffix_length(StringVector::const_iterator begin,
-                           StringVector::const_iterator end);
-  const WeightedStringVector &cache_suffix_analyses
-    (const std::string &word,
-     const std::string &suffix,
-     StringVector::const_iterator begin,
-     StringVector::const_iterator end);
-
-  float get_suffix_penalty(const std::string &suffix, bool upper_case);
+
+  float get_suffix_penalty(const SuffixGuessTrie::Node * suffix,
+                           const std::string &suffix_string);
   float get_tag_penalty(const std::string &tag, bool upper_case);
   
   std::string to_string(StringVector::const_iterator begin,
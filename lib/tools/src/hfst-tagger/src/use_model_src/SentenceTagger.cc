@@ -2,9 +2,9 @@
 
 #ifndef MAIN_TEST
 
+#include <thread>
+
 #include "DataTypes.h"
-#include "DelayedSequenceModelComponent.h"
-#include "SequenceModelComponentPair.h"
 
 SentenceTagger::SentenceTagger(const std::string &lexical_model_filename,
                                const std::string &sequence_model_filename,
@@ -17,44 +17,38 @@ SentenceTagger::SentenceTagger(const std::string &lexical_model_filename,
 
 SentenceTagger::~SentenceTagger(void)
 {
-  for (ModelPointerVector::iterator it = models.begin();
-       it != models.end();
+  for (TaggerPointerVector::iterator it = taggers.begin();
+       it != taggers.end();
        ++it)
     { delete *it; }
-
-  delete sequence_tagger;
 }
 
 void SentenceTagger::init_sequence_model
 (const std::string &sequence_model_filename)
 {
   HfstInputStream in(sequence_model_filename);
-  
-  SequenceModelComponent * p = NULL;
-
-  if (in.is_good())
-    { p = read_model(p,in); }
 
   while (in.is_good())
-    { p = read_model(p,in); }
+    { read_model(in); }
 
-  top_level_model = p;
-  assert(top_level_model != NULL);
-  sequence_tagger = new SequenceTagger(*top_level_model);
+  assert(sequence_model.get_component_count() > 0);
+
+  taggers.push_back(new ViterbiTagger(sequence_model));
+  lattices.resize(1);
 }
 
-WeightedStringPairVector SentenceTagger::operator[]
-(const StringVector &sentence)
+void SentenceTagger::get_lattice(const StringVector &sentence,
+                                 SentenceLattice &lattice)
 {
   // Assert that at least the initial and final buffer symbols are present.
   assert(sentence.size() > 3);
 
-  SentenceTransducer sentence_transducer;
+  lattice.clear();
 
   bool first = true;
 
   // Add the analyses for initial buffer symbols.
-  sentence_transducer.add_word(BUFFER,buffer_analyses);
+  lattice.add_word(BUFFER,buffer_analyses,sequence_model);
 
   for (StringVector::const_iterator it = sentence.begin() + 1;
        it != sentence.end() - 1;
@@ -67,49 +61,70 @@ WeightedStringPairVector SentenceTagger::operator[]
          lexical_model.get_first_word_analysis(word) :
          lexical_model[word]);
 
-      sentence_transducer.add_word(word,unigram_analyses);
-      
+      lattice.add_word(word,unigram_analyses,sequence_model);
+
       if (word != "||")
         { first = false; }
     }
 
   // Add the analyses for final buffer symbols.
-  sentence_transducer.add_word(BUFFER,buffer_analyses);
-
-  sentence_transducer.finalize();
+  lattice.add_word(BUFFER,buffer_analyses,sequence_model);
+}
 
-  return sequence_tagger->operator[] (sentence_transducer);
+WeightedStringPairVector SentenceTagger::operator[]
+(const StringVector &sentence)
+{
+  get_lattice(sentence,lattices[0]);
+  return taggers[0]->operator[] (lattices[0]);
 }
 
-SequenceModelComponent * SentenceTagger::read_model
-(SequenceModelComponent * p,
- HfstInputStream &in)
+void SentenceTagger::tag(const std::vector<StringVector> &sentences,
+                         std::vector<WeightedStringPairVector> &taggings,
+                         unsigned int jobs)
 {
-  HfstTransducer model_fst(in);
-  SequenceModelComponent * model = new SequenceModelComponent(model_fst);
-  models.push_back(model);
+  if (jobs == 0)
+    { jobs = 1; }
 
-  size_t n = get_model_order(model_fst);
+  while (taggers.size() < jobs)
+    { taggers.push_back(new ViterbiTagger(sequence_model)); }
+
+  if (lattices.size() < sentences.size())
+    { lattices.resize(sentences.size()); }
+
+  for (size_t i = 0; i < sentences.size(); ++i)
+    { get_lattice(sentences[i],lattices[i]); }
+
+  taggings.resize(sentences.size());
 
-  if (p == NULL)
-    { p = model; }
-  else
+  // Thread t tags sentences t, t + jobs, t + 2*jobs, ...
+  std::vector<std::thread> threads;
+  for (unsigned int t = 1; t < jobs; ++t)
     {
-      p = new SequenceModelComponentPair(*model,*p);
-      models.push_back(p);
+      threads.push_back(std::thread([this,&sentences,&taggings,jobs,t]()
+        {
+          for (size_t i = t; i < sentences.size(); i += jobs)
+            { taggings[i] = taggers[t]->operator[] (lattices[i]); }
+        }));
     }
 
-  for (size_t i = 1; i < n; ++i)
-    {
-      DelayedSequenceModelComponent * delayed_model =
-        new DelayedSequenceModelComponent(*model,2*i);
-      models.push_back(delayed_model);
+  for (size_t i = 0; i < sentences.size(); i += jobs)
+    { taggings[i] = taggers[0]->operator[] (lattices[i]); }
 
-      p = new SequenceModelComponentPair(*delayed_model,*p);
-      models.push_back(p);
-    }
+  for (size_t t = 0; t < threads.size(); ++t)
+    { threads[t].join(); }
+}
 
-  return p;
+void SentenceTagger::read_model(HfstInputStream &in)
+{
+  HfstTransducer model_fst(in);
+  size_t n = get_model_order(model_fst);
+
+  // Each n-gram model is combined with copies of itself delayed by
+  // 1, ..., n - 1 words, i.e. 2, ..., 2*(n - 1) symbols.
+  size_t model = sequence_model.add_model(HfstBasicTransducer(model_fst));
+
+  for (size_t i = 1; i < n; ++i)
+    { sequence_model.add_delayed_model(model,2*i); }
 }
 
 bool SentenceTagger::is_oov(const std::string &word)
@@ -5,7 +5,10 @@
 #  include "config.h"
 #endif
 
-#include "SequenceTagger.h"
+#include <vector>
+
+#include "CompiledSequenceModel.h"
+#include "ViterbiTagger.h"
 #include "NewLexicalModel.h"
 
 #define BUFFER "||"
@@ -18,20 +21,28 @@ class SentenceTagger
 		 std::istream * paradigm_guess_stream = 0);
   ~SentenceTagger(void);
   WeightedStringPairVector operator[] (const StringVector &sentence);
+
+  // Tag sentences using jobs threads. The lexical model is consulted
+  // in one thread, since it caches analyses, after which the sentences
+  // are tagged in parallel.
+  void tag(const std::vector<StringVector> &sentences,
+           std::vector<WeightedStringPairVector> &taggings,
+           unsigned int jobs);
+
   bool is_oov(const std::string &word);
   bool is_lexicon_oov(const std::string &word);
  protected:
-  typedef std::vector<SequenceModelComponent*> ModelPointerVector;
+  typedef std::vector<ViterbiTagger*> TaggerPointerVector;
 
   NewLexicalModel lexical_model;
-  ModelPointerVector models;
-  SequenceModelComponent * top_level_model;
-  SequenceTagger * sequence_tagger;
+  CompiledSequenceModel sequence_model;
+  TaggerPointerVector taggers;
+  std::vector<SentenceLattice> lattices;
   WeightedStringVector buffer_analyses;
   
   void init_sequence_model(const std::string &sequence_model_filename);
-  SequenceModelComponent * read_model(SequenceModelComponent * p,
-				      HfstInputStream &in);
+  void read_model(HfstInputStream &in);
+  void get_lattice(const StringVector &sentence, SentenceLattice &lattice);
   static size_t get_model_order(const HfstTransducer &model_fst);
 };
 
@@ -0,0 +1,458 @@
+#include <algorithm>
+#include <math.h>
+
+#include "SuffixGuessTrie.h"
+
+#ifndef MAIN_TEST
+
+using hfst::HfstOneLevelPaths;
+
+static bool symbol_less(const std::pair<Symbol,size_t> &p,Symbol symbol)
+{ return p.first < symbol; }
+
+SuffixGuessTrie::SuffixGuessTrie(void)
+{
+  nodes.push_back(Node());
+  nodes.back().has_penalty = false;
+}
+
+SuffixGuessTrie::SuffixGuessTrie(const HfstTransducer &lexical_model,
+                                 const HfstBasicTransducer &fst,
+                                 const std::string &suffix_and_tag_marker,
+                                 const std::string &suffix_marker,
+                                 TagTable &tag_table)
+{
+  HfstTokenizer tokenizer;
+  this->suffix_and_tag_marker =
+    tokenizer.tokenize_one_level(suffix_and_tag_marker);
+  this->suffix_marker = tokenizer.tokenize_one_level(suffix_marker);
+
+  nodes.push_back(Node());
+  nodes.back().has_penalty = false;
+
+  StringVectorSet analysis_suffixes;
+  StringVectorSet penalty_suffixes;
+
+  {
+    std::vector<int> marker_states;
+    find_marker_states(fst,marker_states);
+    StringVector path;
+    std::vector<HfstState> epsilon_states(1,0);
+    collect_suffixes(fst,marker_states,0,path,epsilon_states,0,
+                     analysis_suffixes,penalty_suffixes);
+  }
+
+  // Optimized lookup tokenizes the concatenation of the input symbols,
+  // so the markers can be given as strings.
+  for (StringVectorSet::const_iterator it = analysis_suffixes.begin();
+       it != analysis_suffixes.end();
+       ++it)
+    {
+      HfstOneLevelPaths * paths =
+        lexical_model.lookup(to_string(*it) + suffix_and_tag_marker);
+      Node &node = nodes[add(it->begin(),it->end())];
+
+      for (HfstOneLevelPaths::const_iterator jt = paths->begin();
+           jt != paths->end();
+           ++jt)
+        {
+          if (jt->second.empty())
+            { continue; }
+
+          // The last output symbol is the tag. Penalties are stored as
+          // probabilities.
+          node.analyses.push_back
+            (WeightedTag(exp(-1 * jt->first),
+                         tag_table.intern(*(jt->second.rbegin()))));
+        }
+
+      delete paths;
+    }
+
+  for (StringVectorSet::const_iterator it = penalty_suffixes.begin();
+       it != penalty_suffixes.end();
+       ++it)
+    {
+      HfstOneLevelPaths * paths =
+        lexical_model.lookup(to_string(*it) + suffix_marker);
+
+      if (not paths->empty())
+        {
+          Node &node = nodes[add(it->begin(),it->end())];
+          node.has_penalty = true;
+          node.penalty = paths->begin()->first;
+        }
+
+      delete paths;
+    }
+}
+
+std::string SuffixGuessTrie::to_string(const StringVector &symbols)
+{
+  std::string result;
+  for (StringVector::const_iterator it = symbols.begin();
+       it != symbols.end();
+       ++it)
+    { result += *it; }
+  return result;
+}
+
+bool SuffixGuessTrie::starts_marker(const HfstBasicTransducer &fst,
+                                    HfstState state,
+                                    StringVector::const_iterator begin,
+                                    StringVector::const_iterator end) const
+{
+  if (begin == end)
+    { return true; }
+
+  const hfst::implementations::HfstBasicTransitions &transitions =
+    fst.transitions(state);
+
+  for (hfst::implementations::HfstBasicTransitions::const_iterator it =
+         transitions.begin();
+       it != transitions.end();
+       ++it)
+    {
+      if (it->get_input_symbol() == *begin and
+          starts_marker(fst,it->get_target_state(),begin + 1,end))
+        { return true; }
+    }
+
+  return false;
+}
+
+// Set marker_states[s] to tell which markers start at state s and
+// whether a marker can be reached from s. Only those states are
+// visited when suffixes are collected, so the paths of the words of
+// the model are not followed.
+void SuffixGuessTrie::find_marker_states(const HfstBasicTransducer &fst,
+                                         std::vector<int> &marker_states) const
+{
+  size_t state_count = fst.get_max_state() + 1;
+  marker_states.assign(state_count,NO_MARKER);
+
+  std::vector<std::vector<HfstState> > predecessors(state_count);
+  std::vector<HfstState> agenda;
+
+  for (HfstState s = 0; s < state_count; ++s)
+    {
+      if (starts_marker(fst,s,suffix_and_tag_marker.begin(),
+                        suffix_and_tag_marker.end()))
+        { marker_states[s] |= SUFFIX_AND_TAG_MARKER; }
+      if (starts_marker(fst,s,suffix_marker.begin(),suffix_marker.end()))
+        { marker_states[s] |= SUFFIX_MARKER; }
+      if (marker_states[s] != NO_MARKER)
+        {
+          marker_states[s] |= MARKER_AHEAD;
+          agenda.push_back(s);
+        }
+
+      const hfst::implementations::HfstBasicTransitions &transitions =
+        fst.transitions(s);
+      for (hfst::implementations::HfstBasicTransitions::const_iterator it =
+             transitions.begin();
+           it != transitions.end();
+           ++it)
+        { predecessors[it->get_target_state()].push_back(s); }
+    }
+
+  while (not agenda.empty())
+    {
+      HfstState s = agenda.back();
+      agenda.pop_back();
+      for (std::vector<HfstState>::const_iterator it =
+             predecessors[s].begin();
+           it != predecessors[s].end();
+           ++it)
+        {
+          if (not (marker_states[*it] & MARKER_AHEAD))
+            {
+              marker_states[*it] |= MARKER_AHEAD;
+              agenda.push_back(*it);
+            }
+        }
+    }
+}
+
+// epsilon_states holds the states reached by epsilons since the last
+// symbol of path from index epsilon_begin on, so that epsilon cycles
+// are not followed.
+void SuffixGuessTrie::collect_suffixes(const HfstBasicTransducer &fst,
+                                       const std::vector<int> &marker_states,
+                                       HfstState state,
+                                       StringVector &path,
+                                       std::vector<HfstState> &epsilon_states,
+                                       size_t epsilon_begin,
+                                       StringVectorSet &analysis_suffixes,
+                                       StringVectorSet &penalty_suffixes)
+{
+  if (marker_states[state] & SUFFIX_AND_TAG_MARKER)
+    { analysis_suffixes.insert(path); }
+
+  if (marker_states[state] & SUFFIX_MARKER)
+    { penalty_suffixes.insert(path); }
+
+  const hfst::implementations::HfstBasicTransitions &transitions =
+    fst.transitions(state);
+
+  for (hfst::implementations::HfstBasicTransitions::const_iterator it =
+         transitions.begin();
+       it != transitions.end();
+       ++it)
+    {
+      HfstState target = it->get_target_state();
+      if (not (marker_states[target] & MARKER_AHEAD))
+        { continue; }
+
+      const std::string &symbol = it->get_input_symbol();
+      if (hfst::is_epsilon(symbol))
+        {
+          if (std::find(epsilon_states.begin() + epsilon_begin,
+                        epsilon_states.end(),target) != epsilon_states.end())
+            { continue; }
+
+          epsilon_states.push_back(target);
+          collect_suffixes(fst,marker_states,target,path,
+                           epsilon_states,epsilon_begin,
+                           analysis_suffixes,penalty_suffixes);
+          epsilon_states.pop_back();
+        }
+      else if (path.size() < MAX_GUESSED_SUFFIX_LENGTH)
+        {
+          path.push_back(symbol);
+          epsilon_states.push_back(target);
+          collect_suffixes(fst,marker_states,target,path,
+                           epsilon_states,epsilon_states.size() - 1,
+                           analysis_suffixes,penalty_suffixes);
+          epsilon_states.pop_back();
+          path.pop_back();
+        }
+    }
+}
+
+size_t SuffixGuessTrie::add(StringVector::const_iterator begin,
+                            StringVector::const_iterator end)
+{
+  size_t node = 0;
+
+  for (StringVector::const_iterator it = begin; it != end; ++it)
+    {
+      Symbol2NumberMap::const_iterator symbol_it = symbol_numbers.find(*it);
+      Symbol symbol;
+
+      if (symbol_it == symbol_numbers.end())
+        {
+          symbol = symbol_numbers.size();
+          symbol_numbers[*it] = symbol;
+        }
+      else
+        { symbol = symbol_it->second; }
+
+      std::vector<std::pair<Symbol,size_t> > &children = nodes[node].children;
+      std::vector<std::pair<Symbol,size_t> >::iterator child_it =
+        std::lower_bound(children.begin(),children.end(),symbol,symbol_less);
+
+      if (child_it != children.end() and child_it->first == symbol)
+        {
+          node = child_it->second;
+          continue;
+        }
+
+      size_t child = nodes.size();
+      children.insert(child_it,std::pair<Symbol,size_t>(symbol,child));
+
+      nodes.push_back(Node());
+      nodes.back().has_penalty = false;
+      node = child;
+    }
+
+  return node;
+}
+
+const SuffixGuessTrie::Node * SuffixGuessTrie::get_child
+(const Node &node, const std::string &symbol) const
+{
+  Symbol2NumberMap::const_iterator symbol_it = symbol_numbers.find(symbol);
+
+  if (symbol_it == symbol_numbers.end())
+    { return NULL; }
+
+  std::vector<std::pair<Symbol,size_t> >::const_iterator child_it =
+    std::lower_bound(node.children.begin(),node.children.end(),
+                     symbol_it->second,symbol_less);
+
+  if (child_it == node.children.end() or
+      child_it->first != symbol_it->second)
+    { return NULL; }
+
+  return &nodes[child_it->second];
+}
+
+const SuffixGuessTrie::Node * SuffixGuessTrie::find
+(StringVector::const_iterator begin,
+ StringVector::const_iterator end) const
+{
+  const Node * node = &nodes[0];
+
+  for ( ; begin != end and node != NULL; ++begin)
+    { node = get_child(*node,*begin); }
+
+  return node;
+}
+
+void SuffixGuessTrie::find_prefixes(StringVector::const_iterator begin,
+                                    StringVector::const_iterator end,
+                                    std::vector<const Node *> &nodes) const
+{
+  nodes.assign(end - begin + 1,NULL);
+  nodes[0] = &this->nodes[0];
+
+  for (size_t i = 1; begin != end; ++begin, ++i)
+    {
+      nodes[i] = get_child(*nodes[i - 1],*begin);
+
+      if (nodes[i] == NULL)
+        { break; }
+    }
+}
+
+size_t SuffixGuessTrie::size(void) const
+{ return nodes.size(); }
+
+#else // MAIN_TEST
+
+#include <cassert>
+
+using hfst::HfstOneLevelPaths;
+using hfst::HFST_OLW_TYPE;
+using hfst::TROPICAL_OPENFST_TYPE;
+using hfst::internal_epsilon;
+using hfst::implementations::HfstBasicTransition;
+
+// Add the line word, tag and weight of the statistics of
+// hfst-train-tagger like LexicalModelBuilder does. The last symbol is
+// only on the output side. The line starts at state start.
+static void add_line(HfstBasicTransducer &fst,
+                     const std::string &word,
+                     const std::string &tag,
+                     float weight,
+                     HfstState start = 0)
+{
+  HfstTokenizer tokenizer;
+  StringVector symbols = tokenizer.tokenize_one_level(word);
+  if (tag != "")
+    { symbols.push_back(tag); }
+
+  HfstState s = start;
+  for (size_t i = 0; i < symbols.size(); ++i)
+    {
+      bool last = (i + 1 == symbols.size());
+      HfstState t = fst.add_state();
+      fst.add_transition(s,HfstBasicTransition(t,
+                                               last ? internal_epsilon :
+                                               symbols[i],
+                                               symbols[i],
+                                               last ? weight : 0));
+      s = t;
+    }
+  fst.set_final_weight(s,0);
+}
+
+int main(void)
+{
+  HfstBasicTransducer fst;
+  add_line(fst,"a<lower_suffix_and_tag>","NN",1.0);
+  add_line(fst,"a<lower_suffix_and_tag>","VB",2.0);
+  add_line(fst,"ab<lower_suffix_and_tag>","VB",0.5);
+  add_line(fst,"<lower_suffix_and_tag>","NN",0.25);
+  add_line(fst,"a<lower_suffix>T","",1.5);
+  add_line(fst,"<lower_suffix>T","",0.0);
+  add_line(fst,"a<upper_suffix_and_tag>","NN",3.0);
+  add_line(fst,"ab","NN",4.0);
+
+  // A suffix behind an epsilon.
+  HfstState epsilon_target = fst.add_state();
+  fst.add_transition(0,HfstBasicTransition(epsilon_target,internal_epsilon,
+                                           internal_epsilon,0));
+  add_line(fst,"c<upper_suffix_and_tag>","VB",1.0,epsilon_target);
+
+  HfstTransducer lexical_model(fst,TROPICAL_OPENFST_TYPE);
+  lexical_model.minimize();
+  lexical_model.convert(HFST_OLW_TYPE);
+
+  TagTable tag_table;
+  SuffixGuessTrie trie(lexical_model,fst,"<lower_suffix_and_tag>",
+                       "<lower_suffix>",tag_table);
+
+  // The root, "a" and "ab".
+  assert(trie.size() == 3);
+
+  StringVector suffix;
+  suffix.push_back("a");
+  suffix.push_back("b");
+
+  // The analyses are those given by lookup.
+  for (size_t i = 0; i < 2; ++i)
+    {
+      const SuffixGuessTrie::Node * node =
+        trie.find(suffix.begin(),suffix.begin() + i);
+      assert(node != NULL);
+
+      HfstOneLevelPaths * paths = lexical_model.lookup
+        (SuffixGuessTrie::to_string(StringVector(suffix.begin(),
+                                                 suffix.begin() + i)) +
+         "<lower_suffix_and_tag>");
+
+      assert(node->analyses.size() == paths->size());
+      size_t j = 0;
+      for (HfstOneLevelPaths::const_iterator it = paths->begin();
+           it != paths->end();
+           ++it, ++j)
+        {
+          assert(node->analyses[j].first ==
+                 static_cast<float>(exp(-1 * it->first)));
+          assert(tag_table.get_tag(node->analyses[j].second) ==
+                 *(it->second.rbegin()));
+        }
+      delete paths;
+
+      assert(node->has_penalty);
+    }
+
+  assert(trie.find(suffix.begin(),suffix.begin() + 1)->analyses.size() == 2);
+  assert(trie.find(suffix.begin(),suffix.begin() + 1)->penalty == 1.5);
+  assert(trie.find(suffix.begin(),suffix.begin())->penalty == 0.0);
+
+  // "ab" has analyses but no penalty.
+  const SuffixGuessTrie::Node * ab = trie.find(suffix.begin(),suffix.end());
+  assert(ab != NULL);
+  assert(ab->analyses.size() == 1);
+  assert(tag_table.get_tag(ab->analyses[0].second) == "VB");
+  assert(not ab->has_penalty);
+
+  // Upper case suffixes and words are not in the trie.
+  suffix.push_back("c");
+  assert(trie.find(suffix.begin(),suffix.end()) == NULL);
+
+  std::vector<const SuffixGuessTrie::Node *> nodes;
+  trie.find_prefixes(suffix.begin(),suffix.end(),nodes);
+  assert(nodes.size() == 4);
+  assert(nodes[0] == trie.find(suffix.begin(),suffix.begin()));
+  assert(nodes[2] == ab);
+  assert(nodes[3] == NULL);
+
+  SuffixGuessTrie upper_trie(lexical_model,fst,"<upper_suffix_and_tag>",
+                             "<upper_suffix>",tag_table);
+  assert(upper_trie.size() == 3);
+  assert(tag_table.size() == 2);
+
+  // "c" is found behind the epsilon.
+  StringVector c(1,"c");
+  const SuffixGuessTrie::Node * c_node = upper_trie.find(c.begin(),c.end());
+  assert(c_node != NULL);
+  assert(c_node->analyses.size() == 1);
+  assert(tag_table.get_tag(c_node->analyses[0].second) == "VB");
+
+  assert(SuffixGuessTrie().size() == 1);
+}
+#endif // MAIN_TEST
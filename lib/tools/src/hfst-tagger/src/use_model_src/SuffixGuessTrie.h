@@ -0,0 +1,111 @@
+#ifndef HEADER_SuffixGuessTrie_h
+#define HEADER_SuffixGuessTrie_h
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <set>
+
+#include "HfstTransducer.h"
+
+#include "AnalysisCache.h"
+#include "DataTypes.h"
+
+using hfst::HfstTokenizer;
+using hfst::HfstTransducer;
+using hfst::StringVector;
+using hfst::implementations::HfstBasicTransducer;
+using hfst::implementations::HfstState;
+
+// Suffixes longer than this are not used for guessing.
+#define MAX_GUESSED_SUFFIX_LENGTH 100
+
+// The suffix guesses of a lexical model, i.e. the tags and penalties it
+// gives reversed suffixes followed by suffix_and_tag_marker and
+// suffix_marker, e.g. "<lower_suffix_and_tag>" and "<lower_suffix>".
+// LexicalModelBuilder spells the markers using one symbol per
+// character, so they are found as symbol sequences in the model.
+//
+// All suffixes of the model are looked up once, when the trie is
+// built, so that guessing the analyses of unknown words does not
+// require lookups in the model. The suffixes are found in fst, the
+// model converted to HfstBasicTransducer, which can be shared by the
+// tries of different markers.
+class SuffixGuessTrie
+{
+ public:
+  struct Node
+  {
+    // The tags of the suffix and their probabilities in the order
+    // given by lookup.
+    WeightedTagVector analyses;
+
+    bool   has_penalty;
+    Weight penalty;
+
+    // Children sorted by symbol.
+    std::vector<std::pair<Symbol,size_t> > children;
+  };
+
+  // An empty trie.
+  SuffixGuessTrie(void);
+
+  SuffixGuessTrie(const HfstTransducer &lexical_model,
+                  const HfstBasicTransducer &fst,
+                  const std::string &suffix_and_tag_marker,
+                  const std::string &suffix_marker,
+                  TagTable &tag_table);
+
+  // Return the node of the reversed suffix [begin, end) or NULL, if
+  // there is no such suffix in the model.
+  const Node * find(StringVector::const_iterator begin,
+                    StringVector::const_iterator end) const;
+
+  // Set nodes[i] to the node of [begin, begin + i) for i = 0, ...,
+  // end - begin. Suffixes, which are not in the model, get NULL.
+  void find_prefixes(StringVector::const_iterator begin,
+                     StringVector::const_iterator end,
+                     std::vector<const Node *> &nodes) const;
+
+  size_t size(void) const;
+
+  static std::string to_string(const StringVector &symbols);
+
+ protected:
+  typedef std::set<StringVector> StringVectorSet;
+
+  StringVector      suffix_and_tag_marker;
+  StringVector      suffix_marker;
+  std::vector<Node> nodes;
+  Symbol2NumberMap  symbol_numbers;
+
+  // What can follow a state on the way to the markers.
+  enum
+  {
+    NO_MARKER = 0,
+    SUFFIX_AND_TAG_MARKER = 1,
+    SUFFIX_MARKER = 2,
+    MARKER_AHEAD = 4
+  };
+
+  void find_marker_states(const HfstBasicTransducer &fst,
+                          std::vector<int> &marker_states) const;
+  bool starts_marker(const HfstBasicTransducer &fst,
+                     HfstState state,
+                     StringVector::const_iterator begin,
+                     StringVector::const_iterator end) const;
+  void collect_suffixes(const HfstBasicTransducer &fst,
+                        const std::vector<int> &marker_states,
+                        HfstState state,
+                        StringVector &path,
+                        std::vector<HfstState> &epsilon_states,
+                        size_t epsilon_begin,
+                        StringVectorSet &analysis_suffixes,
+                        StringVectorSet &penalty_suffixes);
+  size_t add(StringVector::const_iterator begin,
+             StringVector::const_iterator end);
+  const Node * get_child(const Node &node, const std::string &symbol) const;
+};
+
+#endif // HEADER_SuffixGuessTrie_h
@@ -0,0 +1,369 @@
+#include <algorithm>
+#include <limits>
+
+#include "ViterbiTagger.h"
+
+#ifndef MAIN_TEST
+
+#define LEX_K 1.0
+#define INITIAL_SLOT_COUNT 64
+
+SentenceLattice::SentenceLattice(void)
+{ clear(); }
+
+void SentenceLattice::add_word(const std::string &word,
+                               const WeightedStringVector &tags,
+                               const CompiledSequenceModel &model)
+{
+  words.push_back(word);
+  word_symbols.push_back(model.get_symbol(word));
+
+  for (WeightedStringVector::const_iterator it = tags.begin();
+       it != tags.end();
+       ++it)
+    {
+      this->tags.push_back(it->second);
+      tag_symbols.push_back(model.get_symbol(it->second));
+      tag_weights.push_back(LEX_K*it->first);
+    }
+
+  tag_offsets.push_back(this->tags.size());
+}
+
+void SentenceLattice::clear(void)
+{
+  words.clear();
+  word_symbols.clear();
+  tag_offsets.assign(1,0);
+  tags.clear();
+  tag_symbols.clear();
+  tag_weights.clear();
+}
+
+size_t SentenceLattice::size(void) const
+{ return words.size(); }
+
+ViterbiTagger::ViterbiTagger(const CompiledSequenceModel &model):
+  model(model),
+  width(model.get_component_count()),
+  next_begin(0),
+  slots(INITIAL_SLOT_COUNT,-1),
+  target(model.get_component_count())
+{}
+
+bool ViterbiTagger::get_transition
+(const State * source, Symbol symbol, Weight &weight)
+{
+  TransitionData transition;
+
+  // Sum the weights in the same order as nested
+  // SequenceModelComponentPairs, whose first component is the one
+  // added last.
+  for (size_t i = 0; i < width; ++i)
+    {
+      if (not model.get_transition(i,source[i],symbol,transition))
+        { return false; }
+
+      target[i] = transition.target;
+      weight = (i == 0 ? transition.weight : transition.weight + weight);
+    }
+
+  return true;
+}
+
+size_t ViterbiTagger::find_slot(const State * model_states) const
+{
+  size_t hash = 0;
+  for (size_t i = 0; i < width; ++i)
+    { hash = (hash ^ static_cast<size_t>(model_states[i])) * 0x100000001b3; }
+
+  size_t mask = slots.size() - 1;
+  for (size_t slot = hash & mask; ; slot = (slot + 1) & mask)
+    {
+      if (slots[slot] == -1)
+        { return slot; }
+
+      const State * entry_states =
+        &next_states[(slots[slot] - next_begin)*width];
+      if (std::equal(model_states,model_states + width,entry_states))
+        { return slot; }
+    }
+}
+
+void ViterbiTagger::grow_slots(void)
+{
+  slots.assign(2*slots.size(),-1);
+  used_slots.clear();
+
+  for (int entry = next_begin; entry < static_cast<int>(weights.size());
+       ++entry)
+    {
+      size_t slot = find_slot(&next_states[(entry - next_begin)*width]);
+      slots[slot] = entry;
+      used_slots.push_back(slot);
+    }
+}
+
+void ViterbiTagger::clear_slots(void)
+{
+  for (std::vector<size_t>::const_iterator it = used_slots.begin();
+       it != used_slots.end();
+       ++it)
+    { slots[*it] = -1; }
+
+  used_slots.clear();
+}
+
+void ViterbiTagger::add_entry(Weight weight, int back_pointer, int tag_index)
+{
+  size_t slot = find_slot(&target[0]);
+
+  if (slots[slot] != -1)
+    {
+      // Of paths with equal weights, the first one found is kept.
+      int entry = slots[slot];
+      if (weight < weights[entry])
+        {
+          weights[entry] = weight;
+          back_pointers[entry] = back_pointer;
+          tag_indices[entry] = tag_index;
+        }
+      return;
+    }
+
+  slots[slot] = weights.size();
+  used_slots.push_back(slot);
+
+  weights.push_back(weight);
+  back_pointers.push_back(back_pointer);
+  tag_indices.push_back(tag_index);
+  next_states.insert(next_states.end(),target.begin(),target.end());
+
+  // Keep the table at most half full.
+  if (2*used_slots.size() > slots.size())
+    { grow_slots(); }
+}
+
+void ViterbiTagger::step(const SentenceLattice &lattice,
+                         size_t word,
+                         bool tag_position,
+                         int entry_begin,
+                         int entry_end)
+{
+  next_states.clear();
+  next_begin = entry_end;
+
+  size_t symbol_begin = tag_position ? lattice.tag_offsets[word] : word;
+  size_t symbol_end =
+    tag_position ? lattice.tag_offsets[word + 1] : word + 1;
+
+  for (int entry = entry_begin; entry < entry_end; ++entry)
+    {
+      const State * source = &states[(entry - entry_begin)*width];
+
+      for (size_t i = symbol_begin; i < symbol_end; ++i)
+        {
+          Symbol symbol =
+            tag_position ? lattice.tag_symbols[i] : lattice.word_symbols[i];
+          Weight symbol_weight = tag_position ? lattice.tag_weights[i] : 0;
+
+          Weight model_weight;
+          if (not get_transition(source,symbol,model_weight))
+            { continue; }
+
+          add_entry(weights[entry] + (symbol_weight + model_weight),
+                    entry,
+                    tag_position ? static_cast<int>(i) : -1);
+        }
+    }
+
+  clear_slots();
+  states.swap(next_states);
+}
+
+WeightedStringPairVector ViterbiTagger::operator[]
+(const SentenceLattice &lattice)
+{
+  // The entry of the start state, where every component is in its
+  // state 0.
+  states.assign(width,0);
+  weights.assign(1,0.0);
+  back_pointers.assign(1,-1);
+  tag_indices.assign(1,-1);
+
+  int entry_begin = 0;
+  int entry_end = 1;
+
+  for (size_t word = 0; word < lattice.size(); ++word)
+    {
+      for (int tag_position = 0; tag_position < 2; ++tag_position)
+        {
+          step(lattice,word,tag_position,entry_begin,entry_end);
+          entry_begin = entry_end;
+          entry_end = weights.size();
+        }
+    }
+
+  Weight infinity = std::numeric_limits<float>::infinity();
+
+  int best_entry = -1;
+  Weight best_weight = infinity;
+
+  for (int entry = entry_begin; entry < entry_end; ++entry)
+    {
+      const State * model_states = &states[(entry - entry_begin)*width];
+
+      Weight final_weight = 0.0;
+      for (size_t i = 0; i < width; ++i)
+        {
+          Weight w = model.get_final_weight(i,model_states[i]);
+          final_weight = (i == 0 ? w : w + final_weight);
+        }
+
+      if (final_weight == infinity)
+        { continue; }
+
+      Weight weight = weights[entry] + final_weight;
+      if (best_entry == -1 or weight < best_weight)
+        {
+          best_entry = entry;
+          best_weight = weight;
+        }
+    }
+
+  WeightedStringPairVector tagging;
+  tagging.first = best_weight;
+
+  if (best_entry == -1)
+    { return tagging; }
+
+  tagging.second.resize(lattice.size());
+  size_t word = lattice.size();
+
+  for (int entry = best_entry; entry != -1; entry = back_pointers[entry])
+    {
+      if (tag_indices[entry] == -1)
+        { continue; }
+
+      --word;
+      tagging.second[word] = StringPair(lattice.words[word],
+                                        lattice.tags[tag_indices[entry]]);
+    }
+
+  return tagging;
+}
+
+#else // MAIN_TEST
+
+#include <cassert>
+#include <iostream>
+
+#include "SequenceTagger.h"
+#include "SequenceModelComponentPair.h"
+#include "DelayedSequenceModelComponent.h"
+
+using hfst::HfstTransducer;
+using hfst::TROPICAL_OPENFST_TYPE;
+using hfst::implementations::HfstState;
+using hfst::implementations::HfstBasicTransition;
+
+int main(void)
+{
+  // The same model and sentence as in the tests of SequenceTagger.
+  HfstBasicTransducer b_a;
+  b_a.add_state();
+  b_a.add_state();
+  b_a.add_state();
+  b_a.add_transition(0,HfstBasicTransition(1,DEFAULT_SYMBOL,DEFAULT_SYMBOL,0.0));
+  b_a.add_transition(1,HfstBasicTransition(2,"A","A",1.0));
+  b_a.add_transition(1,HfstBasicTransition(2,"B","B",10.0));
+  b_a.add_transition(1,HfstBasicTransition(2,DEFAULT_SYMBOL,DEFAULT_SYMBOL,10.0));
+  b_a.add_transition(2,HfstBasicTransition(3,DEFAULT_SYMBOL,DEFAULT_SYMBOL,0.0));
+  b_a.add_transition(3,HfstBasicTransition(0,"A","A",10.0));
+  b_a.add_transition(3,HfstBasicTransition(0,"B","B",2.0));
+  b_a.add_transition(3,HfstBasicTransition(0,DEFAULT_SYMBOL,DEFAULT_SYMBOL,10.0));
+
+  for (HfstState s = 0; s <= b_a.get_max_state(); ++s)
+    { b_a.set_final_weight(s,0.0); }
+
+  WeightedStringVector a_tags;
+  a_tags.push_back(WeightedString(0.5,"A"));
+  a_tags.push_back(WeightedString(1.5,"B"));
+  a_tags.push_back(WeightedString(2.0,"C"));
+
+  WeightedStringVector b_tags;
+  b_tags.push_back(WeightedString(0.5,"B"));
+  b_tags.push_back(WeightedString(1.5,"A"));
+  b_tags.push_back(WeightedString(2.0,"C"));
+
+  WeightedStringVector c_tags;
+  c_tags.push_back(WeightedString(0.5,"E"));
+  c_tags.push_back(WeightedString(1.5,"F"));
+  c_tags.push_back(WeightedString(2.0,"G"));
+
+  const char * words[] = { "a", "b", "a", "b", "c", "c" };
+  const WeightedStringVector * word_tags[] =
+    { &a_tags, &b_tags, &a_tags, &b_tags, &c_tags, &c_tags };
+
+  // Two copies of the model, c.f. SequenceModelComponentPair(m,m).
+  CompiledSequenceModel compiled_model;
+  size_t model = compiled_model.add_model(b_a);
+  compiled_model.add_delayed_model(model,0);
+
+  SentenceLattice lattice;
+  for (size_t i = 0; i < 6; ++i)
+    { lattice.add_word(words[i],*word_tags[i],compiled_model); }
+
+  ViterbiTagger viterbi_tagger(compiled_model);
+  WeightedStringPairVector result = viterbi_tagger[lattice];
+
+  const char * expected_tags[] = { "A", "B", "A", "B", "E", "E" };
+  assert(result.second.size() == 6);
+  for (size_t i = 0; i < 6; ++i)
+    {
+      assert(result.second.at(i).first == words[i]);
+      assert(result.second.at(i).second == expected_tags[i]);
+    }
+  assert(result.first == static_cast<float>(55.0));
+
+  // The buffers are reused for the next sentence.
+  result = viterbi_tagger[lattice];
+  assert(result.first == static_cast<float>(55.0));
+
+  // The model and a copy delayed by one word, c.f.
+  // SequenceModelComponentPair(m,DelayedSequenceModelComponent(m,2)).
+  CompiledSequenceModel compiled_model2;
+  model = compiled_model2.add_model(b_a);
+  compiled_model2.add_delayed_model(model,2);
+
+  SentenceLattice lattice2;
+  for (size_t i = 0; i < 6; ++i)
+    { lattice2.add_word(words[i],*word_tags[i],compiled_model2); }
+
+  ViterbiTagger viterbi_tagger2(compiled_model2);
+  result = viterbi_tagger2[lattice2];
+  assert(result.second.size() == 6);
+
+  // The weight is the same as the one found by SequenceTagger.
+  HfstTransducer a(b_a,TROPICAL_OPENFST_TYPE);
+  SequenceModelComponent m(a);
+  DelayedSequenceModelComponent d(m,2);
+  SequenceModelComponentPair mp(m,d);
+  SequenceTagger sequence_tagger(mp);
+
+  SentenceTransducer sentence_transducer;
+  for (size_t i = 0; i < 6; ++i)
+    { sentence_transducer.add_word(words[i],*word_tags[i]); }
+  sentence_transducer.finalize();
+
+  assert(result.first == sequence_tagger[sentence_transducer].first);
+  assert(result.first == static_cast<float>(79.0));
+
+  // Sentences that the model does not accept get no tagging.
+  SentenceLattice empty_lattice;
+  empty_lattice.add_word("a",WeightedStringVector(),compiled_model);
+  result = viterbi_tagger[empty_lattice];
+  assert(result.second.empty());
+  assert(result.first == std::numeric_limits<float>::infinity());
+}
+#endif // MAIN_TEST
@@ -0,0 +1,102 @@
+#ifndef HEADER_ViterbiTagger_h
+#define HEADER_ViterbiTagger_h
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <vector>
+
+#include "HfstDataTypes.h"
+
+#include "CompiledSequenceModel.h"
+#include "DataTypes.h"
+
+using hfst::StringVector;
+
+// The words of a sentence and their weighted tags, with symbols numbered
+// by a CompiledSequenceModel. This is what SentenceTransducer holds,
+// without references to the static symbol table of
+// SequenceModelComponent, so that lattices can be built and tagged in
+// different threads.
+class SentenceLattice
+{
+ public:
+  SentenceLattice(void);
+
+  void add_word(const std::string &word,
+                const WeightedStringVector &tags,
+                const CompiledSequenceModel &model);
+
+  void clear(void);
+
+  size_t size(void) const;
+
+ protected:
+  friend class ViterbiTagger;
+
+  StringVector        words;
+  SymbolVector        word_symbols;
+
+  // The tags of word i are in positions
+  // [ tag_offsets[i], tag_offsets[i + 1] ).
+  std::vector<size_t> tag_offsets;
+  StringVector        tags;
+  SymbolVector        tag_symbols;
+  std::vector<Weight> tag_weights;
+};
+
+// Finds the best tagging of a SentenceLattice using the Viterbi
+// algorithm.
+//
+// The sentence is read one symbol at a time. At each position the
+// tagger keeps the distinct states of the sequence model that can be
+// reached, together with the weight of the best path to them and a
+// back pointer to the previous position. The buffers are kept from one
+// sentence to the next, so that tagging allocates memory only when a
+// sentence is longer or more ambiguous than the earlier ones.
+//
+// The model is only read, so each thread can have a tagger of its own
+// for the same model.
+class ViterbiTagger
+{
+ public:
+  ViterbiTagger(const CompiledSequenceModel &model);
+
+  WeightedStringPairVector operator[] (const SentenceLattice &lattice);
+
+ protected:
+  const CompiledSequenceModel &model;
+  size_t width;
+
+  // The model states of the entries of the current position and the
+  // next one, width states per entry.
+  std::vector<State> states;
+  std::vector<State> next_states;
+
+  // Weights, back pointers and tag indices of all entries of the
+  // sentence. Word positions have tag index -1.
+  std::vector<Weight> weights;
+  std::vector<int>    back_pointers;
+  std::vector<int>    tag_indices;
+
+  // The first entry of the next position.
+  int next_begin;
+
+  // Open addressing hash table from the model states of the next
+  // position to their entries. Its size is a power of two.
+  std::vector<int>    slots;
+  std::vector<size_t> used_slots;
+
+  std::vector<State> target;
+
+  bool get_transition(const State * source, Symbol symbol, Weight &weight);
+  size_t find_slot(const State * model_states) const;
+  void grow_slots(void);
+  void add_entry(Weight weight, int back_pointer, int tag_index);
+  void step(const SentenceLattice &lattice, size_t word, bool tag_position,
+            int entry_begin, int entry_end);
+  void clear_slots(void);
+};
+
+#endif // HEADER_ViterbiTagger_h
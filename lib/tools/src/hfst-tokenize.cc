@@ -69,6 +69,9 @@ static int token_number = 1;
 std::string tokenizer_filename;
 static hfst::ImplementationType default_format = hfst::TROPICAL_OPENFST_TYPE;
 TokenizeSettings settings;
+static bool profile = false;
+static hfst_ol::ProfileFormat profile_format = hfst_ol::profile_text;
+static std::string profile_filename;
 
 void
 print_usage()
@@ -102,6 +105,9 @@ print_usage()
             "  -C  --conllu             CoNLL-U format\n"
             "  -f, --finnpos            FinnPos output\n"
             "  -L, --visl               VISL input and output (implies -W, handles <s> as blocks and <STYLE> inline)\n"
+            "  -p, --profile[=FORMAT]   Print profiling data to stderr when done, FORMAT is\n"
+            "                           text (default), json or collapsed (for flamegraph tools)\n"
+            "      --profile-file=FILE  Write profiling data to FILE instead of stderr\n"
             );
     fprintf(message_out,
             "Use standard streams for input and output (for now).\n"
@@ -434,10 +440,12 @@ int parse_options(int argc, char** argv)
                 {"conllu", no_argument, 0, 'C'},
                 {"finnpos", no_argument, 0, 'f'},
                 {"visl", no_argument, 0, 'L'},
+                {"profile", optional_argument, 0, 'p'},
+                {"profile-file", required_argument, 0, 'P'},
                 {0,0,0,0}
             };
         int option_index = 0;
-        int c = getopt_long(argc, argv, HFST_GETOPT_COMMON_SHORT "nkawWmub:t:l:zixcSgCfL",
+        int c = getopt_long(argc, argv, HFST_GETOPT_COMMON_SHORT "nkawWmub:t:l:zixcSgCfLp::",
                              long_options, &option_index);
         if (-1 == c)
         {
@@ -533,6 +541,19 @@ int parse_options(int argc, char** argv)
         case 'f':
             settings.output_format = finnpos;
             break;
+        case 'p':
+            profile = true;
+            if (optarg != NULL &&
+                !hfst_ol::PmatchContainer::parse_profile_format(optarg, profile_format))
+            {
+                std::cerr << "Invalid argument for --profile\n";
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'P':
+            profile = true;
+            profile_filename = optarg;
+            break;
 #include "inc/getopt-cases-error.h"
         }
 
@@ -573,6 +594,25 @@ int parse_options(int argc, char** argv)
     return EXIT_FAILURE;
 }
 
+int process_input_and_profile(hfst_ol::PmatchContainer & container)
+{
+    container.set_profile(profile);
+    int retval = process_input(container, std::cout);
+    if (profile) {
+        if (!profile_filename.empty()) {
+            std::ofstream profile_stream(profile_filename.c_str());
+            if (!profile_stream.good()) {
+                std::cerr << "Could not open file " << profile_filename << std::endl;
+                return EXIT_FAILURE;
+            }
+            profile_stream << container.get_profiling_info(profile_format);
+        } else {
+            std::cerr << container.get_profiling_info(profile_format);
+        }
+    }
+    return retval;
+}
+
 bool first_transducer_is_called_TOP(const HfstTransducer & dictionary)
 {
     return dictionary.get_name() == "TOP";
@@ -623,13 +663,13 @@ int main(int argc, char ** argv)
             delete dictionary;
             container.set_verbose(verbose);
             container.set_single_codepoint_tokenization(!settings.tokenize_multichar);
-            return process_input(container, std::cout);
+            return process_input_and_profile(container);
         } else {
             verbose_printf("TOP automaton seen, treating as pmatch script...\n");
             hfst_ol::PmatchContainer container(instream);
             container.set_verbose(verbose);
             container.set_single_codepoint_tokenization(!settings.tokenize_multichar);
-            return process_input(container, std::cout);
+            return process_input_and_profile(container);
         }
     } catch(HfstException & e) {
         std::cerr << "Exception thrown:\n" << e.what() << std::endl;
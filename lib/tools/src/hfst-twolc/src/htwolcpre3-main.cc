@@ -66,6 +66,7 @@ int main(int argc, char * argv[])
 				 command_line.be_verbose,
 				 command_line.resolve_left_conflicts,
 				 command_line.resolve_right_conflicts);
+      twolc_grammar.set_jobs(command_line.jobs);
       hfst::twolcpre3::set_grammar(&twolc_grammar);
       int exit_code = hfst::twolcpre3::parse();
       if (exit_code != 0)
@@ -19,6 +19,10 @@
 #endif
 
 #include "XfstCompiler.h"
+#include "HfstCompilationCache.h"
+#include "HfstSpillStore.h"
+
+#include <memory>
 
 #ifdef WINDOWS
   #include <io.h>
@@ -52,6 +56,9 @@ static char* execute_command_and_quit = NULL;
 static bool pipe_input = false;
 static bool pipe_output = false; // this has no effect on non-windows platforms
 static bool restricted_mode = false;
+static char* cache_directory = NULL;
+static char* spill_directory = NULL;
+static bool report_memory = false;
 
 #ifdef HAVE_READLINE
   static bool use_readline = true;
@@ -83,6 +90,13 @@ print_usage()
           "  -w, --print-weight         Print weights for each operation\n"
 	  "  -R, --restricted-mode      Allow read and write operations only in current\n"
 	  "                             directory, do not allow system calls\n"
+          "      --cache=DIR            Reuse regexes and lexicons compiled in earlier\n"
+          "                             runs from directory DIR and store new ones there\n"
+          "      --spill=DIR            Keep networks that are not in use, i.e. those\n"
+          "                             below the top of the stack and definitions, in a\n"
+          "                             temporary directory under DIR\n"
+          "      --report-memory        Print the memory usage of the process and the\n"
+          "                             size of the spill directory after each command\n"
           //          "  -k, --no-console         Do not output directly to console (Windows-specific)\n"
           "\n"
           "Option --execute can be invoked many times.\n"
@@ -128,6 +142,9 @@ parse_options(int argc, char** argv)
             {"no-readline", no_argument, 0, 'r'},
             {"print-weight", no_argument, 0, 'w'},
 	    {"restricted-mode", no_argument, 0, 'R'},
+            {"cache", required_argument, 0, 'K'},
+            {"spill", required_argument, 0, 'S'},
+            {"report-memory", no_argument, 0, 'M'},
             //            {"no-console", no_argument, 0, 'k'},
             {0,0,0,0}
           };
@@ -212,6 +229,15 @@ parse_options(int argc, char** argv)
 	  case 'k':
             pipe_output = true;
             break;
+          case 'K':
+            cache_directory = hfst_strdup(optarg);
+            break;
+          case 'S':
+            spill_directory = hfst_strdup(optarg);
+            break;
+          case 'M':
+            report_memory = true;
+            break;
 #include "inc/getopt-cases-error.h"
           }
     }
@@ -400,6 +426,35 @@ int main(int argc, char** argv)
     {
       comp.setRestrictedMode(true);
     }
+
+  std::unique_ptr<hfst::HfstCompilationCache> cache;
+  if (cache_directory != NULL)
+    {
+      cache.reset(new hfst::HfstCompilationCache(cache_directory));
+      comp.setCache(cache.get());
+    }
+
+  std::unique_ptr<hfst::HfstSpillStore> spill_store;
+  if (spill_directory != NULL)
+    {
+      try
+        {
+          spill_store.reset(new hfst::HfstSpillStore(spill_directory));
+        }
+      catch (const HfstException & e)
+        {
+          error(EXIT_FAILURE, 0, "%s", e.what().c_str());
+          return EXIT_FAILURE;
+        }
+      verbose_printf("Spilling networks to %s\n",
+                     spill_store->get_directory().c_str());
+      comp.setSpillStore(spill_store.get());
+    }
+
+  if (report_memory)
+    {
+      comp.setMemoryReport(true);
+    }
   
   if (!pipe_output)
     comp.setOutputToConsole(true);
@@ -9,6 +9,13 @@ extern "C" {
     ) -> *const c_char;
     fn hfst_make_tokenizer(tokenizer: *const u8, tokenizer_size: usize) -> *const c_void;
     fn hfst_tokenizer_free(ptr: *const c_void);
+    fn hfst_tokenizer_set_profile(tokenizer: *const c_void, profile: bool);
+    fn hfst_tokenizer_reset_profile(tokenizer: *const c_void);
+    fn hfst_tokenizer_profile(
+        tokenizer: *const c_void,
+        format: *const c_char,
+        format_size: usize,
+    ) -> *const c_char;
     fn hfst_free(ptr: *const c_void);
     fn hfst_transducer_free(ptr: *const c_void);
     fn hfst_transducer_new(analyzer_bytes: *const u8, analyzer_size: usize) -> *const c_void;
@@ -21,6 +28,15 @@ extern "C" {
         tags: *mut CVec,
         callback: extern "C" fn(tags: *mut CVec, it: *const u8, it_size: usize),
     );
+    fn hfst_transducer_lookdown_tags(
+        analyzer: *const c_void,
+        is_diacritic: bool,
+        input: *const c_char,
+        input_size: usize,
+        time_cutoff: f64,
+        tags: *mut CVec,
+        callback: extern "C" fn(tags: *mut CVec, it: *const u8, it_size: usize),
+    );
 }
 
 #[repr(transparent)]
@@ -116,6 +132,54 @@ impl Transducer {
         // tags.sort();
         tags
     }
+
+    /// Generates with the transducer, i.e. returns the input side strings
+    /// of the paths whose output side is `input`. With an analyser this
+    /// gives the surface forms of an analysis.
+    pub fn lookdown_tags(&self, input: &str, is_diacritic: bool) -> Vec<String> {
+        let mut tags = CVec::new();
+
+        extern "C" fn callback(tags: *mut CVec, it: *const u8, it_size: usize) {
+            let slice = unsafe { std::slice::from_raw_parts(it, it_size) };
+            let s = std::str::from_utf8(slice).unwrap();
+            unsafe { tags.as_mut().unwrap().push(s.to_string()) };
+        }
+
+        unsafe {
+            hfst_transducer_lookdown_tags(
+                self.ptr,
+                is_diacritic,
+                input.as_ptr() as _,
+                input.len(),
+                10.0,
+                &mut tags,
+                callback,
+            );
+        }
+
+        tags.into_inner()
+    }
+}
+
+/// Output formats for [`Tokenizer::profile`].
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum ProfileFormat {
+    /// Human readable tables, as printed by `hfst-pmatch --profile`.
+    Text,
+    /// Per-RTN counters and hottest states as JSON.
+    Json,
+    /// Collapsed call stacks with microsecond counts, for flamegraph tools.
+    Collapsed,
+}
+
+impl ProfileFormat {
+    fn as_str(&self) -> &'static str {
+        match self {
+            ProfileFormat::Text => "text",
+            ProfileFormat::Json => "json",
+            ProfileFormat::Collapsed => "collapsed",
+        }
+    }
 }
 
 pub struct Tokenizer {
@@ -155,6 +219,34 @@ impl Tokenizer {
 
         Some(out)
     }
+
+    /// Turns per-RTN profiling on or off for subsequent calls to `tokenize`.
+    pub fn set_profile(&self, profile: bool) {
+        unsafe { hfst_tokenizer_set_profile(*self.ptr, profile) };
+    }
+
+    /// Clears the profiling data gathered so far.
+    pub fn reset_profile(&self) {
+        unsafe { hfst_tokenizer_reset_profile(*self.ptr) };
+    }
+
+    /// Returns the profiling data gathered since profiling was turned on.
+    pub fn profile(&self, format: ProfileFormat) -> Option<String> {
+        let format = format.as_str();
+        let output =
+            unsafe { hfst_tokenizer_profile(*self.ptr, format.as_ptr() as _, format.len()) };
+
+        if output.is_null() {
+            return None;
+        }
+
+        let bytes = unsafe { CStr::from_ptr(output).to_bytes() };
+
+        let out = String::from_utf8_lossy(bytes).into_owned();
+        unsafe { hfst_free(output as _) };
+
+        Some(out)
+    }
 }
 
 #[cfg(test)]
@@ -171,23 +171,36 @@ extern "C" void hfst_tokenizer_free(hfst_ol::PmatchContainer *ptr) {
   delete ptr;
 }
 
-extern "C" void hfst_free(void *ptr) { free(ptr); }
+extern "C" void hfst_tokenizer_set_profile(hfst_ol::PmatchContainer *tokenizer,
+                                           bool profile) {
+  tokenizer->set_profile(profile);
+}
 
-extern "C" void hfst_transducer_free(hfst::HfstTransducer *ptr) { delete ptr; }
+extern "C" void
+hfst_tokenizer_reset_profile(hfst_ol::PmatchContainer *tokenizer) {
+  tokenizer->reset_profile();
+}
 
-extern "C" void hfst_transducer_lookup_tags(
-    hfst::HfstTransducer *analyzer, bool is_diacritic, const char *input,
-    size_t input_size, double time_cutoff, void *tags,
-    void (*callback)(void *tags, const char *, size_t)) {
-  
-  // std::cerr << "hfst_transducer_lookup_tags" << std::endl;
+extern "C" const char *
+hfst_tokenizer_profile(hfst_ol::PmatchContainer *tokenizer,
+                       const char *format, size_t format_size) {
+  hfst_ol::ProfileFormat profile_format;
+  if (!hfst_ol::PmatchContainer::parse_profile_format(
+          std::string(format, format + format_size), profile_format)) {
+    return nullptr;
+  }
 
-  std::string input_str(input, input + input_size);
-  hfst::HfstOneLevelPaths *results =
-      analyzer->lookup_fd(input_str, -1, time_cutoff);
+  char *c_str = strdup(tokenizer->get_profiling_info(profile_format).c_str());
+  return c_str;
+}
 
-  // std::cerr << "results: " << results->size() << std::endl;
+extern "C" void hfst_free(void *ptr) { free(ptr); }
 
+extern "C" void hfst_transducer_free(hfst::HfstTransducer *ptr) { delete ptr; }
+
+static void emit_tags(hfst::HfstOneLevelPaths *results, bool is_diacritic,
+                      void *tags,
+                      void (*callback)(void *tags, const char *, size_t)) {
   for (auto result : *results) {
     // std::cerr << "result: " << result.first << std::endl;
     auto string_builder = std::stringstream();
@@ -202,6 +215,36 @@ extern "C" void hfst_transducer_lookup_tags(
     auto s = string_builder.str();
     (callback)(tags, s.c_str(), s.length());
   }
+  delete results;
+}
+
+extern "C" void hfst_transducer_lookup_tags(
+    hfst::HfstTransducer *analyzer, bool is_diacritic, const char *input,
+    size_t input_size, double time_cutoff, void *tags,
+    void (*callback)(void *tags, const char *, size_t)) {
+  
+  // std::cerr << "hfst_transducer_lookup_tags" << std::endl;
+
+  std::string input_str(input, input + input_size);
+  hfst::HfstOneLevelPaths *results =
+      analyzer->lookup_fd(input_str, -1, time_cutoff);
+
+  // std::cerr << "results: " << results->size() << std::endl;
+
+  emit_tags(results, is_diacritic, tags, callback);
+}
+
+// Generate the input side strings of an analysis, e.g. the surface
+// forms of "cat+N+Pl" with an analyser.
+extern "C" void hfst_transducer_lookdown_tags(
+    hfst::HfstTransducer *analyzer, bool is_diacritic, const char *input,
+    size_t input_size, double time_cutoff, void *tags,
+    void (*callback)(void *tags, const char *, size_t)) {
+  std::string input_str(input, input + input_size);
+  hfst::HfstOneLevelPaths *results =
+      analyzer->lookdown_fd(input_str, -1, time_cutoff);
+
+  emit_tags(results, is_diacritic, tags, callback);
 }
 
 extern "C" const hfst::HfstTransducer *